@@ -0,0 +1,1069 @@
+// Rocket.cpp 의 메인 루프에서 시간이 드는 부분들을 따로 떼어서 재는 벤치마크.
+// 결과는 기본으로 rocket_bench.json 에 JSON 으로 저장된다 (--benchmark_out 로 바꿀 수 있다).
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <algorithm>
+
+// Include GLEW
+#include <GL/glew.h>
+
+// Include GLFW
+#include <GLFW/glfw3.h>
+GLFWwindow* window;
+
+// Include GLM
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+using namespace glm;
+#include <common/controls.hpp>
+
+#include <benchmark/benchmark.h>
+
+#include "mesh.hpp"
+#include "flight.hpp"
+#include "capture.hpp"
+#include "telemetry.hpp"
+#include "scene.hpp"
+#include "jobs.hpp"
+#include "collision.hpp"
+#include "debris.hpp"
+#include "streambuffer.hpp"
+#include "particles.hpp"
+#include "hud.hpp"
+#include "trajectory.hpp"
+#include "flightlog.hpp"
+#include "views.hpp"
+#include "lighting.hpp"
+#include "sky.hpp"
+#include "resolution.hpp"
+
+// 시작할 때 glBufferData 로 올리는 배열들 (Rocket.cpp 와 같은 순서 : 메쉬마다 위치, 색, 법선)
+struct MeshArray {
+	const GLfloat * data;
+	GLsizeiptr size;
+};
+#define MESH_ARRAYS(id) \
+	{ mesh::meshes[mesh::id].positions, mesh::meshes[mesh::id].vertexCount * 3 * (GLsizeiptr)sizeof(GLfloat) }, \
+	{ mesh::meshes[mesh::id].colors, mesh::meshes[mesh::id].vertexCount * 3 * (GLsizeiptr)sizeof(GLfloat) }, \
+	{ mesh::meshes[mesh::id].normals, mesh::meshes[mesh::id].vertexCount * 3 * (GLsizeiptr)sizeof(GLfloat) }
+static const MeshArray sceneArrays[] = {
+	MESH_ARRAYS(MESH_BODY), MESH_ARRAYS(MESH_WING1), MESH_ARRAYS(MESH_WING2), MESH_ARRAYS(MESH_WING3),
+	MESH_ARRAYS(MESH_WING4), MESH_ARRAYS(MESH_HEAD), MESH_ARRAYS(MESH_WALL), MESH_ARRAYS(MESH_FLOOR),
+	MESH_ARRAYS(MESH_LINES), MESH_ARRAYS(MESH_SUIT1), MESH_ARRAYS(MESH_SUIT2), MESH_ARRAYS(MESH_SUIT3),
+	MESH_ARRAYS(MESH_SUIT4), MESH_ARRAYS(MESH_SUIT5),
+};
+#undef MESH_ARRAYS
+static const int sceneArrayCount = sizeof(sceneArrays) / sizeof(sceneArrays[0]);
+
+static GLsizeiptr sceneBytes(){
+	GLsizeiptr total = 0;
+	for (int i = 0; i < sceneArrayCount; i++)
+		total += sceneArrays[i].size;
+	return total;
+}
+
+// 비행 업데이트 블록. 로켓 N 대를 한 프레임씩 진행한다.
+static void BM_UpdateFlight(benchmark::State & state){
+	const int count = (int)state.range(0);
+	std::vector<FlightState> flights(count);
+	for (int i = 0; i < count; i++) {
+		initFlight(flights[i]);
+		launchFlight(flights[i]);
+		if (i % 4 == 3)   //일부는 낙하산 단계
+			deployParachute(flights[i]);
+	}
+	const float deltaTime = FLIGHT_TICK;
+	for (auto _ : state) {
+		for (int i = 0; i < count; i++) {
+			FlightState & f = flights[i];
+			updateFlight(f, deltaTime);
+			if (f.sky == 0) {   //착륙하면 다시 발사
+				initFlight(f);
+				launchFlight(f);
+			}
+		}
+		benchmark::ClobberMemory();
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_UpdateFlight)->RangeMultiplier(4)->Range(1, 1 << 16);
+
+// 궤적 예측. 발사 직후 상태에서 착지까지의 구간을 모두 닫힌 식으로 다시 구한다.
+static void BM_TrajectoryRebuild(benchmark::State & state){
+	FlightState flight;
+	initFlight(flight);
+	launchFlight(flight);
+	updateFlight(flight, FLIGHT_TICK);
+	TrajectoryPrediction prediction;
+	for (auto _ : state) {
+		initPrediction(prediction, flight);
+		benchmark::DoNotOptimize(prediction.touchdownTick);
+	}
+	state.counters["phases"] = prediction.phaseCount;
+}
+BENCHMARK(BM_TrajectoryRebuild);
+
+// 캐시된 예측에서 임의의 틱의 위치를 묻는다 (선 그리기, HUD)
+static void BM_TrajectoryQuery(benchmark::State & state){
+	FlightState flight;
+	initFlight(flight);
+	launchFlight(flight);
+	updateFlight(flight, FLIGHT_TICK);
+	TrajectoryPrediction prediction;
+	initPrediction(prediction, flight);
+	int64_t tick = 0;
+	for (auto _ : state) {
+		benchmark::DoNotOptimize(predictPosition(prediction, tick));
+		tick = (tick + 37) % prediction.touchdownTick;
+	}
+}
+BENCHMARK(BM_TrajectoryQuery);
+
+// 예측을 한 틱씩 돌린 비행과 맞춰 본다. 인자는 낙하산을 펴는 틱 (-1 이면 펴지 않음).
+// 한 번의 반복 = 발사부터 착지까지 updateFlight + updatePrediction. 예측이 맞으면 다시 계산은 발사와 낙하산 때뿐이다.
+static void BM_TrajectoryValidate(benchmark::State & state){
+	const int parachuteTick = (int)state.range(0);
+	TrajectoryPrediction prediction;
+	float maxError = 0.0f;
+	double apogeeError = 0.0, touchdownError = 0.0;
+	int64_t tickError = 0;
+	int rebuilds = 0;
+	for (auto _ : state) {
+		FlightState flight;
+		initFlight(flight);
+		launchFlight(flight);
+		updateFlight(flight, FLIGHT_TICK);
+		initPrediction(prediction, flight);
+		float predictedApogee = prediction.apogee;
+		float apogee = flight.gro1.y;
+		int64_t tick = 0;
+		while (flight.sky == 1) {
+			tick++;
+			if (tick == parachuteTick)
+				deployParachute(flight);
+			updateFlight(flight, FLIGHT_TICK);
+			updatePrediction(prediction, flight);
+			apogee = std::max(apogee, flight.gro1.y);
+		}
+		// 낙하산을 펴면 거기서부터 다시 예측하므로 정점은 처음 예측과 비교하지 않는다
+		if (parachuteTick < 0)
+			apogeeError = std::max(apogeeError, (double)fabsf(apogee - predictedApogee));
+		touchdownError = std::max(touchdownError, (double)glm::length(flight.gro1 - prediction.touchdown));
+		tickError = std::max(tickError, (int64_t)llabs(prediction.touchdownTick - prediction.tick));
+		maxError = std::max(maxError, prediction.stats.maxError);
+		rebuilds = prediction.stats.rebuilds;
+	}
+	state.counters["max_error"] = maxError;
+	state.counters["apogee_error"] = apogeeError;
+	state.counters["touchdown_error"] = touchdownError;
+	state.counters["touchdown_tick_error"] = (double)tickError;
+	state.counters["rebuilds"] = rebuilds;
+	state.counters["ticks"] = (double)prediction.tick;
+}
+BENCHMARK(BM_TrajectoryValidate)->Arg(-1)->Arg(100)->Arg(300)->Arg(500)->Unit(benchmark::kMicrosecond);
+
+// 발사부터 한 블록 분량 (FLIGHTLOG_BLOCK_TICKS 틱, 중간에 낙하산) 의 양자화된 채널들
+static void makeFlightLogBlock(const FlightLogHeader & header, std::vector<int32_t> & values){
+	values.resize(FLIGHTLOG_CHANNELS * FLIGHTLOG_BLOCK_TICKS);
+	FlightState flight;
+	initFlight(flight);
+	launchFlight(flight);
+	for (int i = 0; i < FLIGHTLOG_BLOCK_TICKS; i++) {
+		if (i == 500)
+			deployParachute(flight);
+		updateFlight(flight, FLIGHT_TICK);
+		const float sample[FLIGHTLOG_CHANNELS] = { flight.gro1.x, flight.gro1.y, flight.gro1.z, flight.velocity,
+			(float)((flight.start ? TELEMETRY_START : 0) | (flight.sky ? TELEMETRY_SKY : 0) | (flight.suit ? TELEMETRY_SUIT : 0)) };
+		for (int c = 0; c < FLIGHTLOG_CHANNELS; c++)
+			values[c * FLIGHTLOG_BLOCK_TICKS + i] = (int32_t)llrint((double)sample[c] / header.step[c]);
+	}
+}
+
+// 비행 기록 한 블록 인코딩 (5 채널). 처리량은 원래 크기 (틱당 FLIGHTLOG_RAW_TICK_BYTES) 기준.
+static void BM_FlightLogEncode(benchmark::State & state){
+	FlightLogHeader header;
+	defaultFlightLogSteps(header.step);
+	std::vector<int32_t> values;
+	makeFlightLogBlock(header, values);
+	std::vector<uint8_t> out(flightLogChannelBound(FLIGHTLOG_BLOCK_TICKS));
+	size_t bytes = 0;
+	for (auto _ : state) {
+		bytes = 0;
+		for (int c = 0; c < FLIGHTLOG_CHANNELS; c++)
+			bytes += encodeFlightLogChannel(&values[c * FLIGHTLOG_BLOCK_TICKS], FLIGHTLOG_BLOCK_TICKS, &out[0]);
+		benchmark::DoNotOptimize(out.data());
+	}
+	state.SetBytesProcessed(state.iterations() * FLIGHTLOG_BLOCK_TICKS * FLIGHTLOG_RAW_TICK_BYTES);
+	state.counters["ratio"] = (double)FLIGHTLOG_BLOCK_TICKS * FLIGHTLOG_RAW_TICK_BYTES / bytes;
+}
+BENCHMARK(BM_FlightLogEncode);
+
+// 블록 하나를 float 열로 푼다. 인자 : SSE 를 쓰는지
+static void BM_FlightLogDecode(benchmark::State & state){
+	const bool simd = state.range(0) != 0;
+	FlightLogHeader header;
+	defaultFlightLogSteps(header.step);
+	header.blockTicks = FLIGHTLOG_BLOCK_TICKS;
+	std::vector<int32_t> values;
+	makeFlightLogBlock(header, values);
+	std::vector<uint8_t> block(FLIGHTLOG_CHANNELS * (sizeof(uint32_t) + flightLogChannelBound(FLIGHTLOG_BLOCK_TICKS)) + FLIGHTLOG_PADDING);
+	size_t size = FLIGHTLOG_CHANNELS * sizeof(uint32_t);
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++) {
+		uint32_t bytes = (uint32_t)encodeFlightLogChannel(&values[c * FLIGHTLOG_BLOCK_TICKS], FLIGHTLOG_BLOCK_TICKS, &block[size]);
+		memcpy(&block[c * sizeof(uint32_t)], &bytes, sizeof(bytes));
+		size += bytes;
+	}
+	FlightLogRange out;
+	out.x.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.y.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.z.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.velocity.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.flags.resize(FLIGHTLOG_BLOCK_TICKS);
+	std::vector<int32_t> scratch(FLIGHTLOG_CHANNELS * (FLIGHTLOG_BLOCK_TICKS + FLIGHTLOG_GROUP));
+	memset(&block[size], 0, FLIGHTLOG_PADDING);
+	size += FLIGHTLOG_PADDING;
+	// 한 번 풀어서 원래 값과 맞는지 본다 (scratch 에 남은 양자화된 정수와 플래그 열)
+	if (!decodeFlightLogBlock(header, &block[0], size, FLIGHTLOG_BLOCK_TICKS, 0, FLIGHTLOG_BLOCK_TICKS, &scratch[0], out, 0, simd)) {
+		state.SkipWithError("decode failed");
+		return;
+	}
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++) {
+		const int32_t * decoded = &scratch[c * (FLIGHTLOG_BLOCK_TICKS + FLIGHTLOG_GROUP)];
+		for (int i = 0; i < FLIGHTLOG_BLOCK_TICKS; i++) {
+			int32_t expected = values[c * FLIGHTLOG_BLOCK_TICKS + i];
+			if (decoded[i] != expected || (c == FLIGHTLOG_FLAGS && out.flags[i] != (uint8_t)expected)) {
+				state.SkipWithError("round trip mismatch");
+				return;
+			}
+		}
+	}
+	for (auto _ : state) {
+		decodeFlightLogBlock(header, &block[0], size, FLIGHTLOG_BLOCK_TICKS, 0, FLIGHTLOG_BLOCK_TICKS, &scratch[0], out, 0, simd);
+		benchmark::DoNotOptimize(out.y.data());
+	}
+	state.SetBytesProcessed(state.iterations() * FLIGHTLOG_BLOCK_TICKS * FLIGHTLOG_RAW_TICK_BYTES);
+	state.counters["ratio"] = (double)FLIGHTLOG_BLOCK_TICKS * FLIGHTLOG_RAW_TICK_BYTES / size;
+}
+BENCHMARK(BM_FlightLogDecode)->Arg(0)->Arg(1);
+
+// ProjectionMatrix * ViewMatrix * Model 을 물체마다 계산하는 지금의 방식 (장면 하나에 14개)
+static void BM_ComposeMVP(benchmark::State & state){
+	const int count = (int)state.range(0);
+	glm::mat4 ProjectionMatrix = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	glm::mat4 ViewMatrix = glm::lookAt(glm::vec3(3, 3, 10), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+	std::vector<glm::mat4> models(count);
+	std::vector<glm::mat4> mvps(count);
+	for (int i = 0; i < count; i++)
+		models[i] = translate(mat4(), vec3((float)i, 0.0f, 0.0f));
+	for (auto _ : state) {
+		for (int i = 0; i < count; i++)
+			mvps[i] = ProjectionMatrix * ViewMatrix * models[i];
+		benchmark::DoNotOptimize(mvps.data());
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ComposeMVP)->RangeMultiplier(4)->Range(14, 14 << 12);
+
+// 비교용 : ProjectionMatrix * ViewMatrix 를 한 번만 계산하는 경우
+static void BM_ComposeMVPHoisted(benchmark::State & state){
+	const int count = (int)state.range(0);
+	glm::mat4 ProjectionMatrix = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f);
+	glm::mat4 ViewMatrix = glm::lookAt(glm::vec3(3, 3, 10), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+	std::vector<glm::mat4> models(count);
+	std::vector<glm::mat4> mvps(count);
+	for (int i = 0; i < count; i++)
+		models[i] = translate(mat4(), vec3((float)i, 0.0f, 0.0f));
+	for (auto _ : state) {
+		glm::mat4 VP = ProjectionMatrix * ViewMatrix;
+		for (int i = 0; i < count; i++)
+			mvps[i] = VP * models[i];
+		benchmark::DoNotOptimize(mvps.data());
+	}
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_ComposeMVPHoisted)->RangeMultiplier(4)->Range(14, 14 << 12);
+
+// 장면 그래프 : 로켓 N 대 (로켓 노드 + 부품 13 개). 매 프레임 로켓 노드만 움직이고 world/MVP 를 갱신한다.
+static void BM_SceneGraphUpdate(benchmark::State & state){
+	const int rockets = (int)state.range(0);
+	SceneGraph scene;
+	initSceneGraph(scene, rockets * 14);
+	std::vector<int> roots(rockets);
+	for (int r = 0; r < rockets; r++) {
+		roots[r] = addSceneNode(scene, -1, translate(mat4(), vec3((float)r, 0.0f, 0.0f)));
+		for (int part = 0; part < 13; part++)
+			addSceneNode(scene, roots[r], glm::mat4(1.0f));
+	}
+	std::vector<glm::mat4> mvps(scene.world.size());
+	glm::mat4 VP = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) *
+		glm::lookAt(glm::vec3(3, 3, 10), glm::vec3(0, 0, 0), glm::vec3(0, 1, 0));
+	float y = 0.0f;
+	for (auto _ : state) {
+		y += 0.01f;
+		for (int r = 0; r < rockets; r++)
+			setLocalTransform(scene, roots[r], translate(mat4(), vec3((float)r, y, 0.0f)));
+		updateWorldTransforms(scene);
+		computeSceneMVP(scene, VP, &mvps[0]);
+		benchmark::DoNotOptimize(mvps.data());
+	}
+	state.SetItemsProcessed(state.iterations() * scene.world.size());
+}
+BENCHMARK(BM_SceneGraphUpdate)->RangeMultiplier(4)->Range(1, 1 << 12);
+
+// 여러 화면 : 뷰 N 개의 카메라 + 노드 컬링 (로켓 1024 대) + 잔해 50000 개 컬링과 인스턴스 쓰기.
+// 그리기 호출 수는 뷰 수와 상관없으므로 뷰를 늘렸을 때 CPU 쪽에서 느는 것은 이것뿐이다.
+static void BM_MultiViewCull(benchmark::State & state){
+	const int viewCount = (int)state.range(0);
+	const int rockets = 1024;
+	SceneGraph scene;
+	initSceneGraph(scene, rockets * 14);
+	for (int r = 0; r < rockets; r++) {
+		int root = addSceneNode(scene, -1, translate(mat4(), vec3(r % 32 * 3.0f - 48.0f, 0.0f, r / 32 * 3.0f - 48.0f)));
+		for (int part = 0; part < 13; part++)
+			addSceneNode(scene, root, glm::mat4(1.0f));
+	}
+	updateWorldTransforms(scene);
+	std::vector<vec3> nodeMin(scene.world.size(), vec3(0.0f)), nodeMax(scene.world.size(), vec3(1.0f, 2.0f, 1.0f));
+	std::vector<unsigned char> viewMask(scene.world.size());
+	DebrisSystem debris;
+	initDebris(debris, 50000);
+	spawnDebrisBurst(debris, vec3(0.0f, 5.0f, 0.0f), vec3(0.9f, 4.0f, 0.0f), 50000, 2.0f, 1);
+	FlightState flight;
+	initFlight(flight);
+	TrajectoryPrediction prediction;
+	initPrediction(prediction, flight);
+	ViewSet views;
+	views.viewportArray = false;
+	layoutViews(views, viewCount, VIEW_FREE);
+	int visibleNodes = 0, visibleDebris = 0;
+	for (auto _ : state) {
+		computeViews(views, getViewMatrix(), getProjectionMatrix(), 4.0f / 3.0f, flight, prediction);
+		visibleNodes = cullSceneNodesViews(scene, &nodeMin[0], &nodeMax[0], views.frustum, views.count, &viewMask[0]);
+		visibleDebris = cullDebrisViews(debris, views.frustum, views.count, NULL);
+		writeDebrisInstances(debris, &debris.instances[0], debris.capacity, NULL);
+		benchmark::DoNotOptimize(&debris.instances[0]);
+	}
+	state.counters["visible_nodes"] = visibleNodes;
+	state.counters["visible_debris"] = visibleDebris;
+}
+BENCHMARK(BM_MultiViewCull)->Arg(1)->Arg(2)->Arg(4)->Unit(benchmark::kMillisecond);
+
+// 클러스터 조명 : 빛 N 개를 뷰들의 클러스터에 나눠 담는다. 두번째 인자는 뷰 수, 세번째는 워커 수.
+// 조각 셰이더는 클러스터의 목록만 돌므로 빛이 늘 때 CPU 쪽에서 느는 것은 이것과 목록을 올리는 양이다.
+static void BM_LightClusters(benchmark::State & state){
+	const int lightCount = (int)state.range(0);
+	const int viewCount = (int)state.range(1);
+	const int threads = (int)state.range(2);
+	FlightState flight;
+	initFlight(flight);
+	TrajectoryPrediction prediction;
+	initPrediction(prediction, flight);
+	ViewSet views;
+	views.viewportArray = false;
+	layoutViews(views, viewCount, VIEW_FREE);
+	computeViews(views, getViewMatrix(), getProjectionMatrix(), 4.0f / 3.0f, flight, prediction);
+	LightClusters lights;
+	initLightClusters(lights);
+	generateRangeLights(lights, lightCount, flight.gro1, 2024);
+	JobSystem jobs;
+	startJobs(jobs, threads);
+	double boundsMs = 0, binMs = 0;
+	for (auto _ : state) {
+		buildLightClusters(lights, views, &jobs);
+		boundsMs += lights.stats.boundsMs;
+		binMs += lights.stats.binMs;
+		benchmark::DoNotOptimize(&lights.indices[0]);
+	}
+	stopJobs(jobs);
+	const double iterations = (double)state.iterations();
+	state.counters["bounds_ms"] = boundsMs / iterations;
+	state.counters["bin_ms"] = binMs / iterations;
+	state.counters["in_view"] = lights.stats.visible;
+	state.counters["refs"] = lights.stats.indices;
+	state.counters["max_per_cluster"] = lights.stats.maxPerCluster;
+	state.counters["dropped"] = lights.stats.overflows;
+	state.SetItemsProcessed(state.iterations() * lightCount);
+}
+BENCHMARK(BM_LightClusters)->Args({ 100, 1, 1 })->Args({ 1000, 1, 1 })->Args({ 4000, 1, 1 })->Args({ 10000, 1, 1 })
+	->Args({ 10000, 4, 1 })->Args({ 10000, 4, 4 })->Args({ 10000, 4, 8 })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// 하늘 표 만들기 (시작할 때 한 번, 캐시가 없을 때). 인자는 워커 수.
+static void BM_SkyPrecompute(benchmark::State & state){
+	Sky sky;
+	initSky(sky, NULL, 35.0f, 40.0f);
+	JobSystem jobs;
+	startJobs(jobs, (int)state.range(0));
+	double multipleMs = 0, scatteringMs = 0;
+	for (auto _ : state) {
+		precomputeSky(sky, &jobs);
+		multipleMs += sky.stats.multipleMs;
+		scatteringMs += sky.stats.scatteringMs;
+		benchmark::DoNotOptimize(&sky.scattered[0]);
+	}
+	stopJobs(jobs);
+	state.counters["multiple_ms"] = multipleMs / state.iterations();
+	state.counters["scattering_ms"] = scatteringMs / state.iterations();
+}
+BENCHMARK(BM_SkyPrecompute)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// 하늘 표를 캐시 파일에서 읽기 (두번째 실행부터의 시작 비용)
+static void BM_SkyCacheLoad(benchmark::State & state){
+	Sky sky;
+	initSky(sky, "rocket_bench_sky.lut", 35.0f, 40.0f);
+	precomputeSky(sky, NULL);
+	if (!saveSkyCache(sky)) {
+		state.SkipWithError("cannot write sky cache");
+		return;
+	}
+	for (auto _ : state) {
+		bool loaded = loadSkyCache(sky);
+		benchmark::DoNotOptimize(loaded);
+	}
+	remove(sky.cachePath);
+	state.SetBytesProcessed(state.iterations() * (int64_t)(sizeof(SkyCacheHeader)
+		+ (sky.transmittance.size() + sky.multiple.size() + sky.rayleigh.size() + sky.mie.size() + sky.scattered.size()) * sizeof(float)));
+}
+BENCHMARK(BM_SkyCacheLoad)->Unit(benchmark::kMillisecond);
+
+// 매 프레임 하는 일 : 시선 방향마다 표 찾기 (셰이더와 같은 식을 CPU 에서). 화소 하나당 비용.
+static void BM_SkyLookup(benchmark::State & state){
+	Sky sky;
+	initSky(sky, NULL, 35.0f, 40.0f);
+	precomputeSky(sky, NULL);
+	std::vector<vec3> directions(4096);
+	for (size_t i = 0; i < directions.size(); i++) {
+		float y = 1.0f - 2.0f * (i + 0.5f) / directions.size();
+		float a = i * 2.39996323f;
+		float r = sqrtf(1.0f - y * y);
+		directions[i] = vec3(r * cosf(a), y, r * sinf(a));
+	}
+	float altitude = 0.0f;
+	for (auto _ : state) {
+		vec3 sum(0.0f);
+		for (size_t i = 0; i < directions.size(); i++)
+			sum += skyRadiance(sky, altitude, directions[i]);
+		benchmark::DoNotOptimize(sum);
+		altitude = fmodf(altitude + 0.7f, SKY_TOP_RADIUS - SKY_GROUND_RADIUS);
+	}
+	state.SetItemsProcessed(state.iterations() * directions.size());
+}
+BENCHMARK(BM_SkyLookup);
+
+// 동적 해상도 조절기 : GPU 없이 비용 모형 (고정 1.5 ms + 픽셀 비용 * 배율^2 * MSAA) 으로 부하를 20 초 동안 올렸다 내린다.
+// 측정은 3 프레임 늦게 온다 (타임스탬프 쿼리처럼). 인자는 가장 큰 부하에서의 픽셀 비용 (ms, 배율 1).
+// over_pct 는 목표 (16.6 ms) 를 넘은 프레임의 비율.
+static void BM_ResolutionRamp(benchmark::State & state){
+	const float peakMs = (float)state.range(0);
+	const int frames = 60 * 20;
+	int over = 0, measured = 0, changes = 0;
+	double sumScale = 0.0;
+	for (auto _ : state) {
+		ResolutionController c;
+		initResolutionController(c, 16.6f, 4, true);
+		float pendingMs[3] = { 0.0f, 0.0f, 0.0f }, pendingScale[3] = { 1.0f, 1.0f, 1.0f };
+		int pendingSamples[3] = { 4, 4, 4 };
+		for (int f = 0; f < frames; f++) {
+			int slot = f % 3;
+			if (f >= 3) {
+				recordResolutionFrame(c, pendingMs[slot]);
+				if (pendingMs[slot] > c.targetMs)
+					over++;
+				measured++;
+				updateResolution(c, pendingMs[slot], pendingScale[slot], pendingSamples[slot]);
+			}
+			float load = syntheticLoad(f / 60.0, 10.0);
+			pendingMs[slot] = 1.5f + (6.0f + load * peakMs) * c.scale * c.scale * (1.0f + 0.15f * c.samples);
+			pendingScale[slot] = c.scale;
+			pendingSamples[slot] = c.samples;
+			sumScale += c.scale;
+		}
+		changes += c.window.changes;
+		benchmark::DoNotOptimize(c.scale);
+	}
+	state.counters["over_pct"] = measured > 0 ? over * 100.0 / measured : 0.0;
+	state.counters["mean_scale"] = sumScale / ((double)frames * state.iterations());
+	state.counters["msaa_changes"] = (double)changes / state.iterations();
+	state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_ResolutionRamp)->Arg(10)->Arg(30)->Arg(90);
+
+// 충돌 검사 : 벽 세 개 + 바닥 높이맵 + 상자/헐 잔해 N 개. 두번째 인자는 워커 수.
+// 매 반복마다 잔해를 조금씩 떨어뜨려 해시를 다시 만든다.
+static void BM_CollisionStep(benchmark::State & state){
+	const int bodies = (int)state.range(0);
+	const int threads = (int)state.range(1);
+	CollisionWorld world;
+	initCollisionWorld(world, 2.0f);
+	addBoxBody(world, vec3(-100.0f, 0.0f, -5.1f), vec3(100.0f, 30.0f, -4.9f), true);
+	addBoxBody(world, vec3(49.9f, 0.0f, -5.0f), vec3(50.1f, 30.0f, 100.0f), true);
+	addBoxBody(world, vec3(-30.1f, 0.0f, -5.0f), vec3(-29.9f, 30.0f, 100.0f), true);
+	setFlatTerrain(world, -100.0f, -100.0f, 100.0f, 100.0f, 1.0f, 0.0f);
+	const vec3 cube[8] = {
+		vec3(-0.5f, -0.5f, -0.5f), vec3(0.5f, -0.5f, -0.5f), vec3(-0.5f, 0.5f, -0.5f), vec3(0.5f, 0.5f, -0.5f),
+		vec3(-0.5f, -0.5f, 0.5f), vec3(0.5f, -0.5f, 0.5f), vec3(-0.5f, 0.5f, 0.5f), vec3(0.5f, 0.5f, 0.5f)
+	};
+	srand(1);
+	std::vector<int> debris(bodies);
+	for (int i = 0; i < bodies; i++) {
+		vec3 p(rand() % 20000 * 0.01f - 100.0f, rand() % 3000 * 0.01f, rand() % 20000 * 0.01f - 100.0f);
+		if (i % 2 == 0)
+			debris[i] = addHullBody(world, cube, 8, p, false);
+		else
+			debris[i] = addBoxBody(world, p - vec3(0.3f), p + vec3(0.3f), false);
+	}
+	JobSystem jobs;
+	startJobs(jobs, threads);
+	double buildMs = 0, pairMs = 0, narrowMs = 0;
+	for (auto _ : state) {
+		for (int i = 0; i < bodies; i++) {
+			vec3 p = world.position[debris[i]];
+			p.y = p.y > 0.0f ? p.y - 0.05f : 30.0f;
+			setBodyPosition(world, debris[i], p);
+		}
+		stepCollision(world, &jobs);
+		buildMs += world.stats.buildMs;
+		pairMs += world.stats.pairMs;
+		narrowMs += world.stats.narrowMs;
+	}
+	stopJobs(jobs);
+	const double iterations = (double)state.iterations();
+	state.counters["pairs"] = world.stats.candidatePairs;
+	state.counters["contacts"] = world.stats.contacts + world.stats.terrainContacts;
+	state.counters["build_ms"] = buildMs / iterations;
+	state.counters["pair_ms"] = pairMs / iterations;
+	state.counters["narrow_ms"] = narrowMs / iterations;
+	state.SetItemsProcessed(state.iterations() * bodies);
+}
+BENCHMARK(BM_CollisionStep)->Args({ 1000, 1 })->Args({ 10000, 1 })->Args({ 100000, 1 })
+	->Args({ 100000, 2 })->Args({ 100000, 4 })->Args({ 100000, 8 })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// 잔해 : 파편 N 개를 한 틱씩 진행하고 인스턴스 데이터를 채운다. 두번째 인자는 워커 수.
+// 수명이 다한 만큼 다시 뿌려서 개수를 유지한다.
+static void BM_DebrisStep(benchmark::State & state){
+	const int count = (int)state.range(0);
+	const int threads = (int)state.range(1);
+	DebrisSystem debris;
+	initDebris(debris, count);
+	spawnDebrisBurst(debris, vec3(0.0f, 5.0f, 0.0f), vec3(0.9f, 4.0f, 0.0f), count, 2.0f, 1);
+	JobSystem jobs;
+	startJobs(jobs, threads);
+	double integrateMs = 0, compactMs = 0, instanceMs = 0;
+	uint32_t seed = 2;
+	for (auto _ : state) {
+		stepDebris(debris, FLIGHT_TICK, NULL, &jobs);
+		fillDebrisInstances(debris, NULL, &jobs);
+		integrateMs += debris.stats.integrateMs;
+		compactMs += debris.stats.compactMs;
+		instanceMs += debris.stats.instanceMs;
+		if (debris.count < count)
+			spawnDebrisBurst(debris, vec3(0.0f, 5.0f, 0.0f), vec3(0.9f, 4.0f, 0.0f), count - debris.count, 2.0f, seed++);
+		benchmark::DoNotOptimize(&debris.instances[0]);
+	}
+	stopJobs(jobs);
+	const double iterations = (double)state.iterations();
+	state.counters["integrate_ms"] = integrateMs / iterations;
+	state.counters["compact_ms"] = compactMs / iterations;
+	state.counters["instance_ms"] = instanceMs / iterations;
+	state.SetItemsProcessed(state.iterations() * count);
+}
+BENCHMARK(BM_DebrisStep)->Args({ 1000, 1 })->Args({ 10000, 1 })->Args({ 50000, 1 })
+	->Args({ 50000, 2 })->Args({ 50000, 4 })->Args({ 50000, 8 })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// 배기 입자 : 최대 추력으로 N 개 근처를 유지하며 한 틱씩 진행하고 인스턴스 데이터를 쓴다.
+// 두번째 인자는 워커 수, 세번째는 SSE (1) / 스칼라 (0). 갱신과 인스턴스 쓰기 시간을 따로 센다.
+static void BM_ParticleStep(benchmark::State & state){
+	const int capacity = (int)state.range(0);
+	const int threads = (int)state.range(1);
+	ParticleSystem particles;
+	initParticles(particles, capacity);
+	particles.simd = particles.simd && state.range(2) == 1;
+	FlightState flight;
+	initFlight(flight);
+	launchFlight(flight);
+	flight.main = 2.2f;
+	JobSystem jobs;
+	startJobs(jobs, threads);
+	std::vector<float> instances((size_t)capacity * PARTICLE_INSTANCE_FLOATS);
+	// 살아있는 수가 일정해질 때까지 먼저 돌린다 (연기 수명 5 초)
+	for (int t = 0; t < 400; t++) {
+		emitExhaust(particles, flight, vec3(0.9f, 0.0f, 0.0f), FLIGHT_TICK);
+		stepParticles(particles, FLIGHT_TICK, &jobs);
+	}
+	double updateMs = 0, instanceMs = 0;
+	for (auto _ : state) {
+		emitExhaust(particles, flight, vec3(0.9f, 0.0f, 0.0f), FLIGHT_TICK);
+		stepParticles(particles, FLIGHT_TICK, &jobs);
+		writeParticleInstances(particles, &instances[0], capacity, &jobs);
+		updateMs += particles.stats.emitMs + particles.stats.updateMs + particles.stats.compactMs;
+		instanceMs += particles.stats.instanceMs;
+		benchmark::DoNotOptimize(&instances[0]);
+	}
+	stopJobs(jobs);
+	const double iterations = (double)state.iterations();
+	state.counters["live"] = particles.count;
+	state.counters["update_ms"] = updateMs / iterations;
+	state.counters["instance_ms"] = instanceMs / iterations;
+	state.SetItemsProcessed(state.iterations() * particles.count);
+}
+BENCHMARK(BM_ParticleStep)->Args({ 100000, 1, 1 })->Args({ 1000000, 1, 0 })->Args({ 1000000, 1, 1 })
+	->Args({ 1000000, 2, 1 })->Args({ 1000000, 4, 1 })->Args({ 1000000, 8, 1 })->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// 무거운 장면의 한 프레임을 Rocket.cpp 와 같은 단계 (시뮬레이션 -> 변환 -> 컬링 -> 명령) 의 잡으로 돌린다.
+// 로켓 R 개 (노드 15 개씩) + 충돌체 20000 개 + 잔해 50000 개. 인자는 워커 수.
+// utilization 은 워커들이 잡을 실행한 비율, critical_ms 는 코어가 무한히 많을 때의 프레임 시간.
+struct BenchFrame {
+	JobSystem * jobs;
+	CollisionWorld * world;
+	std::vector<int> * bodies;
+	DebrisSystem * debris;
+	SceneGraph * scene;
+	std::vector<int> * rockets;
+	std::vector<vec3> * nodeMin;
+	std::vector<vec3> * nodeMax;
+	std::vector<glm::mat4> * MVP;
+	std::vector<unsigned char> * visible;
+	std::vector<int> * commands;
+	glm::mat4 VP;
+	Frustum frustum;
+	int tick;
+	int commandCount;
+};
+
+static void benchSimulate(void * context, int, int){
+	BenchFrame & f = *(BenchFrame *)context;
+	std::vector<int> & bodies = *f.bodies;
+	for (size_t i = 0; i < bodies.size(); i++) {
+		vec3 p = f.world->position[bodies[i]];
+		p.y = p.y > 0.0f ? p.y - 0.05f : 30.0f;
+		setBodyPosition(*f.world, bodies[i], p);
+	}
+	stepCollision(*f.world, f.jobs);
+	stepDebris(*f.debris, FLIGHT_TICK, &f.world->terrain, f.jobs);
+	if (f.debris->count < f.debris->capacity)
+		spawnDebrisBurst(*f.debris, vec3(0.0f, 5.0f, 0.0f), vec3(0.9f, 4.0f, 0.0f),
+			f.debris->capacity - f.debris->count, 2.0f, (uint32_t)f.tick + 2);
+	f.tick++;
+}
+
+static void benchTransform(void * context, int, int){
+	BenchFrame & f = *(BenchFrame *)context;
+	std::vector<int> & rockets = *f.rockets;
+	for (size_t r = 0; r < rockets.size(); r++) {
+		float a = f.tick * 0.01f + r;
+		setLocalTransform(*f.scene, rockets[r], translate(mat4(), vec3(r % 64 * 3.0f - 96.0f, 10.0f + 5.0f * sinf(a), r / 64 * 3.0f - 96.0f)));
+	}
+	updateWorldTransforms(*f.scene);
+	computeSceneMVP(*f.scene, f.VP, &(*f.MVP)[0]);
+}
+
+static void benchCullNodes(void * context, int, int){
+	BenchFrame & f = *(BenchFrame *)context;
+	cullSceneNodes(*f.scene, &(*f.nodeMin)[0], &(*f.nodeMax)[0], f.frustum, &(*f.visible)[0]);
+}
+
+static void benchCullDebris(void * context, int, int){
+	BenchFrame & f = *(BenchFrame *)context;
+	fillDebrisInstances(*f.debris, &f.frustum, f.jobs);
+}
+
+static void benchCommands(void * context, int, int){
+	BenchFrame & f = *(BenchFrame *)context;
+	int n = 0;
+	for (size_t i = 0; i < f.visible->size(); i++)
+		if ((*f.visible)[i])
+			(*f.commands)[n++] = (int)i;
+	f.commandCount = n;
+}
+
+static void BM_FrameJobs(benchmark::State & state){
+	const int workers = (int)state.range(0);
+	const int rocketCount = 4096;
+	JobSystem jobs;
+	startJobs(jobs, workers);
+	CollisionWorld world;
+	initCollisionWorld(world, 2.0f);
+	setFlatTerrain(world, -100.0f, -100.0f, 100.0f, 100.0f, 1.0f, 0.0f);
+	srand(1);
+	std::vector<int> bodies(20000);
+	for (size_t i = 0; i < bodies.size(); i++) {
+		vec3 p(rand() % 20000 * 0.01f - 100.0f, rand() % 3000 * 0.01f, rand() % 20000 * 0.01f - 100.0f);
+		bodies[i] = addBoxBody(world, p - vec3(0.3f), p + vec3(0.3f), false);
+	}
+	DebrisSystem debris;
+	initDebris(debris, 50000);
+	spawnDebrisBurst(debris, vec3(0.0f, 5.0f, 0.0f), vec3(0.9f, 4.0f, 0.0f), 50000, 2.0f, 1);
+	// 로켓마다 루트 + 부품 14 개 (Rocket.cpp 의 장면 그래프와 같은 수)
+	SceneGraph scene;
+	initSceneGraph(scene, rocketCount * 15);
+	std::vector<int> rockets(rocketCount);
+	std::vector<vec3> nodeMin, nodeMax;
+	for (int r = 0; r < rocketCount; r++) {
+		rockets[r] = addSceneNode(scene, -1, glm::mat4(1.0f));
+		nodeMin.push_back(vec3(1.0f));
+		nodeMax.push_back(vec3(-1.0f));
+		for (int p = 0; p < 14; p++) {
+			addSceneNode(scene, rockets[r], translate(mat4(), vec3(0.0f, p * 0.2f, 0.0f)));
+			nodeMin.push_back(vec3(0.0f));
+			nodeMax.push_back(vec3(1.0f));
+		}
+	}
+	std::vector<glm::mat4> MVP(scene.parent.size());
+	std::vector<unsigned char> visible(scene.parent.size());
+	std::vector<int> commands(scene.parent.size());
+	BenchFrame frame;
+	frame.jobs = &jobs;
+	frame.world = &world;
+	frame.bodies = &bodies;
+	frame.debris = &debris;
+	frame.scene = &scene;
+	frame.rockets = &rockets;
+	frame.nodeMin = &nodeMin;
+	frame.nodeMax = &nodeMax;
+	frame.MVP = &MVP;
+	frame.visible = &visible;
+	frame.commands = &commands;
+	frame.VP = glm::perspective(glm::radians(45.0f), 4.0f / 3.0f, 0.1f, 100.0f) *
+		glm::lookAt(vec3(0.0f, 20.0f, 60.0f), vec3(0.0f, 5.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+	extractFrustum(frame.VP, frame.frustum);
+	frame.tick = 0;
+	double criticalMs = 0, utilization = 0;
+	double stageMs[4] = { 0, 0, 0, 0 };
+	for (auto _ : state) {
+		beginJobFrame(jobs);
+		JobCounter stage;
+		initCounter(stage);
+		runJob(jobs, benchSimulate, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "sim");
+		initCounter(stage);
+		runJob(jobs, benchTransform, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "transform");
+		initCounter(stage);
+		runJob(jobs, benchCullNodes, &frame, 0, 0, &stage);
+		runJob(jobs, benchCullDebris, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "cull");
+		initCounter(stage);
+		runJob(jobs, benchCommands, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "commands");
+		endJobFrame(jobs);
+		criticalMs += jobs.frame.criticalMs;
+		utilization += jobs.frame.utilization;
+		for (int i = 0; i < 4; i++)
+			stageMs[i] += jobs.frame.stages[i].wallMs;
+		benchmark::DoNotOptimize(frame.commandCount);
+	}
+	stopJobs(jobs);
+	const double iterations = (double)state.iterations();
+	state.counters["critical_ms"] = criticalMs / iterations;
+	state.counters["utilization"] = utilization / iterations;
+	state.counters["sim_ms"] = stageMs[0] / iterations;
+	state.counters["transform_ms"] = stageMs[1] / iterations;
+	state.counters["cull_ms"] = stageMs[2] / iterations;
+	state.counters["commands_ms"] = stageMs[3] / iterations;
+	state.counters["visible"] = frame.commandCount + debris.stats.visible;
+}
+BENCHMARK(BM_FrameJobs)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->Arg(16)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// 지금처럼 배열마다 버퍼를 만들고 GL_STATIC_DRAW 로 올리는 경우. 장면 N 개 분량.
+static void BM_UploadStatic(benchmark::State & state){
+	if (window == NULL) {
+		state.SkipWithError("OpenGL context not available");
+		return;
+	}
+	const int count = (int)state.range(0);
+	std::vector<GLuint> buffers(count * sceneArrayCount);
+	for (auto _ : state) {
+		glGenBuffers((GLsizei)buffers.size(), &buffers[0]);
+		for (int n = 0; n < count; n++) {
+			for (int i = 0; i < sceneArrayCount; i++) {
+				glBindBuffer(GL_ARRAY_BUFFER, buffers[n * sceneArrayCount + i]);
+				glBufferData(GL_ARRAY_BUFFER, sceneArrays[i].size, sceneArrays[i].data, GL_STATIC_DRAW);
+			}
+		}
+		glFinish();
+		glDeleteBuffers((GLsizei)buffers.size(), &buffers[0]);
+	}
+	state.SetBytesProcessed(state.iterations() * count * sceneBytes());
+}
+BENCHMARK(BM_UploadStatic)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+
+// 버퍼 하나를 orphan 하고 GL_STREAM_DRAW 로 이어붙여 올리는 경우
+static void BM_UploadStream(benchmark::State & state){
+	if (window == NULL) {
+		state.SkipWithError("OpenGL context not available");
+		return;
+	}
+	const int count = (int)state.range(0);
+	const GLsizeiptr total = count * sceneBytes();
+	GLuint buffer;
+	glGenBuffers(1, &buffer);
+	glBindBuffer(GL_ARRAY_BUFFER, buffer);
+	for (auto _ : state) {
+		glBufferData(GL_ARRAY_BUFFER, total, NULL, GL_STREAM_DRAW);  //orphan
+		GLintptr offset = 0;
+		for (int n = 0; n < count; n++) {
+			for (int i = 0; i < sceneArrayCount; i++) {
+				glBufferSubData(GL_ARRAY_BUFFER, offset, sceneArrays[i].size, sceneArrays[i].data);
+				offset += sceneArrays[i].size;
+			}
+		}
+		glFinish();
+	}
+	glDeleteBuffers(1, &buffer);
+	state.SetBytesProcessed(state.iterations() * total);
+}
+BENCHMARK(BM_UploadStream)->RangeMultiplier(4)->Range(1, 256)->UseRealTime();
+
+// 잔해 인스턴스 N 개를 매 프레임 올리는 방법 비교. 두번째 인자 0 = glBufferData, 1 = orphan, 2 = persistent 매핑.
+static void BM_StreamInstances(benchmark::State & state){
+	if (window == NULL) {
+		state.SkipWithError("OpenGL context not available");
+		return;
+	}
+	const int count = (int)state.range(0);
+	const int mode = (int)state.range(1);
+	const GLsizeiptr bytes = (GLsizeiptr)count * DEBRIS_INSTANCE_FLOATS * sizeof(float);
+	if (mode == 2 && !GLEW_ARB_buffer_storage) {
+		state.SkipWithError("ARB_buffer_storage not available");
+		return;
+	}
+	DebrisSystem debris;
+	initDebris(debris, count);
+	spawnDebrisBurst(debris, vec3(0.0f, 5.0f, 0.0f), vec3(0.9f, 4.0f, 0.0f), count, 2.0f, 1);
+	cullDebrisInstances(debris, NULL, NULL);
+	StreamBuffer stream;
+	GLuint buffer = 0;
+	if (mode == 0)
+		glGenBuffers(1, &buffer);
+	else
+		initStreamBuffer(stream, GL_ARRAY_BUFFER, bytes, mode == 2);
+	double fenceWaitMs = 0;
+	for (auto _ : state) {
+		if (mode == 0) {
+			writeDebrisInstances(debris, &debris.instances[0], count, NULL);
+			glBindBuffer(GL_ARRAY_BUFFER, buffer);
+			glBufferData(GL_ARRAY_BUFFER, bytes, &debris.instances[0], GL_STREAM_DRAW);
+		}
+		else {
+			beginStreamFrame(stream);
+			GLsizeiptr offset;
+			float * out = (float *)streamAlloc(stream, bytes, &offset);
+			writeDebrisInstances(debris, out, count, NULL);
+			streamFlush(stream);
+			endStreamFrame(stream);
+			fenceWaitMs += stream.stats.fenceWaitMs;
+		}
+		glFlush();
+	}
+	glFinish();
+	if (mode == 0)
+		glDeleteBuffers(1, &buffer);
+	else
+		freeStreamBuffer(stream);
+	state.counters["fence_wait_ms"] = fenceWaitMs / (double)state.iterations();
+	state.SetBytesProcessed(state.iterations() * bytes);
+}
+BENCHMARK(BM_StreamInstances)->Args({ 20000, 0 })->Args({ 20000, 1 })->Args({ 20000, 2 })->UseRealTime();
+
+// HUD 정점 만들기 : Rocket.cpp 의 HUD 와 비슷한 양 (그래프 + 글자 아홉 줄) 을 쓴다. 목표는 0.2 ms 보다 훨씬 아래.
+static void BM_HudBuild(benchmark::State & state){
+	Hud hud;
+	hud.scale = 2;
+	hud.frameIndex = 0;
+	for (int i = 0; i < HUD_GRAPH_SAMPLES; i++)
+		hud.frameMs[i] = 10.0f + (i * 7 % 13);
+	std::vector<HudVertex> vertices(16384);
+	for (auto _ : state) {
+		beginHud(hud, &vertices[0], (int)vertices.size(), 1024, 768);
+		const float line = hudLineHeight(hud);
+		float y = 16.0f;
+		hudRect(hud, 8.0f, 8.0f, 640.0f, 256.0f, HUD_RGBA(0, 0, 0, 110));
+		hudPrintf(hud, 16.0f, y, 0xffffffff, "FRAME %6.2f ms %4.0f fps  cpu %5.2f crit %5.2f", 16.67, 60.0, 2.31, 1.08);
+		y += line;
+		hudFrameGraph(hud, 16.0f, y, HUD_GRAPH_SAMPLES * 3.0f, 60.0f, 1000.0f / 30.0f, 1000.0f / 60.0f);
+		y += 68.0f;
+		for (int i = 0; i < 8; i++) {
+			hudPrintf(hud, 16.0f, y, 0xffffffff, "LINE%d %d calls  %d triangles  %.2f ms", i, 17 + i, 123456 + i, 0.42);
+			y += line;
+		}
+		benchmark::DoNotOptimize(&vertices[0]);
+	}
+	state.counters["vertices"] = hud.count;
+	state.SetBytesProcessed(state.iterations() * hud.count * sizeof(HudVertex));
+}
+BENCHMARK(BM_HudBuild);
+
+// 매 프레임 부르는 카메라 계산
+static void BM_ComputeMatricesFromInputs(benchmark::State & state){
+	if (window == NULL) {
+		state.SkipWithError("OpenGL context not available");
+		return;
+	}
+	for (auto _ : state) {
+		computeMatricesFromInputs();
+		glm::mat4 ViewMatrix = getViewMatrix();
+		benchmark::DoNotOptimize(ViewMatrix);
+	}
+}
+BENCHMARK(BM_ComputeMatricesFromInputs);
+
+// 1080p 프레임 하나를 그리는 데 녹화가 렌더 스레드에 얹는 비용. 인자 0 = 녹화 끔, 1 = 켬.
+static void BM_CaptureFrame(benchmark::State & state){
+	if (window == NULL) {
+		state.SkipWithError("OpenGL context not available");
+		return;
+	}
+	const int width = 1920, height = 1080;
+	GLuint framebuffer, colorRenderbuffer;
+	glGenFramebuffers(1, &framebuffer);
+	glGenRenderbuffers(1, &colorRenderbuffer);
+	glBindRenderbuffer(GL_RENDERBUFFER, colorRenderbuffer);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorRenderbuffer);
+	glViewport(0, 0, width, height);
+
+	FrameCapture capture;
+	if (state.range(0) == 1 && !startCapture(capture, "bench_capture.y4m", width, height, 60, CAPTURE_Y4M)) {
+		state.SkipWithError("could not open capture file");
+		return;
+	}
+	int frame = 0;
+	for (auto _ : state) {
+		glClearColor((frame++ % 60) / 60.0f, 0.0f, 0.0f, 1.0f);
+		glClear(GL_COLOR_BUFFER_BIT);
+		captureFrame(capture, width, height);
+		glFlush();
+	}
+	if (capture.active) {
+		state.counters["dropped"] = capture.framesDropped;
+		stopCapture(capture);
+		remove("bench_capture.y4m");
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glDeleteRenderbuffers(1, &colorRenderbuffer);
+	glDeleteFramebuffers(1, &framebuffer);
+}
+BENCHMARK(BM_CaptureFrame)->Arg(0)->Arg(1)->UseRealTime();
+
+// 벤치마크용 텔레메트리 버퍼. 처음 쓸 때 만들고 프로그램이 끝날 때 지운다.
+struct BenchTelemetry {
+	TelemetryPublisher publisher;
+	bool ok;
+	BenchTelemetry(){ ok = openTelemetryPublisher(publisher, "/rocket_telemetry_bench", 4096); }
+	~BenchTelemetry(){ closeTelemetryPublisher(publisher, "/rocket_telemetry_bench"); }
+};
+static BenchTelemetry & benchTelemetry(){
+	static BenchTelemetry telemetry;
+	return telemetry;
+}
+
+// 쓰는 쪽 처리량 (읽는 쪽 없음)
+static void BM_TelemetryPublish(benchmark::State & state){
+	BenchTelemetry & telemetry = benchTelemetry();
+	if (!telemetry.ok) {
+		state.SkipWithError("shared memory not available");
+		return;
+	}
+	TelemetrySample sample;
+	memset(&sample, 0, sizeof(sample));
+	for (auto _ : state) {
+		sample.y += 0.01f;
+		publishTelemetry(telemetry.publisher, sample);
+	}
+	state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TelemetryPublish);
+
+// 0 번 스레드가 쓰고 나머지가 읽는다. 읽는 쪽은 쓴 시각부터 읽은 시각까지의 지연을 잰다.
+static void BM_TelemetryReaders(benchmark::State & state){
+	BenchTelemetry & telemetry = benchTelemetry();
+	if (!telemetry.ok) {
+		state.SkipWithError("shared memory not available");
+		return;
+	}
+	TelemetrySample sample;
+	memset(&sample, 0, sizeof(sample));
+	if (state.thread_index() == 0) {
+		for (auto _ : state)
+			publishTelemetry(telemetry.publisher, sample);
+		state.SetItemsProcessed(state.iterations());
+		return;
+	}
+
+	TelemetryReader reader;
+	if (!openTelemetryReader(reader, "/rocket_telemetry_bench")) {
+		state.SkipWithError("could not open telemetry reader");
+		return;
+	}
+	double latency = 0;
+	double received = 0;
+	for (auto _ : state) {
+		if (readTelemetry(reader, sample) == TELEMETRY_OK) {
+			latency += (double)(telemetryNow() - sample.timeNs);
+			received++;
+		}
+	}
+	state.counters["latency_ns"] = benchmark::Counter(received > 0 ? latency / received : 0, benchmark::Counter::kAvgThreads);
+	state.counters["missed"] = benchmark::Counter((double)reader.missed, benchmark::Counter::kAvgThreads);
+	closeTelemetryReader(reader);
+}
+BENCHMARK(BM_TelemetryReaders)->ThreadRange(2, 8)->UseRealTime();
+
+// GL 벤치마크를 위해 보이지 않는 창을 하나 만든다. 실패하면 GL 벤치마크만 건너뛴다.
+static void initContext(){
+	if (!glfwInit()) {
+		fprintf(stderr, "Failed to initialize GLFW, skipping OpenGL benchmarks\n");
+		return;
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	window = glfwCreateWindow(1024, 768, "Rocket benchmark", NULL, NULL);
+	if (window == NULL) {
+		fprintf(stderr, "Failed to open GLFW window, skipping OpenGL benchmarks\n");
+		return;
+	}
+	glfwMakeContextCurrent(window);
+	glewExperimental = true; // Needed for core profile
+	if (glewInit() != GLEW_OK) {
+		fprintf(stderr, "Failed to initialize GLEW, skipping OpenGL benchmarks\n");
+		glfwDestroyWindow(window);
+		window = NULL;
+	}
+}
+
+int main(int argc, char ** argv){
+	// --benchmark_out 이 없으면 JSON 결과 파일을 기본으로 남긴다.
+	std::vector<char *> args(argv, argv + argc);
+	bool hasOut = false;
+	for (int i = 1; i < argc; i++) {
+		if (strncmp(argv[i], "--benchmark_out=", 16) == 0)
+			hasOut = true;
+	}
+	static char defaultOut[] = "--benchmark_out=rocket_bench.json";
+	static char defaultFormat[] = "--benchmark_out_format=json";
+	if (!hasOut) {
+		args.push_back(defaultOut);
+		args.push_back(defaultFormat);
+	}
+	int count = (int)args.size();
+
+	benchmark::Initialize(&count, &args[0]);
+	if (benchmark::ReportUnrecognizedArguments(count, &args[0]))
+		return 1;
+
+	initContext();
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	glfwTerminate();
+	return 0;
+}
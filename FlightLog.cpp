@@ -0,0 +1,222 @@
+// 비행 기록 파일 (flightlog.hpp) 도구.
+// 사용법 : FlightLog generate 파일 [비행수] [스레드수]   비행 모델로 발사를 여러 번 돌려서 기록한다
+//          FlightLog info 파일                          블록, 비행 수, 압축률
+//          FlightLog read 파일 비행 [시작틱] [끝틱]      구간을 CSV 로 출력
+//          FlightLog bench 파일                         전체 풀기와 구간 읽기 속도 (SSE / 스칼라)
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <thread>
+
+#include "flight.hpp"
+#include "telemetry.hpp"
+#include "flightlog.hpp"
+#include "jobs.hpp"
+
+#define GENERATE_MAX_TICKS 20000      // 내려오지 않는 비행은 여기서 끊는다
+#define GENERATE_REST_TICKS 120       // 착지한 뒤에도 조금 더 기록한다
+
+static double nowSeconds(){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t hashFlight(uint32_t x){
+	x ^= x >> 16;
+	x *= 0x7FEB352Du;
+	x ^= x >> 15;
+	x *= 0x846CA68Bu;
+	x ^= x >> 16;
+	return x;
+}
+
+struct GenerateContext {
+	FlightLogWriter * writer;
+};
+
+// 비행마다 발사 시각과 낙하산 시각을 다르게 한다. 일부는 낙하산 없이 공중에 멈춘다.
+static void generateFlights(void * data, int begin, int end){
+	GenerateContext * context = (GenerateContext *)data;
+	FlightLogTrack track;
+	for (int i = begin; i < end; i++) {
+		uint32_t seed = hashFlight((uint32_t)i + 1);
+		int launchTick = 30 + (int)(seed % 240);
+		int parachuteTick = (seed >> 8) % 16 == 0 ? -1 : launchTick + 60 + (int)((seed >> 12) % 1200);
+		FlightState f;
+		initFlight(f);
+		beginFlightTrack(track, (uint32_t)i, 0);
+		int landed = -1;
+		for (int tick = 0; tick < GENERATE_MAX_TICKS; tick++) {
+			if (tick == launchTick)
+				launchFlight(f);
+			if (tick == parachuteTick)
+				deployParachute(f);
+			updateFlight(f, FLIGHT_TICK);
+			uint32_t flags = (f.start ? TELEMETRY_START : 0) | (f.sky ? TELEMETRY_SKY : 0) |
+				(f.suit ? TELEMETRY_SUIT : 0) | (f.main > 0.0f ? TELEMETRY_ENGINE : 0);
+			appendFlightTrack(*context->writer, track, f.gro1.x, f.gro1.y, f.gro1.z, f.velocity, flags);
+			if (landed < 0 && tick > launchTick && f.sky == 0)
+				landed = tick;
+			if (landed >= 0 && tick >= landed + GENERATE_REST_TICKS)
+				break;
+		}
+		finishFlightTrack(*context->writer, track);
+	}
+}
+
+static int generate(const char * path, int flights, int threads){
+	FlightLogWriter writer;
+	if (!openFlightLog(writer, path, NULL)) {
+		perror(path);
+		return -1;
+	}
+	JobSystem jobs;
+	startJobs(jobs, threads);
+	GenerateContext context;
+	context.writer = &writer;
+	double start = nowSeconds();
+	parallelFor(jobs, flights, 64, generateFlights, &context);
+	stopJobs(jobs);
+	FlightLogStats stats = writer.stats;
+	if (!closeFlightLog(writer)) {
+		fprintf(stderr, "%s : write failed\n", path);
+		return -1;
+	}
+	double seconds = nowSeconds() - start;
+	double raw = (double)stats.ticks * FLIGHTLOG_RAW_TICK_BYTES;
+	printf("%d flights, %llu ticks, %llu blocks in %.2f s\n", flights, (unsigned long long)stats.ticks,
+		(unsigned long long)stats.blocks, seconds);
+	printf("raw %.1f MB -> %.1f MB (%.1fx)\n", raw / 1e6, stats.encodedBytes / 1e6, raw / stats.encodedBytes);
+	const char * names[FLIGHTLOG_CHANNELS] = { "x", "y", "z", "velocity", "flags" };
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++)
+		printf("  %-9s %6.2f bits/tick  max error %g\n", names[c], stats.channelBytes[c] * 8.0 / stats.ticks, stats.maxError[c]);
+	return 0;
+}
+
+static int info(FlightLogReader & reader){
+	std::vector<uint32_t> flights;
+	listFlightLogFlights(reader, flights);
+	uint64_t ticks = 0;
+	for (size_t i = 0; i < reader.index.size(); i++)
+		ticks += reader.index[i].count;
+	printf("%zu flights, %zu blocks, %llu ticks, %.1f MB (%.1fx smaller than raw)\n", flights.size(), reader.index.size(),
+		(unsigned long long)ticks, reader.fileBytes / 1e6, reader.fileBytes > 0 ? (double)ticks * FLIGHTLOG_RAW_TICK_BYTES / reader.fileBytes : 0.0);
+	printf("step x %g  y %g  z %g  velocity %g\n", reader.header.step[FLIGHTLOG_X], reader.header.step[FLIGHTLOG_Y],
+		reader.header.step[FLIGHTLOG_Z], reader.header.step[FLIGHTLOG_VELOCITY]);
+	return 0;
+}
+
+static int readRange(FlightLogReader & reader, uint32_t flight, uint64_t from, uint64_t to){
+	FlightLogRange range;
+	int count = readFlightLogRange(reader, flight, from, to, range);
+	printf("tick,x,y,z,velocity,flags\n");
+	for (int i = 0; i < range.count; i++)
+		printf("%llu,%.4f,%.4f,%.4f,%.6f,%u\n", (unsigned long long)(range.startTick + i), range.x[i], range.y[i], range.z[i],
+			range.velocity[i], range.flags[i]);
+	if (count < 0) {
+		fprintf(stderr, "corrupt block after %d ticks\n", range.count);
+		return -1;
+	}
+	fprintf(stderr, "%d ticks from %llu blocks\n", count, (unsigned long long)reader.blocksRead);
+	return 0;
+}
+
+// 파일 읽기를 빼고 재기 위해 블록을 모두 메모리에 올려 두고 푼다
+static int bench(FlightLogReader & reader){
+	std::vector<uint8_t> data;
+	std::vector<size_t> offsets;
+	uint64_t ticks = 0;
+	for (size_t i = 0; i < reader.index.size(); i++) {
+		const FlightLogBlockInfo & b = reader.index[i];
+		offsets.push_back(data.size());
+		data.resize(data.size() + b.size);
+		fseek(reader.file, (long)b.offset, SEEK_SET);
+		if (fread(&data[offsets.back()], 1, b.size, reader.file) != b.size) {
+			fprintf(stderr, "read failed\n");
+			return -1;
+		}
+		ticks += b.count;
+	}
+	if (ticks == 0)
+		return 0;
+	FlightLogRange out;
+	out.x.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.y.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.z.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.velocity.resize(FLIGHTLOG_BLOCK_TICKS);
+	out.flags.resize(FLIGHTLOG_BLOCK_TICKS);
+	std::vector<int32_t> scratch(FLIGHTLOG_CHANNELS * (FLIGHTLOG_BLOCK_TICKS + FLIGHTLOG_GROUP));
+	for (int simd = 1; simd >= 0; simd--) {
+		double best = 1e30;
+		for (int repeat = 0; repeat < 5; repeat++) {
+			double start = nowSeconds();
+			for (size_t i = 0; i < reader.index.size(); i++) {
+				int count = (int)reader.index[i].count;
+				if (!decodeFlightLogBlock(reader.header, &data[offsets[i]], reader.index[i].size, count, 0, count, &scratch[0], out, 0, simd != 0)) {
+					fprintf(stderr, "corrupt block %zu\n", i);
+					return -1;
+				}
+			}
+			double seconds = nowSeconds() - start;
+			if (seconds < best)
+				best = seconds;
+		}
+		printf("decode %-6s %.2f GB/s decoded (%.0f M ticks/s, %.2f GB/s compressed in)\n", simd ? "SSE" : "scalar",
+			ticks * FLIGHTLOG_RAW_TICK_BYTES / best / 1e9, ticks / best / 1e6, data.size() / best / 1e9);
+	}
+
+	// 아무 비행의 아무 300 틱 구간 (파일에서 읽기 포함)
+	std::vector<uint32_t> flights;
+	listFlightLogFlights(reader, flights);
+	const int queries = 2000;
+	uint64_t before = reader.blocksRead;
+	uint64_t decoded = 0;
+	double start = nowSeconds();
+	for (int i = 0; i < queries; i++) {
+		uint32_t seed = hashFlight((uint32_t)i);
+		uint32_t flight = flights[seed % flights.size()];
+		uint64_t from = (seed >> 8) % 1500;
+		if (readFlightLogRange(reader, flight, from, from + 300, out) < 0) {
+			fprintf(stderr, "corrupt block in flight %u\n", flight);
+			return -1;
+		}
+		decoded += out.count;
+	}
+	double seconds = nowSeconds() - start;
+	printf("range  %.1f us per query, %.2f blocks per query, %.1f ticks per query\n", seconds / queries * 1e6,
+		(double)(reader.blocksRead - before) / queries, (double)decoded / queries);
+	return 0;
+}
+
+int main(int argc, char ** argv)
+{
+	if (argc >= 3 && strcmp(argv[1], "generate") == 0) {
+		int flights = argc > 3 ? atoi(argv[3]) : 10000;
+		int threads = argc > 4 ? atoi(argv[4]) : (int)std::thread::hardware_concurrency();
+		return generate(argv[2], flights > 0 ? flights : 1, threads > 0 ? threads : 1);
+	}
+	if (argc < 3) {
+		fprintf(stderr, "usage: %s generate|info|read|bench file ...\n", argv[0]);
+		return -1;
+	}
+	FlightLogReader reader;
+	if (!openFlightLogReader(reader, argv[2])) {
+		fprintf(stderr, "%s : not a flight log\n", argv[2]);
+		return -1;
+	}
+	int result = -1;
+	if (strcmp(argv[1], "info") == 0)
+		result = info(reader);
+	else if (strcmp(argv[1], "read") == 0 && argc >= 4)
+		result = readRange(reader, (uint32_t)strtoul(argv[3], NULL, 10), argc > 4 ? strtoull(argv[4], NULL, 10) : 0,
+			argc > 5 ? strtoull(argv[5], NULL, 10) : UINT64_MAX);
+	else if (strcmp(argv[1], "bench") == 0)
+		result = bench(reader);
+	else
+		fprintf(stderr, "usage: %s generate|info|read|bench file ...\n", argv[0]);
+	closeFlightLogReader(reader);
+	return result;
+}
@@ -1,6 +1,11 @@
 // Include standard headers
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <thread>
+#include <algorithm>
 // Include GLEW
 #include <GL/glew.h>
 
@@ -17,12 +22,441 @@ GLFWwindow* window;
 using namespace glm;
 #include <common/controls.hpp>
 #include <glut.h>
-#include <common/shader.hpp>
 #include <common/texture.hpp>
+#include "mesh.hpp"
+#include "flight.hpp"
+#include "startup.hpp"
+#include "capture.hpp"
+#include "telemetry.hpp"
+#include "arena.hpp"
+#include "memory.hpp"
+#include "scene.hpp"
+#include "jobs.hpp"
+#include "collision.hpp"
+#include "debris.hpp"
+#include "streambuffer.hpp"
+#include "particles.hpp"
+#include "hud.hpp"
+#include "trajectory.hpp"
+#include "pacing.hpp"
+#include "input.hpp"
+#include "gpuresources.hpp"
+#include "views.hpp"
+#include "lighting.hpp"
+#include "sky.hpp"
+#include "resolution.hpp"
 #define GL_PI 3.1415f
 
+// 장면에서 그릴 것 하나. 노드의 world 행렬로 정점/색 버퍼를 그린다.
+struct DrawItem {
+	int node;
+	const mesh::MeshView * mesh;   // 정점 수와 컬링용 경계 상자
+	GpuId vertexBuffer;         // GL 이름은 그릴 때 useGpu 로 받는다 (예산을 넘으면 내려 갔다가 다시 올라온다)
+	GpuId colorBuffer;
+	GpuId normalBuffer;
+	int parachute;              // 1 이면 낙하산을 폈을 때만 그린다
+};
+
+// 그리기 명령. 잡에서 만들고 메인 스레드가 GL 로 실행한다.
+struct DrawCommand {
+	GpuId vertexBuffer;
+	GpuId colorBuffer;
+	GpuId normalBuffer;
+	GLsizei vertexCount;
+	const GLfloat * model;
+	unsigned char viewMask;     // 보이는 뷰의 비트. 뷰 수만큼 인스턴스로 그리고 나머지는 셰이더가 자른다.
+};
+
+// 한 프레임을 입력 -> 시뮬레이션 -> 변환 -> 컬링 -> 명령 만들기 단계의 잡으로 나눈다.
+// 단계 사이에는 카운터를 기다리므로 잡들은 이 구조체를 잠금 없이 같이 쓴다.
+struct FrameJobs {
+	JobSystem * jobs;
+	// 입력
+	int * close;
+	InputQueue * input;
+	InputEvent pendingInput[INPUT_QUEUE_SIZE];  // 큐에서 꺼냈지만 아직 틱에 적용하지 않은 키/버튼 이벤트 (시각 순)
+	int pendingInputCount;
+	uint32_t inputSeen;        // 지난 프레임까지 본 이벤트 수
+	bool inputActive;          // 이번 프레임에 키나 마우스 입력이 있었는지 (idle 판단)
+	int64_t frameNs;           // 이번 프레임을 시작한 시각 (jobNowNs)
+	int64_t tracedInputNs;     // 이번 프레임에 반영된 입력 중 가장 이른 것의 시각 (지연 측정)
+	int tracedInputs;
+	int hudToggles;            // 메인 스레드가 프레임 뒤에 처리할 것들 (누른 횟수)
+	int pacingSteps;
+	int captureToggles;
+	int viewSteps;
+	// 시뮬레이션
+	FlightState * flight;
+	double * simAccumulator;
+	int simTicks;
+	double simMs;
+	CollisionWorld * collision;
+	int rocketBody;
+	DebrisSystem * debris;
+	int debrisFragments;
+	const int * finNodes;
+	const vec3 * finCenters;
+	DebrisHandle * finDebris;
+	TelemetryPublisher * telemetry;
+	TrajectoryPrediction * prediction;
+	ParticleSystem * particles;
+	double particleMs;         // 이번 프레임 입자 방출 + 갱신 (모든 틱)
+	// 변환
+	SceneGraph * scene;
+	int rocketNode;
+	vec3 * rocketPosition;
+	int viewCount;             // 메인 스레드가 정한다 (V)
+	float aspect;              // 창의 가로/세로
+	ViewSet views;
+	// 컬링
+	const vec3 * nodeMin;
+	const vec3 * nodeMax;
+	unsigned char * visible;   // 노드마다 보이는 뷰의 비트
+	int visibleNodes;
+	StreamBuffer * debrisStream;
+	GLsizeiptr debrisOffset;   // 이번 프레임 인스턴스 데이터의 버퍼 안 위치
+	int debrisInstances;
+	StreamBuffer * particleStream;
+	GLsizeiptr particleOffset;
+	int particleInstances;
+	LightClusters * lights;    // 뷰마다의 클러스터에 빛을 나눠 담는다
+	// 명령
+	const DrawItem * items;
+	int itemCount;
+	DrawCommand * commands;
+	int commandCount;
+};
+
+// GLFW 는 메인 스레드에서만 부를 수 있으므로 이 단계는 메인에서 실행한다.
+// 키 이벤트는 콜백이 큐에 넣어 두었다. 프레임마다 큐를 모두 비워서 키/버튼 이벤트만 pendingInput 에 옮기고
+// (커서 이동은 틱이 쓰지 않으므로 버린다. 틱이 없는 프레임이 이어져도 커서 이동이 큐를 채워 키가 빠지지 않는다),
+// 시뮬레이션 틱이 그것을 시각 순으로 적용한다. 카메라 이동도 여기서 한다.
+static void readInput(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	uint32_t pushed = inputPushed(*f.input);
+	f.inputActive = pushed != f.inputSeen;
+	f.inputSeen = pushed;
+	InputEvent event;
+	while (popInput(*f.input, f.frameNs, event)) {
+		if (event.type == INPUT_MOUSE_MOVE)
+			continue;
+		if (f.pendingInputCount == INPUT_QUEUE_SIZE) {
+			f.input->dropped.fetch_add(1, std::memory_order_relaxed);
+			continue;
+		}
+		f.pendingInput[f.pendingInputCount++] = event;
+	}
+	computeMatricesFromInputs();
+}
+
+// 이벤트 하나를 적용한다. 누른 순간 (GLFW_PRESS) 만 보므로 누르고 있어도 한 번이다.
+// 화면에 보이는 상태를 바꾼 입력은 지연 측정에 올린다.
+static void applyInput(FrameJobs & f, const InputEvent & e){
+	if (e.type != INPUT_KEY || e.action != GLFW_PRESS)
+		return;
+	FlightState & flight = *f.flight;
+	bool changed = true;
+	switch (e.key) {
+	case GLFW_KEY_SPACE:  //spacebar 누르면출발
+		changed = flight.sky == 0;
+		launchFlight(flight);
+		break;
+	case GLFW_KEY_X:
+		changed = flight.suit == 0;
+		deployParachute(flight);
+		break;
+	case GLFW_KEY_C:
+		*f.close = *f.close == 0 ? 1 : 0;
+		break;
+	case GLFW_KEY_H: f.hudToggles++; break;
+	case GLFW_KEY_P: f.pacingSteps++; break;
+	case GLFW_KEY_F9: f.captureToggles++; break;
+	case GLFW_KEY_V: f.viewSteps++; break;
+	default: changed = false; break;
+	}
+	if (changed) {
+		if (f.tracedInputs == 0 || e.timeNs < f.tracedInputNs)
+			f.tracedInputNs = e.timeNs;
+		f.tracedInputs++;
+	}
+}
+
+// 엔진이 꺼지는 순간 단 분리. 날개 네 개는 다 쓴 단, 페어링 여섯 조각, 나머지는 파편.
+static void separateStage(FrameJobs & f){
+	FlightState & flight = *f.flight;
+	vec3 rocketVelocity(0.9f, 4 * flight.velocity, 0.0f);
+	for (int i = 0; i < 4; i++) {
+		DebrisSpawn spawn;
+		spawn.position = flight.gro1 + f.finCenters[i];
+		spawn.velocity = rocketVelocity * 0.8f + (f.finCenters[i] - vec3(0.5f, 0.5f, 0.5f)) * 1.5f;
+		spawn.angularVelocity = vec3(f.finCenters[i].z - 0.5f, 0.5f, 0.5f - f.finCenters[i].x) * 4.0f;
+		spawn.size = 1.0f;
+		spawn.life = 0.0f;
+		spawn.kind = DEBRIS_STAGE;
+		f.finDebris[i] = spawnDebris(*f.debris, spawn);
+		detachSceneNode(*f.scene, f.finNodes[i]);
+	}
+	for (int i = 0; i < 6; i++) {
+		float a = i * (2 * GL_PI / 6);
+		DebrisSpawn spawn;
+		spawn.position = flight.gro1 + vec3(0.5f + 0.4f * cosf(a), 2.5f, 0.5f + 0.4f * sinf(a));
+		spawn.velocity = rocketVelocity + vec3(cosf(a), 0.5f, sinf(a));
+		spawn.angularVelocity = vec3(sinf(a), 1.0f, -cosf(a)) * 6.0f;
+		spawn.size = 0.3f;
+		spawn.life = 30.0f;
+		spawn.kind = DEBRIS_FAIRING;
+		spawnDebris(*f.debris, spawn);
+	}
+	spawnDebrisBurst(*f.debris, flight.gro1 + vec3(0.5f, 0.0f, 0.5f), rocketVelocity * 0.5f, f.debrisFragments, 2.0f, 12345);
+}
+
+// 틱이 끝난 상태를 공유 메모리로 내보낸다 (틱마다 하나)
+static void publishFlight(FrameJobs & f){
+	const FlightState & flight = *f.flight;
+	TelemetrySample sample;
+	sample.x = flight.gro1.x;
+	sample.y = flight.gro1.y;
+	sample.z = flight.gro1.z;
+	sample.velocity = flight.velocity;
+	sample.thrust = flight.main;
+	sample.flags = (flight.start ? TELEMETRY_START : 0) | (flight.sky ? TELEMETRY_SKY : 0) |
+		(flight.suit ? TELEMETRY_SUIT : 0) | (flight.main > 0.0f ? TELEMETRY_ENGINE : 0);
+	sample.cameraMode = *f.close;
+	sample.padding = 0;
+	publishTelemetry(*f.telemetry, sample);
+}
+
+// 쌓인 시간만큼 고정 틱을 돌린다. 충돌과 잔해는 안에서 다시 잡으로 나뉜다.
+static void simulate(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	FlightState & flight = *f.flight;
+	int64_t start = jobNowNs();
+	f.simTicks = 0;
+	f.particleMs = 0.0;
+	while (*f.simAccumulator >= FLIGHT_TICK) {
+		*f.simAccumulator -= FLIGHT_TICK;
+		f.simTicks++;
+		// 이 틱이 끝나는 시각까지 들어온 입력을 순서대로 적용한다. 남은 것은 다음 틱으로.
+		int64_t tickNs = f.frameNs - (int64_t)(*f.simAccumulator * 1e9);
+		int applied = 0;
+		while (applied < f.pendingInputCount && f.pendingInput[applied].timeNs <= tickNs)
+			applyInput(f, f.pendingInput[applied++]);
+		if (applied > 0) {
+			f.pendingInputCount -= applied;
+			memmove(f.pendingInput, f.pendingInput + applied, f.pendingInputCount * sizeof(InputEvent));
+		}
+		bool engineOn = flight.main > 0.0f;
+		updateFlight(flight, FLIGHT_TICK);
+		if (engineOn && flight.main == 0.0f)
+			separateStage(f);
+		// 벽에 닿으면 가장 적게 겹친 방향으로 밀어내고, 바닥 밑으로 내려가면 바닥 위로 올린다
+		setBodyPosition(*f.collision, f.rocketBody, flight.gro1);
+		stepCollision(*f.collision, f.jobs);
+		for (size_t i = 0; i < f.collision->contacts.size(); i++) {
+			const Contact & contact = f.collision->contacts[i];
+			if (contact.a == f.rocketBody)
+				flight.gro1 += contact.normal * contact.depth;
+			else if (contact.b == f.rocketBody)
+				flight.gro1 -= contact.normal * contact.depth;
+		}
+		// 예측에서 벗어났을 때만 (발사, 낙하산, 벽에 밀림) 다시 계산한다
+		updatePrediction(*f.prediction, flight);
+		stepDebris(*f.debris, FLIGHT_TICK, &f.collision->terrain, f.jobs);
+		// 배기 : 추력이 있는 동안 노즐에서 나온다
+		emitExhaust(*f.particles, flight, vec3(0.9f, 4 * flight.velocity, 0.0f), FLIGHT_TICK);
+		stepParticles(*f.particles, FLIGHT_TICK, f.jobs);
+		f.particleMs += f.particles->stats.emitMs + f.particles->stats.updateMs + f.particles->stats.compactMs;
+		publishFlight(f);
+	}
+	f.simMs = (jobNowNs() - start) / 1e6;
+}
+
+static void updateTransforms(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	const FlightState & flight = *f.flight;
+	// 카메라들. 첫 번째 뷰는 C 로 고른 것 (자유 카메라 또는 로켓을 따라가는 카메라).
+	layoutViews(f.views, f.viewCount, *f.close == 0 ? VIEW_FREE : VIEW_CHASE);
+	computeViews(f.views, getViewMatrix(), getProjectionMatrix(), f.aspect, flight, *f.prediction);
+	// 로켓 노드만 옮기면 부품들은 따라온다. 움직이지 않았으면 다시 계산하지 않는다.
+	if (flight.gro1 != *f.rocketPosition) {
+		*f.rocketPosition = flight.gro1;
+		setLocalTransform(*f.scene, f.rocketNode, translate(mat4(), *f.rocketPosition));
+	}
+	// 떨어져 나간 날개는 잔해를 따라 움직인다
+	for (int i = 0; i < 4; i++) {
+		int d = findDebris(*f.debris, f.finDebris[i]);
+		if (d >= 0)
+			setLocalTransform(*f.scene, f.finNodes[i], debrisTransform(*f.debris, d) * translate(mat4(), -f.finCenters[i]));
+	}
+	// 뷰마다 VP 가 다르므로 MVP 는 만들지 않고 셰이더가 viewVP * model 을 곱한다
+	updateWorldTransforms(*f.scene);
+}
+
+static void cullNodes(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	f.visibleNodes = cullSceneNodesViews(*f.scene, f.nodeMin, f.nodeMax, f.views.frustum, f.views.count, f.visible);
+}
+
+static void cullDebris(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	// 보이는 것만 스트리밍 버퍼의 이번 프레임 구역에 바로 쓴다
+	const GLsizeiptr instanceBytes = DEBRIS_INSTANCE_FLOATS * sizeof(float);
+	int visible = cullDebrisViews(*f.debris, f.views.frustum, f.views.count, f.jobs);
+	int fit = (int)(streamAvailable(*f.debrisStream) / instanceBytes);
+	int count = visible < fit ? visible : fit;
+	f.debrisInstances = 0;
+	if (count == 0)
+		return;
+	float * out = (float *)streamAlloc(*f.debrisStream, count * instanceBytes, &f.debrisOffset);
+	f.debrisInstances = writeDebrisInstances(*f.debris, out, count, f.jobs);
+}
+
+// 빛 컬링. 안에서 다시 잡으로 나뉜다.
+static void binLights(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	buildLightClusters(*f.lights, f.views, f.jobs);
+}
+
+// 입자는 컬링하지 않고 모두 스트리밍 버퍼에 쓴다
+static void writeParticles(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	const GLsizeiptr instanceBytes = PARTICLE_INSTANCE_FLOATS * sizeof(float);
+	int fit = (int)(streamAvailable(*f.particleStream) / instanceBytes);
+	int count = f.particles->count < fit ? f.particles->count : fit;
+	f.particleInstances = 0;
+	if (count == 0)
+		return;
+	float * out = (float *)streamAlloc(*f.particleStream, count * instanceBytes, &f.particleOffset);
+	f.particleInstances = writeParticleInstances(*f.particles, out, count, f.jobs);
+}
+
+// 보이는 것만 그리기 순서대로 명령 목록에 넣는다
+static void buildCommands(void * context, int, int){
+	FrameJobs & f = *(FrameJobs *)context;
+	int n = 0;
+	for (int i = 0; i < f.itemCount; i++) {
+		const DrawItem & item = f.items[i];
+		if (!f.visible[item.node] || (item.parachute && f.flight->suit != 1))
+			continue;
+		DrawCommand & c = f.commands[n++];
+		c.vertexBuffer = item.vertexBuffer;
+		c.colorBuffer = item.colorBuffer;
+		c.normalBuffer = item.normalBuffer;
+		c.vertexCount = item.mesh->vertexCount;
+		c.model = &f.scene->world[item.node][0][0];
+		c.viewMask = f.visible[item.node];
+	}
+	f.commandCount = n;
+}
+
+// 이번 프레임에 센 것들. HUD 와 5 초마다의 출력에 쓴다.
+struct FrameCounters {
+	int drawCalls;             // HUD 자신은 빼고
+	int triangles;
+	float tickRate;            // 최근 1 초 동안의 시뮬레이션 틱 수
+	float frameMs;
+	const FramePacer * pacer;
+	const GpuResources * gpu;
+	const ResolutionController * resolution;
+	const SceneTarget * sceneTarget;
+};
+
+// 화면 왼쪽 위에 성능과 비행 상태를 쓴다. 메인 스레드에서 잡 프레임이 끝난 뒤 부른다.
+static void buildHud(Hud & hud, const FrameJobs & f, const JobSystem & jobs, const FrameCounters & c){
+	const uint32_t white = HUD_RGBA(235, 235, 235, 255);
+	const uint32_t dim = HUD_RGBA(150, 160, 175, 255);
+	const uint32_t warn = HUD_RGBA(255, 170, 60, 255);
+	const float line = hudLineHeight(hud);
+	const float graphWidth = HUD_GRAPH_SAMPLES * 3.0f;
+	const float graphHeight = 60.0f;
+	float x = 16.0f, y = 16.0f;
+	hudRect(hud, x - 8.0f, y - 8.0f, 640.0f, graphHeight + line * 14 + 16.0f, HUD_RGBA(0, 0, 0, 110));
+	hudPrintf(hud, x, y, c.frameMs > 1000.0f / 60.0f ? warn : white, "FRAME %6.2f ms %4.0f fps  cpu %5.2f crit %5.2f",
+		c.frameMs, c.frameMs > 0.0f ? 1000.0f / c.frameMs : 0.0f, jobs.frame.wallMs, jobs.frame.criticalMs);
+	y += line;
+	// 그래프 위쪽 끝은 33 ms, 흰 선은 60 Hz 예산
+	hudFrameGraph(hud, x, y, graphWidth, graphHeight, 1000.0f / 30.0f, 1000.0f / 60.0f);
+	y += graphHeight + 8.0f;
+	hudPrintf(hud, x, y, white, "SIM   %3.0f ticks/s  (%d this frame, %.2f ms)", c.tickRate, f.simTicks, f.simMs);
+	y += line;
+	hudPrintf(hud, x, y, white, "DRAW  %d calls  %d triangles  %d view%s  [V]", c.drawCalls, c.triangles,
+		f.views.count, f.views.count > 1 ? "s" : "");
+	y += line;
+	hudPrintf(hud, x, y, white, "CULL  parts %d/%d  debris %d/%d",
+		f.commandCount, f.itemCount, f.debrisInstances, f.debris->count);
+	y += line;
+	hudPrintf(hud, x, y, white, "PTCL  %d live  update %.2f ms", f.particles->count, f.particleMs);
+	y += line;
+	const LightingStats & lights = f.lights->stats;
+	hudPrintf(hud, x, y, lights.overflows > 0 ? warn : white, "LIGHT %d lights  %d in view  %d refs  max %d/cluster  bin %.2f ms",
+		(int)f.lights->lights.size(), lights.visible, lights.indices, lights.maxPerCluster, lights.boundsMs + lights.binMs);
+	y += line;
+	hudPrintf(hud, x, y, dim, "JOBS  %d workers %3.0f%% busy  %d jobs (%d stolen)",
+		jobs.workerCount, jobs.frame.utilization * 100.0, jobs.frame.jobs, jobs.frame.steals);
+	y += line;
+	const FramePacer & pacer = *c.pacer;
+	hudPrintf(hud, x, y, dim, "PACE  %s%s  jitter %.2f ms  cpu %3.0f%%  %3.0f wakeups/s  [P]",
+		pacingModeName(pacer.mode), pacer.idle ? " (idle)" : "", pacingStdDevMs(pacer.window),
+		pacingCpuPercent(pacer.window), pacingWakeupsPerSecond(pacer.window));
+	y += line;
+	const GpuResources & gpu = *c.gpu;
+	hudPrintf(hud, x, y, gpu.budget > 0 && gpu.residentBytes > gpu.budget ? warn : dim,
+		"GPU   %.0f KB (mesh %.0f stream %.0f)  budget %s  evicted %d reloaded %d",
+		gpu.residentBytes / 1024.0, gpu.bytes[GPU_MESH] / 1024.0, gpu.bytes[GPU_STREAM] / 1024.0,
+		gpu.budget > 0 ? "on" : "off", gpu.evictions, gpu.reloads);
+	y += line;
+	const ResolutionController & r = *c.resolution;
+	const SceneTarget & t = *c.sceneTarget;
+	hudPrintf(hud, x, y, r.lastMs > r.targetMs ? warn : dim, "RES   %dx%d (%3.0f%%)  msaa %dx  gpu %.2f / %.2f ms%s",
+		t.renderWidth, t.renderHeight, t.renderScale * 100.0f, t.samples, t.gpuMs, r.targetMs, r.enabled ? "" : "  fixed");
+	y += line;
+	const FlightState & flight = *f.flight;
+	hudPrintf(hud, x, y, white, "ALT   %7.2f   VEL %7.4f", flight.gro1.y, flight.velocity);
+	y += line;
+	hudPrintf(hud, x, y, flight.main > 0.0f ? warn : white, "ENGINE %s thrust %.4f  %s%s%s", flight.main > 0.0f ? "ON " : "OFF",
+		flight.main, flight.start ? "start " : "", flight.sky ? "sky " : "", flight.suit ? "parachute" : "");
+	y += line;
+	const TrajectoryPrediction & p = *f.prediction;
+	if (p.launched && p.lands)
+		hudPrintf(hud, x, y, dim, "PRED  apogee %.2f  range %.2f  land in %.1f s", p.apogee, p.downrange,
+			p.touchdownTick > p.tick ? (p.touchdownTick - p.tick) * FLIGHT_TICK : 0.0f);
+	else if (p.launched)
+		hudPrintf(hud, x, y, dim, "PRED  apogee %.2f  stalled, no landing", p.apogee);
+	else
+		hudText(hud, x, y, dim, "PRED  on the pad");
+	y += line;
+	hudPrintf(hud, x, y, dim, "HUD   %d verts  build %.3f  draw %.3f ms  [H]",
+		hud.count, hud.buildMs, hud.drawMs);
+}
+
+// 스트리밍 버퍼가 GPU 에 잡은 크기
+static GLsizeiptr streamBytes(const StreamBuffer & s){
+	return s.mode == STREAM_PERSISTENT ? s.regionSize * STREAM_REGIONS : s.regionSize;
+}
+
+// 입력이 오면 바로 깨면서 기다린다 (idle 일 때)
+static void waitForEvents(void *, double seconds){
+	glfwWaitEventsTimeout(seconds);
+}
+
 int main( void )
 {
+	// 셰이더 파일은 창을 만드는 동안 워커 스레드에서 읽는다
+	StartupPipeline startup;
+	beginStartup(startup, "TransformVertexShader.vertexshader", "LitFragmentShader.fragmentshader", "Views.vertexshader");
+	StartupPipeline debrisStartup;
+	beginStartup(debrisStartup, "DebrisVertexShader.vertexshader", "ColorFragmentShader.fragmentshader", "Views.vertexshader");
+	StartupPipeline particleStartup;
+	beginStartup(particleStartup, "ParticleVertexShader.vertexshader", "ParticleFragmentShader.fragmentshader", "Views.vertexshader");
+	StartupPipeline hudStartup;
+	beginStartup(hudStartup, "HudVertexShader.vertexshader", "HudFragmentShader.fragmentshader", NULL);
+	StartupPipeline skyStartup;
+	beginStartup(skyStartup, "SkyVertexShader.vertexshader", "SkyFragmentShader.fragmentshader", "Views.vertexshader");
+	StartupPipeline upscaleStartup;
+	beginStartup(upscaleStartup, "FullscreenVertexShader.vertexshader", "UpscaleFragmentShader.fragmentshader", NULL);
+	StartupPipeline loadStartup;
+	beginStartup(loadStartup, "FullscreenVertexShader.vertexshader", "LoadFragmentShader.fragmentshader", NULL);
+
 	// Initialise GLFW
 	if( !glfwInit() )
 	{
@@ -31,14 +465,15 @@ int main( void )
 		return -1;
 	}
 
-	glfwWindowHint(GLFW_SAMPLES, 4);
+	// MSAA 는 장면 대상 (resolution.hpp) 에서 한다. 창은 업스케일과 HUD 만 받는다.
+	glfwWindowHint(GLFW_SAMPLES, 0);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
 	glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE); // To make MacOS happy; should not be needed
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 	// Open a window and create its OpenGL context
-	window = glfwCreateWindow( 1024, 768, "Tutorial 04 - Colored Cube", NULL, NULL);
+	window = glfwCreateWindow( 1024, 768, "Rocket Launch", NULL, NULL);
 	if( window == NULL ){
 		fprintf( stderr, "Failed to open GLFW window. If you have an Intel GPU, they are not 3.3 compatible. Try the 2.1 version of the tutorials.\n" );
 		getchar();
@@ -63,6 +498,26 @@ int main( void )
 	// Set the mouse at the center of the screen
 	glfwPollEvents();
 	glfwSetCursorPos(window, 1024 / 2, 768 / 2);
+	// 키와 마우스는 콜백으로 받아서 시각을 붙여 큐에 넣는다
+	InputQueue inputQueue;
+	initInputQueue(inputQueue);
+	installInputCallbacks(window, inputQueue);
+
+	// 프레임 속도 조절. ROCKET_PACING=vsync|adaptive|limit|uncapped (기본 adaptive), ROCKET_FPS 는 limit 의 목표,
+	// ROCKET_IDLE=0 이면 멈춰 있어도 속도를 내리지 않는다. P 로 모드를 돌려 가며 비교할 수 있다.
+	FramePacer pacer;
+	PacingMode pacingMode = PACING_ADAPTIVE;
+	const char * pacingEnv = getenv("ROCKET_PACING");
+	if (pacingEnv != NULL && !parsePacingMode(pacingEnv, pacingMode))
+		fprintf(stderr, "Unknown ROCKET_PACING %s, using adaptive\n", pacingEnv);
+	const char * fpsEnv = getenv("ROCKET_FPS");
+	initPacer(pacer, pacingMode, fpsEnv != NULL ? atof(fpsEnv) : 60.0,
+		glfwExtensionSupported("WGL_EXT_swap_control_tear") || glfwExtensionSupported("GLX_EXT_swap_control_tear"));
+	const char * idleEnv = getenv("ROCKET_IDLE");
+	pacer.idleEnabled = idleEnv == NULL || atoi(idleEnv) != 0;
+	pacer.wait = waitForEvents;
+	int swapInterval = pacerSwapInterval(pacer);
+	glfwSwapInterval(swapInterval);
 
 	// Dark blue background
 	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
@@ -72,972 +527,460 @@ int main( void )
 	// Accept fragment if it closer to the camera than the former one
 	glDepthFunc(GL_LESS); 
 
+	// GPU 자원은 모두 여기에 맡긴다. ROCKET_GPU_BUDGET (KB) 를 주면 넘을 때 오래 안 쓴 메쉬부터 내린다.
+	const char * gpuBudgetEnv = getenv("ROCKET_GPU_BUDGET");
+	GpuResources gpu;
+	initGpuResources(gpu, gpuBudgetEnv != NULL ? (GLsizeiptr)atol(gpuBudgetEnv) * 1024 : 0);
+
 	GLuint VertexArrayID;
 	glGenVertexArrays(1, &VertexArrayID);
 	glBindVertexArray(VertexArrayID);
-
-	// Create and compile our GLSL program from the shaders
-	GLuint programID = LoadShaders( "TransformVertexShader.vertexshader", "ColorFragmentShader.fragmentshader");
-	// Get a handle for our "MVP" uniform
-	GLuint MatrixID = glGetUniformLocation(programID, "MVP");
-
-
-
-	
-	// Our vertices. Tree consecutive floats give a 3D vertex; Three consecutive vertices give a triangle.
-	// A cube has 6 faces with 2 triangles each, so this makes 6*2=12 triangles, and 12*3 vertices
-	static const GLfloat g_vertex_buffer_data[] = { 
-		1.0f,0.0f,0.0f,
-		1.0f,2.0f, 0.0f,
-		1.0f, 0.0f, 1.0f,
-		 1.0f, 0.0f,1.0f,
-		1.0f,2.0f,0.0f,
-		1.0f, 2.0f,1.0f,
-		 1.0f,2.0f, 0.0f,
-		0.0f,2.0f,0.0f,
-		 1.0f,2.0f,1.0f,
-		 0.0f, 2.0f,0.0f,
-		 0.0f,2.0f,1.0f,
-		1.0f,2.0f,1.0f,
-		0.0f,0.0f,0.0f,
-		0.0f, 2.0f, 0.0f,
-		0.0f, 0.0f,1.0f,
-		 0.0f,0.0f, 1.0f,
-		0.0f,2.0f, 0.0f,
-		0.0f,2.0f,1.0f,
-		1.0f, 0.0f, 0.0f,
-		0.0f,0.0f, 0.0f,
-		 1.0f,0.0f, 1.0f,
-		 0.0f, 0.0f, 0.0f,
-		 0.0f,0.0f,1.0f,
-		 1.0f, 0.0f,1.0f,
-		 1.0f,0.0f,0.0f,
-		 1.0f, 2.0f, 0.0f,
-		 0.0f,2.0f, 0.0f,
-		 1.0f, 0.0f, 0.0f,
-		 0.0f, 2.0f,0.0f,
-		0.0f, 0.0f,0.0f,
-		 1.0f, 0.0f, 1.0f,
-		1.0f, 2.0f,1.0f,
-		0.0f, 2.0f, 1.0f,
-		 1.0f, 0.0f, 1.0f,
-		0.0f, 2.0f, 1.0f,
-		 0.0f,0.0f, 1.0f
-	};
-
-	// One color for each vertex. They were generated randomly.
-	static const GLfloat g_color_buffer_data[] = { 
-		0.9,  0.9,  0.9,
-		0.7,  0.7,  0.7,
-		0.9,  0.9,  0.9,
-		0.7,  0.7,  0.7,
-		0.9,  0.9,  0.9,
-		0.7,  0.7,  0.7,
-		1,  1,  1,
-		1,  1,  1,
-		0.9,  0.9,  0.9,
-		1,  1,  1,
-		1,  1,  1,
-		0.9,  0.9,  0.9,
-		1,  1,  1,
-		1,  1,  1,
-		0.7,  0.7,  0.7,
-		1,  1,  1,
-		0.9,  0.9,  0.9,
-		1,  1,  1,
-		1,  1,  1,
-		0.7,  0.7,  0.7,
-		0.9,  0.9,  0.9,
-		1,  1,  1,
-		0.7,  0.7,  0.7,
-		1,  1,  1,
-		0.9,  0.9,  0.9,
-		1,  1,  1,
-		0.7,  0.7,  0.7,
-		1,  1,  1,
-		0.7,  0.7,  0.7,
-		0.9,  0.9,  0.9,
-		1,  1,  1,
-		1,  1,  1,
-		0.7,  0.7,  0.7,
-		1,  1,  1,
-		0.7,  0.7,  0.7,
-		1,  1,  1
-		/*0.583f,  0.771f,  0.014f,
-		0.609f,  0.115f,  0.436f,
-		0.327f,  0.483f,  0.844f,
-		0.822f,  0.569f,  0.201f,
-		0.435f,  0.602f,  0.223f,
-		0.310f,  0.747f,  0.185f,
-		0.597f,  0.770f,  0.761f,
-		0.559f,  0.436f,  0.730f,
-		0.359f,  0.583f,  0.152f,
-		0.483f,  0.596f,  0.789f,
-		0.559f,  0.861f,  0.639f,
-		0.195f,  0.548f,  0.859f,
-		0.014f,  0.184f,  0.576f,
-		0.771f,  0.328f,  0.970f,
-		0.406f,  0.615f,  0.116f,
-		0.676f,  0.977f,  0.133f,
-		0.971f,  0.572f,  0.833f,
-		0.140f,  0.616f,  0.489f,
-		0.997f,  0.513f,  0.064f,
-		0.945f,  0.719f,  0.592f,
-		0.543f,  0.021f,  0.978f,
-		0.279f,  0.317f,  0.505f,
-		0.167f,  0.620f,  0.077f,
-		0.347f,  0.857f,  0.137f,
-		0.055f,  0.953f,  0.042f,
-		0.714f,  0.505f,  0.345f,
-		0.783f,  0.290f,  0.734f,
-		0.722f,  0.645f,  0.174f,
-		0.302f,  0.455f,  0.848f,
-		0.225f,  0.587f,  0.040f,
-		0.517f,  0.713f,  0.338f,
-		0.053f,  0.959f,  0.120f,
-		0.393f,  0.621f,  0.362f,
-		0.673f,  0.211f,  0.457f,
-		0.820f,  0.883f,  0.371f,
-		0.982f,  0.099f,  0.879f*/
-	};
-	static const GLfloat headcolor[] = { 
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-		0.0f,0.0f,0.3f,
-		0.0f,0.1f,0.5f,
-	
-	
-	};
-	static const GLfloat wingcolor[] = {
-		0.8f,0.0f,0.0f,
-		0.6f,0.0f,0.0f,
-		0.8f,0.0f,0.0f,
-		0.6f,0.0f,0.0f,
-		0.8f,0.0f,0.0f,
-		0.6f,0.0f,0.0f,
-		0.8f,0.0f,0.0f,
-		0.6f,0.0f,0.0f,
-		0.8f,0.0f,0.0f,
-		0.6f,0.0f,0.0f,
-		0.8f,0.0f,0.0f,
-		0.6f,0.0f,0.0f,
-		0.8f,0.0f,0.0f,
-		0.6f,0.0f,0.0f
-
-	
-	
-	};
-	static const GLfloat floorcolor[] = {
-		0.9f, 0.6f, 0.2f,
-		0.9f, 0.6f, 0.2f,
-		0.9f, 0.6f, 0.2f,
-		0.9f, 0.6f, 0.2f,
-		0.9f, 0.6f, 0.2f,
-		0.9f, 0.6f, 0.2f,
-	};
-	static const GLfloat suit1color[] = {
-		1.0f,0.0f,0.0f,
-		1.0f,0.0f,0.0f,
-		1.0f,0.0f,0.0f,
-		1.0f,0.0f,0.0f,
-		1.0f,0.0f,0.0f,
-		1.0f,0.0f,0.0f,
-	};
-	static const GLfloat suit2color[] = {
-		0.7f,0.3f,0.0f,
-		0.7f,0.3f,0.0f,
-		0.7f,0.3f,0.0f,
-		0.7f,0.3f,0.0f,
-		0.7f,0.3f,0.0f,
-		0.7f,0.3f,0.0f
-	};
-	static const GLfloat suit3color[] = {
-		0.7f,0.7f,0.0f,
-		0.7f,0.7f,0.0f,
-		0.7f,0.7f,0.0f,
-		0.7f,0.7f,0.0f,
-		0.7f,0.7f,0.0f,
-		0.7f,0.7f,0.0f
-	};
-	static const GLfloat suit4color[] = {
-		0.0f,1.0f,0.0f,
-		0.0f,1.0f,0.0f,
-		0.0f,1.0f,0.0f,
-		0.0f,1.0f,0.0f,
-		0.0f,1.0f,0.0f,
-		0.0f,1.0f,0.0f
-	};
-	static const GLfloat suit5color[] = {
-		0.0f,0.0f,1.0f,
-		0.0f,0.0f,1.0f,
-		0.0f,0.0f,1.0f,
-		0.0f,0.0f,1.0f,
-		0.0f,0.0f,1.0f,
-		0.0f,0.0f,1.0f
-	};
-	static const GLfloat wing1[] = {
-		1.5f,0.0f,0.5f,
-		1.0f,0.0f, 0.0f,
-		1.0f, 0.0f, 1.0f,
-		 1.5f, 0.0f,0.5f,
-		1.0f,1.0f,0.5f,
-		1.0f, 0.0f,1.0f,
-		 1.0f,0.0f, 0.0f,
-		1.0f,1.0f,0.5f,
-		 1.5f,0.0f,0.5f,
-		 1.0f,0.0f,0.0f,
-		1.0f,0.0f,1.0f,
-		1.0f,1.0f,0.5f
-
-	};
-	static const GLfloat wing2[] = {
-		1.0f,0.0f,1.0f,
-		0.5f,0.0f, 1.5f,
-		0.0f, 0.0f, 1.0f,
-		 1.0f, 0.0f,1.0f,
-		0.5f,0.0f,1.5f,
-		0.5f, 1.0f,1.0f,
-		 0.0f,0.0f, 1.0f,
-		0.5f,0.0f,1.5f,
-		 0.5f,1.0f,1.0f,
-		 1.0f,0.0f,1.0f,
-		0.0f,0.0f,1.0f,
-		0.5f,1.0f,1.0f
-
-	};
-	static const GLfloat wing3[] = {
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f, 1.0f,
-		-0.5f, 0.0f, 0.5f,
-		 0.0f, 0.0f,1.0f,
-		-0.5f,0.0f,0.5f,
-		0.0f, 1.0f,0.5f,
-		 0.0f,0.0f, 0.0f,
-		-0.5f,0.0f,0.5f,
-		 0.0f,1.0f,0.5f,
-		 0.0f,0.0f,0.0f,
-		0.0f,0.0f,1.0f,
-		0.0f,1.0f,0.5f
-
-	};
-	static const GLfloat wing4[] = {
-		1.0f,0.0f,0.0f,
-		0.0f,0.0f, 0.0f,
-		0.5f, 1.0f, 0.0f,
-		 1.0f, 0.0f,0.0f,
-		0.5f,1.0f,0.0f,
-		0.5f, 0.0f,-0.5f,
-		 0.0f,0.0f, 0.0f,
-		0.5f,1.0f,0.0f,
-		 0.5f,0.0f,-0.5f,
-		 1.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.5f,0.0f,-0.5f
-
-	};
-	static const GLfloat head[] = {
-		1.0f,2.0f,0.0f,
-		0.0f,2.0f, 0.0f,
-		1.0f, 2.0f, 1.0f,
-		 0.0f, 2.0f,0.0f,
-		0.0f,2.0f,1.0f,
-		0.5f, 3.0f,0.5f,
-		 1.0f,2.0f, 1.0f,
-		0.0f,2.0f,1.0f,
-		 0.5f,3.0f,0.5f,
-		 1.0f,2.0f,1.0f,
-		1.0f,2.0f,0.0f,
-		0.5f,3.0f,0.5f,
-		0.0f,2.0f,0.0f,
-		0.0f,2.0f,1.0f,
-		0.5f,3.0f,0.5f,
-		1.0f,2.0f,0.0f,
-		0.0f,2.0f,0.0f,
-		0.5f,3.0f,0.5f
-	};
-	static const GLfloat floor[] = {
-		100.0f, 0.0f, -100.0f,
-		100.0f, 0.0f, 100.0f,
-		-100.0f, 0.0f, -100.0f,
-		-100.0f, 0.0f, -100.0f,
-		-100.0f, 0.0f, 100.0f,
-		100.0f, 0.0f, 100.0f
-	};
-	static const GLfloat suit3[] = {
-		0.2f,4.0f,0.0f,
-		0.6f,4.0f,1.0f,
-		0.6f,4.0f,0.0f,
-		0.2f,4.0f,0.0f,
-		0.2f,4.0f,1.0f,
-		0.6f,4.0f,1.0f
-	};
-	static const GLfloat suit4[] = {
-		0.6f,4.0f, 0.0f,
-		0.9f,3.8f,0.0f,
-		0.9f,3.8f,1.0f,
-		0.6f,4.0f,0.0f,
-		0.6f,4.0f,1.0f,
-		0.9f,3.8f,1.0f
-	};
-	static const GLfloat suit5[] = {
-		0.9f,3.8f,0.0f,
-		1.2f,3.5f,0.0f,
-		1.2f,3.5f,1.0f,
-		0.9f,3.8f,0.0f,
-		0.9f,3.8f,1.0f,
-		1.2f,3.5f,1.0f
-	};
-	static const GLfloat suit2[] = {
-		0.2f,4.0f, 0.0f,
-		-0.2f,3.8f,0.0f,
-		0.2f,4.0f,1.0f,
-		0.2f,4.0f,1.0f,
-		-0.2f,3.8f,0.0f,
-		-0.2f,3.8f,1.0f
-	};
-	static const GLfloat suit1[] = {
-		-0.2f,3.8f,0.0f,
-		-0.5f,3.5f,0.0f,
-		-0.5f,3.5f,1.0f,
-		-0.2f,3.8f,0.0f,
-		-0.2f,3.8f,1.0f,
-		-0.5f,3.5f,1.0f
-	};
-	static const GLfloat wall[] = {
-		100.0f,30.0f,-5.0f,
-		-100.0f,30.0f,-5.0f,
-		100.0f,0.0f,-5.0f,
-		100.0f,0.0f,-5.0f,
-		-100.0f,0.0f,-5.0f,
-		-100.0f,30.0f,-5.0f,
-
-		50.0f,30.0f,-5.0f,
-		50.0f,30.0f,100.0f,
-		50.0f,0.0f,-5.0f,
-		50.0f,30.0f,100.0f,
-		50.0f,0.0f,100.0f,
-		50.0f,0.0f,-5.0f,
-
-		-30.0f,30.0f,-5.0f,
-		-30.0f,30.0f,100.0f,
-		-30.0f,0.0f,-5.0f,
-		-30.0f,30.0f,100.0f,
-		-30.0f,0.0f,100.0f,
-		-30.0f,0.0f,-5.0f,
-
-		
-
-	};
-	static const GLfloat wallcolor[] = {
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-		0.5f,0.5f,1.0f,
-
-	};
-	static const GLfloat line[] = {
-		1.2f,3.5f,1.0f,
-		1.2f,3.5f,0.9f,
-		1.0f,2.0f,1.0f,
-		1.0f,2.0f,0.9f,
-		1.0f,2.0f,1.0f,
-		1.2f,3.5f,0.9f,
-
-		1.2f,3.5f,0.1f,
-		1.2f,3.5f,0.0f,
-		1.0f,2.0f,0.1f,
-		1.0f,2.0f,0.0f,
-		1.0f,2.0f,0.1f,
-		1.2f,3.5f,0.0f,
-
-		-0.5f,3.5f,1.0f,
-		-0.5f,3.5f,0.9f,
-		0.0f,2.0f,1.0f,
-		0.0f,2.0f,0.9f,
-		0.0f,2.0f,1.0f,
-		-0.5f,3.5f,0.9f,
-
-		-0.5f,3.5f,0.1f,
-		-0.5f,3.5f,0.0f,
-		0.0f,2.0f,0.1f,
-		0.0f,2.0f,0.0f,
-		0.0f,2.0f,0.1f,
-		-0.5f,3.5f,0.0f
-	};
-	static const GLfloat linecolor[] = {
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f,
-		0.0f,0.0f,0.0f
-	};
-	//몸통
-	GLuint vertexbuffer;  //이것이 우리의 버텍스 버퍼
-	glGenBuffers(1, &vertexbuffer);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_vertex_buffer_data), g_vertex_buffer_data, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	//몸통색깔
-	GLuint colorbuffer;
-	glGenBuffers(1, &colorbuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(g_color_buffer_data), g_color_buffer_data, GL_STATIC_DRAW);
-	//날개색깔
-	GLuint colorbuffer2;
-	glGenBuffers(1, &colorbuffer2);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer2);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wingcolor), wingcolor, GL_STATIC_DRAW);
-	//뚜껑색깔
-	GLuint colorbuffer3;
-	glGenBuffers(1, &colorbuffer3);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer3);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(headcolor), headcolor, GL_STATIC_DRAW);
-	//바닥색깔
-	GLuint colorbuffer4;
-	glGenBuffers(1, &colorbuffer4);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer4);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(floorcolor), floorcolor, GL_STATIC_DRAW);
-	//낙하산1 색깔
-	GLuint colorbuffer5;
-	glGenBuffers(1, &colorbuffer5);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer5);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit1color), suit1color, GL_STATIC_DRAW);
-	//낙하산2 색깔
-	GLuint colorbuffer6;
-	glGenBuffers(1, &colorbuffer6);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer6);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit2color), suit2color, GL_STATIC_DRAW);
-	//낙하산 3 색깔
-	GLuint colorbuffer7;
-	glGenBuffers(1, &colorbuffer7);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer7);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit3color), suit3color, GL_STATIC_DRAW);
-	//낙하산 4 색깔
-	GLuint colorbuffer8;
-	glGenBuffers(1, &colorbuffer8);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer8);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit4color), suit4color, GL_STATIC_DRAW);
-	//낙하산 5 색깔
-	GLuint colorbuffer9;
-	glGenBuffers(1, &colorbuffer9);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer9);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit5color), suit5color, GL_STATIC_DRAW);
-	//벽색깔
-	GLuint colorbuffer10;
-	glGenBuffers(1, &colorbuffer10);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer10);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wallcolor), wallcolor, GL_STATIC_DRAW);
-	//선색깔
-	GLuint colorbuffer11;
-	glGenBuffers(1, &colorbuffer11);
-	glBindBuffer(GL_ARRAY_BUFFER, colorbuffer11);
-	glBufferData(GL_ARRAY_BUFFER, sizeof(linecolor), linecolor, GL_STATIC_DRAW);
-
-	GLuint linebuffer;  //이것이 우리의 버텍스 버퍼2 날개용
-	glGenBuffers(1, &linebuffer);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, linebuffer); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(line), line, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer2;  //이것이 우리의 버텍스 버퍼2 날개용
-	glGenBuffers(1, &vertexbuffer2);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer2); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wing1), wing1, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-
-	GLuint vertexbuffer3;  //날개2
-	glGenBuffers(1, &vertexbuffer3);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer3); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wing2), wing2, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer4;  //날개3
-	glGenBuffers(1, &vertexbuffer4);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer4); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wing3), wing3, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer5;  //날개4
-	glGenBuffers(1, &vertexbuffer5);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer5); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wing4), wing4, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer6;  //뚜껑
-	glGenBuffers(1, &vertexbuffer6);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer6); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(head), head, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer7;  //바닥
-	glGenBuffers(1, &vertexbuffer7);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer7); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(floor), floor, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer8;  //낙하산1
-	glGenBuffers(1, &vertexbuffer8);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer8); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit1), suit1, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer9;  //낙하산2
-	glGenBuffers(1, &vertexbuffer9);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer9); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit2), suit2, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer10;  //낙하산3
-	glGenBuffers(1, &vertexbuffer10);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer10); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit3), suit3, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer11;  //낙하산4
-	glGenBuffers(1, &vertexbuffer11);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer11); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit4), suit4, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer12;  //낙하산5
-	glGenBuffers(1, &vertexbuffer12);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer12); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(suit5), suit5, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
-	GLuint vertexbuffer13;  //벽
-	glGenBuffers(1, &vertexbuffer13);  //버퍼를 하나 생성한다.
-	glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer13); //우리의 버텍스 버퍼에 대해서 다룬다.
-	glBufferData(GL_ARRAY_BUFFER, sizeof(wall), wall, GL_STATIC_DRAW); //우리의 버텍스를 opengl로 넘겨줌
+	GpuVertexArray vertexArray(gpu, VertexArrayID, GPU_STATE, 0, "scene VAO");
+
+	// 동적 해상도. ROCKET_FRAME_BUDGET 은 GPU 프레임 시간 목표 (ms, 기본은 ROCKET_FPS 의 한 프레임),
+	// ROCKET_MSAA 는 최대 샘플 수 (기본 4), ROCKET_DYNAMIC_RES=0 이면 배율 1 로 고정.
+	// ROCKET_LOAD_RAMP=초 를 주면 그 시간 동안 시험용 부하를 0 에서 ROCKET_LOAD_MAX (기본 400) 번까지 올렸다 내리고,
+	// 프레임마다의 배율을 ROCKET_RESOLUTION_LOG (기본 resolution.csv) 에 남긴다.
+	const char * budgetEnv = getenv("ROCKET_FRAME_BUDGET");
+	const char * msaaEnv = getenv("ROCKET_MSAA");
+	const char * dynamicEnv = getenv("ROCKET_DYNAMIC_RES");
+	const char * loadRampEnv = getenv("ROCKET_LOAD_RAMP");
+	const char * loadMaxEnv = getenv("ROCKET_LOAD_MAX");
+	const char * resolutionLogEnv = getenv("ROCKET_RESOLUTION_LOG");
+	GLint maxSamples = 0;
+	glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+	int msaa = msaaEnv != NULL ? atoi(msaaEnv) : 4;
+	msaa = msaa > maxSamples ? maxSamples : msaa < 0 ? 0 : msaa;
+	ResolutionController resolution;
+	initResolutionController(resolution, budgetEnv != NULL ? (float)atof(budgetEnv) : (float)(1000.0 / pacer.targetHz), msaa,
+		dynamicEnv == NULL || atoi(dynamicEnv) != 0);
+	const double loadRamp = loadRampEnv != NULL ? atof(loadRampEnv) : 0.0;
+	const int loadIterations = loadMaxEnv != NULL ? atoi(loadMaxEnv) : 400;
+	FILE * resolutionLog = NULL;
+	if (resolutionLogEnv != NULL || loadRamp > 0.0) {
+		const char * path = resolutionLogEnv != NULL ? resolutionLogEnv : "resolution.csv";
+		resolutionLog = fopen(path, "w");
+		if (resolutionLog == NULL)
+			fprintf(stderr, "Cannot open %s\n", path);
+		writeResolutionHeader(resolutionLog);
+	}
+	SceneTarget sceneTarget;
+	initSceneTarget(sceneTarget);
+	GpuId sceneTargetId = GPU_NONE;
+	uint64_t renderedFrames = 0;
+
+	// 셰이더 컴파일/링크를 요청해 둔다. 끝날 때까지 기다리지 않는다.
+	pollStartup(startup);
+	pollStartup(debrisStartup);
+	pollStartup(particleStartup);
+	pollStartup(hudStartup);
+	pollStartup(skyStartup);
+	pollStartup(upscaleStartup);
+	pollStartup(loadStartup);
+	GLuint programID = 0;
+	GLuint ModelID = 0;
+	GLuint ViewMaskID = 0;
+	ViewUniforms sceneViews;
+	GLint ViewMatrixID = -1;
+	GLint ClusterDepthID = -1;
+	GLint ScreenSizeID = -1;
+	GLint SunDirectionID = -1;
+	GLint EngineLightID = -1;
+	GLuint debrisProgramID = 0;
+	ViewUniforms debrisViews;
+	GLuint particleProgramID = 0;
+	ViewUniforms particleViews;
+	GLuint particleRightID = 0;
+	GLuint particleUpID = 0;
+	GLuint hudProgramID = 0;
+	GLuint skyProgramID = 0;
+	GLuint upscaleProgramID = 0;
+	GLuint loadProgramID = 0;
+	GpuProgram program, debrisProgram, particleProgram, hudProgram, skyProgram, upscaleProgram, loadProgram;
+
+	// 버퍼 이름은 한번에 만들고, 업로드도 컨텍스트 스레드에서 몰아서 한다.
+	// 메쉬마다 위치, 색, 법선 세 개. 모두 컴파일할 때 만든 읽기 전용 배열이라 시작할 때 계산하는 것은 없다.
+	BufferUpload uploads[mesh::MESH_COUNT * 3];
+	const char * uploadLabels[mesh::MESH_COUNT * 3];
+	for (int m = 0; m < mesh::MESH_COUNT; m++) {
+		const mesh::MeshView & view = mesh::meshes[m];
+		const GLsizeiptr size = view.vertexCount * 3 * sizeof(GLfloat);
+		const GLfloat * arrays[3] = { view.positions, view.colors, view.normals };
+		for (int k = 0; k < 3; k++) {
+			uploads[m * 3 + k].data = arrays[k];
+			uploads[m * 3 + k].size = size;
+			uploadLabels[m * 3 + k] = mesh::meshLabels[m];
+		}
+	}
+	const int uploadCount = mesh::MESH_COUNT * 3;
+	GLuint buffers[uploadCount];
+	uploadBuffers(uploads, uploadCount, buffers);
+	// 원본 배열이 그대로 있으므로 예산을 넘으면 내려 놓았다가 다시 올릴 수 있다
+	std::vector<GpuBuffer> meshBuffers;
+	meshBuffers.reserve(uploadCount);
+	for (int i = 0; i < uploadCount; i++) {
+		meshBuffers.push_back(GpuBuffer(gpu, buffers[i], GPU_MESH, uploads[i].size, uploadLabels[i]));
+		setGpuSource(gpu, meshBuffers[i].id, GL_ARRAY_BUFFER, uploads[i].data, GL_STATIC_DRAW);
+	}
 
 	// For speed computation
 	double lastTime = glfwGetTime();
 	double lastFrameTime = lastTime;
 	float angle = 0.0f;
 	vec3 gOrientation1;
-	vec3 gro1, gro2;
-	int start = 0;
-	float main = 0.000215f;
-	float gravity = 0.00000418f;
-	float velocity = 0;
-	float sky = 0;
-	int up = 0;
-	gro1.x = 0.0f;
-	gro1.y = 0.0f;
-	int suit = 0;
+	FlightState flight;
+	initFlight(flight);
 	int close = 0;
+
+	// 장면 그래프. 로켓의 부품들은 모두 로켓 노드를 따라 움직인다.
+	SceneGraph scene;
+	initSceneGraph(scene, 16);
+	int rocketNode = addSceneNode(scene, -1, glm::mat4(1.0f));
+	int bodyNode = addSceneNode(scene, rocketNode, glm::mat4(1.0f));   //몸통
+	int wingNode1 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //날개1
+	int wingNode2 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //날개2
+	int wingNode3 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //날개3
+	int wingNode4 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //날개4
+	int headNode = addSceneNode(scene, rocketNode, glm::mat4(1.0f));   //뚜껑
+	int lineNode = addSceneNode(scene, rocketNode, glm::mat4(1.0f));   //낙하산 선
+	int suitNode1 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //낙하산1
+	int suitNode2 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //낙하산2
+	int suitNode3 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //낙하산3
+	int suitNode4 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //낙하산4
+	int suitNode5 = addSceneNode(scene, rocketNode, glm::mat4(1.0f));  //낙하산5
+	int floorNode = addSceneNode(scene, -1, glm::mat4(1.0f));          //바닥
+	int wallNode = addSceneNode(scene, -1, glm::mat4(1.0f));           //벽
+	vec3 rocketPosition = flight.gro1;
+	// 그리는 순서대로 (mesh::MeshId 와 같은 순서). 버퍼는 아래에서 채운다.
+	DrawItem drawItems[] = {
+		{ bodyNode, &mesh::meshes[mesh::MESH_BODY], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //몸통
+		{ wingNode1, &mesh::meshes[mesh::MESH_WING1], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //날개1
+		{ wingNode2, &mesh::meshes[mesh::MESH_WING2], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //날개2
+		{ wingNode3, &mesh::meshes[mesh::MESH_WING3], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //날개3
+		{ wingNode4, &mesh::meshes[mesh::MESH_WING4], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //날개4
+		{ headNode, &mesh::meshes[mesh::MESH_HEAD], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //뚜껑
+		{ wallNode, &mesh::meshes[mesh::MESH_WALL], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //벽
+		{ floorNode, &mesh::meshes[mesh::MESH_FLOOR], GPU_NONE, GPU_NONE, GPU_NONE, 0 },  //바닥
+		{ lineNode, &mesh::meshes[mesh::MESH_LINES], GPU_NONE, GPU_NONE, GPU_NONE, 1 },  //낙하산 선
+		{ suitNode1, &mesh::meshes[mesh::MESH_SUIT1], GPU_NONE, GPU_NONE, GPU_NONE, 1 },  //낙하산1
+		{ suitNode2, &mesh::meshes[mesh::MESH_SUIT2], GPU_NONE, GPU_NONE, GPU_NONE, 1 },  //낙하산2
+		{ suitNode3, &mesh::meshes[mesh::MESH_SUIT3], GPU_NONE, GPU_NONE, GPU_NONE, 1 },  //낙하산3
+		{ suitNode4, &mesh::meshes[mesh::MESH_SUIT4], GPU_NONE, GPU_NONE, GPU_NONE, 1 },  //낙하산4
+		{ suitNode5, &mesh::meshes[mesh::MESH_SUIT5], GPU_NONE, GPU_NONE, GPU_NONE, 1 },  //낙하산5
+	};
+	const int drawItemCount = sizeof(drawItems) / sizeof(drawItems[0]);
+	for (int d = 0; d < drawItemCount; d++) {
+		const int m = (int)(drawItems[d].mesh - mesh::meshes);
+		drawItems[d].vertexBuffer = meshBuffers[m * 3].id;
+		drawItems[d].colorBuffer = meshBuffers[m * 3 + 1].id;
+		drawItems[d].normalBuffer = meshBuffers[m * 3 + 2].id;
+	}
+	// 노드마다 로컬 경계 상자. 메쉬가 없는 노드 (로켓) 는 min > max 로 두어 컬링에서 빠진다.
+	std::vector<vec3> nodeMin(scene.parent.size(), vec3(1.0f));
+	std::vector<vec3> nodeMax(scene.parent.size(), vec3(-1.0f));
+	for (int d = 0; d < drawItemCount; d++) {
+		const DrawItem & item = drawItems[d];
+		nodeMin[item.node] = vec3(item.mesh->min.x, item.mesh->min.y, item.mesh->min.z);
+		nodeMax[item.node] = vec3(item.mesh->max.x, item.mesh->max.y, item.mesh->max.z);
+	}
+	// 잡 시스템. 워커 수는 ROCKET_WORKERS 로 바꿀 수 있다 (기본은 코어 수).
+	const char * workersEnv = getenv("ROCKET_WORKERS");
+	JobSystem jobs;
+	startJobs(jobs, workersEnv != NULL ? atoi(workersEnv) : std::max(1, (int)std::thread::hardware_concurrency()));
+	// 하늘. 산란 표는 sky.lut 에 있으면 읽고, 없으면 워커들이 만드는 동안 검은 배경으로 시작한다.
+	// ROCKET_SUN 은 해의 고도 (도, 기본 35). 장면의 햇빛도 같은 방향이다.
+	const char * sunEnv = getenv("ROCKET_SUN");
+	Sky sky;
+	initSky(sky, "sky.lut", sunEnv != NULL ? (float)atof(sunEnv) : 35.0f, 40.0f);
+	// 프레임 잡과 섞이지 않게 전용 스레드에서, 코어 절반으로
+	beginSkyPrecompute(sky, std::max(1, (int)std::thread::hardware_concurrency() / 2));
+	GpuId skyTextureIds[4] = { GPU_NONE, GPU_NONE, GPU_NONE, GPU_NONE };
+	// 충돌 검사. 로켓은 몸통, 날개, 뚜껑 꼭지점의 볼록 헐, 벽은 얇은 상자, 바닥은 높이맵이다.
+	CollisionWorld collision;
+	initCollisionWorld(collision, 4.0f);
+	std::vector<vec3> rocketHull;
+	for (int m = mesh::MESH_BODY; m <= mesh::MESH_HEAD; m++)
+		for (int i = 0; i < mesh::meshes[m].cornerCount; i++)
+			rocketHull.push_back(vec3(mesh::meshes[m].corners[i].x, mesh::meshes[m].corners[i].y, mesh::meshes[m].corners[i].z));
+	int rocketBody = addHullBody(collision, &rocketHull[0], (int)rocketHull.size(), flight.gro1, false);
+	addBoxBody(collision, vec3(-100.0f, 0.0f, -5.1f), vec3(100.0f, 30.0f, -4.9f), true);  //뒷벽
+	addBoxBody(collision, vec3(49.9f, 0.0f, -5.0f), vec3(50.1f, 30.0f, 100.0f), true);    //오른쪽 벽
+	addBoxBody(collision, vec3(-30.1f, 0.0f, -5.0f), vec3(-29.9f, 30.0f, 100.0f), true);  //왼쪽 벽
+	setFlatTerrain(collision, -100.0f, -100.0f, 100.0f, 100.0f, 10.0f, 0.0f);
+	reserveCollision(collision, 16);
+	// 단 분리 잔해. 날개 네 개는 다 쓴 단으로 떨어져 나가고, 페어링 조각과 파편은 인스턴스로 한번에 그린다.
+	// 파편 수는 ROCKET_DEBRIS 로 바꿀 수 있다.
+	const char * debrisEnv = getenv("ROCKET_DEBRIS");
+	int debrisFragments = debrisEnv != NULL ? atoi(debrisEnv) : 20000;
+	DebrisSystem debris;
+	initDebris(debris, debrisFragments + 64);
+	// 잔해 인스턴스 데이터는 매 프레임 새로 올린다. ROCKET_NO_PERSISTENT 가 있으면 orphaning 으로 (비교용).
+	StreamBuffer debrisStream;
+	initStreamBuffer(debrisStream, GL_ARRAY_BUFFER, (GLsizeiptr)debris.capacity * DEBRIS_INSTANCE_FLOATS * sizeof(float),
+		getenv("ROCKET_NO_PERSISTENT") == NULL);
+	// 배기 입자. 최대 수는 ROCKET_PARTICLES 로 바꿀 수 있다.
+	const char * particleEnv = getenv("ROCKET_PARTICLES");
+	ParticleSystem particles;
+	initParticles(particles, particleEnv != NULL ? atoi(particleEnv) : 200000);
+	StreamBuffer particleStream;
+	initStreamBuffer(particleStream, GL_ARRAY_BUFFER, (GLsizeiptr)particles.capacity * PARTICLE_INSTANCE_FLOATS * sizeof(float),
+		getenv("ROCKET_NO_PERSISTENT") == NULL);
+	// HUD. 정점은 매 프레임 스트리밍 버퍼에 새로 쓴다.
+	Hud hud;
+	initHud(hud, 2);
+	const int hudMaxVertices = 16384;
+	StreamBuffer hudStream;
+	initStreamBuffer(hudStream, GL_ARRAY_BUFFER, hudMaxVertices * sizeof(HudVertex), getenv("ROCKET_NO_PERSISTENT") == NULL);
+	// 스트리밍 버퍼와 HUD 아틀라스는 각 모듈이 지우므로 세기만 한다
+	GpuId debrisStreamId = registerGpu(gpu, GPU_BUFFER, debrisStream.buffer, GPU_STREAM, streamBytes(debrisStream), "debris stream", false);
+	GpuId particleStreamId = registerGpu(gpu, GPU_BUFFER, particleStream.buffer, GPU_STREAM, streamBytes(particleStream), "particle stream", false);
+	GpuId hudStreamId = registerGpu(gpu, GPU_BUFFER, hudStream.buffer, GPU_STREAM, streamBytes(hudStream), "hud stream", false);
+	GpuId hudAtlasId = registerGpu(gpu, GPU_TEXTURE, hud.atlas, GPU_TEXTURE_DATA, HUD_ATLAS_WIDTH * HUD_ATLAS_HEIGHT, "hud atlas", false);
+	// 궤적 예측. 다시 계산될 때만 선을 새로 뽑아 올린다.
+	TrajectoryPrediction prediction;
+	initPrediction(prediction, flight);
+	const int trajectoryPoints = 128;
+	GLuint trajectoryName;
+	glGenBuffers(1, &trajectoryName);
+	glBindBuffer(GL_ARRAY_BUFFER, trajectoryName);
+	glBufferData(GL_ARRAY_BUFFER, trajectoryPoints * sizeof(vec3), NULL, GL_DYNAMIC_DRAW);
+	GpuBuffer trajectoryBuffer(gpu, trajectoryName, GPU_DYNAMIC, trajectoryPoints * sizeof(vec3), "trajectory");
+	int trajectoryVersion = -1;
+	int trajectoryCount = 0;
+	// 발사대와 사거리의 점광원. 수는 ROCKET_LIGHTS 로 바꿀 수 있다 (0 이면 해와 엔진만).
+	const char * lightsEnv = getenv("ROCKET_LIGHTS");
+	LightClusters lights;
+	initLightClusters(lights);
+	generateRangeLights(lights, lightsEnv != NULL ? atoi(lightsEnv) : 1000, flight.gro1, 2024);
+	LightBuffers lightBuffers;
+	initLightBuffers(lightBuffers, gpu, getenv("ROCKET_NO_PERSISTENT") == NULL);
+	const int finNodes[4] = { wingNode1, wingNode2, wingNode3, wingNode4 };
+	const vec3 finCenters[4] = { vec3(1.25f, 0.5f, 0.5f), vec3(0.5f, 0.5f, 1.25f), vec3(-0.25f, 0.5f, 0.5f), vec3(0.5f, 0.5f, -0.25f) };
+	DebrisHandle finDebris[4] = { DEBRIS_NONE, DEBRIS_NONE, DEBRIS_NONE, DEBRIS_NONE };
+	// 비행은 FLIGHT_TICK 간격의 고정 틱으로 진행하고, 남은 시간은 다음 프레임으로 넘긴다
+	double simAccumulator = 0.0;
+	double reportTime = lastTime;
+	FrameCapture capture;
+	// 지상국 프로그램들이 읽을 수 있게 시뮬레이션 틱마다 상태를 공유 메모리로 내보낸다
+	TelemetryPublisher telemetry;
+	openTelemetryPublisher(telemetry, TELEMETRY_NAME, 1024);
+	// 프레임마다 필요한 임시 데이터는 여기서 잘라 쓴다 (루프 안에서 힙 할당 금지)
+	FrameArena frameMemory;
+	initFrameArena(frameMemory, 1 << 20);
+	// ROCKET_ALLOC_CHECK=N 이면 N 프레임만 돌리고, 루프 안에서 힙 할당이 있었으면 실패(1)로 끝난다
+	const char * allocCheckEnv = getenv("ROCKET_ALLOC_CHECK");
+	uint64_t allocCheckFrames = allocCheckEnv != NULL ? strtoull(allocCheckEnv, NULL, 10) : 0;
+	AllocationCheck allocCheck;
+	initAllocationCheck(allocCheck, 120);
+	// 입력에서 swap 까지, GPU 가 그 프레임을 다 그릴 때까지 (swap 뒤 fence) 의 지연
+	LatencyHistogram swapLatency;
+	LatencyHistogram gpuLatency;
+	clearLatency(swapLatency);
+	clearLatency(gpuLatency);
+	const int latencyFences = 8;
+	GLsync latencyFence[latencyFences];
+	int64_t latencyInputNs[latencyFences];
+	int latencyFenceHead = 0, latencyFenceCount = 0;
+	FrameCounters counters;
+	counters.pacer = &pacer;
+	counters.gpu = &gpu;
+	counters.resolution = &resolution;
+	counters.sceneTarget = &sceneTarget;
+	counters.drawCalls = 0;
+	counters.triangles = 0;
+	counters.tickRate = 0.0f;
+	counters.frameMs = 0.0f;
+	int tickCount = 0;
+	double tickWindowStart = lastTime;
+	int captureCount = 0;
+	FrameJobs frame;
+	frame.jobs = &jobs;
+	frame.close = &close;
+	frame.input = &inputQueue;
+	frame.pendingInputCount = 0;
+	frame.inputSeen = 0;
+	frame.inputActive = false;
+	frame.frameNs = 0;
+	frame.tracedInputNs = 0;
+	frame.tracedInputs = 0;
+	frame.flight = &flight;
+	frame.simAccumulator = &simAccumulator;
+	frame.simTicks = 0;
+	frame.simMs = 0.0;
+	frame.collision = &collision;
+	frame.rocketBody = rocketBody;
+	frame.debris = &debris;
+	frame.debrisFragments = debrisFragments;
+	frame.finNodes = finNodes;
+	frame.finCenters = finCenters;
+	frame.finDebris = finDebris;
+	frame.telemetry = &telemetry;
+	frame.prediction = &prediction;
+	frame.particles = &particles;
+	frame.particleMs = 0.0;
+	frame.scene = &scene;
+	frame.rocketNode = rocketNode;
+	frame.rocketPosition = &rocketPosition;
+	// 여러 화면. ROCKET_VIEWS 는 처음 뷰 수 (1~4), V 로 1 -> 2 -> 4 를 돌린다.
+	const char * viewsEnv = getenv("ROCKET_VIEWS");
+	frame.viewCount = viewsEnv != NULL ? std::max(1, std::min(MAX_VIEWS, atoi(viewsEnv))) : 1;
+	frame.viewSteps = 0;
+	frame.aspect = 1024.0f / 768.0f;
+	frame.views.viewportArray = viewportArraySupported();
+	layoutViews(frame.views, frame.viewCount, VIEW_FREE);
+	frame.nodeMin = &nodeMin[0];
+	frame.nodeMax = &nodeMax[0];
+	frame.debrisStream = &debrisStream;
+	frame.debrisOffset = 0;
+	frame.particleStream = &particleStream;
+	frame.particleOffset = 0;
+	frame.particleInstances = 0;
+	frame.lights = &lights;
+	frame.items = drawItems;
+	frame.itemCount = drawItemCount;
 	do{
-		// Clear the screen
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		beginAllocationFrame(allocCheck);
+		beginArenaFrame(frameMemory);
+		beginGpuFrame(gpu);
+		if (programID == 0) {
+			if (!pollStartup(startup)) {
+				if (startup.stage == STARTUP_FAILED)
+					break;
+				// Clear the screen
+				glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+				// 셰이더가 준비될 때까지는 빈 화면만 보여준다. 그동안의 입력은 버린다.
+				glfwSwapBuffers(window);
+				glfwPollEvents();
+				InputEvent ignored;
+				while (popInput(inputQueue, jobNowNs(), ignored)) {}
+				markStartupFrame(startup);
+				// 기다리는 동안에도 페이싱을 해서 코어 하나를 돌리지 않게 하고, 할당 검사 프레임도 닫는다
+				// (로딩 프레임은 warmup 으로 치지 않는다)
+				paceFrame(pacer, true);
+				allocCheck.warmupFrames++;
+				endAllocationFrame(allocCheck, glfwGetTime());
+				continue;
+			}
+			programID = startup.programID;
+			program = GpuProgram(gpu, programID, GPU_SHADER, 0, "scene program");
+			// Get a handle for our "model" uniform
+			ModelID = glGetUniformLocation(programID, "model");
+			ViewMaskID = glGetUniformLocation(programID, "viewMask");
+			getViewUniforms(programID, sceneViews);
+			getLightUniforms(lightBuffers, programID);
+			ViewMatrixID = glGetUniformLocation(programID, "viewMatrix");
+			ClusterDepthID = glGetUniformLocation(programID, "clusterDepth");
+			ScreenSizeID = glGetUniformLocation(programID, "screenSize");
+			SunDirectionID = glGetUniformLocation(programID, "sunDirection");
+			EngineLightID = glGetUniformLocation(programID, "engineLight");
+		}
 		// Use our shader
 		glUseProgram(programID);
-		if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {  //spacebar 누르면출발
-			start = 1;
-			sky = 1;
-		}
-		//지속적으로 회전하기위해 deltaTime값을 구한다.
+		// 지난 프레임부터 흐른 시간. 오래 멈췄다 돌아온 경우에는 따라잡지 않고 버린다.
 		double currentTime = glfwGetTime();
-		float deltaTime = (float)(currentTime - lastFrameTime);
-		if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) {
-			suit = 1;
+		frame.frameNs = jobNowNs();
+		double frameTime = currentTime - lastFrameTime;
+		lastFrameTime = currentTime;
+		simAccumulator += frameTime < 0.25 ? frameTime : 0.25;
+		counters.frameMs = (float)(frameTime * 1000.0);
+		pushHudFrameTime(hud, counters.frameMs);
+		// 잡들이 채울 프레임 데이터는 메인에서 미리 잘라 둔다
+		frame.visible = arenaAllocArray<unsigned char>(frameArena(frameMemory), scene.world.size());
+		frame.commands = arenaAllocArray<DrawCommand>(frameArena(frameMemory), drawItemCount);
+		// GPU 가 아직 읽고 있는 구역이면 여기서 기다린다
+		beginStreamFrame(debrisStream);
+		beginStreamFrame(particleStream);
+		beginStreamFrame(hudStream);
+		beginStreamFrame(lightBuffers.stream);
+		frame.tracedInputs = 0;
+		frame.hudToggles = 0;
+		frame.pacingSteps = 0;
+		frame.captureToggles = 0;
+		frame.viewSteps = 0;
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		frame.aspect = framebufferHeight > 0 ? (float)framebufferWidth / framebufferHeight : 1.0f;
+		beginJobFrame(jobs);
+		JobCounter stage;
+		initCounter(stage);
+		runJobHere(jobs, readInput, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "input");
+		initCounter(stage);
+		runJob(jobs, simulate, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "sim");
+		initCounter(stage);
+		runJob(jobs, updateTransforms, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "transform");
+		// 노드 컬링과 잔해 컬링은 서로 상관없으므로 같이 돈다
+		initCounter(stage);
+		runJob(jobs, cullNodes, &frame, 0, 0, &stage);
+		runJob(jobs, cullDebris, &frame, 0, 0, &stage);
+		runJob(jobs, writeParticles, &frame, 0, 0, &stage);
+		runJob(jobs, binLights, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "cull");
+		initCounter(stage);
+		runJob(jobs, buildCommands, &frame, 0, 0, &stage);
+		waitForStage(jobs, stage, "commands");
+		tickCount += frame.simTicks;
+		if (currentTime - tickWindowStart >= 1.0) {
+			counters.tickRate = (float)(tickCount / (currentTime - tickWindowStart));
+			tickCount = 0;
+			tickWindowStart = currentTime;
 		}
-		if (sky == 1)      //하늘에 떠있는 경우
-		{
-			if (suit == 0) {
-				velocity += ((main - gravity)*deltaTime);  //가속도 붙여서 속력변화
-				if (velocity < -0.03f)   //속도가 줄어 멈추게되는경우
-				{
-					start = 0;
-				}
-				if (velocity > 0.009f)  //속도가 일정이상 올라가는 경우 엔진 중지
-				{
-					main = 0.0f;
-				}
-				if (start == 1)
-				{
-					gro1.x += 0.015f;
-					gro1.y += (4 * velocity*deltaTime);
-				}
-			}
-			else {
-				gro1.y -= 0.006f;
-			}
+		counters.drawCalls = 0;
+		counters.triangles = 0;
+
+		// 장면은 창 크기의 오프스크린 대상에 배율만큼 줄여서 그린다 (동적 해상도). 창은 업스케일이 모두 덮으므로 지우지 않는다.
+		if (resizeSceneTarget(sceneTarget, framebufferWidth, framebufferHeight, resolution.samples)) {
+			if (sceneTargetId != GPU_NONE)
+				releaseGpu(gpu, sceneTargetId);
+			sceneTargetId = registerGpu(gpu, GPU_TEXTURE, sceneTarget.resolveTexture, GPU_TEXTURE_DATA, sceneTargetBytes(sceneTarget),
+				"scene target", false);
 		}
-		if (gro1.y < 0)
-		{
-			start = 0;
-			sky = 0;
+		beginSceneTarget(sceneTarget, resolution.enabled ? resolution.scale : 1.0f);
+		const int renderWidth = sceneTarget.renderWidth, renderHeight = sceneTarget.renderHeight;
+		// GL 호출은 컨텍스트가 있는 메인 스레드에서 명령 목록대로 한다. 뷰가 여럿이어도 호출 수는 같다.
+		setViewUniforms(sceneViews, frame.views);
+		// 조명 : 잡들이 나눠 담은 클러스터를 올리고 뷰마다 깊이 조각의 식을 준다
+		uploadLightClusters(lightBuffers, lights);
+		bindLightBuffers(lightBuffers);
+		vec2 clusterDepth[MAX_VIEWS];
+		for (int v = 0; v < frame.views.count; v++)
+			clusterDepth[v] = vec2(lights.nearZ[v], CLUSTER_SLICES / logf(lights.farZ[v] / lights.nearZ[v]));
+		glUniformMatrix4fv(ViewMatrixID, frame.views.count, GL_FALSE, &frame.views.view[0][0][0]);
+		glUniform2fv(ClusterDepthID, frame.views.count, &clusterDepth[0][0]);
+		glUniform2f(ScreenSizeID, (float)renderWidth, (float)renderHeight);
+		glUniform3f(SunDirectionID, sky.sunDirection.x, sky.sunDirection.y, sky.sunDirection.z);
+		// 날아가는 동안 엔진이 켜져 있으면 노즐 아래에서 추력만큼 밝은 빛
+		glUniform4f(EngineLightID, flight.gro1.x + 0.5f, flight.gro1.y - 0.3f, flight.gro1.z + 0.5f,
+			flight.sky == 1 && flight.main > 0.0f ? flight.main * 2.0f : 0.0f);
+		beginViews(frame.views, renderWidth, renderHeight);
+		// 하늘 : 깊이를 쓰지 않고 맨 먼저. 표가 준비되면 올리고 GPU 자원으로 센다.
+		if (skyProgramID == 0 && pollStartup(skyStartup)) {
+			skyProgramID = skyStartup.programID;
+			getSkyUniforms(sky, skyProgramID);
+			skyProgram = GpuProgram(gpu, skyProgramID, GPU_SHADER, 0, "sky program");
 		}
-		if (glfwGetKey(window, GLFW_KEY_C) == GLFW_PRESS) {
-			if (close == 0) {
-				close = 1;
-			}
-			else {
-				close = 0;
-			}
+		if (!sky.uploaded && pollSky(sky)) {
+			static const char * const SKY_LABELS[4] = { "sky transmittance", "sky rayleigh", "sky mie", "sky multiple" };
+			for (int i = 0; i < 4; i++)
+				skyTextureIds[i] = registerGpu(gpu, GPU_TEXTURE, sky.textures[i], GPU_TEXTURE_DATA,
+					i == 0 ? SKY_TRANSMITTANCE_WIDTH * SKY_TRANSMITTANCE_HEIGHT * 6 : SKY_SCATTERING_TEXELS * 6, SKY_LABELS[i], false);
 		}
-		// Send our transformation to the currently bound shader, 
-		computeMatricesFromInputs();
-		glm::mat4 ViewMatrix;
-		if (close == 0) {
-			ViewMatrix = getViewMatrix();
-		}
-		else {
-			ViewMatrix = glm::lookAt(
-				glm::vec3(gro1.x+3, gro1.y+3, 10.0f), // Camera is at (4,3,-3), in World Space
-				glm::vec3(gro1.x, gro1.y, 0.0f), // and looks at the origin
-				glm::vec3(0, 1, 0)  // Head is up (set to 0,-1,0 to look upside-down)
-			);
+		if (skyProgramID != 0 && sky.uploaded) {
+			drawSky(sky, skyProgramID, frame.views, flight.gro1.y);
+			counters.drawCalls++;
+			glUseProgram(programID);
 		}
-		glm::mat4 ProjectionMatrix = getProjectionMatrix();
-		glm::mat4 ModelMatrix = glm::mat4(1.0);
-		glm::mat4 Model2 = glm::mat4(1.0f);
-		//날개2
-		glm::mat4 Model3 = glm::mat4(1.0f);
-		//날개3
-		glm::mat4 Model4 = glm::mat4(1.0f);
-		//날개4
-		glm::mat4 Model5 = glm::mat4(1.0f);
-		//뚜껑
-		glm::mat4 Model6 = glm::mat4(1.0f);
-		//바닥
-		glm::mat4 Model7 = glm::mat4(1.0f);
-		glm::mat4 Model8 = glm::mat4(1.0f);
-		glm::mat4 Model9 = glm::mat4(1.0f);
-		glm::mat4 Model10 = glm::mat4(1.0f);
-		glm::mat4 Model11 = glm::mat4(1.0f);
-		glm::mat4 Model12 = glm::mat4(1.0f);
-		glm::mat4 Model13 = glm::mat4(1.0f);
-		glm::mat4 Model14 = glm::mat4(1.0f);
-		glm::mat4 MVP;
-		glm::mat4 MVP2;
-		glm::mat4 MVP3;
-		glm::mat4 MVP4;
-		glm::mat4 MVP5;
-		glm::mat4 MVP6;
-		glm::mat4 MVP7;
-		glm::mat4 MVP8;
-		glm::mat4 MVP9;
-		glm::mat4 MVP10;
-		glm::mat4 MVP11;
-		glm::mat4 MVP12;
-		glm::mat4 MVP13;
-		glm::mat4 MVP14;
-		
-		glm::mat4 TranslationMatrix1 = translate(mat4(), gro1); // A bit to the left
-		//glm::mat4 RotationMatrix1 = eulerAngleYXZ(gOrientation1.y, gOrientation1.x, gOrientation1.z);
-		ModelMatrix = ModelMatrix*TranslationMatrix1;
-		// Our ModelViewProjection : multiplication of our 3 matrices
-		MVP = ProjectionMatrix * ViewMatrix * ModelMatrix; // Remember, matrix multiplication is the other way around
-		// Our ModelViewProjection : multiplication of our 3 matrices
-		MVP2 = ProjectionMatrix * ViewMatrix * ModelMatrix; // Remember, matrix multiplication is the other way around
-		// Our ModelViewProjection : multiplication of our 3 matrices
-		MVP3 = ProjectionMatrix * ViewMatrix * ModelMatrix;; // Remember, matrix multiplication is the other way around
-		// Our ModelViewProjection : multiplication of our 3 matrices
-		MVP4 = ProjectionMatrix * ViewMatrix * ModelMatrix; // Remember, matrix multiplication is the other way around
-		// Our ModelViewProjection : multiplication of our 3 matrices
-		MVP5 = ProjectionMatrix * ViewMatrix * ModelMatrix; // Remember, matrix multiplication is the other way around
-		// Our ModelViewProjection : multiplication of our 3 matrices
-		MVP6 = ProjectionMatrix * ViewMatrix * ModelMatrix; // Remember, matrix multiplication is the other way around
-		// Our ModelViewProjection : multiplication of our 3 matrices
-		MVP7 = ProjectionMatrix * ViewMatrix * Model7; // Remember, matrix multiplication is the other way around
-		// in the "MVP" uniform
-
-		//낙하산들
-		MVP8 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		MVP9 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		MVP10 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		MVP11 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		MVP12 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		MVP13 = ProjectionMatrix * ViewMatrix * Model13; // Remember, matrix multiplication is the other way around
-		MVP14 = ProjectionMatrix * ViewMatrix * ModelMatrix;
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP[0][0]);
-		
-		//버퍼의 첫번째 속성값 : 버텍스들
-		// 1rst attribute buffer : vertices
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-
-		glDrawArrays(GL_TRIANGLES, 0, 12*3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-		//날개 1
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP2[0][0]);
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer2);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer2);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 4 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-		//날개2
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP3[0][0]);
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer3);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer2);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 4 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		//날개3
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP4[0][0]);
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer4);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer2);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 4 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		//날개4
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP5[0][0]);
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer5);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
+		for (int i = 0; i < frame.commandCount; i++) {
+			const DrawCommand & command = frame.commands[i];
+			glUniformMatrix4fv(ModelID, 1, GL_FALSE, command.model);
+			glUniform1i(ViewMaskID, command.viewMask);
 
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer2);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 4 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		//뚜껑
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP6[0][0]);
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer6);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer3);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 6 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		//벽
-
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP13[0][0]);
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer13);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer10);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 6 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-		//바닥
-		glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP7[0][0]);
-		glEnableVertexAttribArray(0);
-		glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer7);
-		glVertexAttribPointer(
-			0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-			3,                  // size
-			GL_FLOAT,           // type
-			GL_FALSE,           // normalized?
-			0,                  // stride
-			(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-		);
-
-		// 2nd attribute buffer : colors
-		glEnableVertexAttribArray(1);
-		glBindBuffer(GL_ARRAY_BUFFER, colorbuffer4);
-		glVertexAttribPointer(
-			1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-			3,                                // size
-			GL_FLOAT,                         // type
-			GL_FALSE,                         // normalized?
-			0,                                // stride
-			(void*)0                          // array buffer offset
-		);
-		glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
-		glDisableVertexAttribArray(0);
-		glDisableVertexAttribArray(1);
-
-		if (suit == 1) {
-			//낙하산 선
-			glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP14[0][0]);
+			//버퍼의 첫번째 속성값 : 버텍스들
+			// 1rst attribute buffer : vertices
 			glEnableVertexAttribArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, linebuffer);
-			glVertexAttribPointer(
-				0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-				3,                  // size
-				GL_FLOAT,           // type
-				GL_FALSE,           // normalized?
-				0,                  // stride
-				(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-			);
-			glEnableVertexAttribArray(1);
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer11);
-			glVertexAttribPointer(
-				1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
-			glDrawArrays(GL_TRIANGLES, 0, 8 * 3); // 12*3 indices starting at 0 -> 12 triangles
-			glDisableVertexAttribArray(0);
-			glDisableVertexAttribArray(1);
-
-			//낙하산1
-			glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP8[0][0]);
-			glEnableVertexAttribArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer8);
+			glBindBuffer(GL_ARRAY_BUFFER, useGpu(gpu, command.vertexBuffer));
 			glVertexAttribPointer(
 				0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
 				3,                  // size
@@ -1049,7 +992,7 @@ int main( void )
 
 			// 2nd attribute buffer : colors
 			glEnableVertexAttribArray(1);
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer5);
+			glBindBuffer(GL_ARRAY_BUFFER, useGpu(gpu, command.colorBuffer));
 			glVertexAttribPointer(
 				1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
 				3,                                // size
@@ -1058,145 +1001,366 @@ int main( void )
 				0,                                // stride
 				(void*)0                          // array buffer offset
 			);
-			glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 12*3 indices starting at 0 -> 12 triangles
 
-			glDisableVertexAttribArray(0);
-			glDisableVertexAttribArray(1);
-			//낙하산2
-			glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP9[0][0]);
-			glEnableVertexAttribArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer9);
-			glVertexAttribPointer(
-				0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-				3,                  // size
-				GL_FLOAT,           // type
-				GL_FALSE,           // normalized?
-				0,                  // stride
-				(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-			);
+			// 3rd attribute buffer : normals
+			glEnableVertexAttribArray(2);
+			glBindBuffer(GL_ARRAY_BUFFER, useGpu(gpu, command.normalBuffer));
+			glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
 
-			// 2nd attribute buffer : colors
-			glEnableVertexAttribArray(1);
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer6);
-			glVertexAttribPointer(
-				1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
-			glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 12*3 indices starting at 0 -> 12 triangles
+			glDrawArraysInstanced(GL_TRIANGLES, 0, command.vertexCount, frame.views.count);
+			counters.drawCalls++;
+			counters.triangles += command.vertexCount / 3 * viewMaskCount(command.viewMask);
 
 			glDisableVertexAttribArray(0);
 			glDisableVertexAttribArray(1);
-			//낙하산3
-			glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP10[0][0]);
-			glEnableVertexAttribArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer10);
-			glVertexAttribPointer(
-				0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-				3,                  // size
-				GL_FLOAT,           // type
-				GL_FALSE,           // normalized?
-				0,                  // stride
-				(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-			);
-
-			// 2nd attribute buffer : colors
-			glEnableVertexAttribArray(1);
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer7);
-			glVertexAttribPointer(
-				1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
-			glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 12*3 indices starting at 0 -> 12 triangles
+			glDisableVertexAttribArray(2);
+		}
 
+		// 예측 궤적 : 몸통 가운데가 지나갈 길을 선으로. 색은 정점 속성 대신 상수로 준다.
+		if (prediction.version != trajectoryVersion) {
+			trajectoryVersion = prediction.version;
+			vec3 points[trajectoryPoints];
+			trajectoryCount = samplePrediction(prediction, points, trajectoryPoints, (int64_t)(20.0f / FLIGHT_TICK));
+			for (int i = 0; i < trajectoryCount; i++)
+				points[i] += vec3(0.5f, 1.0f, 0.5f);
+			glBindBuffer(GL_ARRAY_BUFFER, trajectoryBuffer.get());
+			glBufferSubData(GL_ARRAY_BUFFER, 0, trajectoryCount * sizeof(vec3), points);
+		}
+		if (trajectoryCount > 1) {
+			const glm::mat4 identity(1.0f);
+			glUniformMatrix4fv(ModelID, 1, GL_FALSE, &identity[0][0]);
+			glUniform1i(ViewMaskID, 0xFF);
+			glEnableVertexAttribArray(0);
+			glBindBuffer(GL_ARRAY_BUFFER, trajectoryBuffer.get());
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+			glVertexAttrib3f(1, 1.0f, 0.85f, 0.2f);
+			glVertexAttrib3f(2, 0.0f, 0.0f, 0.0f);   // 법선이 없으면 빛을 받지 않는다
+			glDrawArraysInstanced(GL_LINE_STRIP, 0, trajectoryCount, frame.views.count);
 			glDisableVertexAttribArray(0);
-			glDisableVertexAttribArray(1);
+			counters.drawCalls++;
+		}
 
-			//낙하산4
-			glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP11[0][0]);
+		// 잔해 : 몸통 메쉬 하나를 인스턴스로 한번에 그린다
+		if (debrisProgramID == 0 && pollStartup(debrisStartup)) {
+			debrisProgramID = debrisStartup.programID;
+			debrisProgram = GpuProgram(gpu, debrisProgramID, GPU_SHADER, 0, "debris program");
+			getViewUniforms(debrisProgramID, debrisViews);
+		}
+		int debrisInstances = frame.debrisInstances;
+		double debrisDrawStart = glfwGetTime();
+		if (debrisProgramID != 0 && debrisInstances > 0) {
+			glUseProgram(debrisProgramID);
+			setViewUniforms(debrisViews, frame.views);
+			streamFlush(debrisStream);
+			for (int a = 0; a < 3; a++) {
+				glEnableVertexAttribArray(2 + a);
+				glVertexAttribPointer(2 + a, 4, GL_FLOAT, GL_FALSE, DEBRIS_INSTANCE_FLOATS * sizeof(float),
+					(void*)(frame.debrisOffset + a * 4 * sizeof(float)));
+				// 잔해 하나를 뷰 수만큼 연달아 그린다 (셰이더의 gl_InstanceID % viewCount)
+				glVertexAttribDivisor(2 + a, frame.views.count);
+			}
 			glEnableVertexAttribArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer11);
-			glVertexAttribPointer(
-				0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-				3,                  // size
-				GL_FLOAT,           // type
-				GL_FALSE,           // normalized?
-				0,                  // stride
-				(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-			);
-
-			// 2nd attribute buffer : colors
-			glEnableVertexAttribArray(1);
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer8);
-			glVertexAttribPointer(
-				1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
-			glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 12*3 indices starting at 0 -> 12 triangles
-
+			glBindBuffer(GL_ARRAY_BUFFER, useGpu(gpu, meshBuffers[mesh::MESH_BODY * 3].id));
+			glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (void*)0);
+			glDrawArraysInstanced(GL_TRIANGLES, 0, mesh::meshes[mesh::MESH_BODY].vertexCount, debrisInstances * frame.views.count);
+			counters.drawCalls++;
+			counters.triangles += mesh::meshes[mesh::MESH_BODY].vertexCount / 3 * debrisInstances * frame.views.count;
 			glDisableVertexAttribArray(0);
-			glDisableVertexAttribArray(1);
+			// 속성 2 는 장면의 법선이기도 하므로 divisor 를 되돌린다
+			for (int a = 0; a < 3; a++) {
+				glDisableVertexAttribArray(2 + a);
+				glVertexAttribDivisor(2 + a, 0);
+			}
+		}
+		endStreamFrame(debrisStream);
+		double debrisDrawMs = (glfwGetTime() - debrisDrawStart) * 1000.0;
+
+		// 배기 입자 : 빌보드를 한번에 그린다. 깊이는 검사만 하고 쓰지 않는다.
+		if (particleProgramID == 0 && pollStartup(particleStartup)) {
+			particleProgramID = particleStartup.programID;
+			particleProgram = GpuProgram(gpu, particleProgramID, GPU_SHADER, 0, "particle program");
+			getViewUniforms(particleProgramID, particleViews);
+			particleRightID = glGetUniformLocation(particleProgramID, "cameraRight");
+			particleUpID = glGetUniformLocation(particleProgramID, "cameraUp");
+		}
+		double particleDrawStart = glfwGetTime();
+		if (particleProgramID != 0 && frame.particleInstances > 0) {
+			glUseProgram(particleProgramID);
+			setViewUniforms(particleViews, frame.views);
+			glUniform3fv(particleRightID, frame.views.count, &frame.views.right[0][0]);
+			glUniform3fv(particleUpID, frame.views.count, &frame.views.up[0][0]);
+			glEnable(GL_BLEND);
+			glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			glDepthMask(GL_FALSE);
+			streamFlush(particleStream);
+			for (int a = 0; a < 2; a++) {
+				glEnableVertexAttribArray(2 + a);
+				glVertexAttribPointer(2 + a, 4, GL_FLOAT, GL_FALSE, PARTICLE_INSTANCE_FLOATS * sizeof(float),
+					(void*)(frame.particleOffset + a * 4 * sizeof(float)));
+				glVertexAttribDivisor(2 + a, frame.views.count);
+			}
+			glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, frame.particleInstances * frame.views.count);
+			counters.drawCalls++;
+			counters.triangles += 2 * frame.particleInstances * frame.views.count;
+			for (int a = 0; a < 2; a++) {
+				glDisableVertexAttribArray(2 + a);
+				glVertexAttribDivisor(2 + a, 0);
+			}
+			glDepthMask(GL_TRUE);
+			glDisable(GL_BLEND);
+		}
+		endStreamFrame(particleStream);
+		double particleDrawMs = (glfwGetTime() - particleDrawStart) * 1000.0;
+		endViews(frame.views, renderWidth, renderHeight);
+		endJobFrame(jobs);
+
+		// 시험용 부하를 더하고 창 크기로 늘린다. 새 GPU 측정이 왔으면 다음 프레임의 배율을 정한다.
+		if (loadProgramID == 0 && pollStartup(loadStartup)) {
+			loadProgramID = loadStartup.programID;
+			setLoadProgram(sceneTarget, loadProgramID);
+			loadProgram = GpuProgram(gpu, loadProgramID, GPU_SHADER, 0, "load program");
+		}
+		if (upscaleProgramID == 0 && pollStartup(upscaleStartup)) {
+			upscaleProgramID = upscaleStartup.programID;
+			setUpscaleProgram(sceneTarget, upscaleProgramID);
+			upscaleProgram = GpuProgram(gpu, upscaleProgramID, GPU_SHADER, 0, "upscale program");
+		}
+		const float load = syntheticLoad(currentTime, loadRamp);
+		const int loadPasses = (int)(load * loadIterations);
+		drawSyntheticLoad(sceneTarget, loadPasses);
+		resolveSceneTarget(sceneTarget, framebufferWidth, framebufferHeight, 0.5f);
+		counters.drawCalls += loadProgramID != 0 && loadPasses > 0 ? 2 : 1;
+		if (sceneTarget.timed) {
+			recordResolutionFrame(resolution, sceneTarget.gpuMs);
+			if (updateResolution(resolution, sceneTarget.gpuMs, sceneTarget.gpuScale, sceneTarget.gpuSamples))
+				printf("Resolution : MSAA %dx -> %dx (gpu %.2f ms at scale %.2f)\n", sceneTarget.samples, resolution.samples,
+					sceneTarget.gpuMs, sceneTarget.gpuScale);
+		}
+		writeResolutionFrame(resolutionLog, renderedFrames++, currentTime, load, (float)((glfwGetTime() - currentTime) * 1000.0),
+			resolution, sceneTarget);
+
+		// 시뮬레이션이 처리한 키 중 메인 스레드 것들
+		if (frame.hudToggles % 2 == 1)
+			hud.visible = !hud.visible;
+		if (frame.pacingSteps > 0) {
+			setPacingMode(pacer, (PacingMode)((pacer.mode + frame.pacingSteps) % PACING_MODES));
+			printf("Pacing mode : %s\n", pacingModeName(pacer.mode));
+		}
+		if (frame.viewSteps > 0) {
+			for (int i = 0; i < frame.viewSteps; i++)
+				frame.viewCount = frame.viewCount == 1 ? 2 : frame.viewCount == 2 ? 4 : 1;
+			printf("Views : %d (%s)\n", frame.viewCount, frame.views.viewportArray ? "viewport array" : "clip planes");
+		}
 
-			//낙하산5
-			glUniformMatrix4fv(MatrixID, 1, GL_FALSE, &MVP12[0][0]);
-			glEnableVertexAttribArray(0);
-			glBindBuffer(GL_ARRAY_BUFFER, vertexbuffer12);
-			glVertexAttribPointer(
-				0,                  // attribute. No particular reason for 0, but must match the layout in the shader.
-				3,                  // size
-				GL_FLOAT,           // type
-				GL_FALSE,           // normalized?
-				0,                  // stride
-				(void*)0            // array buffer offset  배열 버퍼의 오프셋, 옮기는 값
-			);
+		// HUD : 한 정점 스트림으로 만들어서 한번에 그린다
+		if (hudProgramID == 0 && pollStartup(hudStartup)) {
+			hudProgramID = hudStartup.programID;
+			hudProgram = GpuProgram(gpu, hudProgramID, GPU_SHADER, 0, "hud program");
+		}
+		if (hud.visible && hudProgramID != 0) {
+			double hudStart = glfwGetTime();
+			int width, height;
+			glfwGetFramebufferSize(window, &width, &height);
+			GLsizeiptr hudOffset = 0;
+			HudVertex * hudVertices = (HudVertex *)streamAlloc(hudStream, hudMaxVertices * sizeof(HudVertex), &hudOffset);
+			beginHud(hud, hudVertices, hudMaxVertices, width, height);
+			buildHud(hud, frame, jobs, counters);
+			hud.buildMs = (glfwGetTime() - hudStart) * 1000.0;
+			drawHud(hud, hudProgramID, hudStream, hudOffset);
+		}
+		endStreamFrame(hudStream);
+		endStreamFrame(lightBuffers.stream);
+		// 단계별 비용을 5 초마다 출력한다
+		if (currentTime - reportTime >= 5.0) {
+			reportTime = currentTime;
+			const JobFrameStats & stats = jobs.frame;
+			printf("Frame : %.2f ms, critical path %.2f ms, %d workers %.0f%% busy, %d jobs (%d stolen) |",
+				stats.wallMs, stats.criticalMs, jobs.workerCount, stats.utilization * 100.0, stats.jobs, stats.steals);
+			for (int i = 0; i < stats.stageCount; i++)
+				printf(" %s %.2f/%.2f", stats.stages[i].name, stats.stages[i].wallMs, stats.stages[i].criticalMs);
+			printf(" ms | %d/%d drawn, %d draw calls, %d triangles, %d views | hud %s %.3f ms\n", frame.commandCount, drawItemCount,
+				counters.drawCalls, counters.triangles, frame.views.count, hud.visible ? "build+draw" : "off",
+				hud.visible ? hud.buildMs + hud.drawMs : 0.0);
+			const PacingStats & pacing = pacer.window;
+			printf("Pacing : %s (swap interval %d), %.1f fps, frame %.2f +- %.2f ms (max %.2f) | cpu %.0f%%, %.0f wakeups/s,"
+				" sleep %.2f ms/frame, spin %.2f ms/frame | idle %.0f%% of frames\n",
+				pacingModeName(pacer.mode), swapInterval, pacing.wallSeconds > 0.0 ? pacing.frames / pacing.wallSeconds : 0.0,
+				pacingMeanMs(pacing), pacingStdDevMs(pacing), pacing.maxMs, pacingCpuPercent(pacing), pacingWakeupsPerSecond(pacing),
+				pacing.frames > 0 ? pacing.sleepSeconds * 1000.0 / pacing.frames : 0.0,
+				pacing.frames > 0 ? pacing.spinSeconds * 1000.0 / pacing.frames : 0.0,
+				pacing.frames > 0 ? pacing.idleFrames * 100.0 / pacing.frames : 0.0);
+			resetPacingWindow(pacer);
+			printf("GPU memory : %.1f KB resident (peak %.1f KB, budget %s) |", gpu.residentBytes / 1024.0, gpu.peakBytes / 1024.0,
+				gpu.budget > 0 ? "on" : "off");
+			for (int c = 0; c < GPU_CATEGORIES; c++)
+				printf(" %s %d / %.1f KB", gpuCategoryName((GpuCategory)c), gpu.counts[c], gpu.bytes[c] / 1024.0);
+			printf(" | %d evictions, %d reloads (%.1f KB)\n", gpu.evictions, gpu.reloads, gpu.reloadBytes / 1024.0);
+			const ResolutionStats & rs = resolution.window;
+			printf("Resolution : %dx%d of %dx%d, MSAA %dx, scale %.2f (min %.2f, mean %.2f, max %.2f) | gpu %.2f ms (max %.2f),"
+				" budget %.2f ms, %.0f%% over, %d MSAA changes, %d late timings%s\n",
+				sceneTarget.renderWidth, sceneTarget.renderHeight, sceneTarget.width, sceneTarget.height, sceneTarget.samples,
+				sceneTarget.renderScale, rs.minScale, rs.frames > 0 ? rs.sumScale / rs.frames : sceneTarget.renderScale, rs.maxScale,
+				sceneTarget.gpuMs, rs.maxMs, resolution.targetMs, rs.frames > 0 ? rs.overBudget * 100.0 / rs.frames : 0.0,
+				rs.changes, sceneTarget.dropped, resolution.enabled ? "" : " (fixed)");
+			resetResolutionWindow(resolution);
+			if (swapLatency.samples > 0)
+				printf("Input : %u events (%u dropped) | input to swap p50 %.1f p99 %.1f ms, to GPU done p50 %.1f p99 %.1f ms (%llu traced)\n",
+					inputPushed(inputQueue), inputQueue.dropped.load(), latencyPercentile(swapLatency, 0.5),
+					latencyPercentile(swapLatency, 0.99), latencyPercentile(gpuLatency, 0.5), latencyPercentile(gpuLatency, 0.99),
+					(unsigned long long)swapLatency.samples);
+			printf("Stream : %s, %.1f KB/frame, fence wait %.3f ms (%.1f ms in %d stalls so far)%s\n",
+				debrisStream.mode == STREAM_PERSISTENT ? "persistent" : "orphan", debrisStream.stats.bytes / 1024.0,
+				debrisStream.stats.fenceWaitMs, debrisStream.totalWaitMs, debrisStream.stalls,
+				debrisStream.stats.overflows > 0 ? " (overflow)" : "");
+			printf("Lights : %d lights, %d in view, %d cluster refs (max %d per cluster, %d dropped) | bounds %.2f ms, bin %.2f ms,"
+				" upload %.1f KB/frame\n", (int)lights.lights.size(), lights.stats.visible, lights.stats.indices,
+				lights.stats.maxPerCluster, lights.stats.overflows, lights.stats.boundsMs, lights.stats.binMs,
+				lightBuffers.uploadedBytes / 1024.0);
+			if (sky.uploaded)
+				printf("Sky : altitude %.1f km | per frame cpu %.3f ms, gpu %.3f ms | tables %s %.1f ms\n", sky.altitudeKm,
+					sky.stats.cpuMs, sky.stats.gpuMs, sky.stats.cached ? "loaded in" : "precomputed in",
+					sky.stats.cached ? sky.stats.loadMs : sky.stats.precomputeMs);
+			if (prediction.launched)
+				printf("Trajectory : apogee %.3f at %.2f s, %s (%.3f, %.3f) at %.2f s, downrange %.3f"
+					" | %d queries, %d rebuilds (%d phases), max error %.5f\n",
+					prediction.apogee, (prediction.apogeeTick - prediction.launchTick) * FLIGHT_TICK,
+					prediction.lands ? "touchdown" : "stalls at", prediction.touchdown.x, prediction.touchdown.y,
+					prediction.lands ? (prediction.touchdownTick - prediction.launchTick) * FLIGHT_TICK : 0.0f, prediction.downrange,
+					prediction.stats.queries, prediction.stats.rebuilds, prediction.stats.phasesEvaluated, prediction.stats.maxError);
+			if (particles.count > 0)
+				printf("Particles : %d live | update %.2f ms (%d ticks) : emit %.2f ms, integrate %.2f ms, compact %.2f ms"
+					" | render : instances %.2f ms, upload+draw %.2f ms, %.1f KB/frame\n",
+					particles.count, frame.particleMs, frame.simTicks, particles.stats.emitMs, particles.stats.updateMs,
+					particles.stats.compactMs, particles.stats.instanceMs, particleDrawMs, particleStream.stats.bytes / 1024.0);
+			if (debris.count > 0)
+				printf("Debris : %d live (%d resting, %d visible) | sim %.2f ms (%d ticks) : integrate %.2f ms, compact %.2f ms, collision %.2f ms"
+					" | cull+instances %.2f ms, upload+draw %.2f ms\n",
+					debris.count, debris.stats.resting, debris.stats.visible, frame.simMs, frame.simTicks,
+					debris.stats.integrateMs, debris.stats.compactMs,
+					collision.stats.buildMs + collision.stats.pairMs + collision.stats.narrowMs,
+					debris.stats.instanceMs, debrisDrawMs);
+		}
 
-			// 2nd attribute buffer : colors
-			glEnableVertexAttribArray(1);
-			glBindBuffer(GL_ARRAY_BUFFER, colorbuffer9);
-			glVertexAttribPointer(
-				1,                                // attribute. No particular reason for 1, but must match the layout in the shader.
-				3,                                // size
-				GL_FLOAT,                         // type
-				GL_FALSE,                         // normalized?
-				0,                                // stride
-				(void*)0                          // array buffer offset
-			);
-			glDrawArrays(GL_TRIANGLES, 0, 2 * 3); // 12*3 indices starting at 0 -> 12 triangles
+		// Draw the triangle !
 
-			glDisableVertexAttribArray(0);
-			glDisableVertexAttribArray(1);
+		//F9 : 녹화 시작/끝
+		for (int i = 0; i < frame.captureToggles; i++) {
+			if (capture.active) {
+				stopCapture(capture);
+			}
+			else {
+				char capturePath[64];
+				sprintf(capturePath, "capture%d.y4m", captureCount++);
+				int width, height;
+				glfwGetFramebufferSize(window, &width, &height);
+				startCapture(capture, capturePath, width, height, 60, CAPTURE_Y4M);
+			}
 		}
-		
-		// Draw the triangle !
+		if (pacerSwapInterval(pacer) != swapInterval) {
+			swapInterval = pacerSwapInterval(pacer);
+			glfwSwapInterval(swapInterval);
+		}
+		captureFrame(capture, framebufferWidth, framebufferHeight);
 
 		// Swap buffers
 		glfwSwapBuffers(window);
+		// 이 프레임에 반영된 입력의 지연. GPU 가 끝난 시각은 fence 로 다음 프레임들에서 확인한다.
+		int64_t swapNs = jobNowNs();
+		if (frame.tracedInputs > 0) {
+			addLatency(swapLatency, (swapNs - frame.tracedInputNs) / 1e6);
+			if (latencyFenceCount < latencyFences) {
+				int slot = (latencyFenceHead + latencyFenceCount) % latencyFences;
+				latencyFence[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+				latencyInputNs[slot] = frame.tracedInputNs;
+				latencyFenceCount++;
+			}
+		}
+		while (latencyFenceCount > 0) {
+			GLenum status = glClientWaitSync(latencyFence[latencyFenceHead], 0, 0);
+			if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED)
+				break;
+			addLatency(gpuLatency, (jobNowNs() - latencyInputNs[latencyFenceHead]) / 1e6);
+			glDeleteSync(latencyFence[latencyFenceHead]);
+			latencyFenceHead = (latencyFenceHead + 1) % latencyFences;
+			latencyFenceCount--;
+		}
 		glfwPollEvents();
+		markStartupFrame(startup);
+		// 모든 파이프라인과 하늘 표가 준비된 첫 프레임에 한번만 출력한다
+		markStartupLoaded(startup, debrisProgramID != 0 && particleProgramID != 0 && hudProgramID != 0 &&
+			skyProgramID != 0 && upscaleProgramID != 0 && loadProgramID != 0 && sky.uploaded);
+		// 발사대 위에서 입력도 없으면 속도를 내린다. 떨어지는 잔해나 입자가 남아 있으면 움직이는 것으로 본다.
+		paceFrame(pacer, frame.inputActive || flight.sky == 1 || particles.count > 0 ||
+			debris.count > debris.stats.resting || capture.active);
+		endAllocationFrame(allocCheck, glfwGetTime());
+		if (allocCheckFrames > 0 && allocCheck.frame >= allocCheckFrames)
+			break;
 
 	} // Check if the ESC key was pressed or the window was closed
 	while( glfwGetKey(window, GLFW_KEY_ESCAPE ) != GLFW_PRESS &&
 		   glfwWindowShouldClose(window) == 0 );
 
+	for (int m = 0; m < PACING_MODES; m++) {
+		const PacingStats & s = pacer.total[m];
+		if (s.frames > 0)
+			printf("Pacing %-8s : %llu frames in %.1f s, frame %.2f +- %.2f ms (max %.2f), cpu %.0f%%, %.0f wakeups/s, idle %.0f%%\n",
+				pacingModeName((PacingMode)m), (unsigned long long)s.frames, s.wallSeconds, pacingMeanMs(s), pacingStdDevMs(s),
+				s.maxMs, pacingCpuPercent(s), pacingWakeupsPerSecond(s), s.idleFrames * 100.0 / s.frames);
+	}
+	if (swapLatency.samples > 0) {
+		printLatency(swapLatency, "Input to swap");
+		printLatency(gpuLatency, "Input to GPU done");
+	}
+	stopCapture(capture);
+	closeTelemetryPublisher(telemetry, TELEMETRY_NAME);
+	freeFrameArena(frameMemory);
+	// 하늘 표를 아직 만드는 중이면 끝날 때까지
+	finishSkyPrecompute(sky);
+	stopJobs(jobs);
+
 	// Cleanup VBO and shader
-	glDeleteBuffers(1, &vertexbuffer);
-	glDeleteBuffers(1, &colorbuffer);
-	glDeleteProgram(programID);
-	glDeleteVertexArrays(1, &VertexArrayID);
+	// 핸들은 보통 소멸자에서 놓지만 main 의 지역 변수는 컨텍스트가 없어진 뒤에 소멸하므로 여기서 먼저 놓는다
+	meshBuffers.clear();
+	trajectoryBuffer.reset();
+	program.reset();
+	debrisProgram.reset();
+	particleProgram.reset();
+	hudProgram.reset();
+	skyProgram.reset();
+	upscaleProgram.reset();
+	loadProgram.reset();
+	if (sceneTargetId != GPU_NONE)
+		releaseGpu(gpu, sceneTargetId);
+	for (int i = 0; i < 4; i++)
+		if (skyTextureIds[i] != GPU_NONE)
+			releaseGpu(gpu, skyTextureIds[i]);
+	releaseGpu(gpu, debrisStreamId);
+	releaseGpu(gpu, particleStreamId);
+	releaseGpu(gpu, hudStreamId);
+	releaseGpu(gpu, hudAtlasId);
+	freeStreamBuffer(debrisStream);
+	freeStreamBuffer(particleStream);
+	freeStreamBuffer(hudStream);
+	freeHud(hud);
+	freeLightBuffers(lightBuffers);
+	freeSky(sky);
+	freeSceneTarget(sceneTarget);
+	if (resolutionLog != NULL)
+		fclose(resolutionLog);
+	for (int i = 0; i < latencyFenceCount; i++)
+		glDeleteSync(latencyFence[(latencyFenceHead + i) % latencyFences]);
+	vertexArray.reset();
+	shutdownGpuResources(gpu);
 
 	// Close OpenGL window and terminate GLFW
 	glfwTerminate();
 
+	if (allocCheckFrames > 0) {
+		printf("Allocation check : %llu frames, %llu with heap allocations (%llu allocations)\n",
+			(unsigned long long)allocCheck.frame, (unsigned long long)allocCheck.badFrames,
+			(unsigned long long)allocCheck.steadyAllocations);
+		return allocCheck.badFrames > 0 ? 1 : 0;
+	}
 	return 0;
 }
 
@@ -0,0 +1,143 @@
+// SimServer 부하 테스트 클라이언트.
+// 세션 N 개를 만들어 발사시키고, 매 라운드 모든 세션에 STEP 을 한번에 보내서 응답이 다 올 때까지의 시간을 잰다.
+// 사용법 : SimClient [-s 소켓경로] [-n 세션수] [-r 라운드수]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "telemetry.hpp"
+#include "simprotocol.hpp"
+
+static bool sendAll(int fd, const void * data, size_t size){
+	const char * p = (const char *)data;
+	while (size > 0) {
+		ssize_t n = send(fd, p, size, 0);
+		if (n <= 0)
+			return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+static bool receiveAll(int fd, void * data, size_t size){
+	char * p = (char *)data;
+	while (size > 0) {
+		ssize_t n = recv(fd, p, size, 0);
+		if (n <= 0)
+			return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+// 요청을 한꺼번에 보내고 응답을 모두 받는다
+static bool roundTrip(int fd, std::vector<SimRequest> & requests, std::vector<SimResponse> & responses){
+	responses.resize(requests.size());
+	return sendAll(fd, &requests[0], requests.size() * sizeof(SimRequest)) &&
+		receiveAll(fd, &responses[0], responses.size() * sizeof(SimResponse));
+}
+
+static void fillRequests(std::vector<SimRequest> & requests, const std::vector<uint32_t> & sessions, uint8_t op, uint32_t arg){
+	requests.resize(sessions.size());
+	for (size_t i = 0; i < sessions.size(); i++) {
+		memset(&requests[i], 0, sizeof(SimRequest));
+		requests[i].op = op;
+		requests[i].session = sessions[i];
+		requests[i].arg = arg;
+		requests[i].tag = (uint32_t)i;
+	}
+}
+
+int main(int argc, char ** argv)
+{
+	const char * path = SIM_SOCKET_PATH;
+	int count = 1000;
+	int rounds = 600;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-s") == 0) path = argv[i + 1];
+		else if (strcmp(argv[i], "-n") == 0) count = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-r") == 0) rounds = atoi(argv[i + 1]);
+		else {
+			fprintf(stderr, "usage: %s [-s socket] [-n sessions] [-r rounds]\n", argv[0]);
+			return -1;
+		}
+	}
+	if (count < 1) count = 1;
+	if (rounds < 1) rounds = 1;
+
+	int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+	if (fd < 0 || connect(fd, (sockaddr *)&address, sizeof(address)) != 0) {
+		perror(path);
+		return -1;
+	}
+
+	std::vector<uint32_t> sessions(count, 0);
+	std::vector<SimRequest> requests;
+	std::vector<SimResponse> responses;
+
+	fillRequests(requests, sessions, SIM_CREATE, 0);
+	if (!roundTrip(fd, requests, responses)) {
+		fprintf(stderr, "connection lost\n");
+		return -1;
+	}
+	for (int i = 0; i < count; i++) {
+		if (responses[i].status != SIM_OK) {
+			fprintf(stderr, "could not create session %d (status %d)\n", i, responses[i].status);
+			return -1;
+		}
+		sessions[responses[i].tag] = responses[i].session;
+	}
+
+	fillRequests(requests, sessions, SIM_LAUNCH, 0);
+	roundTrip(fd, requests, responses);
+
+	// 라운드마다 모든 세션을 한 틱씩 진행
+	std::vector<double> latencies;
+	fillRequests(requests, sessions, SIM_STEP, 1);
+	for (int r = 0; r < rounds; r++) {
+		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		if (!roundTrip(fd, requests, responses)) {
+			fprintf(stderr, "connection lost\n");
+			return -1;
+		}
+		latencies.push_back(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count());
+	}
+
+	fillRequests(requests, sessions, SIM_STATS, 0);
+	roundTrip(fd, requests, responses);
+	double avgTick = 0;
+	uint32_t maxTick = 0;
+	float maxAltitude = 0;
+	for (int i = 0; i < count; i++) {
+		avgTick += responses[i].tickNs;
+		maxTick = std::max(maxTick, responses[i].maxTickNs);
+		maxAltitude = std::max(maxAltitude, responses[i].y);
+	}
+
+	fillRequests(requests, sessions, SIM_DESTROY, 0);
+	roundTrip(fd, requests, responses);
+	close(fd);
+
+	std::sort(latencies.begin(), latencies.end());
+	printf("%d sessions, %d rounds\n", count, rounds);
+	printf("round trip  p50 %.3f ms  p99 %.3f ms  max %.3f ms\n",
+		latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back());
+	printf("session tick  avg %.0f ns  max %u ns\n", avgTick / count, maxTick);
+	printf("highest altitude %.3f\n", maxAltitude);
+	return 0;
+}
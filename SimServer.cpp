@@ -0,0 +1,484 @@
+// 창 없이 Rocket 의 비행 모델을 여러 세션 돌리는 서버.
+// Unix domain socket 으로 simprotocol.hpp 의 요청을 받아서 틱마다 한꺼번에 처리한다.
+// 사용법 : SimServer [-s 소켓경로] [-t 스레드수] [-r 초당틱수] [-n 최대세션수] [-o 비행기록파일]
+// -o 를 주면 세션마다 틱별 상태를 flightlog.hpp 형식으로 기록한다 (비행 id = 세션 id).
+
+// Include standard headers
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <chrono>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "flight.hpp"
+#include "telemetry.hpp"
+#include "simprotocol.hpp"
+#include "jobs.hpp"
+#include "flightlog.hpp"
+
+static const float SIM_DELTA_TIME = FLIGHT_TICK;   // 세션 한 틱의 시간 (Rocket 과 같은 고정 틱)
+static const uint32_t SIM_MAX_STEPS = 100000;       // 요청 하나로 진행할 수 있는 최대 틱
+
+static int64_t nowNs(){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 세션 id 의 아래 20 비트는 슬롯 번호, 위는 세대. 지운 세션의 id 가 다시 쓰이지 않게 한다.
+#define SESSION_INDEX_BITS 20
+#define SESSION_INDEX_MASK ((1u << SESSION_INDEX_BITS) - 1)
+
+struct Session {
+	FlightState flight;
+	uint32_t generation;
+	bool alive;
+	int owner;                // 만든 클라이언트 자리. 연결이 끊기면 세션도 지운다.
+	uint64_t tick;
+	uint32_t pendingSteps;    // 이번 틱에 진행할 틱 수
+	uint32_t lastTickNs;      // 이번 틱에서 진행한 틱들의 평균
+	uint32_t maxTickNs;
+	uint64_t totalTickNs;
+	FlightLogTrack track;     // -o 일 때만 쓴다
+};
+
+struct Client {
+	int fd;
+	std::vector<char> input;
+	std::vector<char> output;
+};
+
+// 한 틱 동안 모인 요청
+struct PendingRequest {
+	int client;
+	SimRequest request;
+	int64_t receivedNs;
+};
+
+struct Server {
+	std::vector<Session> sessions;
+	std::vector<uint32_t> freeSlots;
+	uint32_t maxSessions;
+	uint32_t liveSessions;
+	std::vector<Client> clients;
+	std::vector<PendingRequest> batch;
+	JobSystem jobs;
+	FlightLogWriter * log;    // 기록하지 않으면 NULL
+
+	// 통계 출력용
+	uint64_t requests;
+	uint64_t steppedTicks;
+	int64_t requestLatencyNs;
+	uint32_t worstTickNs;
+};
+
+static volatile sig_atomic_t running = 1;
+static void handleSignal(int){
+	running = 0;
+}
+
+static Session * findSession(Server & server, uint32_t id){
+	uint32_t index = id & SESSION_INDEX_MASK;
+	if (index >= server.sessions.size())
+		return NULL;
+	Session & s = server.sessions[index];
+	if (!s.alive || s.generation != (id >> SESSION_INDEX_BITS))
+		return NULL;
+	return &s;
+}
+
+static uint32_t createSession(Server & server, int owner){
+	uint32_t index;
+	if (!server.freeSlots.empty()) {
+		index = server.freeSlots.back();
+		server.freeSlots.pop_back();
+	}
+	else {
+		if (server.sessions.size() >= server.maxSessions)
+			return 0;
+		index = (uint32_t)server.sessions.size();
+		server.sessions.push_back(Session());
+		server.sessions.back().generation = 0;
+	}
+	Session & s = server.sessions[index];
+	s.generation = (s.generation + 1) & (0xFFFFFFFFu >> SESSION_INDEX_BITS);
+	if (s.generation == 0)
+		s.generation = 1;    // id 0 은 "없음" 으로 쓴다
+	s.alive = true;
+	s.owner = owner;
+	initFlight(s.flight);
+	s.tick = 0;
+	s.pendingSteps = 0;
+	s.lastTickNs = 0;
+	s.maxTickNs = 0;
+	s.totalTickNs = 0;
+	server.liveSessions++;
+	uint32_t id = (s.generation << SESSION_INDEX_BITS) | index;
+	if (server.log != NULL)
+		beginFlightTrack(s.track, id, 0);
+	return id;
+}
+
+static void destroySession(Server & server, uint32_t index){
+	Session & s = server.sessions[index];
+	s.alive = false;
+	if (server.log != NULL)
+		finishFlightTrack(*server.log, s.track);
+	server.freeSlots.push_back(index);
+	server.liveSessions--;
+}
+
+static uint32_t flightFlags(const FlightState & f){
+	return (f.start ? TELEMETRY_START : 0) | (f.sky ? TELEMETRY_SKY : 0) |
+		(f.suit ? TELEMETRY_SUIT : 0) | (f.main > 0.0f ? TELEMETRY_ENGINE : 0);
+}
+
+static void fillResponse(SimResponse & out, const PendingRequest & p, uint8_t status, uint32_t id, const Session * s){
+	memset(&out, 0, sizeof(out));
+	out.tag = p.request.tag;
+	out.op = p.request.op;
+	out.status = status;
+	out.session = id;
+	if (s == NULL)
+		return;
+	const FlightState & f = s->flight;
+	out.tick = s->tick;
+	out.x = f.gro1.x;
+	out.y = f.gro1.y;
+	out.z = f.gro1.z;
+	out.velocity = f.velocity;
+	out.thrust = f.main;
+	out.flags = flightFlags(f);
+	out.maxTickNs = s->maxTickNs;
+	if (p.request.op == SIM_STATS)
+		out.tickNs = s->tick > 0 ? (uint32_t)(s->totalTickNs / s->tick) : 0;
+	else
+		out.tickNs = s->lastTickNs;
+}
+
+struct StepContext {
+	Server * server;
+	std::atomic<uint64_t> stepped;
+	std::atomic<uint32_t> worst;
+};
+
+// 밀린 틱이 있는 세션들을 진행한다. 스레드 풀에서 세션 구간마다 불린다.
+static void stepSessions(void * data, int begin, int end){
+	StepContext * context = (StepContext *)data;
+	uint64_t localSteps = 0;
+	uint32_t localWorst = 0;
+	for (int i = begin; i < end; i++) {
+		Session & s = context->server->sessions[i];
+		if (!s.alive || s.pendingSteps == 0)
+			continue;
+		FlightLogWriter * log = context->server->log;
+		int64_t start = nowNs();
+		for (uint32_t k = 0; k < s.pendingSteps; k++) {
+			updateFlight(s.flight, SIM_DELTA_TIME);
+			if (log != NULL)
+				appendFlightTrack(*log, s.track, s.flight.gro1.x, s.flight.gro1.y, s.flight.gro1.z, s.flight.velocity, flightFlags(s.flight));
+		}
+		int64_t elapsed = nowNs() - start;
+		s.tick += s.pendingSteps;
+		s.totalTickNs += (uint64_t)elapsed;
+		s.lastTickNs = (uint32_t)(elapsed / s.pendingSteps);
+		if (s.lastTickNs > s.maxTickNs)
+			s.maxTickNs = s.lastTickNs;
+		if (s.lastTickNs > localWorst)
+			localWorst = s.lastTickNs;
+		localSteps += s.pendingSteps;
+		s.pendingSteps = 0;
+	}
+	context->stepped += localSteps;
+	uint32_t current = context->worst.load();
+	while (localWorst > current && !context->worst.compare_exchange_weak(current, localWorst)) {}
+}
+
+// 틱 경계에서 모인 요청을 처리한다.
+// 1. 명령을 적용하고 2. 세션들을 병렬로 진행한 다음 3. 모든 요청에 응답한다.
+static void runTick(Server & server){
+	for (size_t i = 0; i < server.batch.size(); i++) {
+		PendingRequest & p = server.batch[i];
+		if (p.request.op == SIM_CREATE) {
+			p.request.session = createSession(server, p.client);
+			continue;
+		}
+		Session * s = findSession(server, p.request.session);
+		if (s == NULL)
+			continue;
+		switch (p.request.op) {
+		case SIM_LAUNCH: launchFlight(s->flight); break;
+		case SIM_PARACHUTE: deployParachute(s->flight); break;
+		case SIM_STEP: {
+			// 더하기 전에 자른다 (arg 가 UINT32_MAX 근처면 더한 값이 넘쳐서 작아진다)
+			uint32_t steps = p.request.arg == 0 ? 1 : p.request.arg;
+			if (steps > SIM_MAX_STEPS - s->pendingSteps)
+				steps = SIM_MAX_STEPS - s->pendingSteps;
+			s->pendingSteps += steps;
+			break;
+		}
+		default: break;
+		}
+	}
+
+	StepContext context;
+	context.server = &server;
+	context.stepped.store(0);
+	context.worst.store(0);
+	parallelFor(server.jobs, (int)server.sessions.size(), 256, stepSessions, &context);
+	server.steppedTicks += context.stepped.load();
+	if (context.worst.load() > server.worstTickNs)
+		server.worstTickNs = context.worst.load();
+
+	int64_t now = nowNs();
+	for (size_t i = 0; i < server.batch.size(); i++) {
+		PendingRequest & p = server.batch[i];
+		SimResponse response;
+		Session * s = findSession(server, p.request.session);
+		uint8_t status = SIM_OK;
+		if (p.request.op == SIM_CREATE && p.request.session == 0)
+			status = SIM_FULL;
+		else if (p.request.op < SIM_CREATE || p.request.op > SIM_STATS)
+			status = SIM_BAD_REQUEST;
+		else if (s == NULL)
+			status = SIM_NO_SESSION;
+		fillResponse(response, p, status, p.request.session, s);
+
+		if (p.request.op == SIM_DESTROY && s != NULL)
+			destroySession(server, p.request.session & SESSION_INDEX_MASK);
+
+		if (p.client >= 0 && p.client < (int)server.clients.size() && server.clients[p.client].fd >= 0) {
+			std::vector<char> & out = server.clients[p.client].output;
+			out.insert(out.end(), (const char *)&response, (const char *)&response + sizeof(response));
+		}
+		server.requestLatencyNs += now - p.receivedNs;
+	}
+	server.requests += server.batch.size();
+	server.batch.clear();
+}
+
+// 아직 처리하지 않은 요청도 버린다. 자리는 다음 accept 가 다시 쓰므로 남겨 두면 응답이 새 연결로 가고,
+// 만들기 요청은 아무도 모르는 세션을 만든다. 이 클라이언트가 만든 세션도 아무도 닫지 않으므로 지운다.
+static void closeClient(Server & server, int index){
+	size_t kept = 0;
+	for (size_t i = 0; i < server.batch.size(); i++) {
+		if (server.batch[i].client != index)
+			server.batch[kept++] = server.batch[i];
+	}
+	server.batch.resize(kept);
+	for (size_t i = 0; i < server.sessions.size(); i++) {
+		if (server.sessions[i].alive && server.sessions[i].owner == index)
+			destroySession(server, (uint32_t)i);
+	}
+	close(server.clients[index].fd);
+	server.clients[index].fd = -1;
+	server.clients[index].input.clear();
+	server.clients[index].output.clear();
+}
+
+static bool readClient(Server & server, int index){
+	Client & c = server.clients[index];
+	char buffer[16384];
+	for (;;) {
+		ssize_t n = recv(c.fd, buffer, sizeof(buffer), 0);
+		if (n > 0) {
+			c.input.insert(c.input.end(), buffer, buffer + n);
+			continue;
+		}
+		if (n == 0)
+			return false;
+		if (errno == EAGAIN || errno == EWOULDBLOCK)
+			break;
+		if (errno == EINTR)
+			continue;
+		return false;
+	}
+	size_t records = c.input.size() / sizeof(SimRequest);
+	int64_t now = nowNs();
+	for (size_t i = 0; i < records; i++) {
+		PendingRequest p;
+		p.client = index;
+		memcpy(&p.request, &c.input[i * sizeof(SimRequest)], sizeof(SimRequest));
+		p.receivedNs = now;
+		server.batch.push_back(p);
+	}
+	c.input.erase(c.input.begin(), c.input.begin() + records * sizeof(SimRequest));
+	return true;
+}
+
+static bool flushClient(Client & c){
+	while (!c.output.empty()) {
+		ssize_t n = send(c.fd, &c.output[0], c.output.size(), MSG_NOSIGNAL);
+		if (n > 0) {
+			c.output.erase(c.output.begin(), c.output.begin() + n);
+			continue;
+		}
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return true;
+		if (n < 0 && errno == EINTR)
+			continue;
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char ** argv)
+{
+	const char * path = SIM_SOCKET_PATH;
+	int threads = (int)std::thread::hardware_concurrency();
+	double rate = 60.0;
+	uint32_t maxSessions = 100000;
+	const char * logPath = NULL;
+	for (int i = 1; i + 1 < argc; i += 2) {
+		if (strcmp(argv[i], "-s") == 0) path = argv[i + 1];
+		else if (strcmp(argv[i], "-t") == 0) threads = atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-r") == 0) rate = atof(argv[i + 1]);
+		else if (strcmp(argv[i], "-n") == 0) maxSessions = (uint32_t)atoi(argv[i + 1]);
+		else if (strcmp(argv[i], "-o") == 0) logPath = argv[i + 1];
+		else {
+			fprintf(stderr, "usage: %s [-s socket] [-t threads] [-r ticks per second] [-n max sessions] [-o flight log]\n", argv[0]);
+			return -1;
+		}
+	}
+	if (threads < 1) threads = 1;
+	if (rate <= 0) rate = 60.0;
+	if (maxSessions > SESSION_INDEX_MASK) maxSessions = SESSION_INDEX_MASK;
+
+	int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+	if (listener < 0) {
+		perror("socket");
+		return -1;
+	}
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+	unlink(path);
+	if (bind(listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(listener, 64) != 0) {
+		perror(path);
+		close(listener);
+		return -1;
+	}
+	fcntl(listener, F_SETFL, O_NONBLOCK);
+	signal(SIGINT, handleSignal);
+	signal(SIGTERM, handleSignal);
+
+	Server server;
+	server.maxSessions = maxSessions;
+	server.liveSessions = 0;
+	server.requests = 0;
+	server.steppedTicks = 0;
+	server.requestLatencyNs = 0;
+	server.worstTickNs = 0;
+	server.log = NULL;
+	FlightLogWriter log;
+	if (logPath != NULL) {
+		if (!openFlightLog(log, logPath, NULL)) {
+			perror(logPath);
+			close(listener);
+			unlink(path);
+			return -1;
+		}
+		server.log = &log;
+	}
+	startJobs(server.jobs, threads);
+	printf("SimServer listening on %s (%d threads, %.0f ticks/s)\n", path, threads, rate);
+
+	const int64_t period = (int64_t)(1e9 / rate);
+	int64_t nextTick = nowNs() + period;
+	int64_t nextReport = nowNs() + 5000000000LL;
+	uint64_t ticks = 0;
+	std::vector<pollfd> fds;
+	while (running) {
+		fds.clear();
+		pollfd listen_fd = { listener, POLLIN, 0 };
+		fds.push_back(listen_fd);
+		for (size_t i = 0; i < server.clients.size(); i++) {
+			pollfd p = { server.clients[i].fd, (short)(POLLIN | (server.clients[i].output.empty() ? 0 : POLLOUT)), 0 };
+			fds.push_back(p);
+		}
+		// 밀리초로 올림한다. 내림하면 1 ms 안쪽에서는 0 이 되어 틱까지 poll 이 계속 바로 돌아온다.
+		int64_t wait = (nextTick - nowNs() + 999999) / 1000000;
+		if (wait < 0) wait = 0;
+		poll(&fds[0], fds.size(), (int)wait);
+
+		if (fds[0].revents & POLLIN) {
+			int fd;
+			while ((fd = accept(listener, NULL, NULL)) >= 0) {
+				fcntl(fd, F_SETFL, O_NONBLOCK);
+				Client c;
+				c.fd = fd;
+				// 닫힌 클라이언트 자리를 다시 쓴다
+				size_t slot = 0;
+				while (slot < server.clients.size() && server.clients[slot].fd >= 0)
+					slot++;
+				if (slot == server.clients.size())
+					server.clients.push_back(c);
+				else
+					server.clients[slot] = c;
+			}
+		}
+		for (size_t i = 1; i < fds.size(); i++) {
+			int index = (int)i - 1;
+			if (fds[i].fd < 0 || server.clients[index].fd != fds[i].fd)
+				continue;
+			if ((fds[i].revents & (POLLIN | POLLHUP | POLLERR)) && !readClient(server, index))
+				closeClient(server, index);
+		}
+
+		int64_t now = nowNs();
+		if (now >= nextTick) {
+			runTick(server);
+			ticks++;
+			nextTick += period;
+			if (nextTick < now)   // 너무 밀렸으면 따라잡으려 하지 않는다
+				nextTick = now + period;
+			for (size_t i = 0; i < server.clients.size(); i++) {
+				if (server.clients[i].fd >= 0 && !flushClient(server.clients[i]))
+					closeClient(server, (int)i);
+			}
+		}
+
+		if (now >= nextReport) {
+			printf("sessions %u  ticks %llu  session ticks/s %.0f  requests/s %.0f  avg request latency %.3f ms  worst session tick %u ns\n",
+				server.liveSessions, (unsigned long long)ticks, server.steppedTicks / 5.0, server.requests / 5.0,
+				server.requests > 0 ? server.requestLatencyNs / 1e6 / server.requests : 0.0, server.worstTickNs);
+			server.steppedTicks = 0;
+			server.requests = 0;
+			server.requestLatencyNs = 0;
+			server.worstTickNs = 0;
+			nextReport = now + 5000000000LL;
+		}
+	}
+
+	stopJobs(server.jobs);
+	if (server.log != NULL) {
+		for (size_t i = 0; i < server.sessions.size(); i++) {
+			if (server.sessions[i].alive)
+				finishFlightTrack(log, server.sessions[i].track);
+		}
+		FlightLogStats & stats = log.stats;
+		bool ok = closeFlightLog(log);
+		printf("Flight log %s : %llu ticks in %llu blocks, %.1f MB (%.1fx smaller than raw)%s\n", logPath,
+			(unsigned long long)stats.ticks, (unsigned long long)stats.blocks, stats.encodedBytes / 1e6,
+			stats.encodedBytes > 0 ? (double)stats.ticks * FLIGHTLOG_RAW_TICK_BYTES / stats.encodedBytes : 0.0,
+			ok ? "" : " (write failed)");
+	}
+	for (size_t i = 0; i < server.clients.size(); i++) {
+		if (server.clients[i].fd >= 0)
+			close(server.clients[i].fd);
+	}
+	close(listener);
+	unlink(path);
+	return 0;
+}
@@ -0,0 +1,40 @@
+// Rocket 이 내보내는 텔레메트리를 읽어서 출력하는 예제 프로그램.
+// 사용법 : TelemetryMonitor [공유 메모리 이름]
+
+#include <stdio.h>
+#include <thread>
+#include <chrono>
+
+#include "telemetry.hpp"
+
+int main(int argc, char ** argv)
+{
+	const char * name = argc > 1 ? argv[1] : TELEMETRY_NAME;
+	TelemetryReader reader;
+	while (!openTelemetryReader(reader, name)) {
+		fprintf(stderr, "Waiting for %s...\n", name);
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+	}
+
+	TelemetrySample sample;
+	for (;;) {
+		TelemetryStatus status = readTelemetry(reader, sample);
+		if (status == TELEMETRY_EMPTY) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		if (status == TELEMETRY_OVERRUN) {
+			fprintf(stderr, "missed %llu samples\n", (unsigned long long)reader.missed);
+			continue;
+		}
+		printf("#%llu  x %.3f  y %.3f  velocity %.5f  thrust %.6f  %s%s%s  camera %u  latency %.1f us\n",
+			(unsigned long long)sample.sequence, sample.x, sample.y, sample.velocity, sample.thrust,
+			(sample.flags & TELEMETRY_ENGINE) ? "engine " : "",
+			(sample.flags & TELEMETRY_SKY) ? "sky " : "",
+			(sample.flags & TELEMETRY_SUIT) ? "parachute " : "",
+			sample.cameraMode, (telemetryNow() - sample.timeNs) / 1000.0);
+	}
+
+	closeTelemetryReader(reader);
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "arena.hpp"
+
+void initArena(LinearArena & a, size_t capacity){
+	a.base = (unsigned char *)malloc(capacity);
+	a.capacity = a.base != NULL ? capacity : 0;
+	a.used = 0;
+	a.peak = 0;
+	a.overflows = 0;
+}
+
+void freeArena(LinearArena & a){
+	free(a.base);
+	a.base = NULL;
+	a.capacity = 0;
+	a.used = 0;
+}
+
+void * arenaAlloc(LinearArena & a, size_t size, size_t align){
+	uintptr_t start = ((uintptr_t)a.base + a.used + (align - 1)) & ~(uintptr_t)(align - 1);
+	size_t end = (size_t)(start - (uintptr_t)a.base) + size;
+	if (end > a.capacity) {
+		if (a.overflows++ == 0)
+			fprintf(stderr, "Arena overflow : %zu bytes requested, %zu of %zu used\n", size, a.used, a.capacity);
+		return NULL;
+	}
+	a.used = end;
+	if (a.used > a.peak)
+		a.peak = a.used;
+	return (void *)start;
+}
+
+void initFrameArena(FrameArena & f, size_t capacityPerFrame){
+	initArena(f.buffers[0], capacityPerFrame);
+	initArena(f.buffers[1], capacityPerFrame);
+	f.current = 0;
+	f.frame = 0;
+}
+
+void freeFrameArena(FrameArena & f){
+	freeArena(f.buffers[0]);
+	freeArena(f.buffers[1]);
+}
+
+void beginArenaFrame(FrameArena & f){
+	f.current ^= 1;
+	resetArena(f.buffers[f.current]);
+	f.frame++;
+}
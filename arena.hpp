@@ -0,0 +1,57 @@
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <new>
+
+// 프레임 단위 메모리.
+// LinearArena 는 앞에서부터 잘라 쓰기만 하고 한꺼번에 비운다 (bump allocator).
+// FrameArena 는 그것을 두 개 번갈아 써서, 지난 프레임에 받은 메모리가 이번 프레임 동안에도 남아 있게 한다.
+// 둘 다 처음에 한번만 힙에서 받고, 루프 안에서는 힙을 쓰지 않는다.
+
+struct LinearArena {
+	unsigned char * base;
+	size_t capacity;
+	size_t used;
+	size_t peak;         // 가장 많이 썼을 때
+	size_t overflows;    // 공간이 모자라서 NULL 을 돌려준 횟수
+};
+
+void initArena(LinearArena & a, size_t capacity);
+void freeArena(LinearArena & a);
+// 공간이 모자라면 NULL
+void * arenaAlloc(LinearArena & a, size_t size, size_t align);
+
+inline void resetArena(LinearArena & a){
+	a.used = 0;
+}
+
+// 생성자는 부르지만 소멸자는 부르지 않는다. 소멸자가 필요 없는 타입에만 쓴다.
+template<typename T>
+T * arenaAllocArray(LinearArena & a, size_t count){
+	void * memory = arenaAlloc(a, sizeof(T) * count, alignof(T));
+	if (memory == NULL)
+		return NULL;
+	T * items = (T *)memory;
+	for (size_t i = 0; i < count; i++)
+		new (&items[i]) T();
+	return items;
+}
+
+struct FrameArena {
+	LinearArena buffers[2];
+	int current;
+	uint64_t frame;
+};
+
+void initFrameArena(FrameArena & f, size_t capacityPerFrame);
+void freeFrameArena(FrameArena & f);
+// 프레임 시작에 부른다. 두 프레임 전 버퍼를 비우고 이번 프레임 버퍼로 쓴다.
+void beginArenaFrame(FrameArena & f);
+
+inline LinearArena & frameArena(FrameArena & f){
+	return f.buffers[f.current];
+}
+
+#endif
@@ -0,0 +1,240 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include "capture.hpp"
+
+// RGBA(아래에서 위로) 를 YUV 4:2:0 (BT.601, full range) 으로 바꿔서 쓴다
+static void writeY4MFrame(FILE * file, const unsigned char * rgba, int width, int height, std::vector<unsigned char> & yuv){
+	const int cw = width / 2, ch = height / 2;
+	yuv.resize(width * height + 2 * cw * ch);
+	unsigned char * Y = &yuv[0];
+	unsigned char * U = Y + width * height;
+	unsigned char * V = U + cw * ch;
+	for (int y = 0; y < height; y++) {
+		const unsigned char * row = rgba + (height - 1 - y) * width * 4;
+		for (int x = 0; x < width; x++) {
+			int r = row[x * 4 + 0], g = row[x * 4 + 1], b = row[x * 4 + 2];
+			Y[y * width + x] = (unsigned char)((77 * r + 150 * g + 29 * b) >> 8);
+		}
+	}
+	for (int y = 0; y < ch; y++) {
+		const unsigned char * row0 = rgba + (height - 1 - 2 * y) * width * 4;
+		const unsigned char * row1 = rgba + (height - 2 - 2 * y) * width * 4;
+		for (int x = 0; x < cw; x++) {
+			int r = row0[x * 8] + row0[x * 8 + 4] + row1[x * 8] + row1[x * 8 + 4];
+			int g = row0[x * 8 + 1] + row0[x * 8 + 5] + row1[x * 8 + 1] + row1[x * 8 + 5];
+			int b = row0[x * 8 + 2] + row0[x * 8 + 6] + row1[x * 8 + 2] + row1[x * 8 + 6];
+			U[y * cw + x] = (unsigned char)(((-43 * r - 85 * g + 128 * b) >> 10) + 128);
+			V[y * cw + x] = (unsigned char)(((128 * r - 107 * g - 21 * b) >> 10) + 128);
+		}
+	}
+	fputs("FRAME\n", file);
+	fwrite(&yuv[0], 1, yuv.size(), file);
+}
+
+static void writeRawFrame(FILE * file, const unsigned char * rgba, int width, int height, std::vector<unsigned char> & rgb){
+	rgb.resize(width * height * 3);
+	for (int y = 0; y < height; y++) {
+		const unsigned char * row = rgba + (height - 1 - y) * width * 4;
+		unsigned char * out = &rgb[y * width * 3];
+		for (int x = 0; x < width; x++) {
+			out[x * 3 + 0] = row[x * 4 + 0];
+			out[x * 3 + 1] = row[x * 4 + 1];
+			out[x * 3 + 2] = row[x * 4 + 2];
+		}
+	}
+	fwrite(&rgb[0], 1, rgb.size(), file);
+}
+
+static void captureWorker(FrameCapture * c){
+	std::vector<unsigned char> converted;
+	converted.reserve(c->width * c->height * 3);
+	for (;;) {
+		int index;
+		{
+			std::unique_lock<std::mutex> guard(c->lock);
+			c->wake.wait(guard, [c] { return c->stopping || c->pendingCount > 0; });
+			if (c->pendingCount == 0)
+				return;   // stopping 이고 남은 프레임도 없음
+			index = c->pending[c->pendingHead];
+			c->pendingHead = (c->pendingHead + 1) % CAPTURE_QUEUE;
+			c->pendingCount--;
+		}
+		const unsigned char * frame = &c->frames[index][0];
+		if (c->format == CAPTURE_Y4M)
+			writeY4MFrame(c->file, frame, c->width, c->height, converted);
+		else
+			writeRawFrame(c->file, frame, c->width, c->height, converted);
+		{
+			std::lock_guard<std::mutex> guard(c->lock);
+			c->framesWritten++;
+			c->spare[c->spareCount++] = index;
+		}
+	}
+}
+
+// 링의 PBO 들을 width x height 로 (다시) 잡는다. 끝나지 않은 슬롯이 없을 때만 부른다.
+static void allocateRing(FrameCapture & c, int width, int height){
+	const GLsizeiptr bytes = (GLsizeiptr)width * height * 4;
+	for (int i = 0; i < CAPTURE_RING; i++) {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, c.pbos[i]);
+		glBufferData(GL_PIXEL_PACK_BUFFER, bytes, NULL, GL_STREAM_READ);
+		c.fences[i] = 0;
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	c.readWidth = width;
+	c.readHeight = height;
+	c.next = 0;
+}
+
+bool startCapture(FrameCapture & c, const char * path, int width, int height, int fps, CaptureFormat format){
+	c.file = fopen(path, "wb");
+	if (c.file == NULL) {
+		fprintf(stderr, "Failed to open %s for capture\n", path);
+		return false;
+	}
+	c.width = width & ~1;   // 4:2:0 이라 짝수로 맞춘다
+	c.height = height & ~1;
+	c.format = format;
+	if (format == CAPTURE_Y4M)
+		fprintf(c.file, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C420jpeg\n", c.width, c.height, fps);
+
+	glGenBuffers(CAPTURE_RING, c.pbos);
+	allocateRing(c, c.width, c.height);
+
+	// 워커에 넘길 버퍼는 미리 만들어 두고 돌려쓴다 (출력 크기)
+	const size_t frameBytes = (size_t)c.width * c.height * 4;
+	for (int i = 0; i < CAPTURE_QUEUE; i++) {
+		c.frames[i].resize(frameBytes);
+		c.spare[i] = i;
+	}
+	c.spareCount = CAPTURE_QUEUE;
+	c.pendingHead = 0;
+	c.pendingCount = 0;
+
+	c.stopping = false;
+	c.framesWritten = 0;
+	c.framesDropped = 0;
+	c.resizes = 0;
+	c.framesSubmitted = 0;
+	c.renderThreadTime = 0;
+	c.worker = std::thread(captureWorker, &c);
+	c.active = true;
+	printf("Capture started : %s (%dx%d)\n", path, c.width, c.height);
+	return true;
+}
+
+// fence 가 끝난 슬롯을 map 해서 워커에 넘긴다. wait 가 false 면 끝나지 않은 슬롯은 건너뛴다.
+static void collectSlot(FrameCapture & c, int slot, bool wait){
+	if (c.fences[slot] == 0)
+		return;
+	// 기다릴 때는 fence 가 아직 GPU 에 안 넘어갔을 수 있으므로 flush 한다 (안 하면 영원히 기다릴 수 있다)
+	GLenum status = glClientWaitSync(c.fences[slot], wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? GL_TIMEOUT_IGNORED : 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+		return;
+	glDeleteSync(c.fences[slot]);
+	c.fences[slot] = 0;
+	// fence 가 깨졌으면 PBO 가 다 찼는지 알 수 없다. 읽지 않고 이 프레임은 버린다.
+	if (status == GL_WAIT_FAILED) {
+		c.framesDropped++;
+		return;
+	}
+
+	int index = -1;
+	{
+		std::lock_guard<std::mutex> guard(c.lock);
+		if (c.spareCount > 0)
+			index = c.spare[--c.spareCount];
+	}
+	if (index < 0) {   // 워커가 밀려 있으면 이 프레임은 버린다
+		c.framesDropped++;
+		return;
+	}
+
+	std::vector<unsigned char> & frame = c.frames[index];
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, c.pbos[slot]);
+	const GLsizeiptr readBytes = (GLsizeiptr)c.readWidth * c.readHeight * 4;
+	const unsigned char * pixels = (const unsigned char *)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, readBytes, GL_MAP_READ_BIT);
+	if (pixels != NULL) {
+		if (c.readWidth == c.width && c.readHeight == c.height)
+			memcpy(&frame[0], pixels, frame.size());
+		else {
+			// 크기가 바뀐 뒤의 프레임. 왼쪽 아래를 맞추고, 넘치면 자르고 모자라면 검게 둔다.
+			const int rows = c.readHeight < c.height ? c.readHeight : c.height;
+			const int columns = c.readWidth < c.width ? c.readWidth : c.width;
+			memset(&frame[0], 0, frame.size());
+			for (int y = 0; y < rows; y++)
+				memcpy(&frame[(size_t)y * c.width * 4], pixels + (size_t)y * c.readWidth * 4, (size_t)columns * 4);
+		}
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	std::lock_guard<std::mutex> guard(c.lock);
+	c.pending[(c.pendingHead + c.pendingCount) % CAPTURE_QUEUE] = index;
+	c.pendingCount++;
+	c.wake.notify_one();
+}
+
+void captureFrame(FrameCapture & c, int width, int height){
+	if (!c.active)
+		return;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+
+	// 창 크기가 바뀌었으면 옛 크기로 읽은 슬롯을 모두 가져간 뒤 링을 새 크기로 만든다 (출력처럼 짝수로)
+	width &= ~1;
+	height &= ~1;
+	if (width > 0 && height > 0 && (width != c.readWidth || height != c.readHeight)) {
+		for (int i = 0; i < CAPTURE_RING; i++)
+			collectSlot(c, (c.next + i) % CAPTURE_RING, true);
+		allocateRing(c, width, height);
+		c.resizes++;
+	}
+
+	// 지난 프레임들 중 GPU 가 끝낸 것부터 가져간다 (오래된 순서)
+	for (int i = 0; i < CAPTURE_RING; i++)
+		collectSlot(c, (c.next + i) % CAPTURE_RING, false);
+
+	if (c.fences[c.next] != 0 || width <= 0 || height <= 0) {
+		// 링이 꽉 찼거나 창이 최소화됐다. 기다리지 않고 이번 프레임을 버린다.
+		c.framesDropped++;
+	}
+	else {
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, c.pbos[c.next]);
+		glReadPixels(0, 0, c.readWidth, c.readHeight, GL_RGBA, GL_UNSIGNED_BYTE, (void*)0);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		c.fences[c.next] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+		c.next = (c.next + 1) % CAPTURE_RING;
+	}
+
+	c.framesSubmitted++;
+	c.renderThreadTime += std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+}
+
+void stopCapture(FrameCapture & c){
+	if (!c.active)
+		return;
+	// 아직 GPU 에 남아있는 프레임까지 순서대로 가져간다
+	for (int i = 0; i < CAPTURE_RING; i++)
+		collectSlot(c, (c.next + i) % CAPTURE_RING, true);
+	{
+		std::lock_guard<std::mutex> guard(c.lock);
+		c.stopping = true;
+		c.wake.notify_one();
+	}
+	c.worker.join();
+	glDeleteBuffers(CAPTURE_RING, c.pbos);
+	fclose(c.file);
+	c.file = NULL;
+	c.active = false;
+	printf("Capture stopped : %d frames written, %d dropped, %d resizes, %.3f ms/frame on render thread\n",
+		c.framesWritten, c.framesDropped, c.resizes,
+		c.framesSubmitted > 0 ? c.renderThreadTime * 1000.0 / c.framesSubmitted : 0.0);
+}
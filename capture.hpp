@@ -0,0 +1,64 @@
+#ifndef CAPTURE_HPP
+#define CAPTURE_HPP
+
+#include <stdio.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include <GL/glew.h>
+
+// 화면 녹화. 백버퍼를 PBO 링에 비동기로 읽어두고 (glReadPixels + fence),
+// fence 가 끝난 슬롯만 map 해서 워커 스레드로 넘긴다. 렌더 스레드는 GPU 를 기다리지 않는다.
+// 워커 스레드는 RGBA 를 YUV 4:2:0 으로 바꿔서 Y4M 으로 쓰거나, RGB 그대로 raw 로 쓴다.
+// 창 크기가 바뀌면 PBO 링을 새 크기로 다시 만든다. 출력 크기는 시작할 때 그대로 (왼쪽 아래 기준으로 자르거나 검게 채운다).
+
+#define CAPTURE_RING 4        // PBO 개수
+#define CAPTURE_QUEUE 8       // 워커가 밀려 있을 수 있는 최대 프레임 수
+
+enum CaptureFormat {
+	CAPTURE_Y4M,
+	CAPTURE_RAW_RGB
+};
+
+struct FrameCapture {
+	bool active = false;
+	int width, height;         // 출력 크기
+	int readWidth, readHeight; // PBO 링을 만든 크기 (프레임버퍼)
+	CaptureFormat format;
+	FILE * file = NULL;
+
+	GLuint pbos[CAPTURE_RING];
+	GLsync fences[CAPTURE_RING];
+	int next;               // 다음에 읽어올 슬롯
+
+	std::thread worker;
+	std::mutex lock;
+	std::condition_variable wake;
+	// 프레임 버퍼는 시작할 때 CAPTURE_QUEUE 개 만들어 두고 돌려쓴다 (루프 안에서 힙 할당 없음)
+	std::vector<unsigned char> frames[CAPTURE_QUEUE];
+	int pending[CAPTURE_QUEUE];   // 쓰기 기다리는 프레임 번호 (원형 큐)
+	int pendingHead, pendingCount;
+	int spare[CAPTURE_QUEUE];     // 비어있는 프레임 번호 (스택)
+	int spareCount;
+	bool stopping;
+
+	// 통계
+	int framesWritten;
+	int framesDropped;
+	int resizes;
+	double renderThreadTime;   // captureFrame 안에서 쓴 시간 합 (초)
+	int framesSubmitted;
+};
+
+// 녹화를 시작한다. 실패하면 false.
+bool startCapture(FrameCapture & c, const char * path, int width, int height, int fps, CaptureFormat format);
+
+// 그리기가 끝나고 swap 하기 전에 매 프레임 부른다. 현재 read framebuffer (width x height) 를 읽는다.
+void captureFrame(FrameCapture & c, int width, int height);
+
+// 남은 프레임을 모두 쓰고 녹화를 끝낸다. 통계를 출력한다.
+void stopCapture(FrameCapture & c);
+
+#endif
@@ -0,0 +1,505 @@
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#include <glm/glm.hpp>
+
+#include "collision.hpp"
+
+using namespace glm;
+
+// 이보다 많은 칸을 걸치는 물체는 해시에 넣지 않고 모든 물체와 직접 비교한다
+static const int MAX_CELLS_PER_BODY = 64;
+// 쌍을 만들 때 한 청크가 맡는 버킷 수의 최소값
+static const int MIN_BUCKETS_PER_CHUNK = 256;
+static const int PAIR_CHUNKS = 64;
+static const int NARROW_CHUNK = 1024;
+
+static int cellCoordinate(float v, float cellSize){
+	return (int)floorf(v / cellSize);
+}
+
+static uint32_t hashCell(int x, int y, int z){
+	return ((uint32_t)x * 73856093u) ^ ((uint32_t)y * 19349663u) ^ ((uint32_t)z * 83492791u);
+}
+
+static bool overlaps(const CollisionWorld & w, int a, int b){
+	const vec3 & minA = w.boundsMin[a];
+	const vec3 & maxA = w.boundsMax[a];
+	const vec3 & minB = w.boundsMin[b];
+	const vec3 & maxB = w.boundsMax[b];
+	return minA.x <= maxB.x && minB.x <= maxA.x &&
+		minA.y <= maxB.y && minB.y <= maxA.y &&
+		minA.z <= maxB.z && minB.z <= maxA.z;
+}
+
+// jobs 가 없으면 이 스레드에서 청크 순서대로 부른다
+static int pushBody(CollisionWorld & w, unsigned char shape, bool isStatic){
+	w.boundsMin.push_back(vec3(0));
+	w.boundsMax.push_back(vec3(0));
+	w.shape.push_back(shape);
+	w.isStatic.push_back(isStatic ? 1 : 0);
+	w.position.push_back(vec3(0));
+	w.localMin.push_back(vec3(0));
+	w.localMax.push_back(vec3(0));
+	w.hullFirst.push_back(0);
+	w.hullCount.push_back(0);
+	return (int)w.shape.size() - 1;
+}
+
+void initCollisionWorld(CollisionWorld & w, float cellSize){
+	w.cellSize = cellSize;
+	w.hasTerrain = false;
+	w.stats = CollisionStats();
+}
+
+void reserveCollision(CollisionWorld & w, int maxPairs){
+	w.chunkPairs.resize(PAIR_CHUNKS);
+	for (int c = 0; c < PAIR_CHUNKS; c++)
+		w.chunkPairs[c].reserve(maxPairs);
+	w.pairs.reserve(maxPairs);
+	w.pairContacts.reserve(maxPairs);
+	w.contacts.reserve(maxPairs + w.shape.size());
+}
+
+int addBoxBody(CollisionWorld & w, const vec3 & min, const vec3 & max, bool isStatic){
+	int body = pushBody(w, SHAPE_BOX, isStatic);
+	setBoxBounds(w, body, min, max);
+	return body;
+}
+
+int addHullBody(CollisionWorld & w, const vec3 * vertices, int count, const vec3 & position, bool isStatic){
+	int body = pushBody(w, SHAPE_HULL, isStatic);
+	w.hullFirst[body] = (int)w.hullVertices.size();
+	w.hullCount[body] = count;
+	vec3 min = vertices[0];
+	vec3 max = vertices[0];
+	for (int i = 0; i < count; i++) {
+		w.hullVertices.push_back(vertices[i]);
+		min = glm::min(min, vertices[i]);
+		max = glm::max(max, vertices[i]);
+	}
+	w.localMin[body] = min;
+	w.localMax[body] = max;
+	setBodyPosition(w, body, position);
+	return body;
+}
+
+void setBoxBounds(CollisionWorld & w, int body, const vec3 & min, const vec3 & max){
+	w.boundsMin[body] = min;
+	w.boundsMax[body] = max;
+	w.position[body] = (min + max) * 0.5f;
+}
+
+void setBodyPosition(CollisionWorld & w, int body, const vec3 & position){
+	if (w.shape[body] == SHAPE_BOX) {
+		vec3 half = (w.boundsMax[body] - w.boundsMin[body]) * 0.5f;
+		setBoxBounds(w, body, position - half, position + half);
+		return;
+	}
+	w.position[body] = position;
+	w.boundsMin[body] = position + w.localMin[body];
+	w.boundsMax[body] = position + w.localMax[body];
+}
+
+void setFlatTerrain(CollisionWorld & w, float minX, float minZ, float maxX, float maxZ, float spacing, float height){
+	Heightfield & t = w.terrain;
+	t.columns = (int)ceilf((maxX - minX) / spacing) + 1;
+	t.rows = (int)ceilf((maxZ - minZ) / spacing) + 1;
+	t.originX = minX;
+	t.originZ = minZ;
+	t.spacing = spacing;
+	t.heights.assign(t.columns * t.rows, height);
+	w.hasTerrain = true;
+}
+
+float terrainHeight(const Heightfield & t, float x, float z){
+	float fx = (x - t.originX) / t.spacing;
+	float fz = (z - t.originZ) / t.spacing;
+	fx = std::min(std::max(fx, 0.0f), (float)(t.columns - 1));
+	fz = std::min(std::max(fz, 0.0f), (float)(t.rows - 1));
+	int i = std::min((int)fx, t.columns - 2 < 0 ? 0 : t.columns - 2);
+	int j = std::min((int)fz, t.rows - 2 < 0 ? 0 : t.rows - 2);
+	int i1 = std::min(i + 1, t.columns - 1);
+	int j1 = std::min(j + 1, t.rows - 1);
+	float u = fx - i;
+	float v = fz - j;
+	float h00 = t.heights[j * t.columns + i];
+	float h10 = t.heights[j * t.columns + i1];
+	float h01 = t.heights[j1 * t.columns + i];
+	float h11 = t.heights[j1 * t.columns + i1];
+	return (h00 * (1 - u) + h10 * u) * (1 - v) + (h01 * (1 - u) + h11 * u) * v;
+}
+
+// 해시 만들기 ////////////////////////////////////////////////////////////////
+
+static void buildHash(CollisionWorld & w){
+	const int bodies = (int)w.shape.size();
+	const float cellSize = w.cellSize;
+
+	// 먼저 항목 수를 세서 버킷 수를 정한다 (항목 수의 두배 이상인 2 의 거듭제곱)
+	int total = 0;
+	w.oversized.clear();
+	for (int b = 0; b < bodies; b++) {
+		int cx = cellCoordinate(w.boundsMax[b].x, cellSize) - cellCoordinate(w.boundsMin[b].x, cellSize) + 1;
+		int cy = cellCoordinate(w.boundsMax[b].y, cellSize) - cellCoordinate(w.boundsMin[b].y, cellSize) + 1;
+		int cz = cellCoordinate(w.boundsMax[b].z, cellSize) - cellCoordinate(w.boundsMin[b].z, cellSize) + 1;
+		int64_t cells = (int64_t)cx * cy * cz;
+		if (cells > MAX_CELLS_PER_BODY)
+			w.oversized.push_back(b);
+		else
+			total += (int)cells;
+	}
+	uint32_t buckets = 64;
+	while (buckets < (uint32_t)total * 2)
+		buckets <<= 1;
+	const uint32_t mask = buckets - 1;
+
+	w.entries.resize(total);
+	w.sorted.resize(total);
+	w.bucketStart.assign(buckets + 1, 0);
+
+	int n = 0;
+	size_t nextOversized = 0;
+	for (int b = 0; b < bodies; b++) {
+		if (nextOversized < w.oversized.size() && w.oversized[nextOversized] == b) {
+			nextOversized++;
+			continue;
+		}
+		int x0 = cellCoordinate(w.boundsMin[b].x, cellSize), x1 = cellCoordinate(w.boundsMax[b].x, cellSize);
+		int y0 = cellCoordinate(w.boundsMin[b].y, cellSize), y1 = cellCoordinate(w.boundsMax[b].y, cellSize);
+		int z0 = cellCoordinate(w.boundsMin[b].z, cellSize), z1 = cellCoordinate(w.boundsMax[b].z, cellSize);
+		for (int z = z0; z <= z1; z++)
+			for (int y = y0; y <= y1; y++)
+				for (int x = x0; x <= x1; x++) {
+					CellEntry & e = w.entries[n++];
+					e.x = x;
+					e.y = y;
+					e.z = z;
+					e.body = b;
+					e.bucket = hashCell(x, y, z) & mask;
+					e.min = w.boundsMin[b];
+					e.max = w.boundsMax[b];
+					w.bucketStart[e.bucket + 1]++;
+				}
+	}
+
+	// 버킷별 계수 정렬
+	for (uint32_t k = 0; k < buckets; k++)
+		w.bucketStart[k + 1] += w.bucketStart[k];
+	for (int i = 0; i < total; i++)
+		w.sorted[w.bucketStart[w.entries[i].bucket]++] = w.entries[i];
+	for (uint32_t k = buckets; k > 0; k--)
+		w.bucketStart[k] = w.bucketStart[k - 1];
+	w.bucketStart[0] = 0;
+}
+
+// 쌍 만들기 //////////////////////////////////////////////////////////////////
+
+struct PairContext {
+	CollisionWorld * world;
+	int chunk;
+};
+
+static void findPairs(void * context, int begin, int end){
+	PairContext * c = (PairContext *)context;
+	CollisionWorld & w = *c->world;
+	std::vector<BodyPair> & out = w.chunkPairs[begin / c->chunk];
+	out.clear();
+	for (int k = begin; k < end; k++) {
+		const uint32_t first = w.bucketStart[k];
+		const uint32_t last = w.bucketStart[k + 1];
+		for (uint32_t i = first; i < last; i++) {
+			const CellEntry & ea = w.sorted[i];
+			for (uint32_t j = i + 1; j < last; j++) {
+				const CellEntry & eb = w.sorted[j];
+				// 해시만 같고 다른 칸
+				if (ea.x != eb.x || ea.y != eb.y || ea.z != eb.z)
+					continue;
+				if (ea.min.x > eb.max.x || eb.min.x > ea.max.x ||
+					ea.min.y > eb.max.y || eb.min.y > ea.max.y ||
+					ea.min.z > eb.max.z || eb.min.z > ea.max.z)
+					continue;
+				int a = ea.body;
+				int b = eb.body;
+				if (w.isStatic[a] && w.isStatic[b])
+					continue;
+				// 여러 칸을 같이 걸치는 쌍은 겹친 영역의 최소 모서리가 있는 칸에서만 낸다
+				vec3 corner = glm::max(ea.min, eb.min);
+				if (cellCoordinate(corner.x, w.cellSize) != ea.x ||
+					cellCoordinate(corner.y, w.cellSize) != ea.y ||
+					cellCoordinate(corner.z, w.cellSize) != ea.z)
+					continue;
+				BodyPair p;
+				p.a = std::min(a, b);
+				p.b = std::max(a, b);
+				out.push_back(p);
+			}
+		}
+	}
+}
+
+static void findPairs(CollisionWorld & w, JobSystem * jobs){
+	const int buckets = (int)w.bucketStart.size() - 1;
+	int chunk = std::max(MIN_BUCKETS_PER_CHUNK, (buckets + PAIR_CHUNKS - 1) / PAIR_CHUNKS);
+	int chunks = (buckets + chunk - 1) / chunk;
+	if ((int)w.chunkPairs.size() < chunks)
+		w.chunkPairs.resize(chunks);
+
+	PairContext context;
+	context.world = &w;
+	context.chunk = chunk;
+	runChunked(jobs, buckets, chunk, findPairs, &context);
+
+	w.pairs.clear();
+	for (int c = 0; c < chunks; c++)
+		w.pairs.insert(w.pairs.end(), w.chunkPairs[c].begin(), w.chunkPairs[c].end());
+
+	// 해시에 넣지 않은 큰 물체는 모든 물체와 직접 비교한다
+	const int bodies = (int)w.shape.size();
+	for (size_t o = 0; o < w.oversized.size(); o++) {
+		int a = w.oversized[o];
+		for (int b = 0; b < bodies; b++) {
+			if (b == a || (w.isStatic[a] && w.isStatic[b]))
+				continue;
+			// 큰 물체끼리는 한번만
+			if (b < a && std::binary_search(w.oversized.begin(), w.oversized.end(), b))
+				continue;
+			if (!overlaps(w, a, b))
+				continue;
+			BodyPair p;
+			p.a = std::min(a, b);
+			p.b = std::max(a, b);
+			w.pairs.push_back(p);
+		}
+	}
+}
+
+// narrowphase ////////////////////////////////////////////////////////////////
+
+static vec3 support(const CollisionWorld & w, int body, const vec3 & d){
+	if (w.shape[body] == SHAPE_BOX) {
+		const vec3 & min = w.boundsMin[body];
+		const vec3 & max = w.boundsMax[body];
+		return vec3(d.x >= 0 ? max.x : min.x, d.y >= 0 ? max.y : min.y, d.z >= 0 ? max.z : min.z);
+	}
+	const vec3 * v = &w.hullVertices[w.hullFirst[body]];
+	const int count = w.hullCount[body];
+	int best = 0;
+	float bestDot = dot(v[0], d);
+	for (int i = 1; i < count; i++) {
+		float t = dot(v[i], d);
+		if (t > bestDot) {
+			bestDot = t;
+			best = i;
+		}
+	}
+	return w.position[body] + v[best];
+}
+
+static vec3 minkowskiSupport(const CollisionWorld & w, int a, int b, const vec3 & d){
+	return support(w, a, d) - support(w, b, -d);
+}
+
+static bool sameDirection(const vec3 & a, const vec3 & b){
+	return dot(a, b) > 0;
+}
+
+// GJK 단체. p[0] 이 가장 최근에 넣은 점이다.
+struct Simplex {
+	vec3 p[4];
+	int count;
+};
+
+static bool nearlyZero(const vec3 & v){
+	return dot(v, v) < 1e-12f;
+}
+
+static bool lineCase(Simplex & s, vec3 & d){
+	vec3 a = s.p[0], b = s.p[1];
+	vec3 ab = b - a, ao = -a;
+	if (sameDirection(ab, ao)) {
+		d = cross(cross(ab, ao), ab);
+		// 원점이 선분 위에 있다
+		if (nearlyZero(d))
+			return true;
+	}
+	else {
+		s.count = 1;
+		d = ao;
+	}
+	return false;
+}
+
+static bool triangleCase(Simplex & s, vec3 & d){
+	vec3 a = s.p[0], b = s.p[1], c = s.p[2];
+	vec3 ab = b - a, ac = c - a, ao = -a;
+	vec3 abc = cross(ab, ac);
+	if (sameDirection(cross(abc, ac), ao)) {
+		if (sameDirection(ac, ao)) {
+			s.p[1] = c;
+			s.count = 2;
+			d = cross(cross(ac, ao), ac);
+			return nearlyZero(d);
+		}
+		s.count = 2;
+		return lineCase(s, d);
+	}
+	if (sameDirection(cross(ab, abc), ao)) {
+		s.count = 2;
+		return lineCase(s, d);
+	}
+	float side = dot(abc, ao);
+	// 원점이 삼각형 평면 위에 있다
+	if (fabsf(side) < 1e-9f)
+		return true;
+	if (side > 0)
+		d = abc;
+	else {
+		s.p[1] = c;
+		s.p[2] = b;
+		d = -abc;
+	}
+	return false;
+}
+
+static bool tetrahedronCase(Simplex & s, vec3 & d){
+	vec3 a = s.p[0], b = s.p[1], c = s.p[2], e = s.p[3];
+	vec3 ab = b - a, ac = c - a, ae = e - a, ao = -a;
+	vec3 abc = cross(ab, ac);
+	vec3 ace = cross(ac, ae);
+	vec3 aeb = cross(ae, ab);
+	if (sameDirection(abc, ao)) {
+		s.count = 3;
+		return triangleCase(s, d);
+	}
+	if (sameDirection(ace, ao)) {
+		s.p[1] = c;
+		s.p[2] = e;
+		s.count = 3;
+		return triangleCase(s, d);
+	}
+	if (sameDirection(aeb, ao)) {
+		s.p[1] = e;
+		s.p[2] = b;
+		s.count = 3;
+		return triangleCase(s, d);
+	}
+	return true;
+}
+
+static bool gjkIntersect(const CollisionWorld & w, int a, int b){
+	vec3 d = w.position[a] - w.position[b];
+	if (nearlyZero(d))
+		d = vec3(1, 0, 0);
+	Simplex s;
+	s.p[0] = minkowskiSupport(w, a, b, d);
+	s.count = 1;
+	d = -s.p[0];
+	if (nearlyZero(d))
+		return true;
+	for (int iteration = 0; iteration < 64; iteration++) {
+		vec3 p = minkowskiSupport(w, a, b, d);
+		if (dot(p, d) < 0)
+			return false;
+		for (int i = s.count; i > 0; i--)
+			s.p[i] = s.p[i - 1];
+		s.p[0] = p;
+		s.count++;
+		bool inside;
+		if (s.count == 2) inside = lineCase(s, d);
+		else if (s.count == 3) inside = triangleCase(s, d);
+		else inside = tetrahedronCase(s, d);
+		if (inside)
+			return true;
+	}
+	// 수렴하지 않으면 AABB 는 이미 겹쳐 있으므로 닿은 것으로 본다
+	return true;
+}
+
+// 밀어낼 방향과 깊이는 두 AABB 가 가장 적게 겹친 축으로 정한다
+static Contact boundsContact(const CollisionWorld & w, int a, int b){
+	vec3 overlap = glm::min(w.boundsMax[a], w.boundsMax[b]) - glm::max(w.boundsMin[a], w.boundsMin[b]);
+	vec3 offset = (w.boundsMin[a] + w.boundsMax[a]) - (w.boundsMin[b] + w.boundsMax[b]);
+	int axis = 0;
+	if (overlap.y < overlap[axis]) axis = 1;
+	if (overlap.z < overlap[axis]) axis = 2;
+	Contact c;
+	c.a = a;
+	c.b = b;
+	c.normal = vec3(0);
+	c.normal[axis] = offset[axis] >= 0 ? 1.0f : -1.0f;
+	c.depth = overlap[axis];
+	return c;
+}
+
+static void narrowPhase(void * context, int begin, int end){
+	CollisionWorld & w = *(CollisionWorld *)context;
+	for (int i = begin; i < end; i++) {
+		int a = w.pairs[i].a;
+		int b = w.pairs[i].b;
+		Contact & c = w.pairContacts[i];
+		if ((w.shape[a] == SHAPE_HULL || w.shape[b] == SHAPE_HULL) && !gjkIntersect(w, a, b)) {
+			c.depth = -1;
+			continue;
+		}
+		c = boundsContact(w, a, b);
+	}
+}
+
+static void terrainContacts(CollisionWorld & w){
+	const Heightfield & t = w.terrain;
+	const int bodies = (int)w.shape.size();
+	for (int b = 0; b < bodies; b++) {
+		if (w.isStatic[b])
+			continue;
+		const vec3 & min = w.boundsMin[b];
+		const vec3 & max = w.boundsMax[b];
+		// 밑면의 네 모서리와 가운데 중 가장 높은 지형
+		float ground = terrainHeight(t, (min.x + max.x) * 0.5f, (min.z + max.z) * 0.5f);
+		ground = std::max(ground, terrainHeight(t, min.x, min.z));
+		ground = std::max(ground, terrainHeight(t, max.x, min.z));
+		ground = std::max(ground, terrainHeight(t, min.x, max.z));
+		ground = std::max(ground, terrainHeight(t, max.x, max.z));
+		if (min.y >= ground)
+			continue;
+		Contact c;
+		c.a = b;
+		c.b = -1;
+		c.normal = vec3(0, 1, 0);
+		c.depth = ground - min.y;
+		w.contacts.push_back(c);
+		w.stats.terrainContacts++;
+	}
+}
+
+void stepCollision(CollisionWorld & w, JobSystem * jobs){
+	CollisionStats & stats = w.stats;
+	stats = CollisionStats();
+	stats.bodies = (int)w.shape.size();
+
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	buildHash(w);
+	stats.buildMs = elapsedMs(begin);
+	stats.cellEntries = (int)w.sorted.size();
+	stats.oversized = (int)w.oversized.size();
+
+	begin = std::chrono::steady_clock::now();
+	findPairs(w, jobs);
+	stats.pairMs = elapsedMs(begin);
+	stats.candidatePairs = (int)w.pairs.size();
+
+	begin = std::chrono::steady_clock::now();
+	w.pairContacts.resize(w.pairs.size());
+	runChunked(jobs, (int)w.pairs.size(), NARROW_CHUNK, narrowPhase, &w);
+	w.contacts.clear();
+	for (size_t i = 0; i < w.pairContacts.size(); i++)
+		if (w.pairContacts[i].depth >= 0)
+			w.contacts.push_back(w.pairContacts[i]);
+	stats.contacts = (int)w.contacts.size();
+	if (w.hasTerrain)
+		terrainContacts(w);
+	stats.narrowMs = elapsedMs(begin);
+}
@@ -0,0 +1,118 @@
+#ifndef COLLISION_HPP
+#define COLLISION_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "jobs.hpp"
+
+// 충돌 검사. 로켓, 벽, 바닥, (나중에) 잔해.
+// broadphase : 균일 격자 공간 해시. 물체의 AABB 가 걸치는 칸마다 항목을 넣고 해시 버킷별로 정렬한 뒤,
+//              같은 칸에 있는 물체끼리만 AABB 를 비교한다. 버킷 단위로 나눠 여러 스레드에서 쌍을 만든다.
+// narrowphase : 상자끼리는 AABB 겹침, 볼록 헐이 끼면 GJK. 바닥은 높이맵과 비교한다.
+// 물체 데이터는 SoA 로 둔다. 물체를 추가할 때만 힙을 쓰고 stepCollision 은 힙을 쓰지 않는다 (크기가 같으면).
+
+enum ShapeType {
+	SHAPE_BOX = 0,    // AABB 그 자체
+	SHAPE_HULL = 1    // 로컬 꼭지점들의 볼록 헐 + 위치
+};
+
+// 격자 높이맵. (originX + i * spacing, originZ + j * spacing) 점의 높이가 heights[j * columns + i]
+struct Heightfield {
+	int columns;
+	int rows;
+	float originX;
+	float originZ;
+	float spacing;
+	std::vector<float> heights;
+};
+
+// 물체의 AABB 를 같이 들고 있어서 쌍을 만들 때 물체 배열을 다시 읽지 않는다
+struct CellEntry {
+	int32_t x, y, z;   // 칸 좌표. 해시 충돌을 거르는 데 쓴다.
+	int body;
+	uint32_t bucket;
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+struct BodyPair {
+	int a, b;          // a < b
+};
+
+// 물체 a 를 normal 방향으로 depth 만큼 밀면 떨어진다. b 가 -1 이면 지형.
+struct Contact {
+	int a;
+	int b;
+	glm::vec3 normal;
+	float depth;
+};
+
+struct CollisionStats {
+	int bodies;
+	int cellEntries;
+	int oversized;         // 칸을 너무 많이 걸쳐서 따로 전부 비교한 물체
+	int candidatePairs;    // broadphase 를 통과한 쌍
+	int contacts;          // narrowphase 를 통과한 쌍 (지형 제외)
+	int terrainContacts;
+	double buildMs;        // 해시 만들기
+	double pairMs;         // 쌍 만들기
+	double narrowMs;       // narrowphase + 지형
+};
+
+struct CollisionWorld {
+	float cellSize;
+
+	// 물체 (SoA)
+	std::vector<glm::vec3> boundsMin;      // 월드 AABB
+	std::vector<glm::vec3> boundsMax;
+	std::vector<unsigned char> shape;
+	std::vector<unsigned char> isStatic;   // 정적 물체끼리는 비교하지 않는다
+	std::vector<glm::vec3> position;       // 헐의 위치 (상자는 쓰지 않음)
+	std::vector<glm::vec3> localMin;       // 헐의 로컬 AABB
+	std::vector<glm::vec3> localMax;
+	std::vector<int> hullFirst;            // hullVertices 안의 범위
+	std::vector<int> hullCount;
+	std::vector<glm::vec3> hullVertices;
+
+	Heightfield terrain;
+	bool hasTerrain;
+
+	// 공간 해시. 매 stepCollision 마다 다시 만든다.
+	std::vector<CellEntry> entries;
+	std::vector<CellEntry> sorted;
+	std::vector<uint32_t> bucketStart;     // 버킷 k 의 항목은 sorted[bucketStart[k] .. bucketStart[k + 1])
+	std::vector<int> oversized;
+
+	// 쌍과 접촉. 청크마다 따로 모았다가 합친다.
+	std::vector<std::vector<BodyPair> > chunkPairs;
+	std::vector<BodyPair> pairs;
+	std::vector<Contact> pairContacts;     // pairs 와 같은 순서. depth < 0 이면 접촉 없음
+	std::vector<Contact> contacts;
+
+	CollisionStats stats;
+};
+
+void initCollisionWorld(CollisionWorld & w, float cellSize);
+// 쌍과 접촉 배열을 미리 잡아 둔다. 루프 안에서 처음 부딪힐 때 힙을 쓰지 않게 하려면 부른다.
+void reserveCollision(CollisionWorld & w, int maxPairs);
+
+// 물체를 추가하고 번호를 돌려준다.
+int addBoxBody(CollisionWorld & w, const glm::vec3 & min, const glm::vec3 & max, bool isStatic);
+// vertices 는 로컬 좌표. 볼록하지 않으면 볼록 헐로 취급된다.
+int addHullBody(CollisionWorld & w, const glm::vec3 * vertices, int count, const glm::vec3 & position, bool isStatic);
+
+void setBoxBounds(CollisionWorld & w, int body, const glm::vec3 & min, const glm::vec3 & max);
+void setBodyPosition(CollisionWorld & w, int body, const glm::vec3 & position);
+
+// 평평한 바닥 높이맵을 만든다. 높이는 terrain.heights 를 직접 고쳐도 된다.
+void setFlatTerrain(CollisionWorld & w, float minX, float minZ, float maxX, float maxZ, float spacing, float height);
+// (x, z) 의 지형 높이 (쌍선형 보간). 높이맵 밖이면 가장자리 값.
+float terrainHeight(const Heightfield & t, float x, float z);
+
+// 해시를 만들고, 쌍을 찾고, 접촉을 w.contacts 에 채운다. jobs 가 NULL 이면 한 스레드로 한다.
+void stepCollision(CollisionWorld & w, JobSystem * jobs);
+
+#endif
@@ -0,0 +1,339 @@
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+
+#include <glm/glm.hpp>
+
+#include "debris.hpp"
+#include "random.hpp"
+
+static const float DEBRIS_GRAVITY = 1.2f;      // 로켓 비행과 같은 단위 (4 * FlightState::gravity)
+static const float DEBRIS_DRAG = 0.15f;        // 초당 속도 감소 비율
+static const float DEBRIS_BOUNCE = 0.3f;       // 바닥에서 튕길 때 남는 수직 속도
+static const float DEBRIS_FRICTION = 0.7f;     // 바닥에 닿을 때 남는 수평 속도, 각속도
+static const float DEBRIS_REST_SPEED = 0.05f;  // 이보다 느리게 바닥에 닿으면 멈춘다
+static const int DEBRIS_CHUNK = 4096;
+static const uint32_t DEBRIS_SLOT_MASK = (1u << DEBRIS_SLOT_BITS) - 1;
+
+void initDebris(DebrisSystem & d, int capacity){
+	if (capacity > (int)DEBRIS_SLOT_MASK)
+		capacity = (int)DEBRIS_SLOT_MASK;
+	d.capacity = capacity;
+	d.count = 0;
+	std::vector<float> * floats[] = { &d.px, &d.py, &d.pz, &d.vx, &d.vy, &d.vz,
+		&d.qx, &d.qy, &d.qz, &d.qw, &d.wx, &d.wy, &d.wz, &d.size, &d.age, &d.life };
+	for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+		floats[i]->assign(capacity, 0.0f);
+	d.kind.assign(capacity, 0);
+	d.resting.assign(capacity, 0);
+	d.expired.assign(capacity, 0);
+	d.visible.assign(capacity, 0);
+	d.chunkVisible.assign(capacity / DEBRIS_CHUNK + 1, 0);
+	d.denseSlot.assign(capacity, 0);
+	d.slotDense.assign(capacity, 0);
+	d.slotGeneration.assign(capacity, 0);
+	d.freeSlots.resize(capacity);
+	// 낮은 번호부터 쓰도록 거꾸로 쌓는다
+	for (int i = 0; i < capacity; i++)
+		d.freeSlots[i] = capacity - 1 - i;
+	d.freeCount = capacity;
+	d.instances.assign((size_t)capacity * DEBRIS_INSTANCE_FLOATS, 0.0f);
+	d.stats = DebrisStats();
+}
+
+DebrisHandle spawnDebris(DebrisSystem & d, const DebrisSpawn & spawn){
+	if (d.freeCount == 0)
+		return DEBRIS_NONE;
+	uint32_t slot = d.freeSlots[--d.freeCount];
+	int i = d.count++;
+	d.px[i] = spawn.position.x;
+	d.py[i] = spawn.position.y;
+	d.pz[i] = spawn.position.z;
+	d.vx[i] = spawn.velocity.x;
+	d.vy[i] = spawn.velocity.y;
+	d.vz[i] = spawn.velocity.z;
+	d.qx[i] = 0.0f;
+	d.qy[i] = 0.0f;
+	d.qz[i] = 0.0f;
+	d.qw[i] = 1.0f;
+	d.wx[i] = spawn.angularVelocity.x;
+	d.wy[i] = spawn.angularVelocity.y;
+	d.wz[i] = spawn.angularVelocity.z;
+	d.size[i] = spawn.size;
+	d.age[i] = 0.0f;
+	d.life[i] = spawn.life;
+	d.kind[i] = (unsigned char)spawn.kind;
+	d.resting[i] = 0;
+	d.expired[i] = 0;
+	d.denseSlot[i] = slot;
+	d.slotDense[slot] = i;
+	// 세대 0 은 쓰지 않아서 핸들이 DEBRIS_NONE 이 되지 않는다
+	uint32_t generation = (d.slotGeneration[slot] + 1) & (0xFFFFFFFFu >> DEBRIS_SLOT_BITS);
+	if (generation == 0)
+		generation = 1;
+	d.slotGeneration[slot] = generation;
+	d.stats.spawned++;
+	d.stats.live = d.count;
+	return (generation << DEBRIS_SLOT_BITS) | slot;
+}
+
+int findDebris(const DebrisSystem & d, DebrisHandle handle){
+	uint32_t slot = handle & DEBRIS_SLOT_MASK;
+	if (handle == DEBRIS_NONE || slot >= (uint32_t)d.capacity || d.slotGeneration[slot] != (handle >> DEBRIS_SLOT_BITS))
+		return -1;
+	int dense = (int)d.slotDense[slot];
+	if (dense >= d.count || d.denseSlot[dense] != slot)
+		return -1;
+	return dense;
+}
+
+// 마지막 것을 i 자리로 옮긴다
+static void removeDense(DebrisSystem & d, int i){
+	uint32_t slot = d.denseSlot[i];
+	d.slotGeneration[slot] = (d.slotGeneration[slot] + 1) & (0xFFFFFFFFu >> DEBRIS_SLOT_BITS);
+	d.freeSlots[d.freeCount++] = slot;
+	int last = --d.count;
+	if (i != last) {
+		d.px[i] = d.px[last]; d.py[i] = d.py[last]; d.pz[i] = d.pz[last];
+		d.vx[i] = d.vx[last]; d.vy[i] = d.vy[last]; d.vz[i] = d.vz[last];
+		d.qx[i] = d.qx[last]; d.qy[i] = d.qy[last]; d.qz[i] = d.qz[last]; d.qw[i] = d.qw[last];
+		d.wx[i] = d.wx[last]; d.wy[i] = d.wy[last]; d.wz[i] = d.wz[last];
+		d.size[i] = d.size[last];
+		d.age[i] = d.age[last];
+		d.life[i] = d.life[last];
+		d.kind[i] = d.kind[last];
+		d.resting[i] = d.resting[last];
+		d.expired[i] = d.expired[last];
+		d.denseSlot[i] = d.denseSlot[last];
+		d.slotDense[d.denseSlot[i]] = i;
+	}
+}
+
+void removeDebris(DebrisSystem & d, DebrisHandle handle){
+	int dense = findDebris(d, handle);
+	if (dense >= 0)
+		removeDense(d, dense);
+	d.stats.live = d.count;
+}
+
+void spawnDebrisBurst(DebrisSystem & d, const glm::vec3 & origin, const glm::vec3 & velocity, int count, float speed, uint32_t seed){
+	uint32_t state = seed != 0 ? seed : 1;
+	for (int n = 0; n < count; n++) {
+		float r[7];
+		for (int k = 0; k < 7; k++)
+			r[k] = nextRandom(state);
+		glm::vec3 direction(r[0] * 2 - 1, r[1] * 2 - 1, r[2] * 2 - 1);
+		float length = sqrtf(glm::dot(direction, direction));
+		if (length < 1e-3f)
+			direction = glm::vec3(0, 1, 0);
+		else
+			direction = direction * (1.0f / length);
+		DebrisSpawn spawn;
+		spawn.position = origin + direction * 0.3f;
+		spawn.velocity = velocity + direction * (speed * (0.3f + 0.7f * r[3]));
+		spawn.angularVelocity = glm::vec3(r[4] * 20 - 10, r[5] * 20 - 10, r[6] * 20 - 10);
+		spawn.size = 0.03f + 0.07f * r[3];
+		spawn.life = 10.0f + 10.0f * r[4];
+		spawn.kind = DEBRIS_FRAGMENT;
+		if (spawnDebris(d, spawn) == DEBRIS_NONE)
+			return;
+	}
+}
+
+struct IntegrateContext {
+	DebrisSystem * debris;
+	float deltaTime;
+	const Heightfield * terrain;
+};
+
+static void integrateDebris(void * context, int begin, int end){
+	IntegrateContext * c = (IntegrateContext *)context;
+	DebrisSystem & d = *c->debris;
+	const float dt = c->deltaTime;
+	const float drag = 1.0f - DEBRIS_DRAG * dt;
+	float * px = &d.px[0], * py = &d.py[0], * pz = &d.pz[0];
+	float * vx = &d.vx[0], * vy = &d.vy[0], * vz = &d.vz[0];
+	float * qx = &d.qx[0], * qy = &d.qy[0], * qz = &d.qz[0], * qw = &d.qw[0];
+	float * wx = &d.wx[0], * wy = &d.wy[0], * wz = &d.wz[0];
+	for (int i = begin; i < end; i++) {
+		d.age[i] += dt;
+		if (d.life[i] > 0.0f && d.age[i] >= d.life[i])
+			d.expired[i] = 1;
+		if (d.resting[i])
+			continue;
+
+		vy[i] -= DEBRIS_GRAVITY * dt;
+		vx[i] *= drag;
+		vy[i] *= drag;
+		vz[i] *= drag;
+		px[i] += vx[i] * dt;
+		py[i] += vy[i] * dt;
+		pz[i] += vz[i] * dt;
+
+		// q += 0.5 * (w, 0) * q * dt 하고 다시 정규화
+		float h = 0.5f * dt;
+		float x = qx[i], y = qy[i], z = qz[i], w = qw[i];
+		float nx = x + h * (wx[i] * w + wy[i] * z - wz[i] * y);
+		float ny = y + h * (wy[i] * w + wz[i] * x - wx[i] * z);
+		float nz = z + h * (wz[i] * w + wx[i] * y - wy[i] * x);
+		float nw = w - h * (wx[i] * x + wy[i] * y + wz[i] * z);
+		float inv = 1.0f / sqrtf(nx * nx + ny * ny + nz * nz + nw * nw);
+		qx[i] = nx * inv;
+		qy[i] = ny * inv;
+		qz[i] = nz * inv;
+		qw[i] = nw * inv;
+
+		// 바닥. 회전은 무시하고 크기의 절반을 바닥에서 띄운다
+		float ground = (c->terrain != NULL ? terrainHeight(*c->terrain, px[i], pz[i]) : 0.0f) + d.size[i] * 0.5f;
+		if (py[i] < ground) {
+			py[i] = ground;
+			if (vy[i] < 0.0f)
+				vy[i] = -vy[i] * DEBRIS_BOUNCE;
+			vx[i] *= DEBRIS_FRICTION;
+			vz[i] *= DEBRIS_FRICTION;
+			wx[i] *= DEBRIS_FRICTION;
+			wy[i] *= DEBRIS_FRICTION;
+			wz[i] *= DEBRIS_FRICTION;
+			if (vx[i] * vx[i] + vy[i] * vy[i] + vz[i] * vz[i] < DEBRIS_REST_SPEED * DEBRIS_REST_SPEED) {
+				vx[i] = vy[i] = vz[i] = 0.0f;
+				wx[i] = wy[i] = wz[i] = 0.0f;
+				d.resting[i] = 1;
+			}
+		}
+	}
+}
+
+void stepDebris(DebrisSystem & d, float deltaTime, const Heightfield * terrain, JobSystem * jobs){
+	DebrisStats & stats = d.stats;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	IntegrateContext context;
+	context.debris = &d;
+	context.deltaTime = deltaTime;
+	context.terrain = terrain;
+	runChunked(jobs, d.count, DEBRIS_CHUNK, integrateDebris, &context);
+	stats.integrateMs = elapsedMs(begin);
+
+	// 뒤에서부터 지우면 옮겨 오는 것은 이미 검사한 것이다
+	begin = std::chrono::steady_clock::now();
+	stats.removed = 0;
+	stats.resting = 0;
+	for (int i = d.count - 1; i >= 0; i--) {
+		if (d.expired[i]) {
+			removeDense(d, i);
+			stats.removed++;
+		}
+		else if (d.resting[i])
+			stats.resting++;
+	}
+	stats.compactMs = elapsedMs(begin);
+	stats.live = d.count;
+}
+
+struct FillContext {
+	DebrisSystem * debris;
+	const Frustum * frusta;     // NULL 이면 모든 뷰에서 보인다
+	int frustumCount;
+	float * out;
+	int maxCount;
+};
+
+// 1 단계 : 보이는지 표시하고 청크마다 센다
+static void cullInstances(void * context, int begin, int end){
+	FillContext & c = *(FillContext *)context;
+	DebrisSystem & d = *c.debris;
+	int shown = 0;
+	for (int i = begin; i < end; i++) {
+		// 다 쓴 단은 원래 메쉬로 따로 그린다
+		unsigned char mask = 0;
+		if (d.kind[i] != DEBRIS_STAGE && c.frusta == NULL)
+			mask = 0xFF;
+		else if (d.kind[i] != DEBRIS_STAGE) {
+			// 회전해도 들어가도록 반지름은 대각선 절반
+			glm::vec3 center(d.px[i], d.py[i], d.pz[i]);
+			for (int v = 0; v < c.frustumCount; v++)
+				if (sphereInFrustum(c.frusta[v], center, d.size[i] * 0.87f))
+					mask |= (unsigned char)(1 << v);
+		}
+		d.visible[i] = mask;
+		shown += mask != 0 ? 1 : 0;
+	}
+	d.chunkVisible[begin / DEBRIS_CHUNK] = shown;
+}
+
+// 2 단계 : 청크 앞까지의 합 (chunkVisible) 부터 빈틈없이 쓴다
+static void fillInstances(void * context, int begin, int end){
+	FillContext & c = *(FillContext *)context;
+	DebrisSystem & d = *c.debris;
+	int o = d.chunkVisible[begin / DEBRIS_CHUNK];
+	for (int i = begin; i < end && o < c.maxCount; i++) {
+		if (!d.visible[i])
+			continue;
+		float * out = c.out + (size_t)(o++) * DEBRIS_INSTANCE_FLOATS;
+		out[0] = d.px[i];
+		out[1] = d.py[i];
+		out[2] = d.pz[i];
+		out[3] = d.size[i];
+		out[4] = d.qx[i];
+		out[5] = d.qy[i];
+		out[6] = d.qz[i];
+		out[7] = d.qw[i];
+		if (d.kind[i] == DEBRIS_FAIRING) {
+			out[8] = 0.9f;
+			out[9] = 0.9f;
+			out[10] = 0.9f;
+		}
+		else {
+			// 뜨거운 파편이 3 초 동안 식는다
+			float t = d.age[i] < 3.0f ? d.age[i] / 3.0f : 1.0f;
+			out[8] = 1.0f - 0.7f * t;
+			out[9] = 0.5f - 0.2f * t;
+			out[10] = 0.1f + 0.2f * t;
+		}
+		out[11] = (float)d.visible[i];
+	}
+}
+
+int cullDebrisInstances(DebrisSystem & d, const Frustum * frustum, JobSystem * jobs){
+	return cullDebrisViews(d, frustum, frustum != NULL ? 1 : 0, jobs);
+}
+
+int cullDebrisViews(DebrisSystem & d, const Frustum * frusta, int frustumCount, JobSystem * jobs){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	FillContext context = { &d, frusta, frustumCount, NULL, 0 };
+	runChunked(jobs, d.count, DEBRIS_CHUNK, cullInstances, &context);
+	// 청크별 개수를 시작 위치로 바꾼다
+	const int chunks = (d.count + DEBRIS_CHUNK - 1) / DEBRIS_CHUNK;
+	int visible = 0;
+	for (int c = 0; c < chunks; c++) {
+		int n = d.chunkVisible[c];
+		d.chunkVisible[c] = visible;
+		visible += n;
+	}
+	d.stats.visible = visible;
+	d.stats.instanceMs = elapsedMs(begin);
+	return visible;
+}
+
+int writeDebrisInstances(DebrisSystem & d, float * out, int maxCount, JobSystem * jobs){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	FillContext context = { &d, NULL, 0, out, maxCount };
+	runChunked(jobs, d.count, DEBRIS_CHUNK, fillInstances, &context);
+	d.stats.instanceMs += elapsedMs(begin);
+	return d.stats.visible < maxCount ? d.stats.visible : maxCount;
+}
+
+int fillDebrisInstances(DebrisSystem & d, const Frustum * frustum, JobSystem * jobs){
+	cullDebrisInstances(d, frustum, jobs);
+	return writeDebrisInstances(d, &d.instances[0], d.capacity, jobs);
+}
+
+glm::mat4 debrisTransform(const DebrisSystem & d, int i){
+	float x = d.qx[i], y = d.qy[i], z = d.qz[i], w = d.qw[i];
+	glm::mat4 m(1.0f);
+	m[0] = glm::vec4(1 - 2 * (y * y + z * z), 2 * (x * y + w * z), 2 * (x * z - w * y), 0);
+	m[1] = glm::vec4(2 * (x * y - w * z), 1 - 2 * (x * x + z * z), 2 * (y * z + w * x), 0);
+	m[2] = glm::vec4(2 * (x * z + w * y), 2 * (y * z - w * x), 1 - 2 * (x * x + y * y), 0);
+	m[3] = glm::vec4(d.px[i], d.py[i], d.pz[i], 1);
+	return m;
+}
@@ -0,0 +1,110 @@
+#ifndef DEBRIS_HPP
+#define DEBRIS_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "jobs.hpp"
+#include "collision.hpp"
+#include "scene.hpp"
+
+// 단 분리 때 떨어져 나가는 강체들 (다 쓴 단, 페어링, 파편).
+// 데이터는 SoA 로 앞쪽 count 개에 빽빽하게 둔다. 지울 때는 마지막 것을 빈 자리로 옮긴다.
+// 밖에서는 DebrisHandle (세대 << DEBRIS_SLOT_BITS | 슬롯) 로 가리키므로, 옮겨져도 핸들은 그대로이고
+// 지워진 뒤에는 세대가 달라서 무효가 된다.
+// 모든 배열은 initDebris 에서 capacity 만큼 잡아 두고 루프 안에서는 힙을 쓰지 않는다.
+typedef uint32_t DebrisHandle;
+
+#define DEBRIS_NONE 0u               // 0 은 "없음"
+#define DEBRIS_SLOT_BITS 20          // 최대 1M 개
+
+enum DebrisKind {
+	DEBRIS_STAGE = 0,       // 다 쓴 단 (날개)
+	DEBRIS_FAIRING = 1,     // 페어링 조각
+	DEBRIS_FRAGMENT = 2     // 작은 파편
+};
+
+// 인스턴스 하나 = vec4 (위치, 크기) + vec4 (자세 쿼터니언) + vec4 (색, 보이는 뷰의 비트)
+#define DEBRIS_INSTANCE_FLOATS 12
+
+struct DebrisStats {
+	int live;
+	int spawned;            // 지금까지 생긴 수
+	int removed;            // 지난 stepDebris 에서 수명이 다해 지운 수
+	int resting;            // 바닥에 멈춘 수
+	double integrateMs;     // 적분 + 바닥 충돌 (병렬)
+	double compactMs;       // 죽은 것 지우기
+	int visible;            // 지난 fillDebrisInstances 에서 절두체 안에 있던 수
+	double instanceMs;      // 컬링 + 인스턴스 데이터 채우기 (병렬)
+};
+
+struct DebrisSystem {
+	int capacity;
+	int count;
+
+	// dense 위치로 인덱스. 앞쪽 count 개만 살아있다.
+	std::vector<float> px, py, pz;         // 위치 (중심)
+	std::vector<float> vx, vy, vz;         // 속도
+	std::vector<float> qx, qy, qz, qw;     // 자세
+	std::vector<float> wx, wy, wz;         // 각속도 (rad/s)
+	std::vector<float> size;               // 한 변 길이
+	std::vector<float> age;
+	std::vector<float> life;               // age 가 이것을 넘으면 지운다. 0 이면 지우지 않는다
+	std::vector<unsigned char> kind;
+	std::vector<unsigned char> resting;    // 바닥에 멈춰서 적분하지 않는다
+	std::vector<unsigned char> expired;    // 이번 틱에 수명이 다했다
+	std::vector<unsigned char> visible;    // 이번 프레임에 보이는 뷰의 비트 (0 이면 그리지 않는다)
+	std::vector<uint32_t> denseSlot;       // dense -> 슬롯
+
+	// 핸들 -> dense
+	std::vector<uint32_t> slotDense;
+	std::vector<uint32_t> slotGeneration;
+	std::vector<uint32_t> freeSlots;       // 스택
+	int freeCount;
+
+	std::vector<float> instances;          // capacity * DEBRIS_INSTANCE_FLOATS (fillDebrisInstances 용)
+	std::vector<int> chunkVisible;         // 청크마다 보이는 수 -> 쓰기 시작 위치
+	DebrisStats stats;
+};
+
+struct DebrisSpawn {
+	glm::vec3 position;
+	glm::vec3 velocity;
+	glm::vec3 angularVelocity;
+	float size;
+	float life;
+	DebrisKind kind;
+};
+
+void initDebris(DebrisSystem & d, int capacity);
+
+// 꽉 차면 DEBRIS_NONE
+DebrisHandle spawnDebris(DebrisSystem & d, const DebrisSpawn & spawn);
+void removeDebris(DebrisSystem & d, DebrisHandle handle);
+// 살아있으면 dense 위치, 아니면 -1
+int findDebris(const DebrisSystem & d, DebrisHandle handle);
+
+// 파편 count 개를 origin 에서 사방으로 흩뿌린다. 속도는 velocity + 임의 방향 * speed 이하.
+void spawnDebrisBurst(DebrisSystem & d, const glm::vec3 & origin, const glm::vec3 & velocity, int count, float speed, uint32_t seed);
+
+// 한 틱 진행한다. 중력, 공기저항, 회전, 지형과의 충돌 (튕기고 미끄러지다 멈춤), 수명.
+// terrain 이 NULL 이면 바닥은 y = 0. jobs 가 NULL 이면 한 스레드로 한다.
+void stepDebris(DebrisSystem & d, float deltaTime, const Heightfield * terrain, JobSystem * jobs);
+
+// 절두체 안에 있는 것을 표시하고 그 수를 돌려준다.
+// 다 쓴 단 (DEBRIS_STAGE) 은 원래 메쉬로 따로 그리므로 넣지 않는다. frustum 이 NULL 이면 컬링하지 않는다.
+int cullDebrisInstances(DebrisSystem & d, const Frustum * frustum, JobSystem * jobs);
+// 여러 뷰의 절두체로. 하나라도 들어가는 것을 세고, 뷰마다 보이는지는 비트로 남긴다 (views.hpp).
+int cullDebrisViews(DebrisSystem & d, const Frustum * frusta, int frustumCount, JobSystem * jobs);
+// 지난 cullDebrisInstances 에서 보인 것의 인스턴스 데이터를 out 에 빈틈없이 쓴다 (최대 maxCount 개).
+// out 은 스트리밍 버퍼의 매핑일 수 있다. 쓴 개수를 돌려준다.
+int writeDebrisInstances(DebrisSystem & d, float * out, int maxCount, JobSystem * jobs);
+// 위 둘을 d.instances 에
+int fillDebrisInstances(DebrisSystem & d, const Frustum * frustum, JobSystem * jobs);
+
+// 물체 하나의 모델 행렬 (회전 + 이동. 크기는 넣지 않는다)
+glm::mat4 debrisTransform(const DebrisSystem & d, int dense);
+
+#endif
@@ -0,0 +1,52 @@
+#include <glm/glm.hpp>
+
+#include "flight.hpp"
+
+void initFlight(FlightState & f){
+	f.gro1 = glm::vec3(0.0f, 0.0f, 0.0f);
+	f.velocity = 0;
+	f.main = 2.2f;
+	f.gravity = 0.307f;
+	f.start = 0;
+	f.sky = 0;
+	f.suit = 0;
+}
+
+void launchFlight(FlightState & f){
+	f.start = 1;
+	f.sky = 1;
+}
+
+void deployParachute(FlightState & f){
+	f.suit = 1;
+}
+
+void updateFlight(FlightState & f, float deltaTime){
+	if (f.sky == 1)      //하늘에 떠있는 경우
+	{
+		if (f.suit == 0) {
+			f.velocity += ((f.main - f.gravity)*deltaTime);  //가속도 붙여서 속력변화
+			if (f.velocity < FLIGHT_STALL_VELOCITY)   //속도가 줄어 멈추게되는경우
+			{
+				f.start = 0;
+			}
+			if (f.velocity > FLIGHT_CUTOFF_VELOCITY)  //속도가 일정이상 올라가는 경우 엔진 중지
+			{
+				f.main = 0.0f;
+			}
+			if (f.start == 1)
+			{
+				f.gro1.x += FLIGHT_DRIFT_SPEED * deltaTime;
+				f.gro1.y += (FLIGHT_CLIMB_SCALE * f.velocity*deltaTime);
+			}
+		}
+		else {
+			f.gro1.y -= FLIGHT_PARACHUTE_SPEED * deltaTime;
+		}
+	}
+	if (f.gro1.y < 0)
+	{
+		f.start = 0;
+		f.sky = 0;
+	}
+}
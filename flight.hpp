@@ -0,0 +1,40 @@
+#ifndef FLIGHT_HPP
+#define FLIGHT_HPP
+
+#include <glm/glm.hpp>
+
+// 로켓 한 대의 비행 상태. 원래 main() 의 지역변수들을 그대로 모은 것.
+struct FlightState {
+	glm::vec3 gro1;     // 로켓 위치
+	float velocity;     // 상승 속도
+	float main;         // 엔진 추력 (엔진이 꺼지면 0)
+	float gravity;
+	int start;          // 엔진/이동 중
+	int sky;            // 하늘에 떠있는 중
+	int suit;           // 낙하산 펼침
+};
+
+// 시뮬레이션 한 틱의 시간. 비행은 프레임 시간과 상관없이 이 간격으로 진행한다.
+static const float FLIGHT_TICK = 1.0f / 60.0f;
+
+// 비행 모델의 상수들. 궤적 예측 (trajectory.cpp) 도 같은 값을 쓴다.
+static const float FLIGHT_CUTOFF_VELOCITY = 2.27f;    // 이 속도를 넘으면 엔진이 꺼진다
+static const float FLIGHT_STALL_VELOCITY = -7.6f;     // 이 속도보다 느려지면 (떨어지면) 움직임을 멈춘다
+static const float FLIGHT_DRIFT_SPEED = 0.9f;         // x 방향으로 흘러가는 속도
+static const float FLIGHT_CLIMB_SCALE = 4.0f;         // 높이 변화 = velocity * 이 값
+static const float FLIGHT_PARACHUTE_SPEED = 0.36f;    // 낙하산으로 내려오는 속도
+
+// 발사대 위의 초기 상태로 만든다.
+void initFlight(FlightState & f);
+
+// 발사 (spacebar)
+void launchFlight(FlightState & f);
+
+// 낙하산 펼침 (X)
+void deployParachute(FlightState & f);
+
+// deltaTime (초) 만큼 비행을 진행한다. 상수들은 초 단위로 맞춰져 있다.
+// 엔진은 약 1.2 초 뒤에 꺼지고, 약 8.6 초에 높이 39 정도까지 올라간다.
+void updateFlight(FlightState & f, float deltaTime);
+
+#endif
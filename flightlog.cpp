@@ -0,0 +1,472 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define FLIGHTLOG_SSE 1
+#endif
+
+#include "flightlog.hpp"
+
+// 블록 앞의 채널별 바이트 수
+#define BLOCK_HEADER_BYTES (FLIGHTLOG_CHANNELS * sizeof(uint32_t))
+
+// 2 GB 가 넘는 로그도 찾아갈 수 있게 64 비트 위치를 쓴다 (Windows 의 long 은 32 비트)
+static int seekFile(FILE * file, int64_t offset, int origin){
+#ifdef _WIN32
+	return _fseeki64(file, offset, origin);
+#else
+	return fseeko(file, (off_t)offset, origin);
+#endif
+}
+
+static int64_t tellFile(FILE * file){
+#ifdef _WIN32
+	return _ftelli64(file);
+#else
+	return (int64_t)ftello(file);
+#endif
+}
+
+void defaultFlightLogSteps(float * step){
+	step[FLIGHTLOG_X] = 1e-4f;
+	step[FLIGHTLOG_Y] = 1e-4f;
+	step[FLIGHTLOG_Z] = 1e-4f;
+	step[FLIGHTLOG_VELOCITY] = 1e-6f;
+	step[FLIGHTLOG_FLAGS] = 1.0f;
+}
+
+static inline uint32_t zigzag(int32_t v){
+	return ((uint32_t)v << 1) ^ (uint32_t)(v >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t u){
+	return (u >> 1) ^ (0u - (u & 1u));
+}
+
+static inline int bitWidth(uint32_t v){
+	int w = 0;
+	while (v != 0) {
+		w++;
+		v >>= 1;
+	}
+	return w;
+}
+
+static inline uint64_t load64(const uint8_t * p){
+	uint64_t v;
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static int groupCount(int count){
+	return count > 2 ? (count - 2 + FLIGHTLOG_GROUP - 1) / FLIGHTLOG_GROUP : 0;
+}
+
+size_t flightLogChannelBound(int count){
+	return 2 * sizeof(int32_t) + groupCount(count) * (1 + FLIGHTLOG_GROUP * sizeof(uint32_t));
+}
+
+// [첫 값][첫 차이][묶음 : 비트 수 한 바이트 + 32 * 비트 수 비트]...
+// 묶음 안에서 j 번째 값은 j * w 비트 위치부터 little endian 으로 들어간다.
+size_t encodeFlightLogChannel(const int32_t * values, int count, uint8_t * out){
+	uint8_t * p = out;
+	if (count == 0)
+		return 0;
+	memcpy(p, &values[0], sizeof(int32_t));
+	p += sizeof(int32_t);
+	if (count == 1)
+		return p - out;
+	int32_t delta = (int32_t)((uint32_t)values[1] - (uint32_t)values[0]);
+	memcpy(p, &delta, sizeof(int32_t));
+	p += sizeof(int32_t);
+	uint32_t group[FLIGHTLOG_GROUP];
+	for (int begin = 2; begin < count; begin += FLIGHTLOG_GROUP) {
+		int n = count - begin < FLIGHTLOG_GROUP ? count - begin : FLIGHTLOG_GROUP;
+		uint32_t bits = 0;
+		for (int j = 0; j < FLIGHTLOG_GROUP; j++) {
+			uint32_t u = 0;
+			if (j < n) {
+				int32_t d = (int32_t)((uint32_t)values[begin + j] - (uint32_t)values[begin + j - 1]);
+				u = zigzag((int32_t)((uint32_t)d - (uint32_t)delta));
+				delta = d;
+			}
+			group[j] = u;
+			bits |= u;
+		}
+		int w = bitWidth(bits);
+		*p++ = (uint8_t)w;
+		uint64_t accumulator = 0;
+		int filled = 0;
+		for (int j = 0; j < FLIGHTLOG_GROUP && w > 0; j++) {
+			accumulator |= (uint64_t)group[j] << filled;
+			filled += w;
+			while (filled >= 8) {
+				*p++ = (uint8_t)accumulator;
+				accumulator >>= 8;
+				filled -= 8;
+			}
+		}
+		// 32 * w 비트는 항상 바이트로 나누어 떨어진다
+	}
+	return p - out;
+}
+
+// 묶음 하나의 값 32 개를 꺼낸다. 비트 수마다 따로 만들어서 이동량이 상수가 되게 한다.
+template <int W>
+static void unpackGroupWidth(const uint8_t * p, uint32_t * group){
+	const uint64_t mask = (W == 32) ? 0xFFFFFFFFull : ((1ull << W) - 1);
+	for (int j = 0; j < FLIGHTLOG_GROUP; j++) {
+		const int bit = j * W;
+		group[j] = (uint32_t)((load64(p + (bit >> 3)) >> (bit & 7)) & mask);
+	}
+}
+
+template <>
+void unpackGroupWidth<0>(const uint8_t *, uint32_t * group){
+	memset(group, 0, FLIGHTLOG_GROUP * sizeof(uint32_t));
+}
+
+typedef void (*UnpackFunction)(const uint8_t * p, uint32_t * group);
+
+#define UNPACK4(n) unpackGroupWidth<n>, unpackGroupWidth<n + 1>, unpackGroupWidth<n + 2>, unpackGroupWidth<n + 3>
+static const UnpackFunction UNPACK[33] = {
+	UNPACK4(0), UNPACK4(4), UNPACK4(8), UNPACK4(12), UNPACK4(16), UNPACK4(20), UNPACK4(24), UNPACK4(28), unpackGroupWidth<32>
+};
+#undef UNPACK4
+
+size_t decodeFlightLogChannel(const uint8_t * in, int count, int32_t * values, bool simd){
+	const uint8_t * p = in;
+	if (count == 0)
+		return 0;
+	memcpy(&values[0], p, sizeof(int32_t));
+	p += sizeof(int32_t);
+	if (count == 1)
+		return p - in;
+	int32_t firstDelta;
+	memcpy(&firstDelta, p, sizeof(int32_t));
+	p += sizeof(int32_t);
+	values[1] = (int32_t)((uint32_t)values[0] + (uint32_t)firstDelta);
+	uint32_t delta = (uint32_t)firstDelta;
+	uint32_t value = (uint32_t)values[1];
+	uint32_t group[FLIGHTLOG_GROUP];
+#ifdef FLIGHTLOG_SSE
+	if (simd) {
+		// zigzag 를 풀고 두 번 누적합 (차이의 차이 -> 차이 -> 값). 4 개씩 레지스터 안에서 누적하고 마지막 칸을 넘긴다.
+		__m128i carryDelta = _mm_set1_epi32((int)delta);
+		__m128i carryValue = _mm_set1_epi32((int)value);
+		const __m128i one = _mm_set1_epi32(1);
+		const __m128i zero = _mm_setzero_si128();
+		for (int begin = 2; begin < count; begin += FLIGHTLOG_GROUP) {
+			int n = count - begin < FLIGHTLOG_GROUP ? count - begin : FLIGHTLOG_GROUP;
+			int w = *p++;
+			if (w > 32)
+				return 0;    // 깨진 블록
+			UNPACK[w](p, group);
+			p += w * FLIGHTLOG_GROUP / 8;
+			// 꽉 찬 묶음은 values 에 바로 쓰고, 마지막 묶음은 group 에 썼다가 n 개만 옮긴다
+			int32_t * target = n == FLIGHTLOG_GROUP ? values + begin : (int32_t *)group;
+			for (int j = 0; j < FLIGHTLOG_GROUP; j += 4) {
+				__m128i u = _mm_loadu_si128((const __m128i *)(group + j));
+				__m128i d = _mm_xor_si128(_mm_srli_epi32(u, 1), _mm_sub_epi32(zero, _mm_and_si128(u, one)));
+				d = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+				d = _mm_add_epi32(d, _mm_slli_si128(d, 8));
+				d = _mm_add_epi32(d, carryDelta);
+				carryDelta = _mm_shuffle_epi32(d, _MM_SHUFFLE(3, 3, 3, 3));
+				__m128i v = _mm_add_epi32(d, _mm_slli_si128(d, 4));
+				v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+				v = _mm_add_epi32(v, carryValue);
+				carryValue = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+				_mm_storeu_si128((__m128i *)(target + j), v);
+			}
+			if (target != values + begin)
+				memcpy(values + begin, group, n * sizeof(int32_t));
+		}
+		return p - in;
+	}
+#endif
+	for (int begin = 2; begin < count; begin += FLIGHTLOG_GROUP) {
+		int n = count - begin < FLIGHTLOG_GROUP ? count - begin : FLIGHTLOG_GROUP;
+		int w = *p++;
+		if (w > 32)
+			return 0;    // 깨진 블록
+		UNPACK[w](p, group);
+		p += w * FLIGHTLOG_GROUP / 8;
+		for (int j = 0; j < n; j++) {
+			delta += unzigzag(group[j]);
+			value += delta;
+			values[begin + j] = (int32_t)value;
+		}
+	}
+	return p - in;
+}
+
+void dequantizeFlightLog(const int32_t * values, int count, float step, float * out, bool simd){
+	int i = 0;
+#ifdef FLIGHTLOG_SSE
+	if (simd) {
+		const __m128 s = _mm_set1_ps(step);
+		for (; i + 4 <= count; i += 4)
+			_mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)(values + i))), s));
+	}
+#else
+	(void)simd;
+#endif
+	for (; i < count; i++)
+		out[i] = (float)values[i] * step;
+}
+
+bool openFlightLog(FlightLogWriter & w, const char * path, const float * step){
+	w.file = fopen(path, "wb");
+	if (w.file == NULL)
+		return false;
+	memset(&w.header, 0, sizeof(w.header));
+	w.header.magic = FLIGHTLOG_MAGIC;
+	w.header.version = FLIGHTLOG_VERSION;
+	w.header.blockTicks = FLIGHTLOG_BLOCK_TICKS;
+	w.header.channels = FLIGHTLOG_CHANNELS;
+	if (step != NULL)
+		memcpy(w.header.step, step, sizeof(w.header.step));
+	else
+		defaultFlightLogSteps(w.header.step);
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++)
+		w.inverseStep[c] = 1.0 / w.header.step[c];
+	w.failed = fwrite(&w.header, sizeof(w.header), 1, w.file) != 1;
+	w.offset = sizeof(w.header);
+	w.index.clear();
+	memset(&w.stats, 0, sizeof(w.stats));
+	return true;
+}
+
+static bool blockOrder(const FlightLogBlockInfo & a, const FlightLogBlockInfo & b){
+	return a.flight != b.flight ? a.flight < b.flight : a.startTick < b.startTick;
+}
+
+bool closeFlightLog(FlightLogWriter & w){
+	if (w.file == NULL)
+		return false;
+	std::sort(w.index.begin(), w.index.end(), blockOrder);
+	FlightLogFooter footer;
+	footer.indexOffset = w.offset;
+	footer.blockCount = (uint32_t)w.index.size();
+	footer.magic = FLIGHTLOG_MAGIC;
+	bool ok = !w.failed;
+	if (!w.index.empty())
+		ok = fwrite(&w.index[0], sizeof(FlightLogBlockInfo), w.index.size(), w.file) == w.index.size() && ok;
+	ok = fwrite(&footer, sizeof(footer), 1, w.file) == 1 && ok;
+	ok = fclose(w.file) == 0 && ok;
+	w.file = NULL;
+	return ok;
+}
+
+void beginFlightTrack(FlightLogTrack & t, uint32_t flight, uint64_t startTick){
+	t.flight = flight;
+	t.startTick = startTick;
+	t.count = 0;
+	t.values.resize(FLIGHTLOG_CHANNELS * FLIGHTLOG_BLOCK_TICKS);
+	t.block.resize(BLOCK_HEADER_BYTES + FLIGHTLOG_CHANNELS * flightLogChannelBound(FLIGHTLOG_BLOCK_TICKS) + FLIGHTLOG_PADDING);
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++)
+		t.maxError[c] = 0.0f;
+}
+
+static bool writeBlock(FlightLogWriter & w, FlightLogTrack & t){
+	if (t.count == 0)
+		return true;
+	uint32_t channelBytes[FLIGHTLOG_CHANNELS];
+	size_t size = BLOCK_HEADER_BYTES;
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++) {
+		channelBytes[c] = (uint32_t)encodeFlightLogChannel(&t.values[c * FLIGHTLOG_BLOCK_TICKS], t.count, &t.block[size]);
+		size += channelBytes[c];
+	}
+	memcpy(&t.block[0], channelBytes, BLOCK_HEADER_BYTES);
+	memset(&t.block[size], 0, FLIGHTLOG_PADDING);
+	size += FLIGHTLOG_PADDING;
+
+	std::lock_guard<std::mutex> guard(w.lock);
+	FlightLogBlockInfo info;
+	info.flight = t.flight;
+	info.count = (uint32_t)t.count;
+	info.startTick = t.startTick;
+	info.offset = w.offset;
+	info.size = (uint32_t)size;
+	info.reserved = 0;
+	// 쓰지 못한 블록은 색인에 넣지 않는다. 한 번 실패하면 closeFlightLog 도 false 를 돌려준다.
+	t.startTick += t.count;
+	if (w.failed || fwrite(&t.block[0], 1, size, w.file) != size) {
+		w.failed = true;
+		t.count = 0;
+		return false;
+	}
+	w.offset += size;
+	w.index.push_back(info);
+	w.stats.ticks += t.count;
+	w.stats.blocks++;
+	w.stats.encodedBytes += size;
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++) {
+		w.stats.channelBytes[c] += channelBytes[c];
+		if (t.maxError[c] > w.stats.maxError[c])
+			w.stats.maxError[c] = t.maxError[c];
+	}
+	t.count = 0;
+	return true;
+}
+
+bool appendFlightTrack(FlightLogWriter & w, FlightLogTrack & t, float x, float y, float z, float velocity, uint32_t flags){
+	const float sample[FLIGHTLOG_CHANNELS] = { x, y, z, velocity, (float)flags };
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++) {
+		double scaled = (double)sample[c] * w.inverseStep[c];
+		int32_t q = (int32_t)llrint(scaled);
+		t.values[c * FLIGHTLOG_BLOCK_TICKS + t.count] = q;
+		float error = fabsf((float)((q - scaled) * w.header.step[c]));
+		if (error > t.maxError[c])
+			t.maxError[c] = error;
+	}
+	t.count++;
+	if (t.count == FLIGHTLOG_BLOCK_TICKS)
+		return writeBlock(w, t);
+	return true;
+}
+
+bool finishFlightTrack(FlightLogWriter & w, FlightLogTrack & t){
+	return writeBlock(w, t);
+}
+
+bool openFlightLogReader(FlightLogReader & r, const char * path){
+	r.file = fopen(path, "rb");
+	if (r.file == NULL)
+		return false;
+	FlightLogFooter footer;
+	bool ok = fread(&r.header, sizeof(r.header), 1, r.file) == 1 &&
+		r.header.magic == FLIGHTLOG_MAGIC && r.header.version == FLIGHTLOG_VERSION &&
+		r.header.channels == FLIGHTLOG_CHANNELS && r.header.blockTicks <= FLIGHTLOG_BLOCK_TICKS;
+	ok = ok && seekFile(r.file, -(int64_t)sizeof(footer), SEEK_END) == 0 && fread(&footer, sizeof(footer), 1, r.file) == 1 &&
+		footer.magic == FLIGHTLOG_MAGIC;
+	if (ok) {
+		r.fileBytes = (uint64_t)tellFile(r.file);
+		r.index.resize(footer.blockCount);
+		ok = seekFile(r.file, (int64_t)footer.indexOffset, SEEK_SET) == 0 &&
+			(footer.blockCount == 0 || fread(&r.index[0], sizeof(FlightLogBlockInfo), footer.blockCount, r.file) == footer.blockCount);
+	}
+	if (!ok) {
+		fclose(r.file);
+		r.file = NULL;
+		return false;
+	}
+	r.block.clear();
+	r.values.resize(FLIGHTLOG_CHANNELS * (FLIGHTLOG_BLOCK_TICKS + FLIGHTLOG_GROUP));
+#ifdef FLIGHTLOG_SSE
+	r.simd = true;
+#else
+	r.simd = false;
+#endif
+	r.blocksRead = 0;
+	return true;
+}
+
+void closeFlightLogReader(FlightLogReader & r){
+	if (r.file != NULL)
+		fclose(r.file);
+	r.file = NULL;
+}
+
+void listFlightLogFlights(const FlightLogReader & r, std::vector<uint32_t> & flights){
+	flights.clear();
+	for (size_t i = 0; i < r.index.size(); i++)
+		if (flights.empty() || flights.back() != r.index[i].flight)
+			flights.push_back(r.index[i].flight);
+}
+
+bool decodeFlightLogBlock(const FlightLogHeader & header, const uint8_t * data, size_t size, int count, int skip, int n,
+	int32_t * scratch, FlightLogRange & out, int outOffset, bool simd){
+	if (count <= 0 || (uint32_t)count > header.blockTicks || skip < 0 || n < 0 || skip + n > count || size < BLOCK_HEADER_BYTES)
+		return false;
+	uint32_t channelBytes[FLIGHTLOG_CHANNELS];
+	memcpy(channelBytes, data, BLOCK_HEADER_BYTES);
+	// 채널들이 블록 안에 있고 뒤에 여유가 남아야 한다 (풀 때 8 바이트씩 읽는다)
+	uint64_t payload = BLOCK_HEADER_BYTES + FLIGHTLOG_PADDING;
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++)
+		payload += channelBytes[c];
+	if (payload > size)
+		return false;
+	const uint8_t * p = data + BLOCK_HEADER_BYTES;
+	float * columns[FLIGHTLOG_FLAGS] = { &out.x[outOffset], &out.y[outOffset], &out.z[outOffset], &out.velocity[outOffset] };
+	for (int c = 0; c < FLIGHTLOG_CHANNELS; c++) {
+		int32_t * values = scratch + c * (count + FLIGHTLOG_GROUP);
+		if (decodeFlightLogChannel(p, count, values, simd) != channelBytes[c])
+			return false;
+		p += channelBytes[c];
+		if (c == FLIGHTLOG_FLAGS) {
+			for (int i = 0; i < n; i++)
+				out.flags[outOffset + i] = (uint8_t)values[skip + i];
+		}
+		else {
+			dequantizeFlightLog(values + skip, n, header.step[c], columns[c], simd);
+		}
+	}
+	return true;
+}
+
+// 블록이 끝나는 틱으로 찾는다
+static bool blockEndsBefore(const FlightLogBlockInfo & block, const FlightLogBlockInfo & key){
+	return block.flight != key.flight ? block.flight < key.flight : block.startTick + block.count <= key.startTick;
+}
+
+int readFlightLogRange(FlightLogReader & r, uint32_t flight, uint64_t fromTick, uint64_t toTick, FlightLogRange & out){
+	FlightLogBlockInfo key;
+	key.flight = flight;
+	key.startTick = fromTick;
+	std::vector<FlightLogBlockInfo>::const_iterator first = std::lower_bound(r.index.begin(), r.index.end(), key, blockEndsBefore);
+	std::vector<FlightLogBlockInfo>::const_iterator last = first;
+	int total = 0;
+	bool corrupt = false;
+	while (last != r.index.end() && last->flight == flight && last->startTick < toTick) {
+		// 색인의 틱 수를 믿지 않는다 (풀기 버퍼는 blockTicks 만큼이다)
+		if (last->count == 0 || last->count > r.header.blockTicks) {
+			corrupt = true;
+			break;
+		}
+		uint64_t begin = std::max(fromTick, last->startTick);
+		uint64_t end = std::min(toTick, last->startTick + last->count);
+		total += (int)(end - begin);
+		++last;
+	}
+	out.count = total;
+	out.startTick = first != last ? std::max(fromTick, first->startTick) : fromTick;
+	out.x.resize(total);
+	out.y.resize(total);
+	out.z.resize(total);
+	out.velocity.resize(total);
+	out.flags.resize(total);
+	int written = 0;
+	for (std::vector<FlightLogBlockInfo>::const_iterator b = first; b != last; ++b) {
+		if (r.block.size() < b->size)
+			r.block.resize(b->size);
+		if (seekFile(r.file, (int64_t)b->offset, SEEK_SET) != 0 || fread(&r.block[0], 1, b->size, r.file) != b->size) {
+			corrupt = true;
+			break;
+		}
+		r.blocksRead++;
+		int skip = fromTick > b->startTick ? (int)(fromTick - b->startTick) : 0;
+		int n = (int)(std::min(toTick, b->startTick + b->count) - (b->startTick + skip));
+		if (!decodeFlightLogBlock(r.header, &r.block[0], b->size, (int)b->count, skip, n, &r.values[0], out, written, r.simd)) {
+			corrupt = true;
+			break;
+		}
+		written += n;
+	}
+	// 실패하면 앞에서 푼 데까지만 남긴다
+	if (written < total) {
+		out.count = written;
+		out.x.resize(written);
+		out.y.resize(written);
+		out.z.resize(written);
+		out.velocity.resize(written);
+		out.flags.resize(written);
+	}
+	return corrupt ? -1 : written;
+}
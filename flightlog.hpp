@@ -0,0 +1,151 @@
+#ifndef FLIGHTLOG_HPP
+#define FLIGHTLOG_HPP
+
+#include <stdio.h>
+#include <stdint.h>
+#include <vector>
+#include <mutex>
+
+// 비행 기록 파일 (.rfl). 비행마다 틱별 gro1, velocity, 상태 플래그를 압축해서 모아 둔다.
+//
+// 채널마다 따로 (열 단위) 저장한다. 값은 채널의 step 으로 양자화한 정수로 바꾸고
+// (오차는 step / 2 이하), 블록의 첫 값과 첫 차이 뒤로는 차이의 차이 (delta-of-delta) 만 남긴다.
+// 비행 모델은 구간마다 가속도가 일정하므로 차이의 차이는 거의 0 이나 상수다.
+// 이것을 zigzag 로 부호 없는 수로 바꾸고, 32 개씩 묶음마다 가장 큰 값에 맞춘 비트 수로 빽빽하게 채운다.
+//
+// 파일 = 헤더, 블록들 (비행 하나의 연속된 FLIGHTLOG_BLOCK_TICKS 틱), 블록 색인, 꼬리.
+// 색인은 (비행, 시작 틱) 순으로 정렬되어 있어서 아무 비행의 아무 구간이나 그 구간의 블록만 읽어서 풀 수 있다.
+// 여러 비행을 동시에 기록할 수 있고 (SimServer), 블록 인코딩은 비행마다 따로 하고 파일 쓰기만 잠근다.
+#define FLIGHTLOG_MAGIC 0x4C544B52u        // "RKTL"
+#define FLIGHTLOG_VERSION 1
+#define FLIGHTLOG_CHANNELS 5
+#define FLIGHTLOG_BLOCK_TICKS 1024
+#define FLIGHTLOG_GROUP 32                  // 비트 수를 함께 쓰는 값의 수
+#define FLIGHTLOG_PADDING 8                 // 블록 뒤 여유. 풀 때 8 바이트씩 읽어도 넘치지 않게
+
+enum FlightLogChannel {
+	FLIGHTLOG_X = 0,
+	FLIGHTLOG_Y,
+	FLIGHTLOG_Z,
+	FLIGHTLOG_VELOCITY,
+	FLIGHTLOG_FLAGS                         // telemetry.hpp 의 TELEMETRY_* 비트 (step 1)
+};
+
+#pragma pack(push, 1)
+struct FlightLogHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t blockTicks;
+	uint32_t channels;
+	float step[FLIGHTLOG_CHANNELS];          // 양자화 간격
+};
+
+struct FlightLogBlockInfo {
+	uint32_t flight;
+	uint32_t count;                          // 틱 수
+	uint64_t startTick;
+	uint64_t offset;                         // 파일 안 위치
+	uint32_t size;                           // 바이트 (여유 포함)
+	uint32_t reserved;
+};
+
+struct FlightLogFooter {
+	uint64_t indexOffset;
+	uint32_t blockCount;
+	uint32_t magic;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(FlightLogBlockInfo) == 32, "FlightLogBlockInfo must be 32 bytes");
+
+// 한 틱의 원래 크기 (float 네 개 + 플래그 한 바이트). 압축률은 이것과 비교한다.
+#define FLIGHTLOG_RAW_TICK_BYTES (4 * sizeof(float) + 1)
+
+// 기본 양자화 간격 : 위치 0.1 mm, 속도 1e-6
+void defaultFlightLogSteps(float * step);
+
+// 채널 하나 인코딩. values 는 양자화된 정수 count 개. out 에 쓰고 쓴 바이트 수를 돌려준다.
+// out 은 flightLogChannelBound(count) 바이트 이상이어야 한다.
+size_t flightLogChannelBound(int count);
+size_t encodeFlightLogChannel(const int32_t * values, int count, uint8_t * out);
+// 풀기. in 뒤에 FLIGHTLOG_PADDING 바이트를 더 읽을 수 있어야 한다. 읽은 바이트 수를 돌려준다 (깨졌으면 0).
+// simd 가 false 면 스칼라로 (비교용)
+size_t decodeFlightLogChannel(const uint8_t * in, int count, int32_t * values, bool simd);
+// 양자화된 정수를 float 로
+void dequantizeFlightLog(const int32_t * values, int count, float step, float * out, bool simd);
+
+struct FlightLogStats {
+	uint64_t ticks;
+	uint64_t blocks;
+	uint64_t encodedBytes;                   // 블록 (여유 포함)
+	uint64_t channelBytes[FLIGHTLOG_CHANNELS];
+	float maxError[FLIGHTLOG_CHANNELS];      // 양자화 오차
+};
+
+struct FlightLogWriter {
+	FILE * file;
+	FlightLogHeader header;
+	double inverseStep[FLIGHTLOG_CHANNELS];
+	uint64_t offset;
+	std::vector<FlightLogBlockInfo> index;
+	FlightLogStats stats;
+	bool failed;                             // 쓰기가 한 번이라도 실패했다
+	std::mutex lock;                         // 파일 쓰기, 색인, 통계
+};
+
+// 기록 중인 비행 하나. 블록 하나 분량의 양자화된 값을 모았다가 차면 인코딩해서 쓴다 (비행마다 약 20 KB).
+struct FlightLogTrack {
+	uint32_t flight;
+	uint64_t startTick;                      // 지금 블록의 첫 틱
+	int count;
+	std::vector<int32_t> values;             // FLIGHTLOG_CHANNELS * FLIGHTLOG_BLOCK_TICKS
+	std::vector<uint8_t> block;              // 인코딩 버퍼
+	float maxError[FLIGHTLOG_CHANNELS];
+};
+
+// step 이 NULL 이면 기본값
+bool openFlightLog(FlightLogWriter & w, const char * path, const float * step);
+// 남은 블록은 먼저 finishFlightTrack 으로 써야 한다. 색인과 꼬리를 쓰고 닫는다. 그 전의 쓰기가 실패했어도 false.
+bool closeFlightLog(FlightLogWriter & w);
+
+void beginFlightTrack(FlightLogTrack & t, uint32_t flight, uint64_t startTick);
+// 한 틱 더한다. 블록이 차면 인코딩해서 파일에 쓴다 (여러 스레드에서 각자 다른 track 으로 불러도 된다).
+// 블록을 쓰지 못했으면 false.
+bool appendFlightTrack(FlightLogWriter & w, FlightLogTrack & t, float x, float y, float z, float velocity, uint32_t flags);
+// 모은 것을 블록으로 쓴다. 비행이 끝나면 부른다. 쓰지 못했으면 false.
+bool finishFlightTrack(FlightLogWriter & w, FlightLogTrack & t);
+
+struct FlightLogReader {
+	FILE * file;
+	FlightLogHeader header;
+	std::vector<FlightLogBlockInfo> index;   // (flight, startTick) 순
+	std::vector<uint8_t> block;              // 읽기 버퍼
+	std::vector<int32_t> values;             // 풀기 버퍼
+	bool simd;
+	uint64_t fileBytes;
+	uint64_t blocksRead;                     // 지금까지 읽은 블록 수 (구간 읽기 확인용)
+};
+
+// 풀어 낸 구간. 열 단위.
+struct FlightLogRange {
+	uint64_t startTick;
+	int count;
+	std::vector<float> x, y, z, velocity;
+	std::vector<uint8_t> flags;
+};
+
+bool openFlightLogReader(FlightLogReader & r, const char * path);
+void closeFlightLogReader(FlightLogReader & r);
+// 기록된 비행 id 들 (중복 없이, 순서대로)
+void listFlightLogFlights(const FlightLogReader & r, std::vector<uint32_t> & flights);
+// flight 의 [fromTick, toTick) 중 기록된 부분을 out 에 푼다. 겹치는 블록만 읽는다. 푼 틱 수를 돌려준다.
+// 블록을 읽지 못하거나 깨졌으면 -1 이고, out 에는 그 앞까지 푼 것 (out.count 틱) 만 남는다.
+int readFlightLogRange(FlightLogReader & r, uint32_t flight, uint64_t fromTick, uint64_t toTick, FlightLogRange & out);
+
+// 메모리에 있는 블록 하나 (size 바이트, 여유 포함, count 틱) 를 풀어서 그 중 [skip, skip + n) 을 out 의 outOffset 부터 쓴다.
+// scratch 는 FLIGHTLOG_CHANNELS * (count + FLIGHTLOG_GROUP) 개가 있어야 한다.
+// count 가 header.blockTicks 를 넘거나 채널 크기가 맞지 않으면 (깨진 블록) false.
+bool decodeFlightLogBlock(const FlightLogHeader & header, const uint8_t * data, size_t size, int count, int skip, int n,
+	int32_t * scratch, FlightLogRange & out, int outOffset, bool simd);
+
+#endif
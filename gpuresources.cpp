@@ -0,0 +1,182 @@
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+#include "gpuresources.hpp"
+
+// id 의 아래 20 비트는 슬롯 번호, 위는 세대 (지운 자원의 id 를 다시 쓰지 않게)
+#define GPU_INDEX_BITS 20
+#define GPU_INDEX_MASK ((1u << GPU_INDEX_BITS) - 1)
+
+static const char * const CATEGORY_NAMES[GPU_CATEGORIES] = { "mesh", "dynamic", "stream", "texture", "shader", "state" };
+static const char * const KIND_NAMES[] = { "buffer", "texture", "program", "vertex array" };
+
+const char * gpuCategoryName(GpuCategory category){
+	return category >= 0 && category < GPU_CATEGORIES ? CATEGORY_NAMES[category] : "?";
+}
+
+void initGpuResources(GpuResources & r, GLsizeiptr budget){
+	r.slots.clear();
+	r.slots.push_back(GpuResource());
+	memset(&r.slots[0], 0, sizeof(GpuResource));
+	r.freeSlots.clear();
+	for (int c = 0; c < GPU_CATEGORIES; c++) {
+		r.bytes[c] = 0;
+		r.counts[c] = 0;
+	}
+	r.residentBytes = 0;
+	r.peakBytes = 0;
+	r.budget = budget;
+	r.frame = 0;
+	r.evictions = 0;
+	r.reloads = 0;
+	r.reloadBytes = 0;
+}
+
+static GpuResource * findGpu(GpuResources & r, GpuId id){
+	uint32_t index = id & GPU_INDEX_MASK;
+	if (id == GPU_NONE || index >= r.slots.size())
+		return NULL;
+	GpuResource & g = r.slots[index];
+	if (!g.alive || g.generation != (id >> GPU_INDEX_BITS))
+		return NULL;
+	return &g;
+}
+
+static void deleteGpuName(GpuKind kind, GLuint name){
+	switch (kind) {
+	case GPU_BUFFER: glDeleteBuffers(1, &name); break;
+	case GPU_TEXTURE: glDeleteTextures(1, &name); break;
+	case GPU_PROGRAM: glDeleteProgram(name); break;
+	case GPU_VERTEX_ARRAY: glDeleteVertexArrays(1, &name); break;
+	}
+}
+
+static void addResident(GpuResources & r, const GpuResource & g, GLsizeiptr bytes){
+	r.bytes[g.category] += bytes;
+	r.residentBytes += bytes;
+	if (r.residentBytes > r.peakBytes)
+		r.peakBytes = r.residentBytes;
+}
+
+GpuId registerGpu(GpuResources & r, GpuKind kind, GLuint name, GpuCategory category, GLsizeiptr bytes, const char * label, bool owned){
+	uint32_t index;
+	if (!r.freeSlots.empty()) {
+		index = r.freeSlots.back();
+		r.freeSlots.pop_back();
+	}
+	else {
+		index = (uint32_t)r.slots.size();
+		r.slots.push_back(GpuResource());
+		r.slots.back().generation = 0;
+	}
+	GpuResource & g = r.slots[index];
+	g.generation = (g.generation + 1) & (0xFFFFFFFFu >> GPU_INDEX_BITS);
+	if (g.generation == 0)
+		g.generation = 1;
+	g.name = name;
+	g.kind = kind;
+	g.category = category;
+	g.bytes = bytes;
+	g.label = label;
+	g.alive = true;
+	g.owned = owned;
+	g.lastUsed = r.frame;
+	g.source = NULL;
+	g.target = GL_ARRAY_BUFFER;
+	g.usage = GL_STATIC_DRAW;
+	r.counts[category]++;
+	addResident(r, g, bytes);
+	return (g.generation << GPU_INDEX_BITS) | index;
+}
+
+void setGpuSource(GpuResources & r, GpuId id, GLenum target, const void * data, GLenum usage){
+	GpuResource * g = findGpu(r, id);
+	if (g == NULL || g->kind != GPU_BUFFER)
+		return;
+	g->source = data;
+	g->target = target;
+	g->usage = usage;
+}
+
+void resizeGpu(GpuResources & r, GpuId id, GLsizeiptr bytes){
+	GpuResource * g = findGpu(r, id);
+	if (g == NULL)
+		return;
+	if (g->name != 0)
+		addResident(r, *g, bytes - g->bytes);
+	g->bytes = bytes;
+}
+
+GLuint useGpu(GpuResources & r, GpuId id){
+	GpuResource * g = findGpu(r, id);
+	if (g == NULL)
+		return 0;
+	g->lastUsed = r.frame;
+	if (g->name == 0 && g->source != NULL) {
+		glGenBuffers(1, &g->name);
+		glBindBuffer(g->target, g->name);
+		glBufferData(g->target, g->bytes, g->source, g->usage);
+		addResident(r, *g, g->bytes);
+		r.reloads++;
+		r.reloadBytes += g->bytes;
+	}
+	return g->name;
+}
+
+void releaseGpu(GpuResources & r, GpuId id){
+	GpuResource * g = findGpu(r, id);
+	if (g == NULL)
+		return;
+	if (g->name != 0) {
+		if (g->owned)
+			deleteGpuName(g->kind, g->name);
+		r.bytes[g->category] -= g->bytes;
+		r.residentBytes -= g->bytes;
+	}
+	r.counts[g->category]--;
+	g->alive = false;
+	g->name = 0;
+	r.freeSlots.push_back(id & GPU_INDEX_MASK);
+}
+
+void beginGpuFrame(GpuResources & r){
+	r.frame++;
+	if (r.budget <= 0)
+		return;
+	// 지난 프레임까지 쓰지 않은 것 중 가장 오래된 것. 이번 프레임에 필요한 것은 useGpu 가 다시 올린다.
+	while (r.residentBytes > r.budget) {
+		GpuResource * oldest = NULL;
+		for (size_t i = 1; i < r.slots.size(); i++) {
+			GpuResource & g = r.slots[i];
+			if (g.alive && g.owned && g.source != NULL && g.name != 0 && g.lastUsed + 1 < r.frame &&
+				(oldest == NULL || g.lastUsed < oldest->lastUsed))
+				oldest = &g;
+		}
+		if (oldest == NULL)
+			break;
+		deleteGpuName(oldest->kind, oldest->name);
+		oldest->name = 0;
+		r.bytes[oldest->category] -= oldest->bytes;
+		r.residentBytes -= oldest->bytes;
+		r.evictions++;
+	}
+}
+
+int shutdownGpuResources(GpuResources & r){
+	int leaks = 0;
+	for (size_t i = 1; i < r.slots.size(); i++) {
+		GpuResource & g = r.slots[i];
+		if (!g.alive)
+			continue;
+		leaks++;
+		printf("GPU leak : %s '%s' (%s, %lld bytes)%s\n", KIND_NAMES[g.kind], g.label != NULL ? g.label : "?",
+			gpuCategoryName(g.category), (long long)g.bytes, g.owned ? "" : ", not owned");
+		releaseGpu(r, ((GpuId)g.generation << GPU_INDEX_BITS) | (GpuId)i);
+	}
+	printf("GPU resources : %s, peak %.1f KB, %d evictions, %d reloads (%.1f KB)\n",
+		leaks == 0 ? "no leaks" : "leaks released at exit", r.peakBytes / 1024.0, r.evictions, r.reloads, r.reloadBytes / 1024.0);
+	return leaks;
+}
@@ -0,0 +1,125 @@
+#ifndef GPURESOURCES_HPP
+#define GPURESOURCES_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include <GL/glew.h>
+
+// GPU 자원 (버퍼, 텍스처, 프로그램, VAO) 관리.
+// 자원마다 종류 (GpuCategory) 별로 바이트를 세고, 가장 많이 쓴 양과 이름표를 남긴다.
+// CPU 쪽 원본이 있는 버퍼 (정적 메쉬) 는 다시 올릴 수 있는 자원으로 표시해 두고, 예산을 넘으면
+// 가장 오래 쓰지 않은 것부터 GPU 에서 내린다 (LRU). 다시 쓰일 때 useGpu 가 원본에서 올린다.
+// 그래서 그릴 때는 GLuint 를 들고 있지 말고 매번 useGpu 로 받아야 한다.
+// 다른 모듈이 만들고 지우는 자원 (StreamBuffer, HUD 아틀라스) 은 owned = false 로 세기만 한다.
+// 끝낼 때 shutdownGpuResources 가 아직 놓지 않은 자원을 이름표와 함께 출력하고 지운다.
+// 메인 스레드 (GL 컨텍스트) 에서만 부른다.
+typedef uint32_t GpuId;          // 0 은 없음
+#define GPU_NONE 0u
+
+enum GpuKind {
+	GPU_BUFFER,
+	GPU_TEXTURE,
+	GPU_PROGRAM,
+	GPU_VERTEX_ARRAY
+};
+
+enum GpuCategory {
+	GPU_MESH,                    // 정적 메쉬 정점/색
+	GPU_DYNAMIC,                 // 가끔 다시 올리는 버퍼 (궤적)
+	GPU_STREAM,                  // 매 프레임 쓰는 스트리밍 버퍼
+	GPU_TEXTURE_DATA,
+	GPU_SHADER,
+	GPU_STATE,                   // VAO
+	GPU_CATEGORIES
+};
+
+struct GpuResource {
+	GLuint name;                 // 내려 놓았으면 0
+	GpuKind kind;
+	GpuCategory category;
+	GLsizeiptr bytes;
+	const char * label;
+	bool alive;
+	bool owned;                  // false 면 세기만 하고 지우지 않는다
+	uint32_t generation;
+	uint64_t lastUsed;           // 마지막으로 useGpu 한 프레임
+	// 다시 올릴 수 있는 버퍼의 원본
+	const void * source;
+	GLenum target;
+	GLenum usage;
+};
+
+struct GpuResources {
+	std::vector<GpuResource> slots;      // slots[0] 은 쓰지 않는다
+	std::vector<uint32_t> freeSlots;
+	GLsizeiptr bytes[GPU_CATEGORIES];    // GPU 에 올라가 있는 바이트
+	int counts[GPU_CATEGORIES];
+	GLsizeiptr residentBytes;
+	GLsizeiptr peakBytes;
+	GLsizeiptr budget;                   // 0 이면 제한 없음
+	uint64_t frame;
+	int evictions;                       // 처음부터
+	int reloads;
+	GLsizeiptr reloadBytes;
+};
+
+void initGpuResources(GpuResources & r, GLsizeiptr budget);
+// 이미 만든 GL 이름을 맡긴다. label 은 끝까지 살아 있는 문자열이어야 한다.
+GpuId registerGpu(GpuResources & r, GpuKind kind, GLuint name, GpuCategory category, GLsizeiptr bytes, const char * label, bool owned);
+// 버퍼의 원본을 알려 준다. 예산을 넘으면 내려 놓았다가 다시 올릴 수 있게 된다.
+void setGpuSource(GpuResources & r, GpuId id, GLenum target, const void * data, GLenum usage);
+// 크기가 바뀌었을 때 (glBufferData 를 다시 부른 경우)
+void resizeGpu(GpuResources & r, GpuId id, GLsizeiptr bytes);
+// 이번 프레임에 쓴다고 표시하고 GL 이름을 돌려준다. 내려 놓은 버퍼면 지금 다시 올린다.
+GLuint useGpu(GpuResources & r, GpuId id);
+// 지운다 (owned 면 GL 자원도). 두 번 불러도 된다.
+void releaseGpu(GpuResources & r, GpuId id);
+// 프레임 시작. 예산을 넘었으면 지난 프레임까지 쓰지 않은 것 중 오래된 것부터 내려 놓는다.
+void beginGpuFrame(GpuResources & r);
+// 남은 자원을 출력하고 (누수) 지운다. 새지 않았으면 0.
+int shutdownGpuResources(GpuResources & r);
+const char * gpuCategoryName(GpuCategory category);
+
+// 자원 하나를 가진 핸들. 소멸자에서 releaseGpu 한다. 복사는 안 되고 옮길 수만 있다.
+template<GpuKind K>
+struct GpuHandle {
+	GpuResources * owner;
+	GpuId id;
+
+	GpuHandle() : owner(NULL), id(GPU_NONE) {}
+	GpuHandle(GpuResources & r, GLuint name, GpuCategory category, GLsizeiptr bytes, const char * label)
+		: owner(&r), id(registerGpu(r, K, name, category, bytes, label, true)) {}
+	GpuHandle(GpuHandle && other) : owner(other.owner), id(other.id){
+		other.id = GPU_NONE;
+	}
+	GpuHandle & operator=(GpuHandle && other){
+		if (this != &other) {
+			reset();
+			owner = other.owner;
+			id = other.id;
+			other.id = GPU_NONE;
+		}
+		return *this;
+	}
+	GpuHandle(const GpuHandle &) = delete;
+	GpuHandle & operator=(const GpuHandle &) = delete;
+	~GpuHandle(){
+		reset();
+	}
+	void reset(){
+		if (owner != NULL && id != GPU_NONE)
+			releaseGpu(*owner, id);
+		id = GPU_NONE;
+	}
+	GLuint get() const{
+		return id != GPU_NONE ? useGpu(*owner, id) : 0;
+	}
+};
+
+typedef GpuHandle<GPU_BUFFER> GpuBuffer;
+typedef GpuHandle<GPU_TEXTURE> GpuTexture;
+typedef GpuHandle<GPU_PROGRAM> GpuProgram;
+typedef GpuHandle<GPU_VERTEX_ARRAY> GpuVertexArray;
+
+#endif
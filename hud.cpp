@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include "hud.hpp"
+
+// 5x7 글꼴. 글자마다 위에서부터 7 줄, 한 줄은 5 비트 (0x10 이 왼쪽 끝).
+static const unsigned char HUD_FONT[HUD_CHAR_COUNT][HUD_GLYPH_HEIGHT] = {
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },  // ' '
+	{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 },  // '!'
+	{ 0x0a, 0x0a, 0x0a, 0x00, 0x00, 0x00, 0x00 },  // '"'
+	{ 0x0a, 0x0a, 0x1f, 0x0a, 0x1f, 0x0a, 0x0a },  // '#'
+	{ 0x04, 0x0f, 0x14, 0x0e, 0x05, 0x1e, 0x04 },  // '$'
+	{ 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },  // '%'
+	{ 0x0c, 0x12, 0x14, 0x08, 0x15, 0x12, 0x0d },  // '&'
+	{ 0x04, 0x04, 0x08, 0x00, 0x00, 0x00, 0x00 },  // '''
+	{ 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },  // '('
+	{ 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },  // ')'
+	{ 0x00, 0x04, 0x15, 0x0e, 0x15, 0x04, 0x00 },  // '*'
+	{ 0x00, 0x04, 0x04, 0x1f, 0x04, 0x04, 0x00 },  // '+'
+	{ 0x00, 0x00, 0x00, 0x00, 0x0c, 0x04, 0x08 },  // ','
+	{ 0x00, 0x00, 0x00, 0x1f, 0x00, 0x00, 0x00 },  // '-'
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x0c, 0x0c },  // '.'
+	{ 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },  // '/'
+	{ 0x0e, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0e },  // '0'
+	{ 0x04, 0x0c, 0x04, 0x04, 0x04, 0x04, 0x0e },  // '1'
+	{ 0x0e, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1f },  // '2'
+	{ 0x1f, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0e },  // '3'
+	{ 0x02, 0x06, 0x0a, 0x12, 0x1f, 0x02, 0x02 },  // '4'
+	{ 0x1f, 0x10, 0x1e, 0x01, 0x01, 0x11, 0x0e },  // '5'
+	{ 0x06, 0x08, 0x10, 0x1e, 0x11, 0x11, 0x0e },  // '6'
+	{ 0x1f, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },  // '7'
+	{ 0x0e, 0x11, 0x11, 0x0e, 0x11, 0x11, 0x0e },  // '8'
+	{ 0x0e, 0x11, 0x11, 0x0f, 0x01, 0x02, 0x0c },  // '9'
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x0c, 0x00 },  // ':'
+	{ 0x00, 0x0c, 0x0c, 0x00, 0x0c, 0x04, 0x08 },  // ';'
+	{ 0x02, 0x04, 0x08, 0x10, 0x08, 0x04, 0x02 },  // '<'
+	{ 0x00, 0x00, 0x1f, 0x00, 0x1f, 0x00, 0x00 },  // '='
+	{ 0x08, 0x04, 0x02, 0x01, 0x02, 0x04, 0x08 },  // '>'
+	{ 0x0e, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 },  // '?'
+	{ 0x0e, 0x11, 0x01, 0x0d, 0x15, 0x15, 0x0e },  // '@'
+	{ 0x0e, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },  // 'A'
+	{ 0x1e, 0x11, 0x11, 0x1e, 0x11, 0x11, 0x1e },  // 'B'
+	{ 0x0e, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0e },  // 'C'
+	{ 0x1c, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1c },  // 'D'
+	{ 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f },  // 'E'
+	{ 0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x10 },  // 'F'
+	{ 0x0e, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0f },  // 'G'
+	{ 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x11 },  // 'H'
+	{ 0x0e, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },  // 'I'
+	{ 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0c },  // 'J'
+	{ 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },  // 'K'
+	{ 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1f },  // 'L'
+	{ 0x11, 0x1b, 0x15, 0x15, 0x11, 0x11, 0x11 },  // 'M'
+	{ 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },  // 'N'
+	{ 0x0e, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },  // 'O'
+	{ 0x1e, 0x11, 0x11, 0x1e, 0x10, 0x10, 0x10 },  // 'P'
+	{ 0x0e, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0d },  // 'Q'
+	{ 0x1e, 0x11, 0x11, 0x1e, 0x14, 0x12, 0x11 },  // 'R'
+	{ 0x0f, 0x10, 0x10, 0x0e, 0x01, 0x01, 0x1e },  // 'S'
+	{ 0x1f, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },  // 'T'
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0e },  // 'U'
+	{ 0x11, 0x11, 0x11, 0x11, 0x11, 0x0a, 0x04 },  // 'V'
+	{ 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0a },  // 'W'
+	{ 0x11, 0x11, 0x0a, 0x04, 0x0a, 0x11, 0x11 },  // 'X'
+	{ 0x11, 0x11, 0x0a, 0x04, 0x04, 0x04, 0x04 },  // 'Y'
+	{ 0x1f, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1f },  // 'Z'
+	{ 0x0e, 0x08, 0x08, 0x08, 0x08, 0x08, 0x0e },  // '['
+	{ 0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00 },  // 'backslash'
+	{ 0x0e, 0x02, 0x02, 0x02, 0x02, 0x02, 0x0e },  // ']'
+	{ 0x04, 0x0a, 0x11, 0x00, 0x00, 0x00, 0x00 },  // '^'
+	{ 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x1f },  // '_'
+	{ 0x08, 0x04, 0x02, 0x00, 0x00, 0x00, 0x00 },  // '`'
+	{ 0x00, 0x00, 0x0e, 0x01, 0x0f, 0x11, 0x0f },  // 'a'
+	{ 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x1e },  // 'b'
+	{ 0x00, 0x00, 0x0e, 0x10, 0x10, 0x11, 0x0e },  // 'c'
+	{ 0x01, 0x01, 0x0d, 0x13, 0x11, 0x11, 0x0f },  // 'd'
+	{ 0x00, 0x00, 0x0e, 0x11, 0x1f, 0x10, 0x0e },  // 'e'
+	{ 0x06, 0x09, 0x08, 0x1c, 0x08, 0x08, 0x08 },  // 'f'
+	{ 0x00, 0x0f, 0x11, 0x11, 0x0f, 0x01, 0x0e },  // 'g'
+	{ 0x10, 0x10, 0x16, 0x19, 0x11, 0x11, 0x11 },  // 'h'
+	{ 0x04, 0x00, 0x0c, 0x04, 0x04, 0x04, 0x0e },  // 'i'
+	{ 0x02, 0x00, 0x06, 0x02, 0x02, 0x12, 0x0c },  // 'j'
+	{ 0x10, 0x10, 0x12, 0x14, 0x18, 0x14, 0x12 },  // 'k'
+	{ 0x0c, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0e },  // 'l'
+	{ 0x00, 0x00, 0x1a, 0x15, 0x15, 0x11, 0x11 },  // 'm'
+	{ 0x00, 0x00, 0x16, 0x19, 0x11, 0x11, 0x11 },  // 'n'
+	{ 0x00, 0x00, 0x0e, 0x11, 0x11, 0x11, 0x0e },  // 'o'
+	{ 0x00, 0x00, 0x1e, 0x11, 0x1e, 0x10, 0x10 },  // 'p'
+	{ 0x00, 0x00, 0x0d, 0x13, 0x0f, 0x01, 0x01 },  // 'q'
+	{ 0x00, 0x00, 0x16, 0x19, 0x10, 0x10, 0x10 },  // 'r'
+	{ 0x00, 0x00, 0x0e, 0x10, 0x0e, 0x01, 0x1e },  // 's'
+	{ 0x08, 0x08, 0x1c, 0x08, 0x08, 0x09, 0x06 },  // 't'
+	{ 0x00, 0x00, 0x11, 0x11, 0x11, 0x13, 0x0d },  // 'u'
+	{ 0x00, 0x00, 0x11, 0x11, 0x11, 0x0a, 0x04 },  // 'v'
+	{ 0x00, 0x00, 0x11, 0x11, 0x15, 0x15, 0x0a },  // 'w'
+	{ 0x00, 0x00, 0x11, 0x0a, 0x04, 0x0a, 0x11 },  // 'x'
+	{ 0x00, 0x00, 0x11, 0x11, 0x0f, 0x01, 0x0e },  // 'y'
+	{ 0x00, 0x00, 0x1f, 0x02, 0x04, 0x08, 0x1f },  // 'z'
+	{ 0x02, 0x04, 0x04, 0x08, 0x04, 0x04, 0x02 },  // '{'
+	{ 0x04, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },  // '|'
+	{ 0x08, 0x04, 0x04, 0x02, 0x04, 0x04, 0x08 },  // '}'
+	{ 0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00 },  // '~'
+};
+
+void bakeHudAtlas(unsigned char * pixels){
+	memset(pixels, 0, HUD_ATLAS_WIDTH * HUD_ATLAS_HEIGHT);
+	for (int c = 0; c <= HUD_SOLID_CELL; c++) {
+		int cellX = (c % HUD_ATLAS_COLUMNS) * HUD_CELL_WIDTH;
+		int cellY = (c / HUD_ATLAS_COLUMNS) * HUD_CELL_HEIGHT;
+		for (int y = 0; y < HUD_CELL_HEIGHT; y++)
+			for (int x = 0; x < HUD_CELL_WIDTH; x++) {
+				bool on;
+				if (c == HUD_SOLID_CELL)
+					on = true;
+				else
+					on = x < HUD_GLYPH_WIDTH && y < HUD_GLYPH_HEIGHT && (HUD_FONT[c][y] >> (HUD_GLYPH_WIDTH - 1 - x)) & 1;
+				pixels[(cellY + y) * HUD_ATLAS_WIDTH + cellX + x] = on ? 255 : 0;
+			}
+	}
+}
+
+void initHud(Hud & h, int scale){
+	h.scale = scale;
+	h.visible = true;
+	h.vertices = NULL;
+	h.count = 0;
+	h.capacity = 0;
+	h.dropped = 0;
+	h.toNdcX = 0.0f;
+	h.toNdcY = 0.0f;
+	for (int i = 0; i < HUD_GRAPH_SAMPLES; i++)
+		h.frameMs[i] = 0.0f;
+	h.frameIndex = 0;
+	h.buildMs = 0.0;
+	h.drawMs = 0.0;
+	static unsigned char pixels[HUD_ATLAS_WIDTH * HUD_ATLAS_HEIGHT];
+	bakeHudAtlas(pixels);
+	glGenTextures(1, &h.atlas);
+	glBindTexture(GL_TEXTURE_2D, h.atlas);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, HUD_ATLAS_WIDTH, HUD_ATLAS_HEIGHT, 0, GL_RED, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	// 정수배로만 늘리므로 가장 가까운 텍셀로 읽어야 글자가 또렷하다
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+}
+
+void freeHud(Hud & h){
+	glDeleteTextures(1, &h.atlas);
+	h.atlas = 0;
+}
+
+void pushHudFrameTime(Hud & h, float ms){
+	h.frameMs[h.frameIndex] = ms;
+	h.frameIndex = (h.frameIndex + 1) % HUD_GRAPH_SAMPLES;
+}
+
+void beginHud(Hud & h, HudVertex * out, int capacity, int width, int height){
+	h.vertices = out;
+	h.count = 0;
+	h.capacity = out != NULL ? capacity : 0;
+	h.dropped = 0;
+	h.toNdcX = 2.0f / width;
+	h.toNdcY = -2.0f / height;
+}
+
+// 사각형 하나 = 삼각형 두 개. (u0,v0)-(u1,v1) 은 아틀라스 텍셀 좌표
+static inline void pushQuad(Hud & h, float x, float y, float w, float hgt, float u0, float v0, float u1, float v1, uint32_t color){
+	if (h.count + 6 > h.capacity) {
+		h.dropped++;
+		return;
+	}
+	const float su = 1.0f / HUD_ATLAS_WIDTH, sv = 1.0f / HUD_ATLAS_HEIGHT;
+	float x0 = x * h.toNdcX - 1.0f, y0 = y * h.toNdcY + 1.0f;
+	float x1 = (x + w) * h.toNdcX - 1.0f, y1 = (y + hgt) * h.toNdcY + 1.0f;
+	u0 *= su; u1 *= su; v0 *= sv; v1 *= sv;
+	HudVertex * v = h.vertices + h.count;
+	v[0].x = x0; v[0].y = y0; v[0].u = u0; v[0].v = v0; v[0].color = color;
+	v[1].x = x0; v[1].y = y1; v[1].u = u0; v[1].v = v1; v[1].color = color;
+	v[2].x = x1; v[2].y = y0; v[2].u = u1; v[2].v = v0; v[2].color = color;
+	v[3].x = x1; v[3].y = y0; v[3].u = u1; v[3].v = v0; v[3].color = color;
+	v[4].x = x0; v[4].y = y1; v[4].u = u0; v[4].v = v1; v[4].color = color;
+	v[5].x = x1; v[5].y = y1; v[5].u = u1; v[5].v = v1; v[5].color = color;
+	h.count += 6;
+}
+
+void hudRect(Hud & h, float x, float y, float w, float hgt, uint32_t color){
+	// 꽉 찬 칸의 가운데 텍셀 하나만 읽는다
+	float u = (HUD_SOLID_CELL % HUD_ATLAS_COLUMNS) * HUD_CELL_WIDTH + HUD_CELL_WIDTH * 0.5f;
+	float v = (HUD_SOLID_CELL / HUD_ATLAS_COLUMNS) * HUD_CELL_HEIGHT + HUD_CELL_HEIGHT * 0.5f;
+	pushQuad(h, x, y, w, hgt, u, v, u, v, color);
+}
+
+float hudLineHeight(const Hud & h){
+	return (float)(HUD_CELL_HEIGHT + 2) * h.scale;
+}
+
+float hudText(Hud & h, float x, float y, uint32_t color, const char * text){
+	const float advance = (float)HUD_CELL_WIDTH * h.scale;
+	float left = x;
+	for (const char * p = text; *p != 0; p++) {
+		unsigned char c = (unsigned char)*p;
+		if (c == '\n') {
+			x = left;
+			y += hudLineHeight(h);
+			continue;
+		}
+		// 빈칸은 정점을 만들지 않는다. 글꼴에 없는 글자는 '?'
+		if (c != ' ') {
+			int index = c >= HUD_FIRST_CHAR && c < HUD_FIRST_CHAR + HUD_CHAR_COUNT ? c - HUD_FIRST_CHAR : '?' - HUD_FIRST_CHAR;
+			float u = (float)(index % HUD_ATLAS_COLUMNS) * HUD_CELL_WIDTH;
+			float v = (float)(index / HUD_ATLAS_COLUMNS) * HUD_CELL_HEIGHT;
+			pushQuad(h, x, y, (float)HUD_GLYPH_WIDTH * h.scale, (float)HUD_GLYPH_HEIGHT * h.scale,
+				u, v, u + HUD_GLYPH_WIDTH, v + HUD_GLYPH_HEIGHT, color);
+		}
+		x += advance;
+	}
+	return x;
+}
+
+float hudPrintf(Hud & h, float x, float y, uint32_t color, const char * format, ...){
+	char text[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	return hudText(h, x, y, color, text);
+}
+
+void hudFrameGraph(Hud & h, float x, float y, float w, float hgt, float maxMs, float budgetMs){
+	hudRect(h, x, y, w, hgt, HUD_RGBA(0, 0, 0, 140));
+	const float bar = w / HUD_GRAPH_SAMPLES;
+	// 가장 오래된 프레임이 왼쪽
+	for (int i = 0; i < HUD_GRAPH_SAMPLES; i++) {
+		float ms = h.frameMs[(h.frameIndex + i) % HUD_GRAPH_SAMPLES];
+		float barHeight = (ms < maxMs ? ms : maxMs) / maxMs * hgt;
+		if (barHeight <= 0.0f)
+			continue;
+		uint32_t color = ms > budgetMs ? HUD_RGBA(230, 60, 50, 255) : HUD_RGBA(80, 210, 90, 255);
+		hudRect(h, x + i * bar, y + hgt - barHeight, bar > 1.0f ? bar - 1.0f : bar, barHeight, color);
+	}
+	hudRect(h, x, y + hgt - budgetMs / maxMs * hgt, w, 1.0f, HUD_RGBA(255, 255, 255, 160));
+}
+
+void drawHud(Hud & h, GLuint program, StreamBuffer & stream, GLsizeiptr offset){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	if (h.count > 0) {
+		glUseProgram(program);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, h.atlas);
+		glDisable(GL_DEPTH_TEST);
+		glEnable(GL_BLEND);
+		glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		streamFlush(stream);
+		glEnableVertexAttribArray(0);
+		glEnableVertexAttribArray(1);
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)(offset + offsetof(HudVertex, x)));
+		glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(HudVertex), (void*)(offset + offsetof(HudVertex, u)));
+		glVertexAttribPointer(2, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(HudVertex), (void*)(offset + offsetof(HudVertex, color)));
+		glDrawArrays(GL_TRIANGLES, 0, h.count);
+		glDisableVertexAttribArray(0);
+		glDisableVertexAttribArray(1);
+		glDisableVertexAttribArray(2);
+		glDisable(GL_BLEND);
+		glEnable(GL_DEPTH_TEST);
+	}
+	h.drawMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
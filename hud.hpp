@@ -0,0 +1,83 @@
+#ifndef HUD_HPP
+#define HUD_HPP
+
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+#include "streambuffer.hpp"
+
+// 화면 위에 겹쳐 그리는 성능/비행 정보.
+// 글자는 코드에 박아 둔 5x7 비트맵 글꼴을 시작할 때 텍스처 한 장 (글리프 아틀라스) 으로 구워 두고,
+// 글자와 그래프 막대, 배경을 모두 텍스처를 입힌 사각형으로 한 정점 스트림에 모아 glDrawArrays 한번으로 그린다.
+// 막대와 배경은 아틀라스 안의 꽉 찬 칸을 쓰므로 셰이더가 하나다.
+// 정점 만들기 (beginHud ~ hud*) 는 GL 을 부르지 않는다. 스트리밍 버퍼의 매핑에 바로 쓴다.
+#define HUD_GLYPH_WIDTH 5
+#define HUD_GLYPH_HEIGHT 7
+#define HUD_CELL_WIDTH 6          // 글리프 + 오른쪽 한 줄 여백
+#define HUD_CELL_HEIGHT 8
+#define HUD_ATLAS_COLUMNS 16
+#define HUD_ATLAS_ROWS 6          // 글자 95 개 (' ' ~ '~') + 꽉 찬 칸 하나
+#define HUD_ATLAS_WIDTH (HUD_CELL_WIDTH * HUD_ATLAS_COLUMNS)
+#define HUD_ATLAS_HEIGHT (HUD_CELL_HEIGHT * HUD_ATLAS_ROWS)
+#define HUD_FIRST_CHAR 32
+#define HUD_CHAR_COUNT 95
+#define HUD_SOLID_CELL 95
+#define HUD_GRAPH_SAMPLES 120     // 프레임 시간 그래프의 막대 수
+
+// 색은 0xAABBGGRR (메모리 순서로 r, g, b, a)
+#define HUD_RGBA(r, g, b, a) ((uint32_t)(r) | ((uint32_t)(g) << 8) | ((uint32_t)(b) << 16) | ((uint32_t)(a) << 24))
+
+// 정점 하나 = 화면 위치 (NDC 로 바꿔서 넣는다), 아틀라스 좌표, 색.
+// hud* 함수들은 왼쪽 위가 0,0 인 픽셀 좌표를 받는다.
+struct HudVertex {
+	float x, y;
+	float u, v;
+	uint32_t color;
+};
+
+struct Hud {
+	GLuint atlas;
+	int scale;                           // 글꼴 한 픽셀을 화면 몇 픽셀로
+	bool visible;
+
+	// 이번 프레임
+	HudVertex * vertices;
+	int count;
+	int capacity;
+	int dropped;                         // 자리가 모자라서 못 넣은 사각형 수
+	float toNdcX, toNdcY;                // 픽셀 -> NDC 배율
+
+	float frameMs[HUD_GRAPH_SAMPLES];    // 돌아가며 쓴다
+	int frameIndex;
+
+	double buildMs;                      // 지난 프레임 정점 만드는 데 든 시간
+	double drawMs;                       // 지난 프레임 올리고 그리는 데 든 시간 (CPU)
+};
+
+// 글꼴을 HUD_ATLAS_WIDTH x HUD_ATLAS_HEIGHT 의 한 바이트 픽셀 (0 / 255) 로 굽는다. GL 을 부르지 않는다.
+void bakeHudAtlas(unsigned char * pixels);
+
+// 아틀라스 텍스처를 만든다. GL 컨텍스트가 있어야 한다.
+void initHud(Hud & h, int scale);
+void freeHud(Hud & h);
+
+// 프레임 시간 그래프에 한 프레임을 더한다. 보이지 않을 때도 불러 두면 켰을 때 그래프가 차 있다.
+void pushHudFrameTime(Hud & h, float ms);
+
+// out 에 최대 capacity 개의 정점을 쓰기 시작한다.
+void beginHud(Hud & h, HudVertex * out, int capacity, int width, int height);
+void hudRect(Hud & h, float x, float y, float w, float hgt, uint32_t color);
+// 한 줄을 쓰고 다음에 쓸 x 를 돌려준다. '\n' 은 다음 줄로.
+float hudText(Hud & h, float x, float y, uint32_t color, const char * text);
+float hudPrintf(Hud & h, float x, float y, uint32_t color, const char * format, ...);
+// 최근 HUD_GRAPH_SAMPLES 프레임의 막대 그래프. budgetMs 에 선을 긋고, 넘은 막대는 빨갛게 칠한다.
+void hudFrameGraph(Hud & h, float x, float y, float w, float hgt, float maxMs, float budgetMs);
+// 글자 한 줄의 높이 (픽셀)
+float hudLineHeight(const Hud & h);
+
+// 쓴 정점을 올리고 한번에 그린다. stream 은 beginHud 의 out 을 준 버퍼, offset 은 그 위치.
+// 깊이 검사를 끄고 알파 혼합으로 그린 뒤 원래대로 돌려 놓는다.
+void drawHud(Hud & h, GLuint program, StreamBuffer & stream, GLsizeiptr offset);
+
+#endif
@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+
+#include <GLFW/glfw3.h>
+
+#include "input.hpp"
+#include "jobs.hpp"
+
+void initInputQueue(InputQueue & q){
+	q.head.store(0);
+	q.tail.store(0);
+	q.sequence = 0;
+	q.dropped.store(0);
+}
+
+bool pushInput(InputQueue & q, const InputEvent & e){
+	uint32_t head = q.head.load(std::memory_order_relaxed);
+	if (head - q.tail.load(std::memory_order_acquire) >= INPUT_QUEUE_SIZE) {
+		q.dropped.fetch_add(1, std::memory_order_relaxed);
+		return false;
+	}
+	q.events[head & (INPUT_QUEUE_SIZE - 1)] = e;
+	q.head.store(head + 1, std::memory_order_release);
+	return true;
+}
+
+bool popInput(InputQueue & q, int64_t untilNs, InputEvent & e){
+	uint32_t tail = q.tail.load(std::memory_order_relaxed);
+	if (tail == q.head.load(std::memory_order_acquire))
+		return false;
+	const InputEvent & front = q.events[tail & (INPUT_QUEUE_SIZE - 1)];
+	if (front.timeNs > untilNs)
+		return false;
+	e = front;
+	q.tail.store(tail + 1, std::memory_order_release);
+	return true;
+}
+
+uint32_t inputPushed(const InputQueue & q){
+	return q.head.load(std::memory_order_relaxed);
+}
+
+static void pushWindowEvent(GLFWwindow * window, uint8_t type, int key, int action, double x, double y){
+	InputQueue & q = *(InputQueue *)glfwGetWindowUserPointer(window);
+	InputEvent e;
+	e.timeNs = jobNowNs();
+	e.sequence = q.sequence++;
+	e.type = type;
+	e.action = (uint8_t)action;
+	e.key = (int16_t)key;
+	e.x = (float)x;
+	e.y = (float)y;
+	pushInput(q, e);
+}
+
+static void onKey(GLFWwindow * window, int key, int, int action, int){
+	pushWindowEvent(window, INPUT_KEY, key, action, 0.0, 0.0);
+}
+
+static void onMouseButton(GLFWwindow * window, int button, int action, int){
+	double x, y;
+	glfwGetCursorPos(window, &x, &y);
+	pushWindowEvent(window, INPUT_MOUSE_BUTTON, button, action, x, y);
+}
+
+static void onCursor(GLFWwindow * window, double x, double y){
+	pushWindowEvent(window, INPUT_MOUSE_MOVE, 0, 0, x, y);
+}
+
+void installInputCallbacks(GLFWwindow * window, InputQueue & q){
+	glfwSetWindowUserPointer(window, &q);
+	glfwSetKeyCallback(window, onKey);
+	glfwSetMouseButtonCallback(window, onMouseButton);
+	glfwSetCursorPosCallback(window, onCursor);
+}
+
+void clearLatency(LatencyHistogram & h){
+	memset(&h, 0, sizeof(h));
+}
+
+void addLatency(LatencyHistogram & h, double ms){
+	int bucket = ms > 0.0 ? (int)(ms / LATENCY_BUCKET_MS) : 0;
+	if (bucket >= LATENCY_BUCKETS)
+		bucket = LATENCY_BUCKETS - 1;
+	h.counts[bucket]++;
+	h.samples++;
+	h.sumMs += ms;
+	if (ms > h.maxMs)
+		h.maxMs = ms;
+}
+
+double latencyPercentile(const LatencyHistogram & h, double p){
+	if (h.samples == 0)
+		return 0.0;
+	uint64_t target = (uint64_t)(p * h.samples);
+	if (target >= h.samples)
+		target = h.samples - 1;
+	uint64_t seen = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		seen += h.counts[i];
+		if (seen > target)
+			return i == LATENCY_BUCKETS - 1 ? h.maxMs : (i + 1) * LATENCY_BUCKET_MS;
+	}
+	return h.maxMs;
+}
+
+void printLatency(const LatencyHistogram & h, const char * name){
+	printf("%s : %llu samples, mean %.2f ms, p50 %.1f, p90 %.1f, p99 %.1f, max %.2f ms\n", name,
+		(unsigned long long)h.samples, h.samples > 0 ? h.sumMs / h.samples : 0.0,
+		latencyPercentile(h, 0.5), latencyPercentile(h, 0.9), latencyPercentile(h, 0.99), h.maxMs);
+	uint64_t most = 0;
+	for (int i = 0; i < LATENCY_BUCKETS; i++)
+		if (h.counts[i] > most)
+			most = h.counts[i];
+	for (int i = 0; i < LATENCY_BUCKETS; i++) {
+		if (h.counts[i] == 0)
+			continue;
+		char bar[41];
+		int length = (int)(h.counts[i] * 40 / most);
+		memset(bar, '#', length);
+		bar[length] = '\0';
+		if (i == LATENCY_BUCKETS - 1)
+			printf("  %5.1f+      ms %6llu %s\n", i * LATENCY_BUCKET_MS, (unsigned long long)h.counts[i], bar);
+		else
+			printf("  %5.1f-%5.1f ms %6llu %s\n", i * LATENCY_BUCKET_MS, (i + 1) * LATENCY_BUCKET_MS,
+				(unsigned long long)h.counts[i], bar);
+	}
+}
@@ -0,0 +1,69 @@
+#ifndef INPUT_HPP
+#define INPUT_HPP
+
+#include <stdint.h>
+#include <atomic>
+
+struct GLFWwindow;
+
+// 이벤트 기반 입력.
+// GLFW 콜백 (glfwPollEvents 안, 메인 스레드) 이 키/마우스 이벤트에 시각을 붙여서 큐에 넣고,
+// 프레임마다 입력 단계 (Rocket.cpp readInput, 메인 스레드) 가 큐를 모두 꺼내 키/버튼 이벤트만 남겨 둔다.
+// 시뮬레이션 틱은 그중 자기 틱 시각까지의 것을 순서대로 적용한다 (큐는 직접 보지 않는다).
+// 생산자 하나, 소비자 하나인 고리 버퍼라 잠금이 없다. 프레임 사이에 눌렀다 뗀 키도 빠지지 않는다.
+// 큐가 가득 차면 새 이벤트를 버리고 dropped 를 센다.
+#define INPUT_QUEUE_SIZE 1024          // 2 의 거듭제곱
+
+enum InputEventType {
+	INPUT_KEY,
+	INPUT_MOUSE_BUTTON,
+	INPUT_MOUSE_MOVE
+};
+
+struct InputEvent {
+	int64_t timeNs;                     // jobNowNs 와 같은 시계
+	uint32_t sequence;
+	uint8_t type;                       // InputEventType
+	uint8_t action;                     // GLFW_PRESS / GLFW_RELEASE / GLFW_REPEAT
+	int16_t key;                        // 키 또는 마우스 버튼
+	float x, y;                         // 마우스 위치
+};
+
+struct InputQueue {
+	InputEvent events[INPUT_QUEUE_SIZE];
+	alignas(64) std::atomic<uint32_t> head;    // 생산자가 쓴다
+	alignas(64) std::atomic<uint32_t> tail;    // 소비자가 쓴다
+	uint32_t sequence;
+	std::atomic<uint32_t> dropped;
+};
+
+void initInputQueue(InputQueue & q);
+// 생산자 쪽. 가득 찼으면 false.
+bool pushInput(InputQueue & q, const InputEvent & e);
+// 소비자 쪽. 맨 앞 이벤트의 시각이 untilNs 이하면 꺼내고 true.
+bool popInput(InputQueue & q, int64_t untilNs, InputEvent & e);
+// 지금까지 들어온 이벤트 수 (입력이 있었는지 보기)
+uint32_t inputPushed(const InputQueue & q);
+
+// window 에 키, 마우스 버튼, 커서 콜백을 달아서 q 로 보낸다 (glfwSetWindowUserPointer 를 쓴다)
+void installInputCallbacks(GLFWwindow * window, InputQueue & q);
+
+// 입력에서 화면까지의 지연 히스토그램. 0.5 ms 칸 128 개, 넘으면 마지막 칸.
+#define LATENCY_BUCKETS 128
+#define LATENCY_BUCKET_MS 0.5
+
+struct LatencyHistogram {
+	uint64_t counts[LATENCY_BUCKETS];
+	uint64_t samples;
+	double sumMs;
+	double maxMs;
+};
+
+void clearLatency(LatencyHistogram & h);
+void addLatency(LatencyHistogram & h, double ms);
+// p (0 ~ 1) 분위. 칸의 위쪽 끝을 돌려준다.
+double latencyPercentile(const LatencyHistogram & h, double p);
+// 칸들을 막대로 출력한다 (빈 칸은 건너뛴다)
+void printLatency(const LatencyHistogram & h, const char * name);
+
+#endif
@@ -0,0 +1,360 @@
+#include <stdint.h>
+#include <assert.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#include "jobs.hpp"
+
+static const int64_t JOB_DEQUE_MASK = JOB_DEQUE_SIZE - 1;
+
+// 지금 스레드의 워커 번호. startJobs 를 부른 스레드는 0, 워커가 아닌 스레드는 -1.
+static thread_local int currentWorker = -1;
+
+int64_t jobNowNs(){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// 덱 (Chase-Lev). push/pop 은 주인만, steal 은 아무나. ////////////////////////
+
+static bool pushJob(JobDeque & q, const Job & job){
+	int64_t b = q.bottom.load(std::memory_order_relaxed);
+	int64_t t = q.top.load(std::memory_order_acquire);
+	if (b - t >= JOB_DEQUE_SIZE)
+		return false;
+	q.items[b & JOB_DEQUE_MASK] = job;
+	std::atomic_thread_fence(std::memory_order_release);
+	q.bottom.store(b + 1, std::memory_order_relaxed);
+	return true;
+}
+
+static bool popJob(JobDeque & q, Job & job){
+	int64_t b = q.bottom.load(std::memory_order_relaxed) - 1;
+	q.bottom.store(b, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t t = q.top.load(std::memory_order_relaxed);
+	if (t > b) {
+		q.bottom.store(b + 1, std::memory_order_relaxed);
+		return false;
+	}
+	job = q.items[b & JOB_DEQUE_MASK];
+	if (t == b) {
+		// 마지막 하나는 훔쳐 가는 쪽과 경쟁한다
+		bool won = q.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+		q.bottom.store(b + 1, std::memory_order_relaxed);
+		return won;
+	}
+	return true;
+}
+
+static bool stealJob(JobDeque & q, Job & job){
+	int64_t t = q.top.load(std::memory_order_acquire);
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+	int64_t b = q.bottom.load(std::memory_order_acquire);
+	if (t >= b)
+		return false;
+	// 덱이 꽉 차기 전에는 이 칸을 다시 쓰지 않으므로, 먼저 읽고 CAS 에 실패하면 버린다
+	job = q.items[t & JOB_DEQUE_MASK];
+	return q.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+// 실행 ////////////////////////////////////////////////////////////////////////
+
+static void executeJob(JobSystem & js, JobWorker & w, const Job & job){
+	js.queued.fetch_sub(1, std::memory_order_relaxed);
+	int d = w.depth++;
+	if (d < JOB_MAX_DEPTH) {
+		w.waitedNs[d] = 0;
+		w.awaitedCriticalNs[d] = 0;
+	}
+	int64_t start = jobNowNs();
+	job.function(job.context, job.begin, job.end);
+	int64_t duration = jobNowNs() - start;
+	w.depth--;
+	if (w.depth == 0)
+		w.busyNs.fetch_add(duration, std::memory_order_relaxed);
+	w.jobs.fetch_add(1, std::memory_order_relaxed);
+	if (job.counter != NULL) {
+		int64_t critical = duration;
+		if (d < JOB_MAX_DEPTH)
+			critical += w.awaitedCriticalNs[d] - w.waitedNs[d];
+		int64_t current = job.counter->criticalNs.load(std::memory_order_relaxed);
+		while (critical > current && !job.counter->criticalNs.compare_exchange_weak(current, critical))
+			;
+		job.counter->pending.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+// 워커가 아닌 스레드가 넣은 잡. 덱은 주인만 넣을 수 있으므로 잠금 큐로 받는다 (먼저 넣은 것부터).
+static bool takeInjected(JobSystem & js, Job & job){
+	if (js.injectedCount.load(std::memory_order_acquire) <= 0)
+		return false;
+	std::lock_guard<std::mutex> guard(js.injectLock);
+	if (js.injectedHead == js.injected.size())
+		return false;
+	job = js.injected[js.injectedHead++];
+	if (js.injectedHead == js.injected.size()) {
+		js.injected.clear();
+		js.injectedHead = 0;
+	}
+	js.injectedCount.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
+
+// 자기 덱에서 꺼내고, 없으면 들어온 큐, 다른 워커 순서로 찾는다
+static bool takeJob(JobSystem & js, int self, Job & job){
+	JobWorker & w = js.workers[self];
+	if (popJob(w.deque, job))
+		return true;
+	if (js.queued.load(std::memory_order_relaxed) <= 0)
+		return false;
+	if (takeInjected(js, job))
+		return true;
+	// xorshift 로 시작 위치를 골라 한바퀴 돈다
+	w.random ^= w.random << 13;
+	w.random ^= w.random >> 17;
+	w.random ^= w.random << 5;
+	int start = (int)(w.random % (uint32_t)js.workerCount);
+	for (int i = 0; i < js.workerCount; i++) {
+		int victim = (start + i) % js.workerCount;
+		if (victim != self && stealJob(js.workers[victim].deque, job)) {
+			w.steals.fetch_add(1, std::memory_order_relaxed);
+			return true;
+		}
+	}
+	return false;
+}
+
+static void jobWorker(JobSystem * js, int index){
+	currentWorker = index;
+	JobWorker & w = js->workers[index];
+	Job job;
+	while (!js->stopping.load()) {
+		if (takeJob(*js, index, job)) {
+			executeJob(*js, w, job);
+			continue;
+		}
+		// 한동안 돌아 보고 그래도 없으면 잠든다
+		bool found = false;
+		for (int spin = 0; spin < 64 && !found; spin++) {
+			std::this_thread::yield();
+			found = js->queued.load() > 0;
+		}
+		if (found)
+			continue;
+		std::unique_lock<std::mutex> guard(js->lock);
+		js->sleepers.fetch_add(1);
+		js->wake.wait(guard, [&] { return js->stopping.load() || js->queued.load() > 0; });
+		js->sleepers.fetch_sub(1);
+	}
+}
+
+void startJobs(JobSystem & js, int workers){
+	if (workers < 1) workers = 1;
+	if (workers > JOB_MAX_WORKERS) workers = JOB_MAX_WORKERS;
+	js.workerCount = workers;
+	js.workers = new JobWorker[workers];
+	for (int i = 0; i < workers; i++) {
+		JobWorker & w = js.workers[i];
+		w.deque.top.store(0);
+		w.deque.bottom.store(0);
+		w.random = 2463534242u + i * 7919u;
+		w.depth = 0;
+		w.busyNs.store(0);
+		w.waitNs.store(0);
+		w.jobs.store(0);
+		w.steals.store(0);
+	}
+	js.queued.store(0);
+	js.injected.clear();
+	js.injected.reserve(JOB_DEQUE_SIZE);
+	js.injectedHead = 0;
+	js.injectedCount.store(0);
+	js.sleepers.store(0);
+	js.stopping.store(false);
+	js.frame = JobFrameStats();
+	currentWorker = 0;
+	beginJobFrame(js);
+	for (int i = 1; i < workers; i++)
+		js.threads.push_back(std::thread(jobWorker, &js, i));
+}
+
+void stopJobs(JobSystem & js){
+	{
+		std::lock_guard<std::mutex> guard(js.lock);
+		js.stopping.store(true);
+	}
+	js.wake.notify_all();
+	for (size_t i = 0; i < js.threads.size(); i++)
+		js.threads[i].join();
+	js.threads.clear();
+	delete [] js.workers;
+	js.workers = NULL;
+	currentWorker = -1;
+}
+
+void initCounter(JobCounter & counter){
+	counter.pending.store(0);
+	counter.criticalNs.store(0);
+	counter.startNs = jobNowNs();
+}
+
+static void wakeWorkers(JobSystem & js){
+	if (js.sleepers.load() > 0) {
+		// 잠들려는 워커가 조건을 확인하고 wait 에 들어갈 때까지 기다렸다가 깨운다
+		{ std::lock_guard<std::mutex> guard(js.lock); }
+		js.wake.notify_all();
+	}
+}
+
+void runJob(JobSystem & js, JobFunction function, void * context, int begin, int end, JobCounter * counter){
+	Job job;
+	job.function = function;
+	job.context = context;
+	job.begin = begin;
+	job.end = end;
+	job.counter = counter;
+	if (counter != NULL)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	js.queued.fetch_add(1);
+	if (currentWorker < 0) {
+		{
+			std::lock_guard<std::mutex> guard(js.injectLock);
+			js.injected.push_back(job);
+			js.injectedCount.fetch_add(1, std::memory_order_release);
+		}
+		wakeWorkers(js);
+		return;
+	}
+	JobWorker & w = js.workers[currentWorker];
+	if (!pushJob(w.deque, job)) {
+		// 덱이 꽉 찼으면 그냥 여기서 실행한다
+		executeJob(js, w, job);
+		return;
+	}
+	wakeWorkers(js);
+}
+
+void runJobHere(JobSystem & js, JobFunction function, void * context, int begin, int end, JobCounter * counter){
+	Job job;
+	job.function = function;
+	job.context = context;
+	job.begin = begin;
+	job.end = end;
+	job.counter = counter;
+	assert(currentWorker >= 0 && "runJobHere from a thread outside the job system");
+	if (counter != NULL)
+		counter->pending.fetch_add(1, std::memory_order_relaxed);
+	js.queued.fetch_add(1);
+	executeJob(js, js.workers[currentWorker], job);
+}
+
+void parallelForAsync(JobSystem & js, int count, int chunk, JobFunction function, void * context, JobCounter * counter){
+	if (chunk < 1) chunk = 1;
+	for (int begin = 0; begin < count; begin += chunk)
+		runJob(js, function, context, begin, begin + chunk < count ? begin + chunk : count, counter);
+}
+
+void waitForCounter(JobSystem & js, JobCounter & counter){
+	const int self = currentWorker;
+	if (self < 0) {
+		// 워커가 아니면 대신 실행할 덱이 없으므로 그냥 기다린다
+		while (counter.pending.load(std::memory_order_acquire) > 0)
+			std::this_thread::yield();
+		return;
+	}
+	JobWorker & w = js.workers[self];
+	Job job;
+	int64_t waitStart = jobNowNs();
+	while (counter.pending.load(std::memory_order_acquire) > 0) {
+		if (takeJob(js, self, job)) {
+			executeJob(js, w, job);
+			continue;
+		}
+		// 남은 잡은 다른 워커가 실행 중이다
+		int64_t start = jobNowNs();
+		std::this_thread::yield();
+		if (w.depth > 0)
+			w.waitNs.fetch_add(jobNowNs() - start, std::memory_order_relaxed);
+	}
+	// 기다린 시간 대신 기다린 잡들의 임계 경로를 이 잡의 임계 경로에 넣는다
+	int d = w.depth - 1;
+	if (d >= 0 && d < JOB_MAX_DEPTH) {
+		w.waitedNs[d] += jobNowNs() - waitStart;
+		w.awaitedCriticalNs[d] += counter.criticalNs.load();
+	}
+}
+
+void parallelFor(JobSystem & js, int count, int chunk, JobFunction function, void * context){
+	JobCounter counter;
+	initCounter(counter);
+	parallelForAsync(js, count, chunk, function, context, &counter);
+	waitForCounter(js, counter);
+}
+
+void runChunked(JobSystem * jobs, int count, int chunk, JobFunction task, void * context){
+	if (jobs != NULL) {
+		parallelFor(*jobs, count, chunk, task, context);
+		return;
+	}
+	for (int begin = 0; begin < count; begin += chunk)
+		task(context, begin, begin + chunk < count ? begin + chunk : count);
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point begin){
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+}
+
+// 프레임 통계 ////////////////////////////////////////////////////////////////
+
+static int64_t workerBusy(const JobWorker & w){
+	return w.busyNs.load(std::memory_order_relaxed) - w.waitNs.load(std::memory_order_relaxed);
+}
+
+void beginJobFrame(JobSystem & js){
+	js.frameStartNs = jobNowNs();
+	js.frameJobs = 0;
+	js.frameSteals = 0;
+	for (int i = 0; i < js.workerCount; i++) {
+		js.frameBusyNs[i] = workerBusy(js.workers[i]);
+		js.frameJobs -= js.workers[i].jobs.load(std::memory_order_relaxed);
+		js.frameSteals -= js.workers[i].steals.load(std::memory_order_relaxed);
+	}
+	js.frameCriticalMs = 0.0;
+	js.frameStageCount = 0;
+}
+
+void waitForStage(JobSystem & js, JobCounter & counter, const char * name){
+	waitForCounter(js, counter);
+	double criticalMs = counter.criticalNs.load() / 1e6;
+	js.frameCriticalMs += criticalMs;
+	if (js.frameStageCount < JOB_MAX_STAGES) {
+		JobStage & s = js.frameStages[js.frameStageCount++];
+		s.name = name;
+		s.wallMs = (jobNowNs() - counter.startNs) / 1e6;
+		s.criticalMs = criticalMs;
+	}
+}
+
+void endJobFrame(JobSystem & js){
+	JobFrameStats & f = js.frame;
+	f.wallMs = (jobNowNs() - js.frameStartNs) / 1e6;
+	f.criticalMs = js.frameCriticalMs;
+	double busy = 0.0;
+	f.jobs = js.frameJobs;
+	f.steals = js.frameSteals;
+	for (int i = 0; i < js.workerCount; i++) {
+		f.busyMs[i] = (workerBusy(js.workers[i]) - js.frameBusyNs[i]) / 1e6;
+		busy += f.busyMs[i];
+		f.jobs += js.workers[i].jobs.load(std::memory_order_relaxed);
+		f.steals += js.workers[i].steals.load(std::memory_order_relaxed);
+	}
+	f.utilization = f.wallMs > 0.0 ? busy / (f.wallMs * js.workerCount) : 0.0;
+	f.stageCount = js.frameStageCount;
+	for (int i = 0; i < js.frameStageCount; i++)
+		f.stages[i] = js.frameStages[i];
+}
@@ -0,0 +1,132 @@
+#ifndef JOBS_HPP
+#define JOBS_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+// 작업 훔치기 (work stealing) 잡 시스템.
+// 워커마다 자기 덱이 있어서 자기가 만든 잡은 뒤에서 꺼내 쓰고 (LIFO), 일이 없는 워커는 다른 워커 덱의
+// 앞에서 훔쳐 간다 (Chase-Lev 덱). 메인 스레드가 워커 0 이다.
+// 잡은 JobCounter 로 묶는다. 잡이 끝나면 카운터가 하나 줄고, waitForCounter 는 0 이 될 때까지
+// 다른 잡을 대신 실행하면서 기다린다 (잡 안에서 기다려도 스레드가 놀지 않는다).
+// 워커가 아닌 스레드가 넣은 잡은 잠금 큐로 들어가고 워커가 가져간다 (덱은 주인만 넣을 수 있다).
+// 루프 안에서는 힙을 쓰지 않는다 (들어온 큐는 덱 크기만큼 미리 잡아 둔다).
+// 임계 경로 : 잡 하나의 임계 경로는 (실행 시간 - 기다린 시간 + 기다린 카운터들의 임계 경로) 이고,
+// 카운터의 임계 경로는 그 잡들 중 가장 긴 것이다. 코어가 무한히 많아도 이보다 빨라질 수는 없다.
+typedef void (*JobFunction)(void * context, int begin, int end);
+
+#define JOB_DEQUE_SIZE 4096        // 워커 덱 하나에 쌓일 수 있는 잡 수 (2 의 거듭제곱)
+#define JOB_MAX_WORKERS 64
+#define JOB_MAX_STAGES 16
+#define JOB_MAX_DEPTH 32           // 잡 안에서 기다리는 중첩 깊이 (넘으면 임계 경로 계산에서 빠진다)
+
+struct JobCounter {
+	std::atomic<int> pending;
+	std::atomic<int64_t> criticalNs;  // 이 카운터에 속한 잡들의 임계 경로 중 가장 긴 것
+	int64_t startNs;                  // initCounter 한 시각
+};
+
+struct Job {
+	JobFunction function;
+	void * context;
+	int begin;
+	int end;
+	JobCounter * counter;
+};
+
+struct JobDeque {
+	std::atomic<int64_t> top;         // 훔쳐 가는 쪽
+	std::atomic<int64_t> bottom;      // 주인 쪽
+	Job items[JOB_DEQUE_SIZE];
+};
+
+struct alignas(64) JobWorker {
+	JobDeque deque;
+	uint32_t random;                  // 훔칠 워커 고르기
+	int depth;                        // 지금 실행 중인 잡의 중첩 깊이
+	int64_t waitedNs[JOB_MAX_DEPTH];          // 깊이별로 잡 안에서 기다린 시간
+	int64_t awaitedCriticalNs[JOB_MAX_DEPTH]; // 깊이별로 기다린 카운터들의 임계 경로 합
+	std::atomic<int64_t> busyNs;      // 잡을 실행한 시간 (중첩은 바깥 것만)
+	std::atomic<int64_t> waitNs;      // 잡 안에서 기다리기만 한 시간 (busyNs 에서 뺀다)
+	std::atomic<int> jobs;
+	std::atomic<int> steals;
+};
+
+// 한 프레임 안의 단계 (입력, 시뮬레이션, ...)
+struct JobStage {
+	const char * name;
+	double wallMs;                    // initCounter 부터 waitForStage 가 끝날 때까지
+	double criticalMs;                // 이 단계의 임계 경로
+};
+
+struct JobFrameStats {
+	double wallMs;
+	double criticalMs;                // 단계마다 임계 경로를 더한 것
+	double utilization;               // 모든 워커의 바쁜 시간 / (wallMs * 워커 수)
+	double busyMs[JOB_MAX_WORKERS];
+	int jobs;
+	int steals;
+	JobStage stages[JOB_MAX_STAGES];
+	int stageCount;
+};
+
+struct JobSystem {
+	int workerCount;
+	JobWorker * workers;
+	std::vector<std::thread> threads;
+	std::atomic<int> queued;          // 덱과 들어온 큐에 들어 있는 잡 수
+	std::mutex injectLock;            // 워커가 아닌 스레드가 넣은 잡
+	std::vector<Job> injected;
+	size_t injectedHead;
+	std::atomic<int> injectedCount;
+	std::atomic<int> sleepers;
+	std::atomic<bool> stopping;
+	std::mutex lock;
+	std::condition_variable wake;
+
+	// 프레임 통계
+	int64_t frameStartNs;
+	int64_t frameBusyNs[JOB_MAX_WORKERS];
+	int frameJobs;
+	int frameSteals;
+	double frameCriticalMs;
+	JobStage frameStages[JOB_MAX_STAGES];
+	int frameStageCount;
+	JobFrameStats frame;              // 지난 endJobFrame 결과
+};
+
+int64_t jobNowNs();
+
+// workers 는 부르는 스레드 (워커 0) 를 포함한 수
+void startJobs(JobSystem & js, int workers);
+void stopJobs(JobSystem & js);
+
+void initCounter(JobCounter & counter);
+
+// [begin, end) 를 맡는 잡 하나를 지금 워커의 덱 (워커가 아니면 들어온 큐) 에 넣는다. counter 는 NULL 이어도 된다.
+void runJob(JobSystem & js, JobFunction function, void * context, int begin, int end, JobCounter * counter);
+// [0, count) 를 chunk 개씩 잡으로 나눠 넣고 바로 돌아온다
+void parallelForAsync(JobSystem & js, int count, int chunk, JobFunction function, void * context, JobCounter * counter);
+// 잡 하나를 이 스레드에서 바로 실행한다. 메인 스레드에서만 해야 하는 일 (GLFW 입력 등) 용. 워커 스레드에서만.
+void runJobHere(JobSystem & js, JobFunction function, void * context, int begin, int end, JobCounter * counter);
+// 다른 잡을 실행하면서 counter 가 0 이 될 때까지 기다린다
+void waitForCounter(JobSystem & js, JobCounter & counter);
+// parallelForAsync + waitForCounter
+void parallelFor(JobSystem & js, int count, int chunk, JobFunction function, void * context);
+
+// jobs 가 있으면 parallelFor, NULL 이면 이 스레드에서 chunk 개씩 차례로 (벤치마크, 혼자 도는 도구용)
+void runChunked(JobSystem * jobs, int count, int chunk, JobFunction task, void * context);
+// begin 부터 지금까지 (ms). 단계별 통계용.
+double elapsedMs(std::chrono::steady_clock::time_point begin);
+
+// 프레임 통계. waitForStage 는 waitForCounter 뒤에 단계 시간을 기록한다.
+void beginJobFrame(JobSystem & js);
+void waitForStage(JobSystem & js, JobCounter & counter, const char * name);
+void endJobFrame(JobSystem & js);
+
+#endif
@@ -0,0 +1,373 @@
+#include <math.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "lighting.hpp"
+#include "random.hpp"
+
+void initLightClusters(LightClusters & c){
+	c.lights.clear();
+	c.version = 0;
+	c.viewCount = 0;
+	c.clusterMin.assign(MAX_VIEWS * CLUSTER_COUNT, glm::vec3(0.0f));
+	c.clusterMax.assign(MAX_VIEWS * CLUSTER_COUNT, glm::vec3(0.0f));
+	for (int v = 0; v < MAX_VIEWS; v++) {
+		c.projection[v] = glm::mat4(0.0f);
+		c.nearZ[v] = 0.1f;
+		c.farZ[v] = 100.0f;
+	}
+	c.clusterData.assign(MAX_VIEWS * CLUSTER_COUNT * 2, 0);
+	c.indices.assign(MAX_VIEWS * CLUSTER_SLICES * CLUSTER_SLICE_INDICES, 0);
+	c.sliceIndices.assign(MAX_VIEWS * CLUSTER_SLICES * CLUSTER_SLICE_INDICES, 0);
+	c.sliceUsed.assign(MAX_VIEWS * CLUSTER_SLICES, 0);
+	c.sliceOverflows.assign(MAX_VIEWS * CLUSTER_SLICES, 0);
+	c.sliceMax.assign(MAX_VIEWS * CLUSTER_SLICES, 0);
+	c.views = NULL;
+	memset(&c.stats, 0, sizeof(c.stats));
+}
+
+void generateRangeLights(LightClusters & c, int count, const glm::vec3 & pad, uint32_t seed){
+	if (count > LIGHT_MAX)
+		count = LIGHT_MAX;
+	if (count < 0)
+		count = 0;
+	c.lights.resize(count);
+	uint32_t state = seed != 0 ? seed : 1;
+	const glm::vec3 base = pad + glm::vec3(0.5f, 0.0f, 0.5f);
+	// 발사대 둘레의 투광등 (밝고 넓다)
+	int ring = count < 12 ? count : 12;
+	for (int i = 0; i < ring; i++) {
+		float a = i * (6.2831853f / ring);
+		PointLight & l = c.lights[i];
+		l.position = base + glm::vec3(4.0f * cosf(a), 0.6f, 4.0f * sinf(a));
+		l.radius = 9.0f;
+		l.color = glm::vec3(0.9f, 0.95f, 1.0f) * 0.8f;
+		l.padding = 0.0f;
+	}
+	// 나머지는 바닥 위 격자에 흩어 놓은 유도등 (빨강, 주황, 초록)
+	static const glm::vec3 RANGE_COLORS[3] = { glm::vec3(1.0f, 0.2f, 0.15f), glm::vec3(1.0f, 0.65f, 0.2f), glm::vec3(0.2f, 1.0f, 0.35f) };
+	int rest = count - ring;
+	int side = 1;
+	while (side * side < rest)
+		side++;
+	float spacing = 190.0f / side;
+	for (int i = 0; i < rest; i++) {
+		PointLight & l = c.lights[ring + i];
+		l.position = glm::vec3(-95.0f + (i % side + nextRandom(state)) * spacing, 0.2f + nextRandom(state) * 0.6f,
+			-4.5f + (i / side + nextRandom(state)) * spacing * 0.55f);
+		l.radius = 2.0f + nextRandom(state) * 3.0f;
+		l.color = RANGE_COLORS[i % 3] * (0.6f + 0.4f * nextRandom(state));
+		l.padding = 0.0f;
+	}
+	const size_t bounds = (size_t)MAX_VIEWS * count;
+	c.bounds.resize(bounds);
+	c.candidates.resize(bounds * CLUSTER_SLICES);
+	c.version++;
+}
+
+static inline int sliceOf(const LightClusters & c, int view, float depth){
+	int s = (int)(logf(depth / c.nearZ[view]) / logf(c.farZ[view] / c.nearZ[view]) * CLUSTER_SLICES);
+	return s < 0 ? 0 : s >= CLUSTER_SLICES ? CLUSTER_SLICES - 1 : s;
+}
+
+// 투영에서 near/far 를 뽑고 클러스터마다 뷰 공간 상자를 만든다. 원근이든 정사영이든
+// 타일 꼭지점마다 near 평면과 far 평면 위의 점을 잇는 선분 위에서 깊이로 자른다.
+static void buildClusterBoxes(LightClusters & c, int view, const glm::mat4 & projection){
+	c.projection[view] = projection;
+	const float p22 = projection[2][2], p32 = projection[3][2];
+	if (projection[2][3] != 0.0f) {
+		c.nearZ[view] = p32 / (p22 - 1.0f);
+		c.farZ[view] = p32 / (p22 + 1.0f);
+	}
+	else {
+		c.nearZ[view] = (p32 + 1.0f) / p22;
+		c.farZ[view] = (p32 - 1.0f) / p22;
+	}
+	if (c.nearZ[view] < 1e-3f)
+		c.nearZ[view] = 1e-3f;
+	const glm::mat4 inverse = glm::inverse(projection);
+	glm::vec3 nearPoint[CLUSTER_TILES_Y + 1][CLUSTER_TILES_X + 1];
+	glm::vec3 farPoint[CLUSTER_TILES_Y + 1][CLUSTER_TILES_X + 1];
+	for (int y = 0; y <= CLUSTER_TILES_Y; y++) {
+		for (int x = 0; x <= CLUSTER_TILES_X; x++) {
+			float nx = -1.0f + 2.0f * x / CLUSTER_TILES_X, ny = -1.0f + 2.0f * y / CLUSTER_TILES_Y;
+			glm::vec4 n = inverse * glm::vec4(nx, ny, -1.0f, 1.0f);
+			glm::vec4 f = inverse * glm::vec4(nx, ny, 1.0f, 1.0f);
+			nearPoint[y][x] = glm::vec3(n) / n.w;
+			farPoint[y][x] = glm::vec3(f) / f.w;
+		}
+	}
+	const float n = c.nearZ[view], f = c.farZ[view];
+	for (int s = 0; s < CLUSTER_SLICES; s++) {
+		float depth0 = n * powf(f / n, (float)s / CLUSTER_SLICES);
+		float depth1 = n * powf(f / n, (float)(s + 1) / CLUSTER_SLICES);
+		float t0 = (depth0 - n) / (f - n), t1 = (depth1 - n) / (f - n);
+		for (int y = 0; y < CLUSTER_TILES_Y; y++) {
+			for (int x = 0; x < CLUSTER_TILES_X; x++) {
+				glm::vec3 lo(1e30f), hi(-1e30f);
+				for (int k = 0; k < 4; k++) {
+					const glm::vec3 & a = nearPoint[y + k / 2][x + k % 2];
+					const glm::vec3 & b = farPoint[y + k / 2][x + k % 2];
+					glm::vec3 p0 = a + (b - a) * t0, p1 = a + (b - a) * t1;
+					lo = glm::min(lo, glm::min(p0, p1));
+					hi = glm::max(hi, glm::max(p0, p1));
+				}
+				int index = view * CLUSTER_COUNT + (s * CLUSTER_TILES_Y + y) * CLUSTER_TILES_X + x;
+				c.clusterMin[index] = lo;
+				c.clusterMax[index] = hi;
+			}
+		}
+	}
+}
+
+static inline int tileOf(float ndc, int tiles){
+	int t = (int)((ndc * 0.5f + 0.5f) * tiles);
+	return t < 0 ? 0 : t >= tiles ? tiles - 1 : t;
+}
+
+// 1 단계 : 빛마다 (뷰, 빛) 의 뷰 공간 중심과 타일/깊이 조각 범위
+static void lightBoundsJob(void * context, int begin, int end){
+	LightClusters & c = *(LightClusters *)context;
+	const int lightCount = (int)c.lights.size();
+	for (int j = begin; j < end; j++) {
+		const int view = j / lightCount;
+		const PointLight & light = c.lights[j % lightCount];
+		LightBounds & b = c.bounds[j];
+		b.center = glm::vec3(c.views->view[view] * glm::vec4(light.position, 1.0f));
+		b.radius = light.radius;
+		b.slice0 = 1;
+		b.slice1 = 0;
+		float depth = -b.center.z;
+		if (depth + b.radius < c.nearZ[view] || depth - b.radius > c.farZ[view])
+			continue;
+		// 구를 감싸는 상자를 near 평면 앞쪽으로 자르고 꼭지점을 투영해서 화면 범위를 잡는다
+		const float zBack = b.center.z - b.radius;
+		const float zFront = b.center.z + b.radius < -c.nearZ[view] ? b.center.z + b.radius : -c.nearZ[view];
+		float loX = 1e30f, loY = 1e30f, hiX = -1e30f, hiY = -1e30f;
+		for (int k = 0; k < 8; k++) {
+			glm::vec4 corner(b.center.x + (k & 1 ? b.radius : -b.radius), b.center.y + (k & 2 ? b.radius : -b.radius), k & 4 ? zFront : zBack, 1.0f);
+			glm::vec4 clip = c.projection[view] * corner;
+			float x = clip.x / clip.w, y = clip.y / clip.w;
+			loX = x < loX ? x : loX;
+			loY = y < loY ? y : loY;
+			hiX = x > hiX ? x : hiX;
+			hiY = y > hiY ? y : hiY;
+		}
+		if (hiX < -1.0f || hiY < -1.0f || loX > 1.0f || loY > 1.0f)
+			continue;
+		b.tile0[0] = (uint8_t)tileOf(loX, CLUSTER_TILES_X);
+		b.tile1[0] = (uint8_t)tileOf(hiX, CLUSTER_TILES_X);
+		b.tile0[1] = (uint8_t)tileOf(loY, CLUSTER_TILES_Y);
+		b.tile1[1] = (uint8_t)tileOf(hiY, CLUSTER_TILES_Y);
+		b.slice0 = (uint8_t)sliceOf(c, view, depth - b.radius > c.nearZ[view] ? depth - b.radius : c.nearZ[view]);
+		b.slice1 = (uint8_t)sliceOf(c, view, depth + b.radius < c.farZ[view] ? depth + b.radius : c.farZ[view]);
+	}
+}
+
+static inline bool sphereInBox(const glm::vec3 & center, float radius, const glm::vec3 & lo, const glm::vec3 & hi){
+	float distance = 0.0f;
+	for (int a = 0; a < 3; a++) {
+		float d = center[a] < lo[a] ? lo[a] - center[a] : center[a] > hi[a] ? center[a] - hi[a] : 0.0f;
+		distance += d * d;
+	}
+	return distance <= radius * radius;
+}
+
+// 2 단계 : (뷰, 깊이 조각) 하나. 이 조각에 걸친 빛을 먼저 추리고, 빛마다 자기 타일 범위의 클러스터만 본다.
+// 한 번 세어서 클러스터마다 자리를 잡고 다시 돌며 채우므로 목록이 클러스터마다 이어진다.
+// 조각마다 자기 구역에만 쓰므로 잠금이 없다.
+static void binSliceJob(void * context, int begin, int end){
+	LightClusters & c = *(LightClusters *)context;
+	const int lightCount = (int)c.lights.size();
+	const int tiles = CLUSTER_TILES_X * CLUSTER_TILES_Y;
+	for (int j = begin; j < end; j++) {
+		const int view = j / CLUSTER_SLICES, slice = j % CLUSTER_SLICES;
+		const LightBounds * bounds = c.bounds.data() + (size_t)view * lightCount;
+		const int first = view * CLUSTER_COUNT + slice * tiles;
+		const glm::vec3 * lo = &c.clusterMin[first];
+		const glm::vec3 * hi = &c.clusterMax[first];
+		uint16_t * candidates = c.candidates.data() + (size_t)j * lightCount;
+		int candidateCount = 0;
+		for (int i = 0; i < lightCount; i++)
+			if (bounds[i].slice0 <= slice && slice <= bounds[i].slice1)
+				candidates[candidateCount++] = (uint16_t)i;
+		int counts[tiles], offsets[tiles], filled[tiles];
+		memset(counts, 0, sizeof(counts));
+		for (int k = 0; k < candidateCount; k++) {
+			const LightBounds & b = bounds[candidates[k]];
+			for (int y = b.tile0[1]; y <= b.tile1[1]; y++)
+				for (int x = b.tile0[0]; x <= b.tile1[0]; x++)
+					if (sphereInBox(b.center, b.radius, lo[y * CLUSTER_TILES_X + x], hi[y * CLUSTER_TILES_X + x]))
+						counts[y * CLUSTER_TILES_X + x]++;
+		}
+		// 자리 잡기. 클러스터 하나에 CLUSTER_MAX_LIGHTS, 조각 하나에 CLUSTER_SLICE_INDICES 까지.
+		int used = 0, overflows = 0, most = 0;
+		for (int t = 0; t < tiles; t++) {
+			int n = counts[t] < CLUSTER_MAX_LIGHTS ? counts[t] : CLUSTER_MAX_LIGHTS;
+			if (used + n > CLUSTER_SLICE_INDICES)
+				n = CLUSTER_SLICE_INDICES - used;
+			overflows += counts[t] - n;
+			offsets[t] = used;
+			filled[t] = 0;
+			counts[t] = n;
+			used += n;
+			most = n > most ? n : most;
+		}
+		uint16_t * out = &c.sliceIndices[(size_t)j * CLUSTER_SLICE_INDICES];
+		for (int k = 0; k < candidateCount; k++) {
+			const LightBounds & b = bounds[candidates[k]];
+			for (int y = b.tile0[1]; y <= b.tile1[1]; y++)
+				for (int x = b.tile0[0]; x <= b.tile1[0]; x++) {
+					int t = y * CLUSTER_TILES_X + x;
+					if (filled[t] < counts[t] && sphereInBox(b.center, b.radius, lo[t], hi[t]))
+						out[offsets[t] + filled[t]++] = candidates[k];
+				}
+		}
+		for (int t = 0; t < tiles; t++) {
+			c.clusterData[(first + t) * 2] = (uint32_t)offsets[t];
+			c.clusterData[(first + t) * 2 + 1] = (uint32_t)counts[t];
+		}
+		c.sliceUsed[j] = used;
+		c.sliceOverflows[j] = overflows;
+		c.sliceMax[j] = most;
+	}
+}
+
+void buildLightClusters(LightClusters & c, const ViewSet & views, JobSystem * jobs){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	c.views = &views;
+	c.viewCount = views.count;
+	for (int v = 0; v < views.count; v++)
+		if (memcmp(&c.projection[v], &views.projection[v], sizeof(glm::mat4)) != 0)
+			buildClusterBoxes(c, v, views.projection[v]);
+	const int lightCount = (int)c.lights.size();
+	runChunked(jobs, views.count * lightCount, 1024, lightBoundsJob, &c);
+	c.stats.boundsMs = elapsedMs(begin);
+
+	begin = std::chrono::steady_clock::now();
+	runChunked(jobs, views.count * CLUSTER_SLICES, 1, binSliceJob, &c);
+	// 조각마다의 구역을 하나로 이어 붙이고 클러스터의 시작 위치를 옮긴다
+	int total = 0;
+	c.stats.overflows = 0;
+	c.stats.maxPerCluster = 0;
+	for (int j = 0; j < views.count * CLUSTER_SLICES; j++) {
+		int used = c.sliceUsed[j];
+		if (used > 0)
+			memcpy(&c.indices[total], &c.sliceIndices[(size_t)j * CLUSTER_SLICE_INDICES], used * sizeof(uint16_t));
+		uint32_t * data = &c.clusterData[(size_t)j * CLUSTER_TILES_X * CLUSTER_TILES_Y * 2];
+		for (int k = 0; k < CLUSTER_TILES_X * CLUSTER_TILES_Y; k++)
+			data[k * 2] += (uint32_t)total;
+		total += used;
+		c.stats.overflows += c.sliceOverflows[j];
+		c.stats.maxPerCluster = c.sliceMax[j] > c.stats.maxPerCluster ? c.sliceMax[j] : c.stats.maxPerCluster;
+	}
+	c.stats.indices = total;
+	int visible = 0;
+	for (int j = 0; j < views.count * lightCount; j++)
+		visible += c.bounds[j].slice0 <= c.bounds[j].slice1 ? 1 : 0;
+	c.stats.visible = visible;
+	c.stats.binMs = elapsedMs(begin);
+}
+
+// 한 프레임에 쓸 수 있는 최대 : 뷰마다 클러스터 (시작, 개수) 와, 깊이 조각마다 다 찬 목록
+static const GLsizeiptr CLUSTER_BYTES = (GLsizeiptr)MAX_VIEWS * CLUSTER_COUNT * 2 * sizeof(uint32_t);
+static const GLsizeiptr INDEX_BYTES = (GLsizeiptr)MAX_VIEWS * CLUSTER_SLICES * CLUSTER_SLICE_INDICES * sizeof(uint16_t);
+
+void initLightBuffers(LightBuffers & b, GpuResources & gpu, bool allowPersistent){
+	static const GLenum FORMATS[3] = { GL_RGBA32F, GL_RG32UI, GL_R16UI };
+	static const char * const LABELS[3] = { "light data texture", "light cluster texture", "light index texture" };
+	glGenBuffers(1, &b.lightBuffer);
+	b.lightCapacity = 256;
+	glBindBuffer(GL_TEXTURE_BUFFER, b.lightBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, b.lightCapacity, NULL, GL_STATIC_DRAW);
+	initStreamBuffer(b.stream, GL_TEXTURE_BUFFER, CLUSTER_BYTES + STREAM_ALIGN + INDEX_BYTES, allowPersistent);
+	glGenTextures(3, b.textures);
+	for (int i = 0; i < 3; i++) {
+		glBindTexture(GL_TEXTURE_BUFFER, b.textures[i]);
+		glTexBuffer(GL_TEXTURE_BUFFER, FORMATS[i], i == 0 ? b.lightBuffer : b.stream.buffer);
+	}
+	glBindTexture(GL_TEXTURE_BUFFER, 0);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	b.clusterBase = 0;
+	b.indexBase = 0;
+	b.lightVersion = -1;
+	b.uploadedBytes = 0;
+	for (int i = 0; i < 3; i++)
+		b.samplerIDs[i] = -1;
+	b.clusterBaseID = -1;
+	b.indexBaseID = -1;
+	// 텍스처 버퍼는 저장소가 따로 없다. 새는지 보려고 이름표만 붙인다.
+	b.gpu = &gpu;
+	b.ids[0] = registerGpu(gpu, GPU_BUFFER, b.lightBuffer, GPU_DYNAMIC, b.lightCapacity, "light data", false);
+	b.ids[1] = registerGpu(gpu, GPU_BUFFER, b.stream.buffer, GPU_STREAM,
+		b.stream.mode == STREAM_PERSISTENT ? b.stream.regionSize * STREAM_REGIONS : b.stream.regionSize, "light cluster stream", false);
+	for (int i = 0; i < 3; i++)
+		b.ids[2 + i] = registerGpu(gpu, GPU_TEXTURE, b.textures[i], GPU_TEXTURE_DATA, 0, LABELS[i], false);
+}
+
+void uploadLightClusters(LightBuffers & b, const LightClusters & c){
+	b.uploadedBytes = 0;
+	// 빛은 바뀌었을 때만. 한 빛에 vec4 두 칸 (위치와 반지름, 색).
+	if (b.lightVersion != c.version && !c.lights.empty()) {
+		GLsizeiptr bytes = (GLsizeiptr)c.lights.size() * sizeof(PointLight);
+		glBindBuffer(GL_TEXTURE_BUFFER, b.lightBuffer);
+		if (bytes > b.lightCapacity) {
+			b.lightCapacity = bytes;
+			resizeGpu(*b.gpu, b.ids[0], bytes);
+		}
+		glBufferData(GL_TEXTURE_BUFFER, b.lightCapacity, NULL, GL_STATIC_DRAW);
+		glBufferSubData(GL_TEXTURE_BUFFER, 0, bytes, &c.lights[0]);
+		glBindBuffer(GL_TEXTURE_BUFFER, 0);
+		b.lightVersion = c.version;
+		b.uploadedBytes += bytes;
+	}
+	// 클러스터와 목록은 스트림에. 구역 안 위치는 STREAM_ALIGN 배수라서 텍셀 크기로 나눠 떨어진다.
+	GLsizeiptr clusterBytes = (GLsizeiptr)c.viewCount * CLUSTER_COUNT * 2 * sizeof(uint32_t);
+	GLsizeiptr indexBytes = (GLsizeiptr)c.stats.indices * sizeof(uint16_t);
+	GLsizeiptr clusterOffset = 0, indexOffset = 0;
+	void * clusters = streamAlloc(b.stream, clusterBytes, &clusterOffset);
+	void * indices = streamAlloc(b.stream, indexBytes > 0 ? indexBytes : sizeof(uint16_t), &indexOffset);
+	if (clusters == NULL || indices == NULL)
+		return;
+	memcpy(clusters, &c.clusterData[0], clusterBytes);
+	if (indexBytes > 0)
+		memcpy(indices, &c.indices[0], indexBytes);
+	streamFlush(b.stream);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+	b.clusterBase = (GLint)(clusterOffset / (2 * sizeof(uint32_t)));
+	b.indexBase = (GLint)(indexOffset / sizeof(uint16_t));
+	b.uploadedBytes += clusterBytes + indexBytes;
+}
+
+void getLightUniforms(LightBuffers & b, GLuint program){
+	static const char * const NAMES[3] = { "lightData", "clusterData", "lightIndices" };
+	for (int i = 0; i < 3; i++)
+		b.samplerIDs[i] = glGetUniformLocation(program, NAMES[i]);
+	b.clusterBaseID = glGetUniformLocation(program, "clusterBase");
+	b.indexBaseID = glGetUniformLocation(program, "indexBase");
+}
+
+void bindLightBuffers(const LightBuffers & b){
+	for (int i = 0; i < 3; i++) {
+		glActiveTexture(GL_TEXTURE0 + LIGHT_TEXTURE_UNIT + i);
+		glBindTexture(GL_TEXTURE_BUFFER, b.textures[i]);
+		glUniform1i(b.samplerIDs[i], LIGHT_TEXTURE_UNIT + i);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glUniform1i(b.clusterBaseID, b.clusterBase);
+	glUniform1i(b.indexBaseID, b.indexBase);
+}
+
+void freeLightBuffers(LightBuffers & b){
+	for (int i = 0; i < 5; i++)
+		releaseGpu(*b.gpu, b.ids[i]);
+	glDeleteTextures(3, b.textures);
+	glDeleteBuffers(1, &b.lightBuffer);
+	freeStreamBuffer(b.stream);
+}
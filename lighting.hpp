@@ -0,0 +1,117 @@
+#ifndef LIGHTING_HPP
+#define LIGHTING_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+
+#include "jobs.hpp"
+#include "views.hpp"
+#include "streambuffer.hpp"
+#include "gpuresources.hpp"
+
+// 클러스터 포워드 조명.
+// 뷰마다 화면을 타일로, 깊이를 지수 간격의 조각으로 나눈 froxel (클러스터) 격자를 만들고,
+// 매 프레임 CPU 잡들이 점광원을 그 격자에 나눠 담는다 (1 단계 : 빛마다 뷰 공간 범위, 2 단계 : 뷰/깊이 조각마다 담기).
+// 조각 셰이더는 자기 클러스터의 빛 목록만 돈다 (LitFragmentShader). 빛, 클러스터, 목록은 텍스처 버퍼로 올린다.
+// 클러스터와 목록은 매 프레임 바뀌므로 StreamBuffer 하나에 이어서 쓰고, 셰이더에는 그 위치를 텍셀 단위로 준다.
+// 격자 크기는 셰이더의 #define 과 같아야 한다.
+#define CLUSTER_TILES_X 16
+#define CLUSTER_TILES_Y 12
+#define CLUSTER_SLICES 24
+#define CLUSTER_COUNT (CLUSTER_TILES_X * CLUSTER_TILES_Y * CLUSTER_SLICES)   // 뷰 하나
+#define CLUSTER_MAX_LIGHTS 256          // 클러스터 하나에 담는 최대 수. 넘는 것은 버리고 센다.
+#define CLUSTER_SLICE_INDICES 16384     // 깊이 조각 하나에 담는 최대 수 (작업 공간)
+#define LIGHT_MAX 65535                 // 목록은 16 비트 번호
+
+struct PointLight {
+	glm::vec3 position;
+	float radius;                       // 이 거리에서 0 이 된다
+	glm::vec3 color;                    // 세기를 곱한 색
+	float padding;                      // 텍스처 버퍼에 vec4 두 칸으로 올린다
+};
+
+// 1 단계 결과. 빛 하나의 한 뷰에서의 범위. 안 보이면 slice0 > slice1.
+struct LightBounds {
+	glm::vec3 center;                   // 뷰 공간
+	float radius;
+	uint8_t tile0[2], tile1[2];
+	uint8_t slice0, slice1;
+};
+
+struct LightingStats {
+	int visible;                        // 한 뷰에라도 걸린 빛 (뷰마다 센 합)
+	int indices;                        // 목록 길이
+	int maxPerCluster;
+	int overflows;                      // 자리가 없어서 버린 것
+	double boundsMs;
+	double binMs;
+};
+
+struct LightClusters {
+	std::vector<PointLight> lights;
+	int version;                        // 빛이 바뀔 때마다 는다 (빛 데이터를 다시 올릴지)
+	int viewCount;
+	// 뷰마다 클러스터의 뷰 공간 상자. 투영이 바뀌면 다시 구한다.
+	std::vector<glm::vec3> clusterMin;
+	std::vector<glm::vec3> clusterMax;
+	glm::mat4 projection[MAX_VIEWS];
+	float nearZ[MAX_VIEWS];
+	float farZ[MAX_VIEWS];
+	// 올릴 것
+	std::vector<uint32_t> clusterData;  // 클러스터마다 (목록 시작, 개수), 뷰 * CLUSTER_COUNT
+	std::vector<uint16_t> indices;      // 빛 번호 목록
+	// 작업 공간
+	std::vector<LightBounds> bounds;    // 뷰 * 빛 수
+	std::vector<uint16_t> candidates;   // 뷰 * 조각 * 빛 수 (그 깊이 조각에 걸친 빛)
+	std::vector<uint16_t> sliceIndices; // 뷰 * 조각 * CLUSTER_SLICE_INDICES
+	std::vector<int> sliceUsed;
+	std::vector<int> sliceOverflows;
+	std::vector<int> sliceMax;
+	const ViewSet * views;
+	LightingStats stats;
+};
+
+void initLightClusters(LightClusters & c);
+// 발사대 둘레의 조명과 사거리를 따라 늘어선 유도등을 count 개 만든다 (seed 로 같은 배치)
+void generateRangeLights(LightClusters & c, int count, const glm::vec3 & pad, uint32_t seed);
+// 뷰들의 절두체로 빛을 클러스터에 나눠 담는다. jobs 가 NULL 이면 이 스레드에서.
+void buildLightClusters(LightClusters & c, const ViewSet & views, JobSystem * jobs);
+
+// GPU 쪽. 빛은 바뀔 때만 올리는 버퍼, 클러스터와 목록은 스트림 하나. 텍스처 버퍼 셋이 그것을 본다
+// (clusterData 와 lightIndices 는 같은 스트림을 다른 형식으로 본다).
+struct LightBuffers {
+	GLuint lightBuffer;
+	GLsizeiptr lightCapacity;
+	StreamBuffer stream;                // 프레임마다 beginStreamFrame / endStreamFrame (메인 루프에서)
+	GLuint textures[3];                 // 빛, 클러스터, 목록
+	GLint clusterBase;                  // 이번 프레임 자료가 스트림 안에서 시작하는 텍셀
+	GLint indexBase;
+	int lightVersion;                   // 올려 둔 빛의 version
+	GLsizeiptr uploadedBytes;           // 지난 uploadLightClusters 에서 올린 양
+	// 링크한 뒤 getLightUniforms 로 한번 찾아 둔다
+	GLint samplerIDs[3];
+	GLint clusterBaseID;
+	GLint indexBaseID;
+	// GPU 자원으로 센 것. 지우는 것은 freeLightBuffers.
+	GpuResources * gpu;
+	GpuId ids[5];                       // 빛 버퍼, 스트림, 텍스처 셋
+};
+
+// 텍스처 단위 1, 2, 3 을 쓴다 (0 은 HUD)
+#define LIGHT_TEXTURE_UNIT 1
+
+// 버퍼들을 만들고 gpu 에 이름표와 함께 센다. allowPersistent 는 initStreamBuffer 와 같다.
+void initLightBuffers(LightBuffers & b, GpuResources & gpu, bool allowPersistent);
+// 스트림의 이번 구역에 클러스터와 목록을 쓴다 (beginStreamFrame 뒤). 빛은 바뀌었을 때만 다시 올린다.
+void uploadLightClusters(LightBuffers & b, const LightClusters & c);
+// 프로그램을 링크한 뒤 한번. 샘플러와 시작 위치 uniform 을 찾아 둔다.
+void getLightUniforms(LightBuffers & b, GLuint program);
+// 지금 쓰는 프로그램의 샘플러를 단위에 묶고 시작 위치를 준다
+void bindLightBuffers(const LightBuffers & b);
+void freeLightBuffers(LightBuffers & b);
+
+#endif
@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <new>
+#ifdef _WIN32
+#include <malloc.h>
+#endif
+
+#include "memory.hpp"
+
+// 스레드마다 따로. 상수로 초기화되므로 operator new 안에서 써도 된다.
+static thread_local uint64_t allocationCount = 0;
+static thread_local uint64_t allocationBytes = 0;
+
+static void * countedAlloc(size_t size){
+	allocationCount++;
+	allocationBytes += size;
+	return malloc(size > 0 ? size : 1);
+}
+
+void * operator new(size_t size){
+	void * p = countedAlloc(size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](size_t size){
+	void * p = countedAlloc(size);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void * operator new(size_t size, const std::nothrow_t &) noexcept{
+	return countedAlloc(size);
+}
+
+void * operator new[](size_t size, const std::nothrow_t &) noexcept{
+	return countedAlloc(size);
+}
+
+// alignas 가 큰 타입용 (C++17)
+static void * countedAlignedAlloc(size_t size, std::align_val_t align){
+	allocationCount++;
+	allocationBytes += size;
+	size_t alignment = (size_t)align;
+#ifdef _WIN32
+	return _aligned_malloc(size > 0 ? size : 1, alignment);
+#else
+	size_t rounded = (size + alignment - 1) / alignment * alignment;
+	return aligned_alloc(alignment, rounded > 0 ? rounded : alignment);
+#endif
+}
+
+static void alignedFree(void * p){
+#ifdef _WIN32
+	_aligned_free(p);
+#else
+	free(p);
+#endif
+}
+
+void * operator new(size_t size, std::align_val_t align){
+	void * p = countedAlignedAlloc(size, align);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void * operator new[](size_t size, std::align_val_t align){
+	void * p = countedAlignedAlloc(size, align);
+	if (p == NULL)
+		throw std::bad_alloc();
+	return p;
+}
+
+void operator delete(void * p, std::align_val_t) noexcept{
+	alignedFree(p);
+}
+
+void operator delete[](void * p, std::align_val_t) noexcept{
+	alignedFree(p);
+}
+
+void operator delete(void * p, size_t, std::align_val_t) noexcept{
+	alignedFree(p);
+}
+
+void operator delete[](void * p, size_t, std::align_val_t) noexcept{
+	alignedFree(p);
+}
+
+void operator delete(void * p) noexcept{
+	free(p);
+}
+
+void operator delete[](void * p) noexcept{
+	free(p);
+}
+
+void operator delete(void * p, size_t) noexcept{
+	free(p);
+}
+
+void operator delete[](void * p, size_t) noexcept{
+	free(p);
+}
+
+void operator delete(void * p, const std::nothrow_t &) noexcept{
+	free(p);
+}
+
+void operator delete[](void * p, const std::nothrow_t &) noexcept{
+	free(p);
+}
+
+uint64_t heapAllocationCount(){
+	return allocationCount;
+}
+
+uint64_t heapAllocationBytes(){
+	return allocationBytes;
+}
+
+void initAllocationCheck(AllocationCheck & c, uint64_t warmupFrames){
+	c.frame = 0;
+	c.warmupFrames = warmupFrames;
+	c.countAtFrameStart = heapAllocationCount();
+	c.lastFrameAllocations = 0;
+	c.steadyAllocations = 0;
+	c.badFrames = 0;
+	c.lastReportTime = -1;
+}
+
+void beginAllocationFrame(AllocationCheck & c){
+	c.countAtFrameStart = heapAllocationCount();
+}
+
+void endAllocationFrame(AllocationCheck & c, double currentTime){
+	c.lastFrameAllocations = heapAllocationCount() - c.countAtFrameStart;
+	if (c.frame++ < c.warmupFrames || c.lastFrameAllocations == 0)
+		return;
+	c.steadyAllocations += c.lastFrameAllocations;
+	c.badFrames++;
+	if (currentTime - c.lastReportTime >= 1.0) {
+		fprintf(stderr, "Frame %llu : %llu heap allocations inside the main loop\n",
+			(unsigned long long)c.frame, (unsigned long long)c.lastFrameAllocations);
+		c.lastReportTime = currentTime;
+	}
+}
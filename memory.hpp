@@ -0,0 +1,32 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+
+// memory.cpp 는 전역 operator new/delete 를 바꿔서 힙 할당 횟수를 센다.
+// 메인 루프는 프레임마다 이 값의 차이를 보고, 루프 안에서 힙을 쓰는 곳이 생기면 알려준다.
+// 횟수는 스레드마다 따로 센다. 하늘 표를 만드는 스레드나 워커들이 파일을 열고 닫는 할당이
+// 메인 루프의 할당으로 잡히지 않게, 검사는 메인 스레드 것만 본다.
+
+// 이 스레드에서 operator new 가 불린 횟수
+uint64_t heapAllocationCount();
+// 이 스레드가 지금까지 받은 바이트 합
+
+// 프레임마다 메인 스레드의 힙 할당을 검사한다. 메인 스레드에서만 부른다.
+struct AllocationCheck {
+	uint64_t frame;
+	uint64_t warmupFrames;      // 이 프레임 수 이후를 steady state 로 본다
+	uint64_t countAtFrameStart;
+	uint64_t lastFrameAllocations;
+	uint64_t steadyAllocations; // steady state 에서 생긴 할당 합
+	uint64_t badFrames;         // 할당이 있었던 steady state 프레임 수
+	double lastReportTime;
+};
+
+void initAllocationCheck(AllocationCheck & c, uint64_t warmupFrames);
+void beginAllocationFrame(AllocationCheck & c);
+// 프레임 끝에 부른다. steady state 에서 할당이 있었으면 (1 초에 한번까지) 출력한다.
+void endAllocationFrame(AllocationCheck & c, double currentTime);
+
+#endif
@@ -0,0 +1,431 @@
+#ifndef MESH_HPP
+#define MESH_HPP
+
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+// 로켓 장면의 메쉬. Rocket.cpp 와 Benchmark.cpp 가 같이 쓴다.
+// 손으로 적은 배열 대신 상자, 프리즘, 원뿔, 날개, 판을 만드는 constexpr 함수로 컴파일할 때 만든다.
+// 메쉬마다 꼭지점 (중복 없이) 과 삼각형 인덱스, 그것을 펼친 위치/색/면 법선 배열, 경계 상자가 모두 읽기 전용 데이터로 들어가고
+// 시작할 때 계산하는 것은 없다. 그릴 때는 펼친 배열을 GL_TRIANGLES 로 그린다 (면 법선이 삼각형마다 달라서 정점을 나눠 쓸 수 없다).
+// 정점 수는 데이터에서 나오고, 만든 개수와 감김 방향은 아래의 static_assert 로 확인한다.
+// 감김은 GL 기본 (바깥에서 볼 때 반시계) 이다 : 닫힌 모양은 모든 변이 반대 방향으로 한 번씩 나오고 부피가 양수,
+// 판은 모든 면이 정한 쪽을 본다.
+namespace mesh {
+
+	struct Point {
+		float x, y, z;
+	};
+
+	constexpr Point operator+(Point a, Point b){ return Point{ a.x + b.x, a.y + b.y, a.z + b.z }; }
+	constexpr Point operator-(Point a, Point b){ return Point{ a.x - b.x, a.y - b.y, a.z - b.z }; }
+	constexpr Point operator*(Point a, float s){ return Point{ a.x * s, a.y * s, a.z * s }; }
+	constexpr bool operator==(Point a, Point b){ return a.x == b.x && a.y == b.y && a.z == b.z; }
+	constexpr float dot(Point a, Point b){ return a.x * b.x + a.y * b.y + a.z * b.z; }
+	constexpr Point cross(Point a, Point b){ return Point{ a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x }; }
+
+	// 뉴턴 법. 컴파일할 때 쓰므로 빠를 필요는 없다.
+	constexpr float squareRoot(float x){
+		if (x <= 0.0f)
+			return 0.0f;
+		float r = x > 1.0f ? x : 1.0f;
+		for (int i = 0; i < 64; i++)
+			r = 0.5f * (r + x / r);
+		return r;
+	}
+	constexpr Point normalize(Point a){
+		float length = squareRoot(dot(a, a));
+		return length > 0.0f ? a * (1.0f / length) : Point{ 0.0f, 0.0f, 0.0f };
+	}
+	// 테일러 급수 (-pi ~ pi 로 줄여서)
+	constexpr float sine(float x){
+		const float pi = 3.14159265358979f;
+		while (x > pi)
+			x -= 2.0f * pi;
+		while (x < -pi)
+			x += 2.0f * pi;
+		float term = x, sum = x;
+		for (int n = 1; n < 12; n++) {
+			term *= -x * x / ((2 * n) * (2 * n + 1));
+			sum += term;
+		}
+		return sum;
+	}
+	constexpr float cosine(float x){ return sine(x + 1.57079632679490f); }
+	// 1/65536 격자에 맞춘다 (삼각함수의 찌꺼기를 없애서 꼭지점이 0, 1 같은 값에 정확히 오게)
+	constexpr float snap(float x){
+		return (float)(long long)(x * 65536.0f + (x >= 0.0f ? 0.5f : -0.5f)) / 65536.0f;
+	}
+
+	// 모양마다 삼각형 수와 꼭지점 수. 메쉬의 크기 (템플릿 인자) 를 이것으로 정한다.
+	#define MESH_BOX_TRIANGLES 12
+	#define MESH_BOX_CORNERS 8
+	#define MESH_PRISM_TRIANGLES 8
+	#define MESH_PRISM_CORNERS 6
+	#define MESH_FIN_TRIANGLES 4
+	#define MESH_FIN_CORNERS 4
+	#define MESH_PANEL_TRIANGLES 2
+	#define MESH_PANEL_CORNERS 4
+	#define MESH_CONE_TRIANGLES(segments) (2 * (segments) - 2)
+	#define MESH_CONE_CORNERS(segments) ((segments) + 1)
+
+	// 완성된 메쉬. Triangles, Corners 는 담을 수 있는 크기이고 실제로 채운 수는 triangleCount, cornerCount 다.
+	template <int Triangles, int Corners>
+	struct Mesh {
+		Point corners[Corners];
+		uint16_t indices[Triangles * 3];
+		GLfloat positions[Triangles * 9];   // 삼각형마다 정점 셋 (x, y, z)
+		GLfloat colors[Triangles * 9];
+		GLfloat normals[Triangles * 9];     // 면 법선 (길이 1)
+		Point min, max;
+		int triangleCount;
+		int cornerCount;
+	};
+
+	// 만드는 중인 메쉬. 색은 정점 순서대로 even, odd 를 번갈아 칠한다 (같으면 한 색).
+	template <int Triangles, int Corners>
+	struct MeshBuilder {
+		Mesh<Triangles, Corners> mesh;
+		Point even, odd;
+	};
+
+	template <int T, int C>
+	constexpr void setColor(MeshBuilder<T, C> & b, Point even, Point odd){
+		b.even = even;
+		b.odd = odd;
+	}
+
+	template <int T, int C>
+	constexpr int addCorner(MeshBuilder<T, C> & b, Point p){
+		Mesh<T, C> & m = b.mesh;
+		for (int i = 0; i < m.cornerCount; i++)
+			if (m.corners[i] == p)
+				return i;
+		m.corners[m.cornerCount] = p;   // 넘치면 컴파일 에러 (상수식에서 배열 밖 접근)
+		return m.cornerCount++;
+	}
+
+	// 법선이 front 쪽을 보게 감는다
+	template <int T, int C>
+	constexpr void addTriangle(MeshBuilder<T, C> & b, Point p0, Point p1, Point p2, Point front){
+		if (dot(cross(p1 - p0, p2 - p0), front) < 0.0f) {
+			Point t = p1;
+			p1 = p2;
+			p2 = t;
+		}
+		Mesh<T, C> & m = b.mesh;
+		int t3 = m.triangleCount * 3;
+		m.indices[t3] = (uint16_t)addCorner(b, p0);
+		m.indices[t3 + 1] = (uint16_t)addCorner(b, p1);
+		m.indices[t3 + 2] = (uint16_t)addCorner(b, p2);
+		m.triangleCount++;
+	}
+
+	// 볼록한 모양의 삼각형. 안쪽 점 inside 의 반대쪽을 보게 감는다.
+	template <int T, int C>
+	constexpr void addOutward(MeshBuilder<T, C> & b, Point p0, Point p1, Point p2, Point inside){
+		addTriangle(b, p0, p1, p2, (p0 + p1 + p2) * (1.0f / 3.0f) - inside);
+	}
+
+	template <int T, int C>
+	constexpr void addQuadOutward(MeshBuilder<T, C> & b, Point p0, Point p1, Point p2, Point p3, Point inside){
+		addOutward(b, p0, p1, p2, inside);
+		addOutward(b, p0, p2, p3, inside);
+	}
+
+	// 축에 나란한 상자 (lo ~ hi)
+	template <int T, int C>
+	constexpr void addBox(MeshBuilder<T, C> & b, Point lo, Point hi){
+		Point c = (lo + hi) * 0.5f;
+		Point p[8] = {};
+		for (int i = 0; i < 8; i++)
+			p[i] = Point{ i & 1 ? hi.x : lo.x, i & 2 ? hi.y : lo.y, i & 4 ? hi.z : lo.z };
+		addQuadOutward(b, p[0], p[2], p[6], p[4], c);   // x = lo
+		addQuadOutward(b, p[1], p[3], p[7], p[5], c);   // x = hi
+		addQuadOutward(b, p[0], p[1], p[5], p[4], c);   // y = lo
+		addQuadOutward(b, p[2], p[3], p[7], p[6], c);   // y = hi
+		addQuadOutward(b, p[0], p[1], p[3], p[2], c);   // z = lo
+		addQuadOutward(b, p[4], p[5], p[7], p[6], c);   // z = hi
+	}
+
+	// a 에서 b 까지의 가는 삼각기둥 (낙하산 줄). radius 는 단면 꼭지점까지.
+	template <int T, int C>
+	constexpr void addPrism(MeshBuilder<T, C> & b, Point a, Point d, float radius){
+		Point axis = d - a;
+		Point reference = axis.z * axis.z > 0.9f * dot(axis, axis) ? Point{ 1.0f, 0.0f, 0.0f } : Point{ 0.0f, 0.0f, 1.0f };
+		Point u = normalize(cross(axis, reference)) * radius;
+		Point v = normalize(cross(axis, u)) * radius;
+		const float c120 = -0.5f, s120 = 0.866025404f;
+		Point ring[3] = { u, u * c120 + v * s120, u * c120 - v * s120 };
+		Point c = (a + d) * 0.5f;
+		for (int i = 0; i < 3; i++) {
+			int j = (i + 1) % 3;
+			addQuadOutward(b, a + ring[i], a + ring[j], d + ring[j], d + ring[i], c);
+		}
+		addOutward(b, a + ring[0], a + ring[1], a + ring[2], c);
+		addOutward(b, d + ring[0], d + ring[1], d + ring[2], c);
+	}
+
+	// 밑면이 정 segments 각형인 뿔 (뚜껑). 밑면은 y = base.y, angle 은 첫 꼭지점의 방위 (라디안).
+	template <int T, int C>
+	constexpr void addCone(MeshBuilder<T, C> & b, Point base, float radius, float height, int segments, float angle){
+		const float step = 2.0f * 3.14159265358979f / segments;
+		Point apex = base + Point{ 0.0f, height, 0.0f };
+		Point c = base + Point{ 0.0f, height * 0.25f, 0.0f };
+		Point first = base + Point{ snap(cosine(angle) * radius), 0.0f, snap(sine(angle) * radius) };
+		Point previous = first;
+		for (int i = 1; i <= segments; i++) {
+			Point p = i == segments ? first : base + Point{ snap(cosine(angle + step * i) * radius), 0.0f, snap(sine(angle + step * i) * radius) };
+			addOutward(b, previous, p, apex, c);
+			// 밑면은 첫 꼭지점에서 부채꼴로
+			if (i >= 2 && i < segments)
+				addOutward(b, first, previous, p, c);
+			previous = p;
+		}
+	}
+
+	// 몸통 옆에 붙는 날개. 몸통 모서리 위의 두 점 (rootA, rootB), 바깥 끝 tip, 몸통 면 위의 꼭대기 top 으로 된 사면체.
+	template <int T, int C>
+	constexpr void addFin(MeshBuilder<T, C> & b, Point rootA, Point rootB, Point tip, Point top){
+		Point c = (rootA + rootB + tip + top) * 0.25f;
+		addOutward(b, rootA, rootB, tip, c);
+		addOutward(b, rootA, tip, top, c);
+		addOutward(b, rootB, tip, top, c);
+		addOutward(b, rootA, rootB, top, c);
+	}
+
+	// origin 에서 u, v 로 펼친 평행사변형 한 장. 앞면은 u x v 쪽.
+	template <int T, int C>
+	constexpr void addPanel(MeshBuilder<T, C> & b, Point origin, Point u, Point v){
+		Point front = cross(u, v);
+		addTriangle(b, origin, origin + u, origin + u + v, front);
+		addTriangle(b, origin, origin + u + v, origin + v, front);
+	}
+
+	// 인덱스를 펼쳐서 위치, 색, 면 법선, 경계 상자를 채운다
+	template <int T, int C>
+	constexpr Mesh<T, C> finish(MeshBuilder<T, C> & b){
+		Mesh<T, C> & m = b.mesh;
+		m.min = m.max = m.corners[0];
+		for (int i = 1; i < m.cornerCount; i++) {
+			Point p = m.corners[i];
+			m.min = Point{ p.x < m.min.x ? p.x : m.min.x, p.y < m.min.y ? p.y : m.min.y, p.z < m.min.z ? p.z : m.min.z };
+			m.max = Point{ p.x > m.max.x ? p.x : m.max.x, p.y > m.max.y ? p.y : m.max.y, p.z > m.max.z ? p.z : m.max.z };
+		}
+		for (int t = 0; t < m.triangleCount; t++) {
+			Point p0 = m.corners[m.indices[t * 3]], p1 = m.corners[m.indices[t * 3 + 1]], p2 = m.corners[m.indices[t * 3 + 2]];
+			Point n = normalize(cross(p1 - p0, p2 - p0));
+			for (int k = 0; k < 3; k++) {
+				Point p = m.corners[m.indices[t * 3 + k]];
+				Point color = (t * 3 + k) % 2 == 0 ? b.even : b.odd;
+				int o = (t * 3 + k) * 3;
+				m.positions[o] = p.x;
+				m.positions[o + 1] = p.y;
+				m.positions[o + 2] = p.z;
+				m.colors[o] = color.x;
+				m.colors[o + 1] = color.y;
+				m.colors[o + 2] = color.z;
+				m.normals[o] = n.x;
+				m.normals[o + 1] = n.y;
+				m.normals[o + 2] = n.z;
+			}
+		}
+		return m;
+	}
+
+	// 검사들 (static_assert 용)
+	template <int T, int C>
+	constexpr bool isFull(const Mesh<T, C> & m){
+		return m.triangleCount == T && m.cornerCount == C;
+	}
+
+	// 넓이가 0 인 삼각형이 없다
+	template <int T, int C>
+	constexpr bool hasNoDegenerate(const Mesh<T, C> & m){
+		for (int t = 0; t < m.triangleCount; t++) {
+			Point p0 = m.corners[m.indices[t * 3]], p1 = m.corners[m.indices[t * 3 + 1]], p2 = m.corners[m.indices[t * 3 + 2]];
+			Point n = cross(p1 - p0, p2 - p0);
+			if (dot(n, n) < 1e-12f)
+				return false;
+		}
+		return true;
+	}
+
+	// 닫혀 있고 바깥으로 감겼다 : 모든 변 (a -> b) 마다 b -> a 가 꼭 한 번 있고, 부피가 양수
+	template <int T, int C>
+	constexpr bool isClosedOutward(const Mesh<T, C> & m){
+		const int edges = m.triangleCount * 3;
+		float volume = 0.0f;
+		for (int e = 0; e < edges; e++) {
+			int t = e / 3, k = e % 3;
+			int a = m.indices[e], b = m.indices[t * 3 + (k + 1) % 3];
+			int same = 0, reverse = 0;
+			for (int f = 0; f < edges; f++) {
+				int s = f / 3, l = f % 3;
+				int c = m.indices[f], d = m.indices[s * 3 + (l + 1) % 3];
+				same += c == a && d == b;
+				reverse += c == b && d == a;
+			}
+			if (same != 1 || reverse != 1)
+				return false;
+		}
+		for (int t = 0; t < m.triangleCount; t++)
+			volume += dot(m.corners[m.indices[t * 3]], cross(m.corners[m.indices[t * 3 + 1]], m.corners[m.indices[t * 3 + 2]]));
+		return volume > 0.0f;
+	}
+
+	// 열린 판들 : 모든 면이 target 점 쪽을 본다
+	template <int T, int C>
+	constexpr bool facesToward(const Mesh<T, C> & m, Point target){
+		for (int t = 0; t < m.triangleCount; t++) {
+			Point p0 = m.corners[m.indices[t * 3]], p1 = m.corners[m.indices[t * 3 + 1]], p2 = m.corners[m.indices[t * 3 + 2]];
+			if (dot(cross(p1 - p0, p2 - p0), target - p0) <= 0.0f)
+				return false;
+		}
+		return true;
+	}
+
+	// 장면의 메쉬들
+	constexpr Point grey(float v){ return Point{ v, v, v }; }
+
+	constexpr Mesh<MESH_BOX_TRIANGLES, MESH_BOX_CORNERS> makeBody(){
+		MeshBuilder<MESH_BOX_TRIANGLES, MESH_BOX_CORNERS> b{};
+		setColor(b, grey(1.0f), grey(0.8f));
+		addBox(b, Point{ 0.0f, 0.0f, 0.0f }, Point{ 1.0f, 2.0f, 1.0f });
+		return finish(b);
+	}
+
+	constexpr Mesh<MESH_FIN_TRIANGLES, MESH_FIN_CORNERS> makeWing(Point rootA, Point rootB, Point tip, Point top){
+		MeshBuilder<MESH_FIN_TRIANGLES, MESH_FIN_CORNERS> b{};
+		setColor(b, Point{ 0.8f, 0.0f, 0.0f }, Point{ 0.6f, 0.0f, 0.0f });
+		addFin(b, rootA, rootB, tip, top);
+		return finish(b);
+	}
+
+	// 사각뿔 : 몸통 윗면 (0 ~ 1) 의 네 모서리에 꼭지점이 오게 45 도 돌린다
+	constexpr Mesh<MESH_CONE_TRIANGLES(4), MESH_CONE_CORNERS(4)> makeHead(){
+		MeshBuilder<MESH_CONE_TRIANGLES(4), MESH_CONE_CORNERS(4)> b{};
+		setColor(b, Point{ 0.0f, 0.0f, 0.3f }, Point{ 0.0f, 0.1f, 0.5f });
+		addCone(b, Point{ 0.5f, 2.0f, 0.5f }, 0.707106781f, 1.0f, 4, 0.785398163f);
+		return finish(b);
+	}
+
+	constexpr Mesh<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> makePanel(Point origin, Point u, Point v, Point color){
+		MeshBuilder<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> b{};
+		setColor(b, color, color);
+		addPanel(b, origin, u, v);
+		return finish(b);
+	}
+
+	// 뒷벽, 오른쪽 벽, 왼쪽 벽. 모두 발사대 쪽을 본다.
+	constexpr Mesh<3 * MESH_PANEL_TRIANGLES, 3 * MESH_PANEL_CORNERS> makeWall(){
+		MeshBuilder<3 * MESH_PANEL_TRIANGLES, 3 * MESH_PANEL_CORNERS> b{};
+		setColor(b, Point{ 0.5f, 0.5f, 1.0f }, Point{ 0.5f, 0.5f, 1.0f });
+		addPanel(b, Point{ -100.0f, 0.0f, -5.0f }, Point{ 200.0f, 0.0f, 0.0f }, Point{ 0.0f, 30.0f, 0.0f });
+		addPanel(b, Point{ 50.0f, 0.0f, -5.0f }, Point{ 0.0f, 0.0f, 105.0f }, Point{ 0.0f, 30.0f, 0.0f });
+		addPanel(b, Point{ -30.0f, 0.0f, -5.0f }, Point{ 0.0f, 30.0f, 0.0f }, Point{ 0.0f, 0.0f, 105.0f });
+		return finish(b);
+	}
+
+	// 낙하산 양 끝에서 몸통 윗모서리로 내려오는 줄 네 가닥
+	constexpr Mesh<4 * MESH_PRISM_TRIANGLES, 4 * MESH_PRISM_CORNERS> makeLines(){
+		MeshBuilder<4 * MESH_PRISM_TRIANGLES, 4 * MESH_PRISM_CORNERS> b{};
+		setColor(b, grey(0.0f), grey(0.0f));
+		addPrism(b, Point{ 1.2f, 3.5f, 0.95f }, Point{ 1.0f, 2.0f, 0.95f }, 0.05f);
+		addPrism(b, Point{ 1.2f, 3.5f, 0.05f }, Point{ 1.0f, 2.0f, 0.05f }, 0.05f);
+		addPrism(b, Point{ -0.5f, 3.5f, 0.95f }, Point{ 0.0f, 2.0f, 0.95f }, 0.05f);
+		addPrism(b, Point{ -0.5f, 3.5f, 0.05f }, Point{ 0.0f, 2.0f, 0.05f }, 0.05f);
+		return finish(b);
+	}
+
+	static constexpr Mesh<MESH_BOX_TRIANGLES, MESH_BOX_CORNERS> body = makeBody();
+	static constexpr Mesh<MESH_FIN_TRIANGLES, MESH_FIN_CORNERS> wing1 = makeWing(Point{ 1.0f, 0.0f, 0.0f }, Point{ 1.0f, 0.0f, 1.0f },
+		Point{ 1.5f, 0.0f, 0.5f }, Point{ 1.0f, 1.0f, 0.5f });
+	static constexpr Mesh<MESH_FIN_TRIANGLES, MESH_FIN_CORNERS> wing2 = makeWing(Point{ 1.0f, 0.0f, 1.0f }, Point{ 0.0f, 0.0f, 1.0f },
+		Point{ 0.5f, 0.0f, 1.5f }, Point{ 0.5f, 1.0f, 1.0f });
+	static constexpr Mesh<MESH_FIN_TRIANGLES, MESH_FIN_CORNERS> wing3 = makeWing(Point{ 0.0f, 0.0f, 0.0f }, Point{ 0.0f, 0.0f, 1.0f },
+		Point{ -0.5f, 0.0f, 0.5f }, Point{ 0.0f, 1.0f, 0.5f });
+	static constexpr Mesh<MESH_FIN_TRIANGLES, MESH_FIN_CORNERS> wing4 = makeWing(Point{ 1.0f, 0.0f, 0.0f }, Point{ 0.0f, 0.0f, 0.0f },
+		Point{ 0.5f, 0.0f, -0.5f }, Point{ 0.5f, 1.0f, 0.0f });
+	static constexpr Mesh<MESH_CONE_TRIANGLES(4), MESH_CONE_CORNERS(4)> head = makeHead();
+	static constexpr Mesh<3 * MESH_PANEL_TRIANGLES, 3 * MESH_PANEL_CORNERS> wall = makeWall();
+	static constexpr Mesh<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> floor = makePanel(Point{ -100.0f, 0.0f, -100.0f },
+		Point{ 0.0f, 0.0f, 200.0f }, Point{ 200.0f, 0.0f, 0.0f }, Point{ 0.9f, 0.6f, 0.2f });
+	static constexpr Mesh<4 * MESH_PRISM_TRIANGLES, 4 * MESH_PRISM_CORNERS> lines = makeLines();
+	// 낙하산 천 다섯 조각 (왼쪽부터). z 는 0 ~ 1, 모두 위쪽이 앞면.
+	static constexpr Mesh<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> suit1 = makePanel(Point{ -0.5f, 3.5f, 0.0f },
+		Point{ 0.0f, 0.0f, 1.0f }, Point{ 0.3f, 0.3f, 0.0f }, Point{ 1.0f, 0.0f, 0.0f });
+	static constexpr Mesh<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> suit2 = makePanel(Point{ -0.2f, 3.8f, 0.0f },
+		Point{ 0.0f, 0.0f, 1.0f }, Point{ 0.4f, 0.2f, 0.0f }, Point{ 0.7f, 0.3f, 0.0f });
+	static constexpr Mesh<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> suit3 = makePanel(Point{ 0.2f, 4.0f, 0.0f },
+		Point{ 0.0f, 0.0f, 1.0f }, Point{ 0.4f, 0.0f, 0.0f }, Point{ 0.7f, 0.7f, 0.0f });
+	static constexpr Mesh<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> suit4 = makePanel(Point{ 0.6f, 4.0f, 0.0f },
+		Point{ 0.0f, 0.0f, 1.0f }, Point{ 0.3f, -0.2f, 0.0f }, Point{ 0.0f, 1.0f, 0.0f });
+	static constexpr Mesh<MESH_PANEL_TRIANGLES, MESH_PANEL_CORNERS> suit5 = makePanel(Point{ 0.9f, 3.8f, 0.0f },
+		Point{ 0.0f, 0.0f, 1.0f }, Point{ 0.3f, -0.3f, 0.0f }, Point{ 0.0f, 0.0f, 1.0f });
+
+	static_assert(isFull(body) && hasNoDegenerate(body) && isClosedOutward(body), "body must be a closed box wound outward");
+	static_assert(isFull(wing1) && hasNoDegenerate(wing1) && isClosedOutward(wing1), "wing 1 must be a closed fin wound outward");
+	static_assert(isFull(wing2) && hasNoDegenerate(wing2) && isClosedOutward(wing2), "wing 2 must be a closed fin wound outward");
+	static_assert(isFull(wing3) && hasNoDegenerate(wing3) && isClosedOutward(wing3), "wing 3 must be a closed fin wound outward");
+	static_assert(isFull(wing4) && hasNoDegenerate(wing4) && isClosedOutward(wing4), "wing 4 must be a closed fin wound outward");
+	static_assert(isFull(head) && hasNoDegenerate(head) && isClosedOutward(head), "head must be a closed pyramid wound outward");
+	static_assert(isFull(lines) && hasNoDegenerate(lines) && isClosedOutward(lines), "parachute lines must be closed prisms wound outward");
+	static_assert(isFull(wall) && hasNoDegenerate(wall) && facesToward(wall, Point{ 10.0f, 15.0f, 40.0f }), "walls must face the pad");
+	static_assert(isFull(floor) && hasNoDegenerate(floor) && facesToward(floor, Point{ 0.0f, 100.0f, 0.0f }), "floor must face up");
+	static_assert(isFull(suit1) && hasNoDegenerate(suit1) && facesToward(suit1, Point{ 0.35f, 100.0f, 0.5f }), "parachute 1 must face up");
+	static_assert(isFull(suit2) && hasNoDegenerate(suit2) && facesToward(suit2, Point{ 0.35f, 100.0f, 0.5f }), "parachute 2 must face up");
+	static_assert(isFull(suit3) && hasNoDegenerate(suit3) && facesToward(suit3, Point{ 0.35f, 100.0f, 0.5f }), "parachute 3 must face up");
+	static_assert(isFull(suit4) && hasNoDegenerate(suit4) && facesToward(suit4, Point{ 0.35f, 100.0f, 0.5f }), "parachute 4 must face up");
+	static_assert(isFull(suit5) && hasNoDegenerate(suit5) && facesToward(suit5, Point{ 0.35f, 100.0f, 0.5f }), "parachute 5 must face up");
+	// 몸통 위에 뚜껑, 날개는 몸통 옆에 붙어 있어야 한다 (장면 그래프가 모두 같은 원점을 쓴다)
+	static_assert(head.min.y == body.max.y && wing1.min.y == body.min.y, "rocket parts must line up");
+
+	// 그리는 쪽에서 쓰는 모양 (크기를 지운 것)
+	struct MeshView {
+		const GLfloat * positions;
+		const GLfloat * colors;
+		const GLfloat * normals;
+		GLsizei vertexCount;
+		const Point * corners;            // 충돌 헐 등
+		int cornerCount;
+		const uint16_t * indices;
+		Point min, max;
+	};
+
+	template <int T, int C>
+	constexpr MeshView view(const Mesh<T, C> & m){
+		return MeshView{ m.positions, m.colors, m.normals, T * 3, m.corners, m.cornerCount, m.indices, m.min, m.max };
+	}
+
+	// 그리는 순서대로
+	enum MeshId {
+		MESH_BODY,
+		MESH_WING1,
+		MESH_WING2,
+		MESH_WING3,
+		MESH_WING4,
+		MESH_HEAD,
+		MESH_WALL,
+		MESH_FLOOR,
+		MESH_LINES,
+		MESH_SUIT1,
+		MESH_SUIT2,
+		MESH_SUIT3,
+		MESH_SUIT4,
+		MESH_SUIT5,
+		MESH_COUNT
+	};
+
+	static constexpr MeshView meshes[MESH_COUNT] = {
+		view(body), view(wing1), view(wing2), view(wing3), view(wing4), view(head), view(wall), view(floor),
+		view(lines), view(suit1), view(suit2), view(suit3), view(suit4), view(suit5)
+	};
+	static const char * const meshLabels[MESH_COUNT] = {
+		"body", "wing 1", "wing 2", "wing 3", "wing 4", "head", "wall", "floor",
+		"parachute lines", "parachute 1", "parachute 2", "parachute 3", "parachute 4", "parachute 5"
+	};
+}
+
+#endif
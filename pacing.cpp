@@ -0,0 +1,193 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#include "pacing.hpp"
+
+#define PACER_MIN_SPIN 0.0002      // 잠에서 깬 뒤 최소한 이만큼은 돌면서 기다린다 (초)
+#define PACER_MAX_SPIN 0.004
+
+double processCpuSeconds(){
+#ifdef _WIN32
+	FILETIME creation, exit, kernel, user;
+	if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+		return 0.0;
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernel.dwLowDateTime;
+	k.HighPart = kernel.dwHighDateTime;
+	u.LowPart = user.dwLowDateTime;
+	u.HighPart = user.dwHighDateTime;
+	return (double)(k.QuadPart + u.QuadPart) * 1e-7;
+#else
+	timespec t;
+	if (clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &t) != 0)
+		return 0.0;
+	return t.tv_sec + t.tv_nsec * 1e-9;
+#endif
+}
+
+double pacerNow(){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void initPacer(FramePacer & p, PacingMode mode, double targetHz, bool tearSupported){
+	p.mode = mode;
+	p.targetHz = targetHz;
+	p.idleHz = 10.0;
+	p.idleAfter = 2.0;
+	p.idleEnabled = true;
+	p.tearSupported = tearSupported;
+	p.idle = false;
+	double now = pacerNow();
+	p.lastActivity = now;
+	p.deadline = now;
+	p.lastFrame = now;
+	p.lastCpu = processCpuSeconds();
+	p.oversleep = 0.001;
+	p.wait = NULL;
+	p.waitContext = NULL;
+	memset(&p.window, 0, sizeof(p.window));
+	memset(p.total, 0, sizeof(p.total));
+}
+
+void setPacingMode(FramePacer & p, PacingMode mode){
+	p.mode = mode;
+	p.deadline = pacerNow();
+}
+
+int pacerSwapInterval(const FramePacer & p){
+	switch (p.mode) {
+	case PACING_VSYNC: return 1;
+	case PACING_ADAPTIVE: return p.tearSupported ? -1 : 1;
+	default: return 0;
+	}
+}
+
+static const char * const PACING_NAMES[PACING_MODES] = { "vsync", "adaptive", "limit", "uncapped" };
+
+bool parsePacingMode(const char * name, PacingMode & mode){
+	for (int i = 0; i < PACING_MODES; i++) {
+		if (strcmp(name, PACING_NAMES[i]) == 0) {
+			mode = (PacingMode)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char * pacingModeName(PacingMode mode){
+	return mode >= 0 && mode < PACING_MODES ? PACING_NAMES[mode] : "?";
+}
+
+static void addFrame(PacingStats & s, double intervalMs, double cpuSeconds, double sleepSeconds, double spinSeconds, bool idle, bool woke){
+	s.frames++;
+	s.idleFrames += idle ? 1 : 0;
+	s.wakeups += woke ? 1 : 0;
+	s.wallSeconds += intervalMs / 1000.0;
+	s.cpuSeconds += cpuSeconds;
+	s.sleepSeconds += sleepSeconds;
+	s.spinSeconds += spinSeconds;
+	s.sumMs += intervalMs;
+	s.sumSquaredMs += intervalMs * intervalMs;
+	if (intervalMs > s.maxMs)
+		s.maxMs = intervalMs;
+}
+
+void paceFrame(FramePacer & p, bool active){
+	double now = pacerNow();
+	if (active)
+		p.lastActivity = now;
+	p.idle = p.idleEnabled && now - p.lastActivity >= p.idleAfter;
+	double period = 0.0;
+	if (p.idle)
+		period = 1.0 / p.idleHz;
+	else if (p.mode == PACING_LIMITER && p.targetHz > 0.0)
+		period = 1.0 / p.targetHz;
+
+	double sleepSeconds = 0.0, spinSeconds = 0.0;
+	bool woke = false;
+	if (period > 0.0) {
+		// 한 프레임 넘게 밀렸으면 따라잡지 않고 지금부터 다시 센다
+		p.deadline += period;
+		if (p.deadline < now)
+			p.deadline = now;
+		if (p.idle) {
+			double start = now;
+			if (p.wait != NULL)
+				p.wait(p.waitContext, p.deadline - now);
+			else
+				std::this_thread::sleep_for(std::chrono::duration<double>(p.deadline - now));
+			now = pacerNow();
+			sleepSeconds = now - start;
+			woke = true;
+			// 일찍 깼으면 입력이 온 것이다
+			if (now < p.deadline - PACER_MAX_SPIN) {
+				p.lastActivity = now;
+				p.idle = false;
+				p.deadline = now;
+			}
+		}
+		else {
+			// OS 의 잠은 늦게 깨므로 늦는 만큼 일찍 일어나서 나머지는 돈다
+			double spin = p.oversleep * 1.5 + PACER_MIN_SPIN;
+			if (spin > PACER_MAX_SPIN)
+				spin = PACER_MAX_SPIN;
+			double sleep = p.deadline - now - spin;
+			if (sleep > 0.0) {
+				double start = now;
+				std::this_thread::sleep_for(std::chrono::duration<double>(sleep));
+				now = pacerNow();
+				sleepSeconds = now - start;
+				double late = sleepSeconds - sleep;
+				p.oversleep = p.oversleep * 0.9 + (late > 0.0 ? late : 0.0) * 0.1;
+				woke = true;
+			}
+			double spinStart = now;
+			while (now < p.deadline)
+				now = pacerNow();
+			spinSeconds = now - spinStart;
+		}
+	}
+	else {
+		p.deadline = now;
+	}
+
+	double cpu = processCpuSeconds();
+	double intervalMs = (now - p.lastFrame) * 1000.0;
+	addFrame(p.window, intervalMs, cpu - p.lastCpu, sleepSeconds, spinSeconds, p.idle, woke);
+	addFrame(p.total[p.mode], intervalMs, cpu - p.lastCpu, sleepSeconds, spinSeconds, p.idle, woke);
+	p.lastFrame = now;
+	p.lastCpu = cpu;
+}
+
+double pacingMeanMs(const PacingStats & s){
+	return s.frames > 0 ? s.sumMs / s.frames : 0.0;
+}
+
+double pacingStdDevMs(const PacingStats & s){
+	if (s.frames < 2)
+		return 0.0;
+	double mean = s.sumMs / s.frames;
+	double variance = s.sumSquaredMs / s.frames - mean * mean;
+	return variance > 0.0 ? sqrt(variance) : 0.0;
+}
+
+double pacingCpuPercent(const PacingStats & s){
+	return s.wallSeconds > 0.0 ? s.cpuSeconds / s.wallSeconds * 100.0 : 0.0;
+}
+
+double pacingWakeupsPerSecond(const PacingStats & s){
+	return s.wallSeconds > 0.0 ? s.wakeups / s.wallSeconds : 0.0;
+}
+
+void resetPacingWindow(FramePacer & p){
+	memset(&p.window, 0, sizeof(p.window));
+}
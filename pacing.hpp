@@ -0,0 +1,84 @@
+#ifndef PACING_HPP
+#define PACING_HPP
+
+#include <stdint.h>
+
+// 프레임 속도 조절.
+// 모드마다 swap interval 과 프레임 사이 기다리기를 정한다.
+//   VSYNC    : swap interval 1. 화면 주사율에 맞춘다.
+//   ADAPTIVE : swap interval -1 (EXT_swap_control_tear). 늦은 프레임은 기다리지 않고 바로 내보낸다 (찢어짐 허용).
+//              확장이 없으면 VSYNC 와 같다.
+//   LIMITER  : swap interval 0, targetHz 에 맞춰 잠들었다가 마지막 조금은 돌면서 (spin) 기다린다.
+//   UNCAPPED : 기다리지 않는다 (비교용).
+// 장면이 멈춰 있고 입력이 없으면 (발사대 위) 모드와 상관없이 idleHz 로 떨어진다. 이때는 wait 함수로
+// 기다리므로 입력이 오면 바로 깬다.
+// 모드마다 프레임 간격의 평균/표준편차, CPU 사용률, 깨어난 횟수 (전력 대신 보는 값) 를 따로 모은다.
+enum PacingMode {
+	PACING_VSYNC,
+	PACING_ADAPTIVE,
+	PACING_LIMITER,
+	PACING_UNCAPPED,
+	PACING_MODES
+};
+
+// 입력이 올 때까지 최대 seconds 초 기다린다 (glfwWaitEventsTimeout). NULL 이면 그냥 잔다.
+typedef void (*PacerWaitFunction)(void * context, double seconds);
+
+struct PacingStats {
+	uint64_t frames;
+	uint64_t idleFrames;
+	uint64_t wakeups;          // 잠들었다 깬 횟수
+	double wallSeconds;
+	double cpuSeconds;         // 프로세스 전체 (워커 포함)
+	double sleepSeconds;
+	double spinSeconds;
+	double sumMs;              // 프레임 간격
+	double sumSquaredMs;
+	double maxMs;
+};
+
+struct FramePacer {
+	PacingMode mode;
+	double targetHz;           // LIMITER 의 목표
+	double idleHz;
+	double idleAfter;          // 이만큼 (초) 아무 것도 바뀌지 않으면 idle
+	bool idleEnabled;
+	bool tearSupported;
+	bool idle;
+	double lastActivity;
+	double deadline;           // 다음 프레임을 시작할 시각
+	double lastFrame;          // 지난 paceFrame 이 끝난 시각
+	double lastCpu;
+	double oversleep;          // 잠이 늦게 깨는 정도 (이동 평균). spin 할 시간을 정한다.
+	PacerWaitFunction wait;
+	void * waitContext;
+	PacingStats window;        // 지난 출력 이후
+	PacingStats total[PACING_MODES];
+};
+
+// 프로세스가 쓴 CPU 시간 (초, 모든 스레드)
+double processCpuSeconds();
+// steady clock (초)
+double pacerNow();
+
+void initPacer(FramePacer & p, PacingMode mode, double targetHz, bool tearSupported);
+void setPacingMode(FramePacer & p, PacingMode mode);
+// 모드에 맞는 glfwSwapInterval 값
+int pacerSwapInterval(const FramePacer & p);
+// "vsync" "adaptive" "limit" "uncapped". 모르는 이름이면 false.
+bool parsePacingMode(const char * name, PacingMode & mode);
+const char * pacingModeName(PacingMode mode);
+
+// swap 뒤에 부른다. active 는 이번 프레임에 장면이 움직였거나 입력이 있었는지.
+// 모드 (또는 idle) 에 맞게 다음 프레임 시각까지 기다리고 통계를 쌓는다.
+void paceFrame(FramePacer & p, bool active);
+
+// 통계에서 뽑은 값
+double pacingMeanMs(const PacingStats & s);
+double pacingStdDevMs(const PacingStats & s);
+double pacingCpuPercent(const PacingStats & s);   // 코어 하나 = 100
+double pacingWakeupsPerSecond(const PacingStats & s);
+// 출력한 뒤 부른다
+void resetPacingWindow(FramePacer & p);
+
+#endif
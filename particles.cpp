@@ -0,0 +1,309 @@
+#include <math.h>
+#include <stdint.h>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_SSE 1
+#endif
+
+#include <glm/glm.hpp>
+
+#include "particles.hpp"
+#include "random.hpp"
+
+static const float PARTICLE_DRAG = 1.5f;          // 초당 속도 감소 비율
+static const float PARTICLE_BOUNCE = 0.25f;       // 바닥에서 튕길 때 남는 수직 속도
+static const float PARTICLE_FULL_THRUST = 2.2f;   // 이 추력에서 방출량이 최대
+static const float PARTICLE_PAD_HEIGHT = 3.0f;    // 이보다 낮으면 먼지가 인다
+static const int PARTICLE_CHUNK = 16384;
+
+// 방출하는 입자의 종류별 비율과 평균 수명. 살아있는 수 = 방출량 * (비율 * 수명) 의 합.
+static const float PLUME_SHARE = 0.6f, PLUME_LIFE = 0.7f;
+static const float SMOKE_SHARE = 0.3f, SMOKE_LIFE = 4.0f;
+static const float DUST_SHARE = 0.1f, DUST_LIFE = 2.5f;
+
+void initParticles(ParticleSystem & ps, int capacity){
+	ps.capacity = capacity;
+	ps.count = 0;
+#ifdef PARTICLES_SSE
+	ps.simd = true;
+#else
+	ps.simd = false;
+#endif
+	std::vector<float> * floats[] = { &ps.px, &ps.py, &ps.pz, &ps.vx, &ps.vy, &ps.vz,
+		&ps.ay, &ps.size, &ps.growth, &ps.age, &ps.life };
+	for (size_t i = 0; i < sizeof(floats) / sizeof(floats[0]); i++)
+		floats[i]->assign(capacity, 0.0f);
+	ps.kind.assign(capacity, 0);
+	ps.chunkAlive.assign(capacity / PARTICLE_CHUNK + 1, 0);
+	ps.emitCarry = 0.0f;
+	ps.random = 2463534242u;
+	ps.stats = ParticleStats();
+}
+
+static void emitOne(ParticleSystem & ps, ParticleKind kind, const glm::vec3 & nozzle, const glm::vec3 & velocity){
+	int i = ps.count++;
+	uint32_t & r = ps.random;
+	float jx = nextRandom(r) * 2 - 1, jz = nextRandom(r) * 2 - 1, t = nextRandom(r);
+	if (kind == PARTICLE_PLUME) {
+		ps.px[i] = nozzle.x + jx * 0.15f;
+		ps.py[i] = nozzle.y;
+		ps.pz[i] = nozzle.z + jz * 0.15f;
+		ps.vx[i] = velocity.x + jx * 1.5f;
+		ps.vy[i] = velocity.y - (6.0f + 4.0f * t);
+		ps.vz[i] = velocity.z + jz * 1.5f;
+		ps.ay[i] = -1.2f;
+		ps.size[i] = 0.25f;
+		ps.growth[i] = 0.8f;
+		ps.life[i] = PLUME_LIFE * (0.7f + 0.6f * nextRandom(r));
+	}
+	else if (kind == PARTICLE_SMOKE) {
+		ps.px[i] = nozzle.x + jx * 0.2f;
+		ps.py[i] = nozzle.y - 0.2f;
+		ps.pz[i] = nozzle.z + jz * 0.2f;
+		ps.vx[i] = velocity.x * 0.3f + jx;
+		ps.vy[i] = velocity.y * 0.3f - (2.0f + 2.0f * t);
+		ps.vz[i] = velocity.z * 0.3f + jz;
+		ps.ay[i] = 0.6f;
+		ps.size[i] = 0.3f;
+		ps.growth[i] = 0.6f;
+		ps.life[i] = SMOKE_LIFE * (0.75f + 0.5f * nextRandom(r));
+	}
+	else {
+		// 발사대 위에서 바닥을 따라 사방으로
+		float a = t * 6.2831853f;
+		float speed = 3.0f + 3.0f * nextRandom(r);
+		ps.px[i] = nozzle.x + jx * 0.5f;
+		ps.py[i] = 0.05f;
+		ps.pz[i] = nozzle.z + jz * 0.5f;
+		ps.vx[i] = cosf(a) * speed;
+		ps.vy[i] = 0.3f * speed * nextRandom(r);
+		ps.vz[i] = sinf(a) * speed;
+		ps.ay[i] = -0.5f;
+		ps.size[i] = 0.2f;
+		ps.growth[i] = 0.5f;
+		ps.life[i] = DUST_LIFE * (0.8f + 0.4f * nextRandom(r));
+	}
+	ps.age[i] = 0.0f;
+	ps.kind[i] = (unsigned char)kind;
+}
+
+void emitExhaust(ParticleSystem & ps, const FlightState & flight, const glm::vec3 & velocity, float deltaTime){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	ps.stats.emitted = 0;
+	// 엔진 조명과 같은 조건. 발사 전에도 main 은 0 이 아니므로 sky 를 같이 본다.
+	if (flight.sky != 1 || flight.main <= 0.0f) {
+		ps.emitCarry = 0.0f;
+		ps.stats.emitMs = elapsedMs(begin);
+		return;
+	}
+	float throttle = flight.main < PARTICLE_FULL_THRUST ? flight.main / PARTICLE_FULL_THRUST : 1.0f;
+	float rate = 0.9f * ps.capacity / (PLUME_SHARE * PLUME_LIFE + SMOKE_SHARE * SMOKE_LIFE + DUST_SHARE * DUST_LIFE);
+	ps.emitCarry += rate * throttle * deltaTime;
+	int n = (int)ps.emitCarry;
+	ps.emitCarry -= n;
+	if (n > ps.capacity - ps.count)
+		n = ps.capacity - ps.count;
+	const glm::vec3 nozzle = flight.gro1 + glm::vec3(0.5f, 0.0f, 0.5f);
+	const bool nearPad = flight.start && flight.gro1.y < PARTICLE_PAD_HEIGHT;
+	for (int k = 0; k < n; k++) {
+		// 비율대로 돌아가며 (먼지 몫은 발사대에서 멀어지면 연기로)
+		int slot = k % 10;
+		ParticleKind kind = slot < 6 ? PARTICLE_PLUME : (slot < 9 || !nearPad ? PARTICLE_SMOKE : PARTICLE_DUST);
+		emitOne(ps, kind, nozzle, velocity);
+	}
+	ps.stats.emitted = n;
+	ps.stats.emitMs = elapsedMs(begin);
+}
+
+struct StepContext {
+	ParticleSystem * particles;
+	float deltaTime;
+};
+
+static void integrateScalar(ParticleSystem & ps, int begin, int end, float dt, float drag){
+	float * px = &ps.px[0], * py = &ps.py[0], * pz = &ps.pz[0];
+	float * vx = &ps.vx[0], * vy = &ps.vy[0], * vz = &ps.vz[0];
+	float * size = &ps.size[0], * age = &ps.age[0];
+	const float * ay = &ps.ay[0], * growth = &ps.growth[0];
+	for (int i = begin; i < end; i++) {
+		vx[i] *= drag;
+		vy[i] = (vy[i] + ay[i] * dt) * drag;
+		vz[i] *= drag;
+		px[i] += vx[i] * dt;
+		py[i] += vy[i] * dt;
+		pz[i] += vz[i] * dt;
+		if (py[i] < 0.0f) {
+			py[i] = 0.0f;
+			vy[i] = -vy[i] * PARTICLE_BOUNCE;
+		}
+		size[i] += growth[i] * dt;
+		age[i] += dt;
+	}
+}
+
+#ifdef PARTICLES_SSE
+// 4 개씩. 나머지는 스칼라로.
+static void integrateSse(ParticleSystem & ps, int begin, int end, float dt, float drag){
+	float * px = &ps.px[0], * py = &ps.py[0], * pz = &ps.pz[0];
+	float * vx = &ps.vx[0], * vy = &ps.vy[0], * vz = &ps.vz[0];
+	float * size = &ps.size[0], * age = &ps.age[0];
+	const float * ay = &ps.ay[0], * growth = &ps.growth[0];
+	const __m128 dt4 = _mm_set1_ps(dt);
+	const __m128 drag4 = _mm_set1_ps(drag);
+	const __m128 bounce4 = _mm_set1_ps(-PARTICLE_BOUNCE);
+	const __m128 zero = _mm_setzero_ps();
+	int i = begin;
+	for (; i + 4 <= end; i += 4) {
+		__m128 x = _mm_loadu_ps(px + i), y = _mm_loadu_ps(py + i), z = _mm_loadu_ps(pz + i);
+		__m128 u = _mm_mul_ps(_mm_loadu_ps(vx + i), drag4);
+		__m128 v = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(vy + i), _mm_mul_ps(_mm_loadu_ps(ay + i), dt4)), drag4);
+		__m128 w = _mm_mul_ps(_mm_loadu_ps(vz + i), drag4);
+		x = _mm_add_ps(x, _mm_mul_ps(u, dt4));
+		y = _mm_add_ps(y, _mm_mul_ps(v, dt4));
+		z = _mm_add_ps(z, _mm_mul_ps(w, dt4));
+		// 바닥 밑이면 바닥 위로 올리고 수직 속도를 뒤집는다
+		__m128 below = _mm_cmplt_ps(y, zero);
+		y = _mm_max_ps(y, zero);
+		v = _mm_or_ps(_mm_and_ps(below, _mm_mul_ps(v, bounce4)), _mm_andnot_ps(below, v));
+		_mm_storeu_ps(px + i, x);
+		_mm_storeu_ps(py + i, y);
+		_mm_storeu_ps(pz + i, z);
+		_mm_storeu_ps(vx + i, u);
+		_mm_storeu_ps(vy + i, v);
+		_mm_storeu_ps(vz + i, w);
+		_mm_storeu_ps(size + i, _mm_add_ps(_mm_loadu_ps(size + i), _mm_mul_ps(_mm_loadu_ps(growth + i), dt4)));
+		_mm_storeu_ps(age + i, _mm_add_ps(_mm_loadu_ps(age + i), dt4));
+	}
+	integrateScalar(ps, i, end, dt, drag);
+}
+#endif
+
+static inline void moveParticle(ParticleSystem & ps, int to, int from){
+	ps.px[to] = ps.px[from];
+	ps.py[to] = ps.py[from];
+	ps.pz[to] = ps.pz[from];
+	ps.vx[to] = ps.vx[from];
+	ps.vy[to] = ps.vy[from];
+	ps.vz[to] = ps.vz[from];
+	ps.ay[to] = ps.ay[from];
+	ps.size[to] = ps.size[from];
+	ps.growth[to] = ps.growth[from];
+	ps.age[to] = ps.age[from];
+	ps.life[to] = ps.life[from];
+	ps.kind[to] = ps.kind[from];
+}
+
+static void updateChunk(void * context, int begin, int end){
+	StepContext * c = (StepContext *)context;
+	ParticleSystem & ps = *c->particles;
+	const float dt = c->deltaTime;
+	const float drag = 1.0f / (1.0f + PARTICLE_DRAG * dt);
+#ifdef PARTICLES_SSE
+	if (ps.simd)
+		integrateSse(ps, begin, end, dt, drag);
+	else
+#endif
+		integrateScalar(ps, begin, end, dt, drag);
+	// 죽은 자리는 청크의 마지막 입자로 채운다 (순서는 상관없다). 옮긴 것도 죽었을 수 있으니 다시 본다.
+	const float * age = &ps.age[0], * life = &ps.life[0];
+	int alive = end;
+	for (int i = begin; i < alive; ) {
+		if (age[i] < life[i]) {
+			i++;
+			continue;
+		}
+		alive--;
+		if (i != alive)
+			moveParticle(ps, i, alive);
+	}
+	ps.chunkAlive[begin / PARTICLE_CHUNK] = alive - begin;
+}
+
+void stepParticles(ParticleSystem & ps, float deltaTime, JobSystem * jobs){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	StepContext context = { &ps, deltaTime };
+	runChunked(jobs, ps.count, PARTICLE_CHUNK, updateChunk, &context);
+	ps.stats.updateMs = elapsedMs(begin);
+
+	// 청크마다 뒤쪽에 생긴 구멍 중 live 앞에 있는 것을, live 뒤에 남은 살아있는 입자로 채운다.
+	// 둘의 수는 같으므로 죽은 수만큼만 옮긴다.
+	begin = std::chrono::steady_clock::now();
+	const int chunks = (ps.count + PARTICLE_CHUNK - 1) / PARTICLE_CHUNK;
+	int live = 0;
+	for (int c = 0; c < chunks; c++)
+		live += ps.chunkAlive[c];
+	int hole = 0;
+	int holeIndex = chunks > 0 ? ps.chunkAlive[0] : 0;
+	int source = chunks - 1;
+	int sourceIndex = chunks > 0 ? source * PARTICLE_CHUNK + ps.chunkAlive[source] - 1 : -1;
+	for (;;) {
+		while (hole < chunks && holeIndex >= std::min((hole + 1) * PARTICLE_CHUNK, ps.count)) {
+			hole++;
+			if (hole < chunks)
+				holeIndex = hole * PARTICLE_CHUNK + ps.chunkAlive[hole];
+		}
+		if (hole >= chunks || holeIndex >= live)
+			break;
+		while (source >= 0 && sourceIndex < source * PARTICLE_CHUNK) {
+			source--;
+			if (source >= 0)
+				sourceIndex = source * PARTICLE_CHUNK + ps.chunkAlive[source] - 1;
+		}
+		if (sourceIndex <= holeIndex)
+			break;
+		moveParticle(ps, holeIndex++, sourceIndex--);
+	}
+	ps.stats.removed = ps.count - live;
+	ps.count = live;
+	ps.stats.live = live;
+	ps.stats.compactMs = elapsedMs(begin);
+}
+
+struct InstanceContext {
+	ParticleSystem * particles;
+	float * out;
+};
+
+// 종류별 색 = (start + change * t) * (1 - t), 알파 = alpha * (1 - t). 미리 알파를 곱해 둔 값이다.
+// 불꽃은 노랑에서 주황으로 식고 알파가 0 이라 더해진다. 분기 없이 표에서 읽는다.
+static const float PARTICLE_COLORS[3][7] = {
+	{ 1.0f, 0.9f, 0.5f, 0.0f, -0.6f, -0.45f, 0.0f },                // 불꽃
+	{ 0.175f, 0.175f, 0.175f, 0.0f, 0.0f, 0.0f, 0.35f },            // 연기
+	{ 0.22f, 0.18f, 0.14f, 0.0f, 0.0f, 0.0f, 0.4f },                // 먼지
+};
+
+static inline void particleColor(unsigned char kind, float t, float * rgba){
+	const float * c = PARTICLE_COLORS[kind];
+	float fade = 1.0f - t;
+	rgba[0] = (c[0] + c[3] * t) * fade;
+	rgba[1] = (c[1] + c[4] * t) * fade;
+	rgba[2] = (c[2] + c[5] * t) * fade;
+	rgba[3] = c[6] * fade;
+}
+
+static void writeInstances(void * context, int begin, int end){
+	InstanceContext * c = (InstanceContext *)context;
+	const ParticleSystem & ps = *c->particles;
+	int i = begin;
+	for (; i < end; i++) {
+		float * out = c->out + (size_t)i * PARTICLE_INSTANCE_FLOATS;
+		out[0] = ps.px[i];
+		out[1] = ps.py[i];
+		out[2] = ps.pz[i];
+		out[3] = ps.size[i];
+		particleColor(ps.kind[i], ps.age[i] / ps.life[i], out + 4);
+	}
+}
+
+int writeParticleInstances(ParticleSystem & ps, float * out, int maxCount, JobSystem * jobs){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	int count = ps.count < maxCount ? ps.count : maxCount;
+	InstanceContext context = { &ps, out };
+	runChunked(jobs, count, PARTICLE_CHUNK, writeInstances, &context);
+	ps.stats.instanceMs = elapsedMs(begin);
+	return count;
+}
@@ -0,0 +1,66 @@
+#ifndef PARTICLES_HPP
+#define PARTICLES_HPP
+
+#include <stdint.h>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "jobs.hpp"
+#include "flight.hpp"
+
+// 엔진 배기 불꽃, 연기, 발사대 먼지 입자.
+// 데이터는 SoA 로 앞쪽 count 개에 빽빽하게 두고, 갱신은 SSE 로 4 개씩 (없으면 스칼라) 청크마다 잡으로 나눈다.
+// 죽은 입자는 청크 안에서 먼저 청크 끝의 입자와 바꾸고 (병렬), 남은 구멍은 맨 뒤의 입자로 채운다 (죽은 수만큼만 옮김).
+// 모든 배열은 initParticles 에서 capacity 만큼 잡아 두고 루프 안에서는 힙을 쓰지 않는다.
+enum ParticleKind {
+	PARTICLE_PLUME = 0,     // 배기 불꽃 (가산 혼합)
+	PARTICLE_SMOKE = 1,     // 연기 (올라가며 커진다)
+	PARTICLE_DUST = 2       // 발사대 먼지 (바닥을 따라 퍼진다)
+};
+
+// 인스턴스 하나 = vec4 (위치, 크기) + vec4 (미리 알파를 곱한 색, 알파). 알파가 0 이면 가산 혼합이 된다.
+#define PARTICLE_INSTANCE_FLOATS 8
+
+struct ParticleStats {
+	int live;
+	int emitted;            // 지난 emitExhaust 에서 만든 수
+	int removed;            // 지난 stepParticles 에서 지운 수
+	double emitMs;
+	double updateMs;        // 적분 + 청크 안 정리 (병렬)
+	double compactMs;       // 청크 사이 구멍 메우기
+	double instanceMs;      // 인스턴스 데이터 쓰기 (병렬)
+};
+
+struct ParticleSystem {
+	int capacity;
+	int count;
+	bool simd;                             // false 면 스칼라로 갱신 (비교용)
+
+	std::vector<float> px, py, pz;         // 위치
+	std::vector<float> vx, vy, vz;         // 속도
+	std::vector<float> ay;                 // 위 방향 가속도 (중력 + 부력)
+	std::vector<float> size, growth;       // 크기, 초당 커지는 양
+	std::vector<float> age, life;
+	std::vector<unsigned char> kind;
+
+	std::vector<int> chunkAlive;           // 청크마다 살아남은 수
+	float emitCarry;                       // 소수점 아래로 남은 방출 수
+	uint32_t random;
+	ParticleStats stats;
+};
+
+void initParticles(ParticleSystem & ps, int capacity);
+
+// 추력 상태에 따라 deltaTime 동안의 입자를 만든다. 발사 뒤 엔진이 켜져 있으면 (sky == 1, main > 0) 불꽃과 연기,
+// 발사대 가까이 (start 이고 낮은 곳) 에서는 먼지도. velocity 는 로켓의 월드 속도.
+// 추력이 최대일 때 살아있는 입자가 capacity 의 90% 정도에서 유지되도록 방출량을 정한다.
+void emitExhaust(ParticleSystem & ps, const FlightState & flight, const glm::vec3 & velocity, float deltaTime);
+
+// 한 틱 진행하고 수명이 다한 입자를 지운다. jobs 가 NULL 이면 한 스레드로 한다.
+void stepParticles(ParticleSystem & ps, float deltaTime, JobSystem * jobs);
+
+// 살아있는 입자 모두의 인스턴스 데이터를 out 에 쓴다 (최대 maxCount 개). 쓴 개수를 돌려준다.
+int writeParticleInstances(ParticleSystem & ps, float * out, int maxCount, JobSystem * jobs);
+
+#endif
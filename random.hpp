@@ -0,0 +1,15 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+#include <stdint.h>
+
+// [0, 1) xorshift32. state 는 0 이 아니어야 한다.
+// 입자, 잔해, 조명처럼 시드로 같은 결과를 다시 만들어야 하는 곳에서 쓴다.
+static inline float nextRandom(uint32_t & state){
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return (state >> 8) * (1.0f / 16777216.0f);
+}
+
+#endif
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+
+#include <GL/glew.h>
+
+#include "resolution.hpp"
+
+#define RESOLUTION_MAX_DOWN 0.7f      // 한 번에 줄이는 최대 (배율에 곱한다)
+#define RESOLUTION_MAX_UP 1.02f       // 한 번에 올리는 최대
+
+static inline float clampf(float x, float lo, float hi){
+	return x < lo ? lo : x > hi ? hi : x;
+}
+
+void initResolutionController(ResolutionController & c, float targetMs, int maxSamples, bool enabled){
+	c.enabled = enabled;
+	c.targetMs = targetMs;
+	c.headroom = 0.85f;
+	c.minScale = 0.5f;
+	c.maxScale = 1.0f;
+	c.scale = 1.0f;
+	c.samples = maxSamples;
+	c.maxSamples = maxSamples;
+	c.upDelay = 30;
+	c.calmCount = 0;
+	c.overCount = 0;
+	c.smoothedMs = 0.0f;
+	c.lastMs = 0.0f;
+	resetResolutionWindow(c);
+}
+
+bool updateResolution(ResolutionController & c, float gpuMs, float measuredScale, int measuredSamples){
+	c.lastMs = gpuMs;
+	if (!c.enabled)
+		return false;
+	// 샘플 수를 바꾸기 전의 측정은 어림할 수 없으므로 버린다
+	if (measuredSamples != c.samples)
+		return false;
+	// 지금 배율이었다면 걸렸을 시간
+	float ratio = c.scale / measuredScale;
+	float predicted = gpuMs * ratio * ratio;
+	c.smoothedMs = c.smoothedMs <= 0.0f ? predicted : c.smoothedMs + (predicted - c.smoothedMs) * 0.2f;
+
+	// 넘으면 튀는 한 번이라도 바로 줄인다. 목표보다 조금 아래 (headroom) 를 겨냥한다.
+	if (predicted > c.targetMs) {
+		c.calmCount = 0;
+		c.smoothedMs = predicted;
+		if (c.scale > c.minScale) {
+			float factor = sqrtf(c.targetMs * c.headroom / predicted);
+			c.scale = clampf(c.scale * (factor < RESOLUTION_MAX_DOWN ? RESOLUTION_MAX_DOWN : factor), c.minScale, c.maxScale);
+			return false;
+		}
+		// 가장 작은 배율로도 모자라면 샘플을 줄인다 (4 -> 2 -> 0)
+		if (c.samples > 0 && ++c.overCount >= c.upDelay / 4) {
+			c.samples = c.samples > 2 ? c.samples / 2 : 0;
+			c.overCount = 0;
+			c.smoothedMs = 0.0f;
+			c.window.changes++;
+			return true;
+		}
+		return false;
+	}
+	c.overCount = 0;
+	if (c.smoothedMs >= c.targetMs * c.headroom) {
+		c.calmCount = 0;
+		return false;
+	}
+	// 여유가 한동안 이어질 때만 천천히 올린다 (오르내림을 막는다)
+	if (++c.calmCount < c.upDelay)
+		return false;
+	if (c.scale < c.maxScale) {
+		float factor = sqrtf(c.targetMs * c.headroom / c.smoothedMs);
+		c.scale = clampf(c.scale * (factor > RESOLUTION_MAX_UP ? RESOLUTION_MAX_UP : factor), c.minScale, c.maxScale);
+		return false;
+	}
+	// 가장 큰 배율에서 목표의 절반도 안 쓰면 샘플을 다시 늘린다
+	if (c.samples < c.maxSamples && c.smoothedMs < c.targetMs * 0.5f) {
+		c.samples = c.samples == 0 ? 2 : c.samples * 2;
+		if (c.samples > c.maxSamples)
+			c.samples = c.maxSamples;
+		c.calmCount = 0;
+		c.smoothedMs = 0.0f;
+		c.window.changes++;
+		return true;
+	}
+	return false;
+}
+
+void recordResolutionFrame(ResolutionController & c, float gpuMs){
+	ResolutionStats & s = c.window;
+	s.frames++;
+	if (gpuMs > c.targetMs)
+		s.overBudget++;
+	s.sumScale += c.scale;
+	if (c.scale < s.minScale)
+		s.minScale = c.scale;
+	if (c.scale > s.maxScale)
+		s.maxScale = c.scale;
+	if (gpuMs > s.maxMs)
+		s.maxMs = gpuMs;
+}
+
+void resetResolutionWindow(ResolutionController & c){
+	memset(&c.window, 0, sizeof(c.window));
+	c.window.minScale = c.scale;
+	c.window.maxScale = c.scale;
+}
+
+float syntheticLoad(double seconds, double rampSeconds){
+	if (rampSeconds <= 0.0)
+		return 0.0f;
+	double phase = fmod(seconds / rampSeconds, 2.0);
+	return (float)(phase < 1.0 ? phase : 2.0 - phase);
+}
+
+void initSceneTarget(SceneTarget & t){
+	memset(&t, 0, sizeof(t));
+	t.renderScale = 1.0f;
+	t.gpuScale = 1.0f;
+	glGenQueries(RESOLUTION_QUERY_FRAMES * 2, &t.queries[0][0]);
+}
+
+static void deleteTargetObjects(SceneTarget & t){
+	if (t.framebuffer != 0) {
+		glDeleteFramebuffers(1, &t.framebuffer);
+		glDeleteFramebuffers(1, &t.resolveFramebuffer);
+		glDeleteTextures(1, &t.resolveTexture);
+		glDeleteRenderbuffers(1, &t.depth);
+		if (t.color != 0)
+			glDeleteRenderbuffers(1, &t.color);
+	}
+	t.framebuffer = t.resolveFramebuffer = t.resolveTexture = t.depth = t.color = 0;
+}
+
+bool resizeSceneTarget(SceneTarget & t, int width, int height, int samples){
+	// 창이 최소화되면 (0 x 0) 있던 것을 그대로 쓴다
+	if (width <= 0 || height <= 0 || (t.framebuffer != 0 && t.width == width && t.height == height && t.samples == samples))
+		return false;
+	deleteTargetObjects(t);
+	t.width = width;
+	t.height = height;
+	t.samples = samples;
+
+	glGenTextures(1, &t.resolveTexture);
+	glBindTexture(GL_TEXTURE_2D, t.resolveTexture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glGenFramebuffers(1, &t.resolveFramebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, t.resolveFramebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, t.resolveTexture, 0);
+
+	// 샘플이 없으면 풀 것도 없으므로 텍스처에 바로 그린다
+	glGenRenderbuffers(1, &t.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, t.depth);
+	glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+	glGenFramebuffers(1, &t.framebuffer);
+	glBindFramebuffer(GL_FRAMEBUFFER, t.framebuffer);
+	if (samples > 0) {
+		glGenRenderbuffers(1, &t.color);
+		glBindRenderbuffer(GL_RENDERBUFFER, t.color);
+		glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+		glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, t.color);
+	}
+	else
+		glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, t.resolveTexture, 0);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, t.depth);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	if (status != GL_FRAMEBUFFER_COMPLETE)
+		fprintf(stderr, "Scene target %dx%d (%d samples) incomplete : 0x%x\n", width, height, samples, status);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	return true;
+}
+
+GLsizeiptr sceneTargetBytes(const SceneTarget & t){
+	GLsizeiptr pixels = (GLsizeiptr)t.width * t.height;
+	int samples = t.samples > 0 ? t.samples : 1;
+	return pixels * 4 + pixels * 4 * samples + (t.color != 0 ? pixels * 4 * samples : 0);
+}
+
+void beginSceneTarget(SceneTarget & t, float scale){
+	// 돌려 쓸 차례의 쿼리가 끝났으면 읽는다. 기다리지 않는다.
+	int q = t.queryIndex;
+	t.timed = false;
+	if (t.queryPending[q]) {
+		GLint available = 0;
+		glGetQueryObjectiv(t.queries[q][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			GLuint64 begin = 0, end = 0;
+			glGetQueryObjectui64v(t.queries[q][0], GL_QUERY_RESULT, &begin);
+			glGetQueryObjectui64v(t.queries[q][1], GL_QUERY_RESULT, &end);
+			t.gpuMs = (float)((end - begin) / 1e6);
+			t.gpuScale = t.queryScale[q];
+			t.gpuSamples = t.querySamples[q];
+			t.timed = true;
+		}
+		else
+			t.dropped++;
+		t.queryPending[q] = false;
+	}
+	t.renderScale = scale;
+	t.renderWidth = (int)(t.width * scale + 0.5f);
+	t.renderHeight = (int)(t.height * scale + 0.5f);
+	if (t.renderWidth < 1)
+		t.renderWidth = 1;
+	if (t.renderHeight < 1)
+		t.renderHeight = 1;
+	glQueryCounter(t.queries[q][0], GL_TIMESTAMP);
+	glBindFramebuffer(GL_FRAMEBUFFER, t.framebuffer);
+	glViewport(0, 0, t.renderWidth, t.renderHeight);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+void setLoadProgram(SceneTarget & t, GLuint program){
+	t.loadProgram = program;
+	t.iterationsID = glGetUniformLocation(program, "iterations");
+}
+
+void setUpscaleProgram(SceneTarget & t, GLuint program){
+	t.upscaleProgram = program;
+	t.sceneTextureID = glGetUniformLocation(program, "sceneTexture");
+	t.uvScaleID = glGetUniformLocation(program, "uvScale");
+	t.texelSizeID = glGetUniformLocation(program, "texelSize");
+	t.sharpnessID = glGetUniformLocation(program, "sharpness");
+}
+
+void drawSyntheticLoad(const SceneTarget & t, int iterations){
+	if (t.loadProgram == 0 || iterations <= 0)
+		return;
+	glUseProgram(t.loadProgram);
+	glUniform1i(t.iterationsID, iterations);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE);
+	glDrawArrays(GL_TRIANGLES, 0, 3);
+	glDisable(GL_BLEND);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+}
+
+void resolveSceneTarget(SceneTarget & t, int windowWidth, int windowHeight, float sharpness){
+	// MSAA 는 크기를 바꾸면서 풀 수 없으므로 같은 크기로 풀고 늘리는 것은 따로
+	if (t.color != 0) {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, t.framebuffer);
+		glBindFramebuffer(GL_DRAW_FRAMEBUFFER, t.resolveFramebuffer);
+		glBlitFramebuffer(0, 0, t.renderWidth, t.renderHeight, 0, 0, t.renderWidth, t.renderHeight, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, windowWidth, windowHeight);
+	if (t.upscaleProgram != 0) {
+		glUseProgram(t.upscaleProgram);
+		glActiveTexture(GL_TEXTURE0);
+		glBindTexture(GL_TEXTURE_2D, t.resolveTexture);
+		glUniform1i(t.sceneTextureID, 0);
+		glUniform2f(t.uvScaleID, (float)t.renderWidth / t.width, (float)t.renderHeight / t.height);
+		glUniform2f(t.texelSizeID, 1.0f / t.width, 1.0f / t.height);
+		// 원래 크기면 선명하게 할 것이 없다
+		glUniform1f(t.sharpnessID, t.renderScale < 1.0f ? sharpness * (1.0f - t.renderScale) * 2.0f : 0.0f);
+		glDisable(GL_DEPTH_TEST);
+		glDrawArrays(GL_TRIANGLES, 0, 3);
+		glEnable(GL_DEPTH_TEST);
+	}
+	else {
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, t.resolveFramebuffer);
+		glBlitFramebuffer(0, 0, t.renderWidth, t.renderHeight, 0, 0, windowWidth, windowHeight, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+		glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+	}
+	int q = t.queryIndex;
+	glQueryCounter(t.queries[q][1], GL_TIMESTAMP);
+	t.queryScale[q] = t.renderScale;
+	t.querySamples[q] = t.samples;
+	t.queryPending[q] = true;
+	t.queryIndex = (q + 1) % RESOLUTION_QUERY_FRAMES;
+}
+
+void freeSceneTarget(SceneTarget & t){
+	deleteTargetObjects(t);
+	glDeleteQueries(RESOLUTION_QUERY_FRAMES * 2, &t.queries[0][0]);
+	memset(t.queries, 0, sizeof(t.queries));
+}
+
+void writeResolutionHeader(FILE * log){
+	if (log != NULL)
+		fprintf(log, "frame,time_s,load,cpu_ms,gpu_ms,measured_scale,target_ms,scale,samples,width,height\n");
+}
+
+void writeResolutionFrame(FILE * log, uint64_t frame, double seconds, float load, float cpuMs,
+	const ResolutionController & c, const SceneTarget & t){
+	if (log == NULL)
+		return;
+	// gpu_ms 는 몇 프레임 전 (measured_scale 로 그린 프레임) 의 측정. 이번에 새로 온 것이 없으면 비운다.
+	if (t.timed)
+		fprintf(log, "%llu,%.4f,%.3f,%.3f,%.3f,%.3f,%.2f,%.3f,%d,%d,%d\n", (unsigned long long)frame, seconds, load, cpuMs,
+			t.gpuMs, t.gpuScale, c.targetMs, t.renderScale, t.samples, t.renderWidth, t.renderHeight);
+	else
+		fprintf(log, "%llu,%.4f,%.3f,%.3f,,,%.2f,%.3f,%d,%d,%d\n", (unsigned long long)frame, seconds, load, cpuMs,
+			c.targetMs, t.renderScale, t.samples, t.renderWidth, t.renderHeight);
+}
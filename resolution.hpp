@@ -0,0 +1,111 @@
+#ifndef RESOLUTION_HPP
+#define RESOLUTION_HPP
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include <GL/glew.h>
+
+// 동적 해상도.
+// 장면은 창 크기로 잡아 둔 오프스크린 대상 (색/깊이 렌더버퍼, MSAA) 의 왼쪽 아래 일부 (배율 scale) 에 그리고,
+// MSAA 를 풀어서 (blit) 창 크기로 늘려 그린다 (UpscaleFragmentShader : 쌍선형 + 줄인 만큼 선명하게).
+// 배율이 바뀌어도 대상은 그대로 두고 뷰포트만 바꾼다. 샘플 수나 창 크기가 바뀔 때만 다시 만든다.
+// HUD 는 업스케일 뒤에 창 해상도로 그린다.
+//
+// 조절기는 GPU 타임스탬프로 잰 장면 + 업스케일 시간 (몇 프레임 늦게 온다) 을 목표와 비교한다.
+// 잰 프레임의 배율로 지금 배율에서의 시간을 어림하고 (픽셀 수, 곧 배율의 제곱에 비례한다고 본다)
+//  - 목표를 넘으면 바로 줄이고,
+//  - 목표 * headroom 아래로 upDelay 번 계속 있으면 조금씩 올린다.
+//  - 가장 작은 배율에서도 넘으면 MSAA 샘플을 반으로, 가장 큰 배율에서 여유가 많으면 다시 올린다.
+// CPU 가 늦는 것은 해상도로 고칠 수 없으므로 조절에 쓰지 않고 기록만 한다.
+#define RESOLUTION_QUERY_FRAMES 4     // 타임스탬프 쌍. 결과를 기다리지 않게 돌려 쓴다.
+
+struct ResolutionStats {
+	int frames;
+	int overBudget;                   // 잰 GPU 시간이 목표를 넘은 프레임
+	int changes;                      // 샘플 수를 바꾼 횟수
+	double sumScale;
+	float minScale;
+	float maxScale;
+	float maxMs;
+};
+
+struct ResolutionController {
+	bool enabled;                     // 꺼져 있으면 배율 1, 샘플 maxSamples 로 고정
+	float targetMs;                   // GPU 프레임 시간 목표
+	float headroom;                   // 이 비율 아래여야 올린다
+	float minScale;
+	float maxScale;
+	float scale;                      // 가로, 세로 각각에 곱한다
+	int samples;                      // 지금 MSAA 샘플 수 (0 이면 없음)
+	int maxSamples;
+	int upDelay;                      // 올리기 전에 여유 있게 지나야 하는 측정 수
+	int calmCount;
+	int overCount;                    // 가장 작은 배율에서 넘은 측정 수
+	float smoothedMs;                 // 지금 배율로 어림한 시간의 이동 평균
+	float lastMs;                     // 마지막으로 받은 측정
+	ResolutionStats window;           // 지난 출력 이후
+};
+
+// GPU 쪽. 그릴 대상과 타이머.
+struct SceneTarget {
+	GLuint framebuffer;               // 장면을 그리는 곳
+	GLuint color;                     // MSAA 렌더버퍼 (샘플이 없으면 0 이고 resolveTexture 에 바로 그린다)
+	GLuint depth;
+	GLuint resolveFramebuffer;
+	GLuint resolveTexture;            // 업스케일이 읽는다
+	int width, height;                // 잡아 둔 크기 (창)
+	int samples;
+	int renderWidth, renderHeight;    // 이번 프레임에 그리는 크기
+	float renderScale;
+	GLuint queries[RESOLUTION_QUERY_FRAMES][2];
+	float queryScale[RESOLUTION_QUERY_FRAMES];
+	int querySamples[RESOLUTION_QUERY_FRAMES];
+	bool queryPending[RESOLUTION_QUERY_FRAMES];
+	int queryIndex;
+	bool timed;                       // 이번 프레임에 새 측정을 읽었다
+	float gpuMs;                      // 그 측정
+	float gpuScale;                   // 그 측정의 배율과 샘플 수
+	int gpuSamples;
+	int dropped;                      // 결과가 아직 없어서 버린 측정
+	// 부하와 업스케일 프로그램 (없으면 0). 링크한 뒤 setLoadProgram / setUpscaleProgram 으로 넣고 uniform 위치를 찾아 둔다.
+	GLuint loadProgram;
+	GLint iterationsID;
+	GLuint upscaleProgram;
+	GLint sceneTextureID;
+	GLint uvScaleID;
+	GLint texelSizeID;
+	GLint sharpnessID;
+};
+
+void initResolutionController(ResolutionController & c, float targetMs, int maxSamples, bool enabled);
+// 새 측정 하나. measuredScale/measuredSamples 는 그 프레임의 것. 샘플 수를 바꿨으면 true (대상을 다시 만든다).
+bool updateResolution(ResolutionController & c, float gpuMs, float measuredScale, int measuredSamples);
+// 매 프레임. 출력 창의 통계에 더한다.
+void recordResolutionFrame(ResolutionController & c, float gpuMs);
+void resetResolutionWindow(ResolutionController & c);
+
+// 시험용 부하의 세기 (0 ~ 1). rampSeconds 동안 올라갔다가 같은 시간 동안 내려온다. rampSeconds 가 0 이면 0.
+float syntheticLoad(double seconds, double rampSeconds);
+
+void initSceneTarget(SceneTarget & t);
+// 크기나 샘플 수가 다르면 다시 만든다. 다시 만들었으면 true.
+bool resizeSceneTarget(SceneTarget & t, int width, int height, int samples);
+// 대상이 GPU 에 잡은 바이트 수
+GLsizeiptr sceneTargetBytes(const SceneTarget & t);
+// 대상을 묶고 배율에 맞는 뷰포트를 잡고 지운다. 지난 측정이 왔으면 읽어서 timed 를 세운다.
+void beginSceneTarget(SceneTarget & t, float scale);
+// 부하를 그린다 (iterations 가 0 이면 안 그린다). 그림은 바뀌지 않는다. beginSceneTarget 뒤에.
+void drawSyntheticLoad(const SceneTarget & t, int iterations);
+// MSAA 를 풀고 기본 프레임버퍼에 창 크기로 늘려 그린다. 업스케일 프로그램이 아직 없으면 쌍선형 blit 으로.
+void resolveSceneTarget(SceneTarget & t, int windowWidth, int windowHeight, float sharpness);
+void setLoadProgram(SceneTarget & t, GLuint program);
+void setUpscaleProgram(SceneTarget & t, GLuint program);
+void freeSceneTarget(SceneTarget & t);
+
+// 프레임마다 한 줄 (CSV, 이번 프레임에 그린 배율과 크기). 파일이 NULL 이면 아무 것도 안 한다.
+void writeResolutionHeader(FILE * log);
+void writeResolutionFrame(FILE * log, uint64_t frame, double seconds, float load, float cpuMs,
+	const ResolutionController & c, const SceneTarget & t);
+
+#endif
@@ -0,0 +1,126 @@
+#include <vector>
+#include <math.h>
+
+#include <glm/glm.hpp>
+
+#include "scene.hpp"
+
+void initSceneGraph(SceneGraph & g, int capacity){
+	g.parent.reserve(capacity);
+	g.local.reserve(capacity);
+	g.world.reserve(capacity);
+	g.dirty.reserve(capacity);
+	g.updated = 0;
+}
+
+int addSceneNode(SceneGraph & g, int parent, const glm::mat4 & local){
+	int node = (int)g.parent.size();
+	g.parent.push_back(parent < node ? parent : -1);
+	g.local.push_back(local);
+	g.world.push_back(local);
+	g.dirty.push_back(1);
+	return node;
+}
+
+void setLocalTransform(SceneGraph & g, int node, const glm::mat4 & local){
+	g.local[node] = local;
+	g.dirty[node] = 1;
+}
+
+void detachSceneNode(SceneGraph & g, int node){
+	if (g.parent[node] < 0)
+		return;
+	// world 가 최신이어야 하므로 먼저 갱신한다
+	updateWorldTransforms(g);
+	g.parent[node] = -1;
+	g.local[node] = g.world[node];
+	g.dirty[node] = 1;
+}
+
+void updateWorldTransforms(SceneGraph & g){
+	const int count = (int)g.parent.size();
+	int updated = 0;
+	for (int i = 0; i < count; i++) {
+		int p = g.parent[i];
+		if (p >= 0 && g.dirty[p])
+			g.dirty[i] = 2;   // 부모 때문에 바뀜. 자손에게도 전해진다
+		if (g.dirty[i] == 0)
+			continue;
+		g.world[i] = p >= 0 ? g.world[p] * g.local[i] : g.local[i];
+		updated++;
+	}
+	// 부모 표시를 다 보고 난 뒤에 지운다
+	for (int i = 0; i < count; i++)
+		g.dirty[i] = 0;
+	g.updated = updated;
+}
+
+void computeSceneMVP(const SceneGraph & g, const glm::mat4 & VP, glm::mat4 * out){
+	const int count = (int)g.world.size();
+	for (int i = 0; i < count; i++)
+		out[i] = VP * g.world[i];
+}
+
+void extractFrustum(const glm::mat4 & VP, Frustum & f){
+	// Gribb-Hartmann : 평면 = 네번째 행 +- 각 행
+	glm::vec4 row[4];
+	for (int r = 0; r < 4; r++)
+		row[r] = glm::vec4(VP[0][r], VP[1][r], VP[2][r], VP[3][r]);
+	f.planes[0] = row[3] + row[0];  // 왼쪽
+	f.planes[1] = row[3] - row[0];  // 오른쪽
+	f.planes[2] = row[3] + row[1];  // 아래
+	f.planes[3] = row[3] - row[1];  // 위
+	f.planes[4] = row[3] + row[2];  // 가까운
+	f.planes[5] = row[3] - row[2];  // 먼
+	for (int i = 0; i < 6; i++)
+		f.planes[i] /= glm::length(glm::vec3(f.planes[i]));
+}
+
+bool boxInFrustum(const Frustum & f, const glm::vec3 & min, const glm::vec3 & max){
+	for (int i = 0; i < 6; i++) {
+		const glm::vec4 & p = f.planes[i];
+		// 평면 법선 쪽으로 가장 나간 꼭지점이 바깥이면 상자 전체가 바깥
+		glm::vec3 v(p.x >= 0.0f ? max.x : min.x, p.y >= 0.0f ? max.y : min.y, p.z >= 0.0f ? max.z : min.z);
+		if (p.x * v.x + p.y * v.y + p.z * v.z + p.w < 0.0f)
+			return false;
+	}
+	return true;
+}
+
+bool sphereInFrustum(const Frustum & f, const glm::vec3 & center, float radius){
+	for (int i = 0; i < 6; i++) {
+		const glm::vec4 & p = f.planes[i];
+		if (p.x * center.x + p.y * center.y + p.z * center.z + p.w < -radius)
+			return false;
+	}
+	return true;
+}
+
+int cullSceneNodes(const SceneGraph & g, const glm::vec3 * localMin, const glm::vec3 * localMax,
+	const Frustum & f, unsigned char * visible){
+	return cullSceneNodesViews(g, localMin, localMax, &f, 1, visible);
+}
+
+int cullSceneNodesViews(const SceneGraph & g, const glm::vec3 * localMin, const glm::vec3 * localMax,
+	const Frustum * frusta, int frustumCount, unsigned char * viewMask){
+	const int count = (int)g.world.size();
+	int shown = 0;
+	for (int i = 0; i < count; i++) {
+		viewMask[i] = 0;
+		if (localMin[i].x > localMax[i].x)
+			continue;
+		// 중심과 반지름으로 옮긴 뒤 회전된 축의 절댓값으로 월드 AABB 를 만든다. 뷰마다 다시 구하지 않는다.
+		const glm::mat4 & m = g.world[i];
+		glm::vec3 center = (localMin[i] + localMax[i]) * 0.5f;
+		glm::vec3 extent = (localMax[i] - localMin[i]) * 0.5f;
+		glm::vec3 worldCenter = glm::vec3(m * glm::vec4(center, 1.0f));
+		glm::vec3 worldExtent;
+		for (int k = 0; k < 3; k++)
+			worldExtent[k] = fabsf(m[0][k]) * extent.x + fabsf(m[1][k]) * extent.y + fabsf(m[2][k]) * extent.z;
+		for (int v = 0; v < frustumCount; v++)
+			if (boxInFrustum(frusta[v], worldCenter - worldExtent, worldCenter + worldExtent))
+				viewMask[i] |= (unsigned char)(1 << v);
+		shown += viewMask[i] != 0 ? 1 : 0;
+	}
+	return shown;
+}
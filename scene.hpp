@@ -0,0 +1,57 @@
+#ifndef SCENE_HPP
+#define SCENE_HPP
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// 계층 변환을 가진 장면 그래프.
+// 노드는 부모가 항상 자식보다 앞에 오도록 (위상 순서) 평평한 배열에 저장한다.
+// 그래서 앞에서부터 한번만 훑으면 부모의 world 행렬이 먼저 계산되어 있다.
+// local 이 바뀐 노드와 그 자손만 world 를 다시 계산한다.
+struct SceneGraph {
+	std::vector<int> parent;            // 루트면 -1
+	std::vector<glm::mat4> local;       // 부모 기준 변환
+	std::vector<glm::mat4> world;       // 월드 변환
+	std::vector<unsigned char> dirty;   // local 이 바뀌어서 world 를 다시 계산해야 함
+	int updated;                        // 지난 updateWorldTransforms 에서 다시 계산한 노드 수
+};
+
+void initSceneGraph(SceneGraph & g, int capacity);
+
+// 노드를 추가하고 번호를 돌려준다. 부모는 이미 추가된 노드여야 한다 (-1 이면 루트).
+int addSceneNode(SceneGraph & g, int parent, const glm::mat4 & local);
+
+void setLocalTransform(SceneGraph & g, int node, const glm::mat4 & local);
+
+// 노드를 부모에서 떼어내 루트로 만든다. 지금 월드 위치는 그대로 유지한다.
+// (단 분리, 낙하산 분리 등)
+void detachSceneNode(SceneGraph & g, int node);
+
+// dirty 인 노드와 그 자손의 world 를 다시 계산한다.
+void updateWorldTransforms(SceneGraph & g);
+
+// 모든 노드의 MVP = VP * world 를 out 에 채운다.
+void computeSceneMVP(const SceneGraph & g, const glm::mat4 & VP, glm::mat4 * out);
+
+// 시야 절두체. 평면 (a,b,c,d) 는 안쪽이 a*x + b*y + c*z + d >= 0 (정규화되어 있음).
+struct Frustum {
+	glm::vec4 planes[6];
+};
+
+// VP 행렬에서 절두체 여섯 평면을 뽑는다 (월드 좌표)
+void extractFrustum(const glm::mat4 & VP, Frustum & f);
+bool boxInFrustum(const Frustum & f, const glm::vec3 & min, const glm::vec3 & max);
+bool sphereInFrustum(const Frustum & f, const glm::vec3 & center, float radius);
+
+// 노드마다 로컬 AABB (localMin, localMax) 를 world 로 옮겨 절두체와 겹치면 visible 에 1, 아니면 0.
+// min > max 인 노드 (메쉬 없음) 는 항상 0. 보이는 노드 수를 돌려준다.
+int cullSceneNodes(const SceneGraph & g, const glm::vec3 * localMin, const glm::vec3 * localMax,
+	const Frustum & f, unsigned char * visible);
+
+// 여러 절두체 (뷰) 를 한번에. viewMask[i] 의 비트 v 는 frusta[v] 안에 있는지 (8 개까지).
+// 하나라도 보이는 노드 수를 돌려준다.
+int cullSceneNodesViews(const SceneGraph & g, const glm::vec3 * localMin, const glm::vec3 * localMax,
+	const Frustum * frusta, int frustumCount, unsigned char * viewMask);
+
+#endif
@@ -0,0 +1,58 @@
+#ifndef SIMPROTOCOL_HPP
+#define SIMPROTOCOL_HPP
+
+#include <stdint.h>
+
+// SimServer 와 클라이언트 사이의 바이너리 프로토콜.
+// 요청은 16 바이트, 응답은 56 바이트 고정 크기이고 little endian 이다.
+// 한 틱 동안 들어온 요청은 모아 두었다가 틱 경계에서 한꺼번에 처리하고 응답한다.
+
+#define SIM_SOCKET_PATH "/tmp/rocket_sim.sock"
+
+enum SimOp {
+	SIM_CREATE = 1,     // 세션 만들기. 응답의 session 에 새 id
+	SIM_DESTROY,
+	SIM_LAUNCH,         // spacebar
+	SIM_PARACHUTE,      // X
+	SIM_STEP,           // arg 틱 만큼 진행 (0 이면 1)
+	SIM_QUERY,          // 상태만 돌려준다
+	SIM_STATS           // 세션의 틱 처리 시간 통계
+};
+
+enum SimStatus {
+	SIM_OK = 0,
+	SIM_NO_SESSION,
+	SIM_BAD_REQUEST,
+	SIM_FULL
+};
+
+#pragma pack(push, 1)
+struct SimRequest {
+	uint8_t op;
+	uint8_t reserved[3];
+	uint32_t session;
+	uint32_t arg;
+	uint32_t tag;        // 응답에 그대로 돌려준다
+};
+
+struct SimResponse {
+	uint32_t tag;
+	uint8_t op;
+	uint8_t status;
+	uint16_t reserved;
+	uint64_t tick;       // 세션이 진행한 틱 수
+	uint32_t session;
+	uint32_t flags;      // telemetry.hpp 의 TELEMETRY_* 와 같은 비트
+	float x, y, z;       // gro1
+	float velocity;
+	float thrust;
+	uint32_t tickNs;     // 이번 요청으로 진행한 틱들의 평균 처리 시간 (SIM_STATS 면 전체 평균)
+	uint32_t maxTickNs;  // 세션의 가장 느렸던 틱
+	uint32_t padding;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(SimRequest) == 16, "SimRequest must be 16 bytes");
+static_assert(sizeof(SimResponse) == 56, "SimResponse must be 56 bytes");
+
+#endif
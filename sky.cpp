@@ -0,0 +1,520 @@
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <vector>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+
+#include "sky.hpp"
+
+// 대기 (Bruneton 2008, Hillaire 2020 의 지구 값). 단위는 1/km.
+static const glm::vec3 RAYLEIGH_SCATTERING(5.802e-3f, 13.558e-3f, 33.1e-3f);
+static const float RAYLEIGH_HEIGHT = 8.0f;
+static const float MIE_SCATTERING = 3.996e-3f;
+static const float MIE_EXTINCTION = 4.44e-3f;
+static const float MIE_HEIGHT = 1.2f;
+static const glm::vec3 OZONE_ABSORPTION(0.650e-3f, 1.881e-3f, 0.085e-3f);
+static const float GROUND_ALBEDO = 0.3f;
+static const float PI = 3.14159265f;
+static const float THICKNESS = SKY_TOP_RADIUS - SKY_GROUND_RADIUS;
+
+#define SKY_TRANSMITTANCE_STEPS 40
+#define SKY_MULTIPLE_DIRECTIONS 64
+#define SKY_MULTIPLE_STEPS 20
+#define SKY_SCATTERING_STEPS 40
+
+static inline float clamp01(float x){
+	return x < 0.0f ? 0.0f : x > 1.0f ? 1.0f : x;
+}
+
+// cos 에서 sin (반올림으로 1 을 조금 넘어도)
+static inline float sineOf(float c){
+	float s = 1.0f - c * c;
+	return s > 0.0f ? sqrtf(s) : 0.0f;
+}
+
+static inline glm::vec3 expNegative(const glm::vec3 & v){
+	return glm::vec3(expf(-v.x), expf(-v.y), expf(-v.z));
+}
+
+// 고도 한 점의 매질
+struct Medium {
+	glm::vec3 rayleigh;                 // 산란
+	float mie;
+	glm::vec3 extinction;               // 산란 + 흡수
+};
+
+static Medium mediumAt(float altitude){
+	Medium m;
+	float rayleighDensity = expf(-altitude / RAYLEIGH_HEIGHT);
+	float mieDensity = expf(-altitude / MIE_HEIGHT);
+	float ozoneDensity = 1.0f - fabsf(altitude - 25.0f) / 15.0f;
+	m.rayleigh = RAYLEIGH_SCATTERING * rayleighDensity;
+	m.mie = MIE_SCATTERING * mieDensity;
+	m.extinction = m.rayleigh + glm::vec3(MIE_EXTINCTION * mieDensity) + OZONE_ABSORPTION * (ozoneDensity > 0.0f ? ozoneDensity : 0.0f);
+	return m;
+}
+
+// 반지름 r 에서 cos 천정각 mu 로 나간 빛이 땅에 닿는지, 닿거나 대기를 벗어나기까지의 거리
+static inline bool hitsGround(float r, float mu){
+	return mu < 0.0f && r * r * (mu * mu - 1.0f) + SKY_GROUND_RADIUS * SKY_GROUND_RADIUS >= 0.0f;
+}
+
+static inline float distanceToTop(float r, float mu){
+	float d = r * r * (mu * mu - 1.0f) + SKY_TOP_RADIUS * SKY_TOP_RADIUS;
+	return -r * mu + sqrtf(d > 0.0f ? d : 0.0f);
+}
+
+static inline float distanceToGround(float r, float mu){
+	float d = r * r * (mu * mu - 1.0f) + SKY_GROUND_RADIUS * SKY_GROUND_RADIUS;
+	return -r * mu - sqrtf(d > 0.0f ? d : 0.0f);
+}
+
+// 표 좌표 [0, 1] 과 값 사이. 셰이더와 같다.
+static inline float altitudeUnit(float altitude){
+	return sqrtf(clamp01(altitude / THICKNESS));
+}
+
+static inline float altitudeOf(float unit){
+	return unit * unit * THICKNESS;
+}
+
+static inline float sunUnit(float muS){
+	return clamp01((muS + 0.2f) / 1.2f);
+}
+
+// 시선 cos 은 지평선을 가운데 (0.5) 에 두고 양쪽을 제곱근으로 당겨서 지평선 둘레를 촘촘하게
+static inline float horizonOf(float r){
+	float s = SKY_GROUND_RADIUS / r;
+	return -sqrtf(1.0f - s * s > 0.0f ? 1.0f - s * s : 0.0f);
+}
+
+static inline float viewUnit(float mu, float r){
+	float horizon = horizonOf(r);
+	if (mu >= horizon)
+		return 0.5f + 0.5f * sqrtf(clamp01((mu - horizon) / (1.0f - horizon)));
+	return 0.5f - 0.5f * sqrtf(clamp01((horizon - mu) / (1.0f + horizon > 1e-6f ? 1.0f + horizon : 1e-6f)));
+}
+
+static inline float viewMuOf(float unit, float r){
+	float horizon = horizonOf(r);
+	if (unit >= 0.5f) {
+		float t = (unit - 0.5f) * 2.0f;
+		return horizon + t * t * (1.0f - horizon);
+	}
+	float t = (0.5f - unit) * 2.0f;
+	return horizon - t * t * (1.0f + horizon);
+}
+
+// rgb 표 찾기 (선형). 좌표는 [0, 1], 칸 가운데가 0 과 1 이다.
+static glm::vec3 lookup2D(const float * table, int width, int height, float u, float v){
+	float fx = clamp01(u) * (width - 1), fy = clamp01(v) * (height - 1);
+	int x0 = (int)fx, y0 = (int)fy;
+	int x1 = x0 + 1 < width ? x0 + 1 : x0, y1 = y0 + 1 < height ? y0 + 1 : y0;
+	float tx = fx - x0, ty = fy - y0;
+	glm::vec3 result;
+	for (int c = 0; c < 3; c++) {
+		float a = table[(y0 * width + x0) * 3 + c] * (1.0f - tx) + table[(y0 * width + x1) * 3 + c] * tx;
+		float b = table[(y1 * width + x0) * 3 + c] * (1.0f - tx) + table[(y1 * width + x1) * 3 + c] * tx;
+		result[c] = a * (1.0f - ty) + b * ty;
+	}
+	return result;
+}
+
+// 산란 표 : 고도 조각 둘을 찾아서 섞는다
+static glm::vec3 lookup3D(const std::vector<float> & table, float u, float v, float w){
+	const size_t slice = (size_t)SKY_VIEW_SIZE * SKY_SUN_SIZE * 3;
+	float fz = clamp01(w) * (SKY_ALTITUDE_SIZE - 1);
+	int z0 = (int)fz;
+	int z1 = z0 + 1 < SKY_ALTITUDE_SIZE ? z0 + 1 : z0;
+	float tz = fz - z0;
+	glm::vec3 lo = lookup2D(&table[z0 * slice], SKY_VIEW_SIZE, SKY_SUN_SIZE, u, v);
+	glm::vec3 hi = lookup2D(&table[z1 * slice], SKY_VIEW_SIZE, SKY_SUN_SIZE, u, v);
+	return lo * (1.0f - tz) + hi * tz;
+}
+
+static glm::vec3 transmittanceAt(const Sky & s, float r, float mu){
+	return lookup2D(&s.transmittance[0], SKY_TRANSMITTANCE_WIDTH, SKY_TRANSMITTANCE_HEIGHT, mu * 0.5f + 0.5f,
+		altitudeUnit(r - SKY_GROUND_RADIUS));
+}
+
+static glm::vec3 multipleAt(const Sky & s, float r, float muS){
+	return lookup2D(&s.multiple[0], SKY_MULTIPLE_SIZE, SKY_MULTIPLE_SIZE, muS * 0.5f + 0.5f, altitudeUnit(r - SKY_GROUND_RADIUS));
+}
+
+glm::vec3 skyTransmittance(const Sky & s, float altitudeKm, float mu){
+	return transmittanceAt(s, SKY_GROUND_RADIUS + altitudeKm, mu);
+}
+
+void initSky(Sky & s, const char * cachePath, float sunElevation, float sunAzimuth){
+	s.transmittance.assign(SKY_TRANSMITTANCE_WIDTH * SKY_TRANSMITTANCE_HEIGHT * 3, 0.0f);
+	s.multiple.assign(SKY_MULTIPLE_SIZE * SKY_MULTIPLE_SIZE * 3, 0.0f);
+	s.rayleigh.assign(SKY_SCATTERING_TEXELS * 3, 0.0f);
+	s.mie.assign(SKY_SCATTERING_TEXELS * 3, 0.0f);
+	s.scattered.assign(SKY_SCATTERING_TEXELS * 3, 0.0f);
+	s.cachePath = cachePath;
+	s.done.store(false);
+	s.workers = 1;
+	s.ready = false;
+	s.uploaded = false;
+	float elevation = sunElevation * PI / 180.0f, azimuth = sunAzimuth * PI / 180.0f;
+	s.sunDirection = glm::vec3(cosf(elevation) * cosf(azimuth), sinf(elevation), cosf(elevation) * sinf(azimuth));
+	s.altitudeKm = 0.0f;
+	memset(s.textures, 0, sizeof(s.textures));
+	memset(s.queries, 0, sizeof(s.queries));
+	s.queryIndex = 0;
+	s.queryPending[0] = s.queryPending[1] = false;
+	memset(&s.stats, 0, sizeof(s.stats));
+}
+
+// 투과율 : 고도 한 줄씩
+static void transmittanceJob(void * context, int begin, int end){
+	Sky & s = *(Sky *)context;
+	for (int y = begin; y < end; y++) {
+		float r = SKY_GROUND_RADIUS + altitudeOf(y / (SKY_TRANSMITTANCE_HEIGHT - 1.0f));
+		for (int x = 0; x < SKY_TRANSMITTANCE_WIDTH; x++) {
+			float mu = x / (SKY_TRANSMITTANCE_WIDTH - 1.0f) * 2.0f - 1.0f;
+			glm::vec3 transmittance(0.0f);
+			if (!hitsGround(r, mu)) {
+				float dt = distanceToTop(r, mu) / SKY_TRANSMITTANCE_STEPS;
+				glm::vec3 depth(0.0f);
+				for (int k = 0; k < SKY_TRANSMITTANCE_STEPS; k++) {
+					float t = (k + 0.5f) * dt;
+					float rp = sqrtf(r * r + 2.0f * r * mu * t + t * t);
+					depth += mediumAt(rp - SKY_GROUND_RADIUS).extinction * dt;
+				}
+				transmittance = expNegative(depth);
+			}
+			float * out = &s.transmittance[(y * SKY_TRANSMITTANCE_WIDTH + x) * 3];
+			out[0] = transmittance.x;
+			out[1] = transmittance.y;
+			out[2] = transmittance.z;
+		}
+	}
+}
+
+// 한 점에서 한 방향으로 대기 끝 (또는 땅) 까지 걸으며 산란을 모은다.
+// 태양 빛은 투과율 표로, 두 번 이상 산란된 빛은 multiple 표가 있으면 그것으로 더한다.
+struct SkyMarch {
+	glm::vec3 rayleigh;                 // 위상 함수를 곱하기 전
+	glm::vec3 mie;
+	glm::vec3 scattered;                // 등방 산란 (위상 1/4pi 를 곱한 것) + 땅 반사
+	glm::vec3 transfer;                 // 산란 계수를 투과율로 적분한 것 (다중 산란 표를 만들 때)
+};
+
+static SkyMarch march(const Sky & s, float r, const glm::vec3 & direction, const glm::vec3 & sun, int steps, bool useMultiple){
+	SkyMarch m;
+	m.rayleigh = m.mie = m.scattered = m.transfer = glm::vec3(0.0f);
+	const float mu = direction.y;
+	const bool ground = hitsGround(r, mu);
+	const float distance = ground ? distanceToGround(r, mu) : distanceToTop(r, mu);
+	const float dt = distance / steps;
+	const glm::vec3 origin(0.0f, r, 0.0f);
+	glm::vec3 transmittance(1.0f);
+	for (int k = 0; k < steps; k++) {
+		glm::vec3 p = origin + direction * ((k + 0.5f) * dt);
+		float rp = glm::length(p);
+		Medium medium = mediumAt(rp - SKY_GROUND_RADIUS);
+		glm::vec3 sunLight = transmittanceAt(s, rp, glm::dot(p, sun) / rp);
+		glm::vec3 step = expNegative(medium.extinction * dt);
+		// 이 구간에서 투과율을 해석적으로 적분한 것
+		glm::vec3 weight;
+		for (int c = 0; c < 3; c++)
+			weight[c] = transmittance[c] * (1.0f - step[c]) / medium.extinction[c];
+		glm::vec3 scattering = medium.rayleigh + glm::vec3(medium.mie);
+		m.rayleigh += weight * medium.rayleigh * sunLight;
+		m.mie += weight * medium.mie * sunLight;
+		m.transfer += weight * scattering;
+		if (useMultiple)
+			m.scattered += weight * scattering * multipleAt(s, rp, glm::dot(p, sun) / rp);
+		else
+			m.scattered += weight * scattering * sunLight * (1.0f / (4.0f * PI));
+		transmittance = transmittance * step;
+	}
+	if (ground) {
+		glm::vec3 p = origin + direction * distance;
+		float muS = glm::dot(p, sun) / glm::length(p);
+		if (muS > 0.0f)
+			m.scattered += transmittance * transmittanceAt(s, SKY_GROUND_RADIUS, muS) * (muS * GROUND_ALBEDO / PI);
+	}
+	return m;
+}
+
+// 다중 산란 (Hillaire 2020) : 구 전체 방향의 2 차 산란 L2 와 전달 f 를 평균해서 L2 / (1 - f)
+static void multipleJob(void * context, int begin, int end){
+	Sky & s = *(Sky *)context;
+	for (int y = begin; y < end; y++) {
+		float r = SKY_GROUND_RADIUS + altitudeOf(y / (SKY_MULTIPLE_SIZE - 1.0f));
+		for (int x = 0; x < SKY_MULTIPLE_SIZE; x++) {
+			float muS = x / (SKY_MULTIPLE_SIZE - 1.0f) * 2.0f - 1.0f;
+			glm::vec3 sun(0.0f, muS, sineOf(muS));
+			glm::vec3 light(0.0f), transfer(0.0f);
+			for (int i = 0; i < SKY_MULTIPLE_DIRECTIONS; i++) {
+				// 피보나치 나선으로 구를 고르게
+				float z = 1.0f - (i + 0.5f) * (2.0f / SKY_MULTIPLE_DIRECTIONS);
+				float ring = sineOf(z), phi = i * 2.39996323f;
+				SkyMarch m = march(s, r, glm::vec3(ring * cosf(phi), z, ring * sinf(phi)), sun, SKY_MULTIPLE_STEPS, false);
+				light += m.scattered;
+				transfer += m.transfer;
+			}
+			light *= 1.0f / SKY_MULTIPLE_DIRECTIONS;
+			transfer *= 1.0f / SKY_MULTIPLE_DIRECTIONS;
+			float * out = &s.multiple[(y * SKY_MULTIPLE_SIZE + x) * 3];
+			for (int c = 0; c < 3; c++)
+				out[c] = light[c] / (1.0f - transfer[c]);
+		}
+	}
+}
+
+// 산란 : 고도 조각 하나씩. 태양은 시선과 방위각 90 도 (nu = mu * muS).
+static void scatteringJob(void * context, int begin, int end){
+	Sky & s = *(Sky *)context;
+	for (int z = begin; z < end; z++) {
+		float r = SKY_GROUND_RADIUS + altitudeOf(z / (SKY_ALTITUDE_SIZE - 1.0f));
+		for (int y = 0; y < SKY_SUN_SIZE; y++) {
+			float muS = y / (SKY_SUN_SIZE - 1.0f) * 1.2f - 0.2f;
+			glm::vec3 sun(0.0f, muS, sineOf(muS));
+			for (int x = 0; x < SKY_VIEW_SIZE; x++) {
+				float mu = viewMuOf(x / (SKY_VIEW_SIZE - 1.0f), r);
+				SkyMarch m = march(s, r, glm::vec3(sineOf(mu), mu, 0.0f), sun, SKY_SCATTERING_STEPS, true);
+				size_t index = (((size_t)z * SKY_SUN_SIZE + y) * SKY_VIEW_SIZE + x) * 3;
+				for (int c = 0; c < 3; c++) {
+					s.rayleigh[index + c] = m.rayleigh[c];
+					s.mie[index + c] = m.mie[c];
+					s.scattered[index + c] = m.scattered[c];
+				}
+			}
+		}
+	}
+}
+
+void precomputeSky(Sky & s, JobSystem * jobs){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	runChunked(jobs, SKY_TRANSMITTANCE_HEIGHT, 4, transmittanceJob, &s);
+	s.stats.transmittanceMs = elapsedMs(begin);
+	std::chrono::steady_clock::time_point stage = std::chrono::steady_clock::now();
+	runChunked(jobs, SKY_MULTIPLE_SIZE, 1, multipleJob, &s);
+	s.stats.multipleMs = elapsedMs(stage);
+	stage = std::chrono::steady_clock::now();
+	runChunked(jobs, SKY_ALTITUDE_SIZE, 1, scatteringJob, &s);
+	s.stats.scatteringMs = elapsedMs(stage);
+	s.stats.precomputeMs = elapsedMs(begin);
+	s.stats.workers = jobs != NULL ? jobs->workerCount : 1;
+	s.stats.cached = false;
+}
+
+// 전용 스레드. 이 스레드가 자기 잡 시스템의 워커 0 이 된다.
+static void precomputeSkyThread(Sky * s){
+	JobSystem jobs;
+	startJobs(jobs, s->workers);
+	precomputeSky(*s, &jobs);
+	stopJobs(jobs);
+	saveSkyCache(*s);
+	s->done.store(true, std::memory_order_release);
+}
+
+static void fillCacheHeader(SkyCacheHeader & h){
+	memset(&h, 0, sizeof(h));
+	h.magic = SKY_MAGIC;
+	h.version = SKY_VERSION;
+	h.sizes[0] = SKY_TRANSMITTANCE_WIDTH;
+	h.sizes[1] = SKY_TRANSMITTANCE_HEIGHT;
+	h.sizes[2] = SKY_MULTIPLE_SIZE;
+	h.sizes[3] = SKY_VIEW_SIZE;
+	h.sizes[4] = SKY_SUN_SIZE;
+	h.sizes[5] = SKY_ALTITUDE_SIZE;
+	h.groundRadius = SKY_GROUND_RADIUS;
+	h.topRadius = SKY_TOP_RADIUS;
+}
+
+bool saveSkyCache(Sky & s){
+	if (s.cachePath == NULL)
+		return false;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	FILE * file = fopen(s.cachePath, "wb");
+	if (file == NULL)
+		return false;
+	SkyCacheHeader header;
+	fillCacheHeader(header);
+	std::vector<float> * const tables[5] = { &s.transmittance, &s.multiple, &s.rayleigh, &s.mie, &s.scattered };
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	for (int i = 0; i < 5 && ok; i++)
+		ok = fwrite(&(*tables[i])[0], sizeof(float), tables[i]->size(), file) == tables[i]->size();
+	ok = fclose(file) == 0 && ok;
+	s.stats.saveMs = elapsedMs(begin);
+	if (!ok)
+		remove(s.cachePath);
+	return ok;
+}
+
+bool loadSkyCache(Sky & s){
+	if (s.cachePath == NULL)
+		return false;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	FILE * file = fopen(s.cachePath, "rb");
+	if (file == NULL)
+		return false;
+	SkyCacheHeader expected, header;
+	fillCacheHeader(expected);
+	std::vector<float> * const tables[5] = { &s.transmittance, &s.multiple, &s.rayleigh, &s.mie, &s.scattered };
+	bool ok = fread(&header, sizeof(header), 1, file) == 1 && memcmp(&header, &expected, sizeof(header)) == 0;
+	for (int i = 0; i < 5 && ok; i++)
+		ok = fread(&(*tables[i])[0], sizeof(float), tables[i]->size(), file) == tables[i]->size();
+	// 꼬리에 남는 것이 있으면 다른 파일이다
+	ok = ok && fgetc(file) == EOF;
+	fclose(file);
+	if (!ok)
+		return false;
+	s.stats.loadMs = elapsedMs(begin);
+	s.stats.precomputeMs = 0.0;
+	s.stats.cached = true;
+	return true;
+}
+
+void beginSkyPrecompute(Sky & s, int workers){
+	if (loadSkyCache(s)) {
+		s.ready = true;
+		return;
+	}
+	s.workers = workers > 0 ? workers : 1;
+	s.done.store(false);
+	s.thread = std::thread(precomputeSkyThread, &s);
+}
+
+void finishSkyPrecompute(Sky & s){
+	if (s.thread.joinable())
+		s.thread.join();
+}
+
+static GLuint uploadTable(GLenum target, const std::vector<float> & table, int width, int height, int depth){
+	GLuint texture;
+	glGenTextures(1, &texture);
+	glBindTexture(target, texture);
+	if (target == GL_TEXTURE_3D)
+		glTexImage3D(target, 0, GL_RGB16F, width, height, depth, 0, GL_RGB, GL_FLOAT, &table[0]);
+	else
+		glTexImage2D(target, 0, GL_RGB16F, width, height, 0, GL_RGB, GL_FLOAT, &table[0]);
+	glTexParameteri(target, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(target, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(target, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(target, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(target, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+	glBindTexture(target, 0);
+	return texture;
+}
+
+bool pollSky(Sky & s){
+	if (s.uploaded)
+		return true;
+	if (!s.ready) {
+		if (!s.thread.joinable() || !s.done.load(std::memory_order_acquire))
+			return false;
+		s.thread.join();
+		s.ready = true;
+	}
+	s.textures[0] = uploadTable(GL_TEXTURE_2D, s.transmittance, SKY_TRANSMITTANCE_WIDTH, SKY_TRANSMITTANCE_HEIGHT, 1);
+	s.textures[1] = uploadTable(GL_TEXTURE_3D, s.rayleigh, SKY_VIEW_SIZE, SKY_SUN_SIZE, SKY_ALTITUDE_SIZE);
+	s.textures[2] = uploadTable(GL_TEXTURE_3D, s.mie, SKY_VIEW_SIZE, SKY_SUN_SIZE, SKY_ALTITUDE_SIZE);
+	s.textures[3] = uploadTable(GL_TEXTURE_3D, s.scattered, SKY_VIEW_SIZE, SKY_SUN_SIZE, SKY_ALTITUDE_SIZE);
+	glGenQueries(2, s.queries);
+	s.uploaded = true;
+	if (s.stats.cached)
+		printf("Sky : tables loaded from %s in %.2f ms\n", s.cachePath, s.stats.loadMs);
+	else
+		printf("Sky : tables precomputed in %.1f ms on %d workers (transmittance %.1f, multiple %.1f, scattering %.1f ms), cache %.2f ms\n",
+			s.stats.precomputeMs, s.stats.workers, s.stats.transmittanceMs, s.stats.multipleMs, s.stats.scatteringMs, s.stats.saveMs);
+	return true;
+}
+
+static inline float rayleighPhase(float nu){
+	return 3.0f / (16.0f * PI) * (1.0f + nu * nu);
+}
+
+// Cornette-Shanks, g = 0.8
+static inline float miePhase(float nu){
+	const float g = 0.8f;
+	float k = 3.0f / (8.0f * PI) * (1.0f - g * g) / (2.0f + g * g);
+	float d = 1.0f + g * g - 2.0f * g * nu;
+	return k * (1.0f + nu * nu) / (d * sqrtf(d));
+}
+
+glm::vec3 skyRadiance(const Sky & s, float altitudeKm, const glm::vec3 & direction){
+	float r = SKY_GROUND_RADIUS + (altitudeKm < 0.0f ? 0.0f : altitudeKm > THICKNESS ? THICKNESS : altitudeKm);
+	float nu = glm::dot(direction, s.sunDirection);
+	float u = viewUnit(direction.y, r), v = sunUnit(s.sunDirection.y), w = altitudeUnit(r - SKY_GROUND_RADIUS);
+	return lookup3D(s.rayleigh, u, v, w) * rayleighPhase(nu) + lookup3D(s.mie, u, v, w) * miePhase(nu) +
+		lookup3D(s.scattered, u, v, w);
+}
+
+void getSkyUniforms(Sky & s, GLuint program){
+	static const char * const NAMES[4] = { "transmittanceTable", "rayleighTable", "mieTable", "scatteredTable" };
+	SkyUniforms & u = s.uniforms;
+	getViewUniforms(program, u.view);
+	u.viewRay = glGetUniformLocation(program, "viewRay");
+	u.sunDirection = glGetUniformLocation(program, "sunDirection");
+	u.altitude = glGetUniformLocation(program, "altitude");
+	for (int i = 0; i < 4; i++)
+		u.tables[i] = glGetUniformLocation(program, NAMES[i]);
+}
+
+void drawSky(Sky & s, GLuint program, const ViewSet & views, float altitudeUnits){
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	float altitude = altitudeUnits * SKY_KM_PER_UNIT;
+	s.altitudeKm = altitude < 0.0f ? 0.0f : altitude > THICKNESS ? THICKNESS : altitude;
+	// 두 프레임 전의 쿼리가 끝났으면 읽는다. 기다리지는 않는다.
+	int q = s.queryIndex;
+	if (s.queryPending[q]) {
+		GLint available = 0;
+		glGetQueryObjectiv(s.queries[q], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (available) {
+			GLuint64 ns = 0;
+			glGetQueryObjectui64v(s.queries[q], GL_QUERY_RESULT, &ns);
+			s.stats.gpuMs = ns / 1e6;
+			s.queryPending[q] = false;
+		}
+	}
+	const bool timing = !s.queryPending[q];
+	if (timing)
+		glBeginQuery(GL_TIME_ELAPSED, s.queries[q]);
+	glUseProgram(program);
+	// 뷰마다 화면 좌표에서 시선 방향으로 : 위치를 뺀 뷰와 투영의 역행렬
+	glm::mat4 rays[MAX_VIEWS];
+	for (int v = 0; v < views.count; v++) {
+		glm::mat4 rotation = views.view[v];
+		rotation[3] = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		rays[v] = glm::inverse(views.projection[v] * rotation);
+	}
+	const SkyUniforms & u = s.uniforms;
+	setViewUniforms(u.view, views);
+	glUniformMatrix4fv(u.viewRay, views.count, GL_FALSE, &rays[0][0][0]);
+	glUniform3f(u.sunDirection, s.sunDirection.x, s.sunDirection.y, s.sunDirection.z);
+	glUniform1f(u.altitude, s.altitudeKm);
+	for (int i = 0; i < 4; i++) {
+		glActiveTexture(GL_TEXTURE0 + SKY_TEXTURE_UNIT + i);
+		glBindTexture(i == 0 ? GL_TEXTURE_2D : GL_TEXTURE_3D, s.textures[i]);
+		glUniform1i(u.tables[i], SKY_TEXTURE_UNIT + i);
+	}
+	glActiveTexture(GL_TEXTURE0);
+	glDisable(GL_DEPTH_TEST);
+	glDepthMask(GL_FALSE);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 3, views.count);
+	glDepthMask(GL_TRUE);
+	glEnable(GL_DEPTH_TEST);
+	if (timing) {
+		glEndQuery(GL_TIME_ELAPSED);
+		s.queryPending[q] = true;
+	}
+	s.queryIndex = 1 - q;
+	s.stats.cpuMs = elapsedMs(begin);
+}
+
+void freeSky(Sky & s){
+	if (!s.uploaded)
+		return;
+	glDeleteTextures(4, s.textures);
+	glDeleteQueries(2, s.queries);
+	s.uploaded = false;
+}
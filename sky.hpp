@@ -0,0 +1,119 @@
+#ifndef SKY_HPP
+#define SKY_HPP
+
+#include <stdint.h>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+
+#include "jobs.hpp"
+#include "views.hpp"
+
+// 고도에 따라 바뀌는 하늘 (대기 산란).
+// 화소마다 대기를 적분하지 않고, 시작할 때 표를 한 번 만들어 둔다 (전용 스레드와 그 잡 시스템, 디스크에 저장해서 다음에는 읽기만).
+//  - 투과율 (고도, 시선 cos) : 그 점에서 대기 끝까지 빛이 남는 비율
+//  - 다중 산란 (고도, 태양 cos) : 두 번 이상 산란된 빛을 등방으로 본 근사 (Hillaire 2020)
+//  - 산란 (시선 cos, 태양 cos, 고도) : 시선을 따라 모은 Rayleigh, Mie, 다중 산란. 위상 함수는 그릴 때 곱한다.
+//    시선과 태양 사이의 방위각은 표에 없고 90 도로 놓고 적분한다 (지구 그림자의 방향만 조금 틀린다).
+// 매 프레임에는 로켓 고도 (gro1.y) 와 태양 방향으로 표를 찾기만 한다 (SkyVertexShader, SkyFragmentShader).
+// 거리는 km. 좌표 식은 셰이더와 같아야 한다.
+#define SKY_MAGIC 0x594B5352u               // "RSKY"
+#define SKY_VERSION 1
+#define SKY_GROUND_RADIUS 6360.0f
+#define SKY_TOP_RADIUS 6460.0f
+#define SKY_KM_PER_UNIT 2.5f                // 장면 한 칸. 최고 고도 (약 40 칸) 에서 대기 끝에 닿는다.
+#define SKY_TRANSMITTANCE_WIDTH 256         // 시선 cos
+#define SKY_TRANSMITTANCE_HEIGHT 64         // 고도
+#define SKY_MULTIPLE_SIZE 32                // 태양 cos x 고도
+#define SKY_VIEW_SIZE 64                    // 산란 표 : 시선 cos (지평선 둘레에 촘촘하게)
+#define SKY_SUN_SIZE 32                     //           태양 cos
+#define SKY_ALTITUDE_SIZE 32                //           고도
+#define SKY_SCATTERING_TEXELS (SKY_VIEW_SIZE * SKY_SUN_SIZE * SKY_ALTITUDE_SIZE)
+
+#pragma pack(push, 1)
+struct SkyCacheHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t sizes[6];                      // 위의 표 크기들. 하나라도 다르면 다시 만든다.
+	float groundRadius;
+	float topRadius;
+};
+#pragma pack(pop)
+
+struct SkyStats {
+	double precomputeMs;                    // 표를 만든 시간 (캐시를 읽었으면 0)
+	double transmittanceMs;
+	double multipleMs;
+	double scatteringMs;
+	double loadMs;                          // 캐시를 읽은 시간
+	double saveMs;
+	double cpuMs;                           // 지난 drawSky
+	double gpuMs;                           // 타이머 쿼리로 잰 그리기 (몇 프레임 늦다)
+	int workers;
+	bool cached;
+};
+
+// 하늘 프로그램의 uniform 위치. 링크한 뒤 getSkyUniforms 로 한번 찾는다.
+struct SkyUniforms {
+	ViewUniforms view;
+	GLint viewRay;
+	GLint sunDirection;
+	GLint altitude;
+	GLint tables[4];
+};
+
+struct Sky {
+	// 표. rgb 로 빽빽하게.
+	std::vector<float> transmittance;       // SKY_TRANSMITTANCE_WIDTH * HEIGHT * 3
+	std::vector<float> multiple;            // SKY_MULTIPLE_SIZE^2 * 3
+	std::vector<float> rayleigh;            // SKY_SCATTERING_TEXELS * 3
+	std::vector<float> mie;
+	std::vector<float> scattered;           // 다중 산란 + 땅 반사
+	const char * cachePath;
+	// 프레임 잡 시스템에 넣으면 waitForCounter 가 긴 조각을 훔쳐 프레임이 밀린다. 따로 스레드를 띄운다.
+	std::thread thread;                     // 만드는 중이면 joinable
+	std::atomic<bool> done;                 // 스레드가 표를 다 만들었다
+	int workers;                            // 그 스레드가 쓸 잡 워커 수 (자신 포함)
+	bool ready;                             // 표가 다 찼다 (메인 스레드가 done 을 보고 정한다)
+	bool uploaded;
+	glm::vec3 sunDirection;                 // 빛이 오는 쪽 (월드)
+	float altitudeKm;                       // 지난 drawSky 의 고도
+	GLuint textures[4];                     // 투과율, Rayleigh, Mie, 다중 산란 + 땅
+	GLuint queries[2];
+	int queryIndex;
+	bool queryPending[2];
+	SkyStats stats;
+	SkyUniforms uniforms;
+};
+
+// 태양 고도/방위 (도). GL 을 부르지 않는다.
+void initSky(Sky & s, const char * cachePath, float sunElevation, float sunAzimuth);
+// 캐시가 맞으면 읽고, 아니면 workers 개의 워커로 표를 만드는 스레드를 띄우고 바로 돌아온다 (다 만들면 캐시에 쓴다)
+void beginSkyPrecompute(Sky & s, int workers);
+// 표를 만드는 스레드가 있으면 끝날 때까지 기다린다. 끝내기 전에 부른다.
+void finishSkyPrecompute(Sky & s);
+// 메인 스레드에서 매 프레임. 표가 다 됐으면 텍스처로 올린다. 올렸으면 true.
+bool pollSky(Sky & s);
+
+// 이 스레드에서 표를 모두 만든다 (jobs 가 NULL 이면 혼자서)
+void precomputeSky(Sky & s, JobSystem * jobs);
+bool loadSkyCache(Sky & s);
+bool saveSkyCache(Sky & s);
+
+// 표 찾기 (셰이더와 같은 식). 높이는 km, 0 ~ 대기 두께.
+glm::vec3 skyTransmittance(const Sky & s, float altitudeKm, float mu);
+// 시선 방향의 하늘 빛 (태양 조도 1, 노출 전)
+glm::vec3 skyRadiance(const Sky & s, float altitudeKm, const glm::vec3 & direction);
+
+// 뷰마다 화면 전체에 하늘을 그린다. 깊이는 쓰지 않으므로 장면보다 먼저 그린다. beginViews 뒤에 부른다.
+// 텍스처 단위 SKY_TEXTURE_UNIT 부터 넷을 쓴다.
+#define SKY_TEXTURE_UNIT 4
+void getSkyUniforms(Sky & s, GLuint program);
+void drawSky(Sky & s, GLuint program, const ViewSet & views, float altitudeUnits);
+void freeSky(Sky & s);
+
+#endif
@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <future>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include "startup.hpp"
+
+#ifndef GL_MAX_SHADER_COMPILER_THREADS_KHR
+#define GL_MAX_SHADER_COMPILER_THREADS_KHR 0x91B0
+#endif
+#ifndef GL_COMPLETION_STATUS_KHR
+#define GL_COMPLETION_STATUS_KHR 0x91B1
+#endif
+
+static double secondsSince(const std::chrono::steady_clock::time_point & t){
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+}
+
+static std::string readFile(const char * path){
+	std::string code;
+	std::ifstream stream(path, std::ios::in);
+	if (stream.is_open()) {
+		std::stringstream sstr;
+		sstr << stream.rdbuf();
+		code = sstr.str();
+	}
+	return code;
+}
+
+// prelude 가 비어 있지 않으면 code 앞에 붙는다 (문자열 두 개로 넘긴다)
+static GLuint compileShader(GLenum type, const char * path, const std::string & prelude, const std::string & code){
+	printf("Compiling shader : %s\n", path);
+	GLuint id = glCreateShader(type);
+	const char * sources[2] = { prelude.c_str(), code.c_str() };
+	glShaderSource(id, prelude.empty() ? 1 : 2, prelude.empty() ? sources + 1 : sources, NULL);
+	glCompileShader(id);
+	return id;
+}
+
+static void printShaderLog(GLuint id){
+	int length = 0;
+	glGetShaderiv(id, GL_INFO_LOG_LENGTH, &length);
+	if (length > 0) {
+		std::vector<char> message(length + 1);
+		glGetShaderInfoLog(id, length, NULL, &message[0]);
+		printf("%s\n", &message[0]);
+	}
+}
+
+void beginStartup(StartupPipeline & s, const char * vertex_file_path, const char * fragment_file_path,
+	const char * vertex_prelude_path){
+	s.startTime = std::chrono::steady_clock::now();
+	s.stage = STARTUP_READING;
+	s.vertexPath = vertex_file_path;
+	s.fragmentPath = fragment_file_path;
+	s.preludePath = vertex_prelude_path;
+	if (vertex_prelude_path != NULL)
+		s.preludeSource = std::async(std::launch::async, readFile, vertex_prelude_path);
+	s.vertexSource = std::async(std::launch::async, readFile, vertex_file_path);
+	s.fragmentSource = std::async(std::launch::async, readFile, fragment_file_path);
+	s.vertexShaderID = 0;
+	s.fragmentShaderID = 0;
+	s.programID = 0;
+	s.parallelCompile = false;
+	s.firstFrameTime = -1;
+	s.loadedTime = -1;
+}
+
+static bool sourceReady(std::future<std::string> & f){
+	return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+}
+
+bool pollStartup(StartupPipeline & s){
+	if (s.stage == STARTUP_READING) {
+		if (!sourceReady(s.vertexSource) || !sourceReady(s.fragmentSource) ||
+			(s.preludePath != NULL && !sourceReady(s.preludeSource)))
+			return false;
+		s.vertexCode = s.vertexSource.get();
+		s.fragmentCode = s.fragmentSource.get();
+		if (s.preludePath != NULL)
+			s.preludeCode = s.preludeSource.get();
+		if (s.vertexCode.empty() || s.fragmentCode.empty() || (s.preludePath != NULL && s.preludeCode.empty())) {
+			printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n",
+				s.vertexCode.empty() ? s.vertexPath : s.fragmentCode.empty() ? s.fragmentPath : s.preludePath);
+			s.stage = STARTUP_FAILED;
+			return false;
+		}
+
+		// 드라이버가 병렬 컴파일을 지원하면 스레드 수를 맡긴다
+		if (GLEW_KHR_parallel_shader_compile) {
+			glMaxShaderCompilerThreadsKHR(0xFFFFFFFFu);
+			s.parallelCompile = true;
+		}
+		else if (GLEW_ARB_parallel_shader_compile) {
+			glMaxShaderCompilerThreadsARB(0xFFFFFFFFu);
+			s.parallelCompile = true;
+		}
+		s.stage = STARTUP_COMPILING;
+	}
+
+	if (s.stage == STARTUP_COMPILING) {
+		// 병렬 컴파일이면 셋을 한번에 요청해 두고 결과는 나중에 확인한다.
+		// 아니면 상태를 물어서 이번 폴링에 컴파일을 끝내고, 다음 단계는 다음 폴링 (다음 프레임) 으로 미룬다.
+		GLint compiled = GL_FALSE;
+		if (s.vertexShaderID == 0) {
+			s.vertexShaderID = compileShader(GL_VERTEX_SHADER, s.vertexPath, s.preludeCode, s.vertexCode);
+			if (!s.parallelCompile) {
+				glGetShaderiv(s.vertexShaderID, GL_COMPILE_STATUS, &compiled);
+				return false;
+			}
+		}
+		if (s.fragmentShaderID == 0) {
+			s.fragmentShaderID = compileShader(GL_FRAGMENT_SHADER, s.fragmentPath, std::string(), s.fragmentCode);
+			if (!s.parallelCompile) {
+				glGetShaderiv(s.fragmentShaderID, GL_COMPILE_STATUS, &compiled);
+				return false;
+			}
+		}
+		std::string().swap(s.preludeCode);
+		std::string().swap(s.vertexCode);
+		std::string().swap(s.fragmentCode);
+		printf("Linking program\n");
+		s.programID = glCreateProgram();
+		glAttachShader(s.programID, s.vertexShaderID);
+		glAttachShader(s.programID, s.fragmentShaderID);
+		glLinkProgram(s.programID);
+		s.stage = STARTUP_LINKING;
+		if (!s.parallelCompile)
+			return false;
+	}
+
+	if (s.stage == STARTUP_LINKING) {
+		if (s.parallelCompile) {
+			GLint done = GL_FALSE;
+			glGetProgramiv(s.programID, GL_COMPLETION_STATUS_KHR, &done);
+			if (done == GL_FALSE)
+				return false;
+		}
+
+		GLint result = GL_FALSE;
+		glGetProgramiv(s.programID, GL_LINK_STATUS, &result);
+		if (result == GL_FALSE) {
+			printShaderLog(s.vertexShaderID);
+			printShaderLog(s.fragmentShaderID);
+			int length = 0;
+			glGetProgramiv(s.programID, GL_INFO_LOG_LENGTH, &length);
+			if (length > 0) {
+				std::vector<char> message(length + 1);
+				glGetProgramInfoLog(s.programID, length, NULL, &message[0]);
+				printf("%s\n", &message[0]);
+			}
+		}
+
+		glDetachShader(s.programID, s.vertexShaderID);
+		glDetachShader(s.programID, s.fragmentShaderID);
+		glDeleteShader(s.vertexShaderID);
+		glDeleteShader(s.fragmentShaderID);
+
+		if (result == GL_FALSE) {
+			glDeleteProgram(s.programID);
+			s.programID = 0;
+			s.stage = STARTUP_FAILED;
+			return false;
+		}
+
+		s.stage = STARTUP_READY;
+	}
+
+	return s.stage == STARTUP_READY;
+}
+
+void markStartupFrame(StartupPipeline & s){
+	if (s.firstFrameTime >= 0)
+		return;
+	s.firstFrameTime = secondsSince(s.startTime);
+	printf("Time to first frame : %.1f ms\n", s.firstFrameTime * 1000.0);
+}
+
+void markStartupLoaded(StartupPipeline & s, bool ready){
+	if (s.loadedTime >= 0 || !ready)
+		return;
+	s.loadedTime = secondsSince(s.startTime);
+	printf("Time to fully loaded : %.1f ms (parallel shader compile %s)\n",
+		s.loadedTime * 1000.0, s.parallelCompile ? "on" : "off");
+}
+
+void uploadBuffers(const BufferUpload * uploads, int count, GLuint * buffers){
+	glGenBuffers(count, buffers);
+	for (int i = 0; i < count; i++) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffers[i]);
+		glBufferData(GL_ARRAY_BUFFER, uploads[i].size, uploads[i].data, GL_STATIC_DRAW);
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
@@ -0,0 +1,68 @@
+#ifndef STARTUP_HPP
+#define STARTUP_HPP
+
+#include <string>
+#include <future>
+#include <chrono>
+
+#include <GL/glew.h>
+
+// 시작 과정을 단계별로 나눈 것.
+// 셰이더 파일은 GLFW/GLEW 초기화 전에 워커 스레드에서 읽기 시작하고,
+// 병렬 컴파일 (GL_KHR/ARB_parallel_shader_compile) 이 있으면 컴파일과 링크를 한꺼번에 요청해 두고 완료 여부만 본다.
+// 없으면 결과를 묻는 순간 드라이버가 그 자리에서 컴파일하므로, 폴링 한번에 한 단계씩 (정점, 조각, 링크) 나눠서
+// 한 프레임이 한 단계만큼만 멈추게 한다. 그동안 메인 루프는 로딩 화면을 그린다.
+enum StartupStage {
+	STARTUP_READING,    // 파일 읽는 중
+	STARTUP_COMPILING,  // 셰이더 컴파일 요청 중 (병렬 컴파일이 없으면 폴링마다 하나씩)
+	STARTUP_LINKING,    // 링크 결과를 기다리는 중
+	STARTUP_READY,
+	STARTUP_FAILED
+};
+
+struct StartupPipeline {
+	StartupStage stage;
+	const char * vertexPath;
+	const char * fragmentPath;
+	const char * preludePath;  // 정점 셰이더 앞에 붙일 공통 부분 (없으면 NULL)
+	std::future<std::string> preludeSource;
+	std::future<std::string> vertexSource;
+	std::future<std::string> fragmentSource;
+	std::string preludeCode;   // 읽은 소스. 컴파일을 요청하면 비운다.
+	std::string vertexCode;
+	std::string fragmentCode;
+	GLuint vertexShaderID;
+	GLuint fragmentShaderID;
+	GLuint programID;
+	bool parallelCompile;
+	std::chrono::steady_clock::time_point startTime;
+	double firstFrameTime;   // 처음 화면이 나온 시각 (초, 시작 기준). 아직이면 -1
+	double loadedTime;       // 모두 준비된 시각 (markStartupLoaded). 아직이면 -1
+};
+
+// 정점 버퍼 하나에 올릴 데이터
+struct BufferUpload {
+	const GLfloat * data;
+	GLsizeiptr size;
+};
+
+// main() 맨 처음에 부른다. 워커 스레드에서 셰이더 파일을 읽기 시작한다.
+// vertex_prelude_path 가 NULL 이 아니면 그 파일 (#version 포함) 을 정점 셰이더 앞에 붙여서 컴파일한다.
+void beginStartup(StartupPipeline & s, const char * vertex_file_path, const char * fragment_file_path,
+	const char * vertex_prelude_path);
+
+// GL 컨텍스트가 생긴 뒤 매 프레임 부른다. 기다리지 않고 다음 단계로 넘어갈 수 있으면 넘어간다.
+// 모두 준비되면 true.
+bool pollStartup(StartupPipeline & s);
+
+// 화면을 한번 swap 한 뒤에 부른다. 첫 프레임 시간을 한번만 기록/출력한다.
+void markStartupFrame(StartupPipeline & s);
+
+// 매 프레임 부른다. ready 는 모든 파이프라인과 다른 자원 (하늘 표 등) 이 준비됐는지.
+// 처음 ready 인 프레임에 s 의 시작 시각부터 잰 시간을 한번만 기록/출력한다.
+void markStartupLoaded(StartupPipeline & s, bool ready);
+
+// 버퍼 이름을 한번에 만들고 GL_STATIC_DRAW 로 차례대로 올린다.
+void uploadBuffers(const BufferUpload * uploads, int count, GLuint * buffers);
+
+#endif
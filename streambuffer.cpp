@@ -0,0 +1,125 @@
+#include <vector>
+#include <chrono>
+
+#include <GL/glew.h>
+
+#include "streambuffer.hpp"
+
+static const GLbitfield STREAM_MAP_FLAGS = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+void initStreamBuffer(StreamBuffer & s, GLenum target, GLsizeiptr regionSize, bool allowPersistent){
+	s.target = target;
+	s.regionSize = (regionSize + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+	s.region = 0;
+	for (int i = 0; i < STREAM_REGIONS; i++)
+		s.fences[i] = 0;
+	s.mapped = NULL;
+	s.offset = 0;
+	s.flushed = 0;
+	s.stats = StreamStats();
+	s.totalWaitMs = 0.0;
+	s.stalls = 0;
+	glGenBuffers(1, &s.buffer);
+	glBindBuffer(target, s.buffer);
+	if (allowPersistent && GLEW_ARB_buffer_storage) {
+		glBufferStorage(target, s.regionSize * STREAM_REGIONS, NULL, STREAM_MAP_FLAGS);
+		s.mapped = (unsigned char *)glMapBufferRange(target, 0, s.regionSize * STREAM_REGIONS, STREAM_MAP_FLAGS);
+	}
+	if (s.mapped != NULL) {
+		s.mode = STREAM_PERSISTENT;
+		return;
+	}
+	// 매핑에 실패했으면 immutable 이 된 버퍼는 버리고 새로 만든다
+	if (allowPersistent && GLEW_ARB_buffer_storage) {
+		glDeleteBuffers(1, &s.buffer);
+		glGenBuffers(1, &s.buffer);
+		glBindBuffer(target, s.buffer);
+	}
+	s.mode = STREAM_ORPHAN;
+	s.staging.resize(s.regionSize);
+	glBufferData(target, s.regionSize, NULL, GL_STREAM_DRAW);
+}
+
+void freeStreamBuffer(StreamBuffer & s){
+	for (int i = 0; i < STREAM_REGIONS; i++) {
+		if (s.fences[i] != 0)
+			glDeleteSync(s.fences[i]);
+		s.fences[i] = 0;
+	}
+	if (s.mapped != NULL) {
+		glBindBuffer(s.target, s.buffer);
+		glUnmapBuffer(s.target);
+		s.mapped = NULL;
+	}
+	glDeleteBuffers(1, &s.buffer);
+	s.buffer = 0;
+}
+
+void beginStreamFrame(StreamBuffer & s){
+	s.stats = StreamStats();
+	s.offset = 0;
+	s.flushed = 0;
+	if (s.mode == STREAM_ORPHAN) {
+		// 이전 저장소는 GPU 가 다 쓰면 드라이버가 버린다
+		glBindBuffer(s.target, s.buffer);
+		glBufferData(s.target, s.regionSize, NULL, GL_STREAM_DRAW);
+		return;
+	}
+	s.region = (s.region + 1) % STREAM_REGIONS;
+	GLsync fence = s.fences[s.region];
+	if (fence == 0)
+		return;
+	std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+	// 보통은 STREAM_REGIONS 프레임 전의 펜스라서 이미 끝나 있다
+	GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+	for (;;) {
+		GLenum result = glClientWaitSync(fence, flags, 1000000);
+		if (flags != 0 && result != GL_ALREADY_SIGNALED)
+			s.stalls++;
+		if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED || result == GL_WAIT_FAILED)
+			break;
+		flags = 0;
+	}
+	s.stats.fenceWaitMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	s.totalWaitMs += s.stats.fenceWaitMs;
+	glDeleteSync(fence);
+	s.fences[s.region] = 0;
+}
+
+void * streamAlloc(StreamBuffer & s, GLsizeiptr size, GLsizeiptr * offset){
+	GLsizeiptr begin = (s.offset + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+	if (begin + size > s.regionSize) {
+		s.stats.overflows++;
+		return NULL;
+	}
+	s.offset = begin + size;
+	s.stats.bytes += size;
+	if (s.mode == STREAM_ORPHAN) {
+		*offset = begin;
+		return &s.staging[begin];
+	}
+	*offset = s.region * s.regionSize + begin;
+	return s.mapped + *offset;
+}
+
+GLsizeiptr streamAvailable(const StreamBuffer & s){
+	GLsizeiptr begin = (s.offset + STREAM_ALIGN - 1) / STREAM_ALIGN * STREAM_ALIGN;
+	return begin < s.regionSize ? s.regionSize - begin : 0;
+}
+
+void streamFlush(StreamBuffer & s){
+	glBindBuffer(s.target, s.buffer);
+	// coherent 매핑은 쓴 것이 바로 보인다
+	if (s.mode == STREAM_ORPHAN && s.offset > s.flushed) {
+		glBufferSubData(s.target, s.flushed, s.offset - s.flushed, &s.staging[s.flushed]);
+		s.flushed = s.offset;
+	}
+}
+
+void endStreamFrame(StreamBuffer & s){
+	if (s.mode != STREAM_PERSISTENT)
+		return;
+	if (s.fences[s.region] != 0)
+		glDeleteSync(s.fences[s.region]);
+	s.fences[s.region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
@@ -0,0 +1,62 @@
+#ifndef STREAMBUFFER_HPP
+#define STREAMBUFFER_HPP
+
+#include <vector>
+
+#include <GL/glew.h>
+
+// 매 프레임 새로 올리는 데이터 (잔해 인스턴스 등) 를 위한 스트리밍 버퍼.
+// ARB_buffer_storage 가 있으면 버퍼 전체를 persistent + coherent 로 한번만 매핑해 두고,
+// STREAM_REGIONS 개의 구역을 프레임마다 돌아가며 쓴다. 구역을 다 그린 뒤 펜스를 걸어 두고,
+// 다시 그 구역으로 돌아왔을 때 GPU 가 아직 읽는 중이면 펜스를 기다린다 (glBufferData 의 암묵적 동기화 대신).
+// 없으면 프레임마다 glBufferData(NULL) 로 버퍼를 버리고 (orphaning) glBufferSubData 로 올린다.
+// streamAlloc 은 GL 을 부르지 않으므로 잡 안에서 불러도 되지만, offset 을 잠금 없이 올리므로 한 스트림은 한 번에 한 스레드만
+// 써야 한다 (잔해와 입자는 각자 자기 스트림을 잡 하나에서 쓴다). 나머지는 메인 스레드에서.
+#define STREAM_REGIONS 3
+#define STREAM_ALIGN 64
+
+enum StreamMode {
+	STREAM_PERSISTENT,
+	STREAM_ORPHAN
+};
+
+struct StreamStats {
+	GLsizeiptr bytes;        // 이번 프레임에 쓴 바이트
+	double fenceWaitMs;      // 이번 프레임에 펜스를 기다린 시간
+	int overflows;           // 구역이 모자라서 못 준 요청 수
+};
+
+struct StreamBuffer {
+	GLuint buffer;
+	GLenum target;
+	StreamMode mode;
+	GLsizeiptr regionSize;
+	int region;                          // 지금 쓰는 구역
+	GLsync fences[STREAM_REGIONS];
+	unsigned char * mapped;              // persistent : 버퍼 전체 매핑
+	std::vector<unsigned char> staging;  // orphan : CPU 쪽에 모아 두었다가 올린다
+	GLsizeiptr offset;                   // 이번 구역에서 다음에 줄 위치
+	GLsizeiptr flushed;                  // orphan : 여기까지 올렸다
+	StreamStats stats;                   // 지금 프레임
+	double totalWaitMs;                  // 처음부터 펜스를 기다린 시간
+	int stalls;                          // 처음부터 펜스가 아직 안 끝나 있던 횟수
+};
+
+// regionSize 는 한 프레임에 쓸 수 있는 최대 바이트. persistent 가 안 되면 orphan 으로 만든다.
+// allowPersistent 가 false 면 항상 orphan (비교용).
+void initStreamBuffer(StreamBuffer & s, GLenum target, GLsizeiptr regionSize, bool allowPersistent);
+void freeStreamBuffer(StreamBuffer & s);
+
+// 프레임 시작. 다음 구역으로 넘어가고, GPU 가 그 구역을 다 읽을 때까지 기다린다.
+void beginStreamFrame(StreamBuffer & s);
+// size 바이트를 쓸 곳을 돌려준다. *offset 은 버퍼 안 위치 (glVertexAttribPointer 의 오프셋).
+// 구역이 모자라면 NULL.
+void * streamAlloc(StreamBuffer & s, GLsizeiptr size, GLsizeiptr * offset);
+// 이번 구역에 남은 바이트
+GLsizeiptr streamAvailable(const StreamBuffer & s);
+// 쓴 데이터를 그리기 전에 부른다. orphan 이면 여기서 올린다. 버퍼를 target 에 바인드한 채로 돌아온다.
+void streamFlush(StreamBuffer & s);
+// 이 구역을 쓰는 그리기 명령을 다 넣은 뒤 부른다. 구역에 펜스를 건다.
+void endStreamFrame(StreamBuffer & s);
+
+#endif
@@ -0,0 +1,191 @@
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "telemetry.hpp"
+
+int64_t telemetryNow(){
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static size_t telemetrySize(uint32_t capacity){
+	return sizeof(TelemetryHeader) + (size_t)capacity * sizeof(TelemetrySlot);
+}
+
+#ifndef _WIN32
+
+bool openTelemetryPublisher(TelemetryPublisher & p, const char * name, uint32_t capacity){
+	uint32_t rounded = 1;
+	while (rounded < capacity)
+		rounded <<= 1;
+	p.header = NULL;
+	p.slots = NULL;
+	p.next = 0;
+	p.mappedSize = telemetrySize(rounded);
+
+	int fd = shm_open(name, O_CREAT | O_RDWR, 0644);
+	if (fd < 0) {
+		perror("shm_open");
+		return false;
+	}
+	if (ftruncate(fd, (off_t)p.mappedSize) != 0) {
+		perror("ftruncate");
+		close(fd);
+		return false;
+	}
+	void * memory = mmap(NULL, p.mappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED) {
+		perror("mmap");
+		return false;
+	}
+
+	p.header = (TelemetryHeader *)memory;
+	p.slots = (TelemetrySlot *)((char *)memory + sizeof(TelemetryHeader));
+	// magic 은 마지막에 써서, 읽는 쪽이 덜 만들어진 헤더를 보지 않게 한다
+	p.header->magic = 0;
+	p.header->version = TELEMETRY_VERSION;
+	p.header->capacity = rounded;
+	p.header->sampleSize = sizeof(TelemetrySample);
+	p.header->head.store(0, std::memory_order_relaxed);
+	for (uint32_t i = 0; i < rounded; i++)
+		p.slots[i].version.store(0, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	p.header->magic = TELEMETRY_MAGIC;
+	return true;
+}
+
+void closeTelemetryPublisher(TelemetryPublisher & p, const char * name){
+	if (p.header == NULL)
+		return;
+	munmap(p.header, p.mappedSize);
+	shm_unlink(name);
+	p.header = NULL;
+}
+
+bool openTelemetryReader(TelemetryReader & r, const char * name){
+	r.header = NULL;
+	r.slots = NULL;
+	r.missed = 0;
+	int fd = shm_open(name, O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(TelemetryHeader)) {
+		close(fd);
+		return false;
+	}
+	void * memory = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (memory == MAP_FAILED)
+		return false;
+
+	const TelemetryHeader * header = (const TelemetryHeader *)memory;
+	if (header->magic != TELEMETRY_MAGIC || header->version != TELEMETRY_VERSION ||
+		header->sampleSize != sizeof(TelemetrySample) || (size_t)info.st_size < telemetrySize(header->capacity)) {
+		fprintf(stderr, "%s is not a compatible telemetry buffer\n", name);
+		munmap(memory, (size_t)info.st_size);
+		return false;
+	}
+	std::atomic_thread_fence(std::memory_order_acquire);
+	r.header = header;
+	r.slots = (const TelemetrySlot *)((const char *)memory + sizeof(TelemetryHeader));
+	r.mappedSize = (size_t)info.st_size;
+	uint64_t head = header->head.load(std::memory_order_acquire);
+	r.next = head > 0 ? head - 1 : 0;
+	return true;
+}
+
+void closeTelemetryReader(TelemetryReader & r){
+	if (r.header == NULL)
+		return;
+	munmap((void *)r.header, r.mappedSize);
+	r.header = NULL;
+}
+
+#else
+
+// Windows 에는 POSIX 공유 메모리가 없다. 내보내기만 꺼진다.
+bool openTelemetryPublisher(TelemetryPublisher & p, const char *, uint32_t){
+	p.header = NULL;
+	return false;
+}
+void closeTelemetryPublisher(TelemetryPublisher &, const char *){}
+bool openTelemetryReader(TelemetryReader & r, const char *){
+	r.header = NULL;
+	return false;
+}
+void closeTelemetryReader(TelemetryReader &){}
+
+#endif
+
+void publishTelemetry(TelemetryPublisher & p, TelemetrySample sample){
+	if (p.header == NULL)
+		return;
+	const uint64_t sequence = p.next++;
+	TelemetrySlot & slot = p.slots[sequence & (p.header->capacity - 1)];
+	sample.sequence = sequence;
+	sample.timeNs = telemetryNow();
+
+	slot.version.store(2 * sequence + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	memcpy(&slot.sample, &sample, sizeof(sample));
+	slot.version.store(2 * sequence + 2, std::memory_order_release);
+	p.header->head.store(sequence + 1, std::memory_order_release);
+}
+
+// sequence 번째 샘플을 읽어본다. 아직이면 EMPTY, 덮어써졌으면 OVERRUN.
+static TelemetryStatus readSlot(const TelemetryReader & r, uint64_t sequence, TelemetrySample & out){
+	const TelemetrySlot & slot = r.slots[sequence & (r.header->capacity - 1)];
+	const uint64_t expected = 2 * sequence + 2;
+	uint64_t before = slot.version.load(std::memory_order_acquire);
+	if (before < expected)
+		return TELEMETRY_EMPTY;
+	if (before != expected)
+		return TELEMETRY_OVERRUN;
+	memcpy(&out, &slot.sample, sizeof(out));
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t after = slot.version.load(std::memory_order_relaxed);
+	return after == expected ? TELEMETRY_OK : TELEMETRY_OVERRUN;
+}
+
+TelemetryStatus readTelemetry(TelemetryReader & r, TelemetrySample & out){
+	if (r.header == NULL)
+		return TELEMETRY_EMPTY;
+	TelemetryStatus status = readSlot(r, r.next, out);
+	if (status == TELEMETRY_OVERRUN) {
+		// 링 한바퀴 이상 뒤처졌다. 남아있는 가장 오래된 샘플로 건너뛴다.
+		uint64_t head = r.header->head.load(std::memory_order_acquire);
+		uint64_t oldest = head > r.header->capacity ? head - r.header->capacity + 1 : 0;
+		if (oldest > r.next) {
+			r.missed += oldest - r.next;
+			r.next = oldest;
+		}
+		return TELEMETRY_OVERRUN;
+	}
+	if (status == TELEMETRY_OK)
+		r.next++;
+	return status;
+}
+
+TelemetryStatus readLatestTelemetry(TelemetryReader & r, TelemetrySample & out){
+	if (r.header == NULL)
+		return TELEMETRY_EMPTY;
+	uint64_t head = r.header->head.load(std::memory_order_acquire);
+	if (head == 0)
+		return TELEMETRY_EMPTY;
+	TelemetryStatus status = readSlot(r, head - 1, out);
+	if (status == TELEMETRY_OK)
+		r.next = head;
+	return status;
+}
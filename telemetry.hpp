@@ -0,0 +1,86 @@
+#ifndef TELEMETRY_HPP
+#define TELEMETRY_HPP
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// 공유 메모리로 로켓 상태를 내보내는 링 버퍼.
+// 쓰는 쪽(시뮬레이션)은 하나, 읽는 쪽은 몇 개든 상관없다. 락은 쓰지 않는다.
+// 슬롯마다 seqlock 을 두어서, 읽는 쪽이 쓰는 쪽을 기다리게 만들지 않는다.
+// 읽는 쪽은 공유 메모리를 그대로 map 해서 읽는다 (복사는 샘플 하나 크기뿐).
+
+#define TELEMETRY_NAME "/rocket_telemetry"
+#define TELEMETRY_MAGIC 0x524B5431u     // "RKT1"
+#define TELEMETRY_VERSION 1
+
+// 상태 플래그
+#define TELEMETRY_START   0x1u     // 엔진/이동 중
+#define TELEMETRY_SKY     0x2u     // 하늘에 떠있음
+#define TELEMETRY_SUIT    0x4u     // 낙하산 펼침
+#define TELEMETRY_ENGINE  0x8u     // 추력 있음
+
+struct TelemetrySample {
+	uint64_t sequence;     // 시뮬레이션 틱 번호 (0 부터, FLIGHT_TICK 마다 하나. 틱이 없는 프레임은 쓰지 않는다)
+	int64_t timeNs;        // 쓴 시각 (steady clock, ns)
+	float x, y, z;         // gro1
+	float velocity;
+	float thrust;          // main
+	uint32_t flags;
+	uint32_t cameraMode;   // close (0: 자유 카메라, 1: 추적 카메라)
+	uint32_t padding;
+};
+
+struct TelemetrySlot {
+	std::atomic<uint64_t> version;   // 홀수면 쓰는 중, 2*(sequence+1) 이면 sequence 가 다 써진 것
+	TelemetrySample sample;
+};
+
+struct TelemetryHeader {
+	uint32_t magic;
+	uint32_t version;
+	uint32_t capacity;     // 슬롯 수 (2 의 거듭제곱)
+	uint32_t sampleSize;
+	std::atomic<uint64_t> head;     // 다음에 쓸 sequence
+};
+
+// 쓰는 쪽
+struct TelemetryPublisher {
+	TelemetryHeader * header;
+	TelemetrySlot * slots;
+	size_t mappedSize;
+	uint64_t next;
+};
+
+// 공유 메모리를 만든다. capacity 는 2 의 거듭제곱으로 올림한다. 실패하면 false.
+bool openTelemetryPublisher(TelemetryPublisher & p, const char * name, uint32_t capacity);
+// 샘플 하나를 쓴다. sequence 와 timeNs 는 여기서 채운다.
+void publishTelemetry(TelemetryPublisher & p, TelemetrySample sample);
+void closeTelemetryPublisher(TelemetryPublisher & p, const char * name);
+
+// 읽는 쪽
+enum TelemetryStatus {
+	TELEMETRY_OK,
+	TELEMETRY_EMPTY,      // 아직 새 샘플 없음
+	TELEMETRY_OVERRUN     // 너무 늦어서 샘플을 놓쳤다. 가장 오래된 남은 샘플부터 다시 읽는다
+};
+
+struct TelemetryReader {
+	const TelemetryHeader * header;
+	const TelemetrySlot * slots;
+	size_t mappedSize;
+	uint64_t next;        // 다음에 읽을 sequence
+	uint64_t missed;      // 놓친 샘플 수
+};
+
+// 읽기 전용으로 연다. 처음 읽는 위치는 지금 최신 샘플부터.
+bool openTelemetryReader(TelemetryReader & r, const char * name);
+// 다음 샘플을 읽는다.
+TelemetryStatus readTelemetry(TelemetryReader & r, TelemetrySample & out);
+// 가장 최근 샘플만 본다 (지나간 샘플은 건너뛴다).
+TelemetryStatus readLatestTelemetry(TelemetryReader & r, TelemetrySample & out);
+void closeTelemetryReader(TelemetryReader & r);
+
+int64_t telemetryNow();
+
+#endif
@@ -0,0 +1,321 @@
+#include <math.h>
+#include <string.h>
+
+#include <glm/glm.hpp>
+
+#include "trajectory.hpp"
+
+#define FLAG_START 1
+#define FLAG_SKY 2
+#define FLAG_SUIT 4
+#define FLAG_ENGINE 8
+
+// 구간을 만들 때 쓰는 비행 상태 (FlightState 를 double 로)
+struct PredictState {
+	double x, y, z, velocity;
+	float main;
+	float gravity;
+	int start, sky, suit;
+};
+
+// 구간 안의 위치. float 로 쌓인 실제 위치와 비교하므로 double 로 구한다.
+struct PhasePoint {
+	double x, y, z;
+};
+
+static const int64_t NEVER = TRAJECTORY_FOREVER;
+
+static int stateFlags(int start, int sky, int suit, float main){
+	return (start ? FLAG_START : 0) | (sky ? FLAG_SKY : 0) | (suit ? FLAG_SUIT : 0) | (main > 0.0f ? FLAG_ENGINE : 0);
+}
+
+static PredictState stateOf(const FlightState & f){
+	PredictState s;
+	s.x = f.gro1.x;
+	s.y = f.gro1.y;
+	s.z = f.gro1.z;
+	s.velocity = f.velocity;
+	s.main = f.main;
+	s.gravity = f.gravity;
+	s.start = f.start;
+	s.sky = f.sky;
+	s.suit = f.suit;
+	return s;
+}
+
+// updateFlight 의 분기 순서 그대로
+static TrajectoryPhaseKind phaseKind(const PredictState & s){
+	if (!s.sky)
+		return PHASE_REST;
+	if (s.suit)
+		return PHASE_PARACHUTE;
+	if (!s.start)
+		return PHASE_STALLED;
+	return s.main > 0.0f ? PHASE_POWERED : PHASE_COAST;
+}
+
+// 추력/관성 구간에서 n 틱 뒤. 매 틱 v += a dt 한 뒤 y += 4 v dt 이므로
+// v(n) = v0 + n a dt, y(n) = y0 + 4 dt (n v0 + a dt n (n + 1) / 2)
+static inline double ballisticVelocity(const TrajectoryPhase & ph, double n){
+	return ph.velocity + ph.accel * FLIGHT_TICK * n;
+}
+
+static inline double ballisticHeight(const TrajectoryPhase & ph, double n){
+	const double dt = FLIGHT_TICK;
+	return ph.y + FLIGHT_CLIMB_SCALE * dt * (n * ph.velocity + ph.accel * dt * n * (n + 1.0) * 0.5);
+}
+
+static PhasePoint phasePosition(const TrajectoryPhase & ph, int64_t tick){
+	double n = (double)(tick - ph.startTick);
+	PhasePoint point = { ph.x, ph.y, ph.z };
+	if (ph.kind == PHASE_POWERED || ph.kind == PHASE_COAST) {
+		point.x += FLIGHT_DRIFT_SPEED * FLIGHT_TICK * n;
+		point.y = ballisticHeight(ph, n);
+	}
+	else if (ph.kind == PHASE_PARACHUTE) {
+		point.y -= FLIGHT_PARACHUTE_SPEED * FLIGHT_TICK * n;
+	}
+	return point;
+}
+
+// 단조인 조건 above(n) 이 처음 참이 되는 n >= 1. guess 는 닫힌 식으로 구한 근처 값이고
+// 반올림 때문에 한두 틱 어긋날 수 있어서 양쪽으로 맞춘다.
+template <typename Predicate>
+static int64_t firstTick(double guess, Predicate above){
+	if (!(guess < 1e15))
+		return NEVER;
+	int64_t n = guess < 1.0 ? 1 : (int64_t)guess;
+	while (n > 1 && above(n - 1))
+		n--;
+	for (int i = 0; i < 4 && !above(n); i++)
+		n++;
+	return above(n) ? n : NEVER;
+}
+
+// 높이가 처음으로 0 아래가 되는 틱. y(n) = A n^2 + B n + y0
+static int64_t groundTick(const TrajectoryPhase & ph){
+	const double dt = FLIGHT_TICK;
+	const double A = FLIGHT_CLIMB_SCALE * dt * ph.accel * dt * 0.5;
+	const double B = FLIGHT_CLIMB_SCALE * dt * (ph.velocity + ph.accel * dt * 0.5);
+	auto below = [&](int64_t n) { return ballisticHeight(ph, (double)n) < 0.0; };
+	if (below(1))
+		return 1;
+	if (A == 0.0)
+		return B < 0.0 ? firstTick(-ph.y / B, below) : NEVER;
+	double D = B * B - 4.0 * A * ph.y;
+	if (D < 0.0)
+		return NEVER;
+	// A < 0 이면 큰 근 뒤로 내려가고, A > 0 이면 (아래로 가다가 추력으로 올라옴) 작은 근부터 잠깐 아래
+	double root = (-B - sqrt(D)) / (2.0 * A);
+	if (root < 0.0)
+		return NEVER;
+	return firstTick(root, below);
+}
+
+// 구간 하나를 채우고 끝나는 틱 (startTick 에서 몇 틱 뒤) 과 그때의 상태를 구한다
+static int64_t evaluatePhase(TrajectoryPhase & ph, const PredictState & s, int64_t tick, PredictState & next){
+	ph.kind = phaseKind(s);
+	ph.startTick = tick;
+	ph.x = s.x;
+	ph.y = s.y;
+	ph.z = s.z;
+	ph.velocity = s.velocity;
+	ph.main = s.main;
+	ph.accel = (double)s.main - s.gravity;
+	ph.flags = stateFlags(s.start, s.sky, s.suit, s.main);
+	next = s;
+	const double dt = FLIGHT_TICK;
+	if (ph.kind == PHASE_PARACHUTE) {
+		const double drop = FLIGHT_PARACHUTE_SPEED * dt;
+		int64_t n = firstTick(s.y / drop, [&](int64_t k) { return s.y - drop * k < 0.0; });
+		next.y = s.y - drop * n;
+		next.start = 0;
+		next.sky = 0;
+		return n;
+	}
+	if (ph.kind != PHASE_POWERED && ph.kind != PHASE_COAST)
+		return NEVER;
+	// 엔진 끄기, 멈춤, 착지 중 먼저 오는 것
+	const double dv = ph.accel * dt;
+	int64_t cutoff = NEVER, stall = NEVER;
+	if (s.main > 0.0f)
+		cutoff = dv > 0.0 ? firstTick((FLIGHT_CUTOFF_VELOCITY - s.velocity) / dv,
+			[&](int64_t k) { return ballisticVelocity(ph, (double)k) > FLIGHT_CUTOFF_VELOCITY; })
+			: (ballisticVelocity(ph, 1.0) > FLIGHT_CUTOFF_VELOCITY ? 1 : NEVER);
+	stall = dv < 0.0 ? firstTick((FLIGHT_STALL_VELOCITY - s.velocity) / dv,
+		[&](int64_t k) { return ballisticVelocity(ph, (double)k) < FLIGHT_STALL_VELOCITY; })
+		: (ballisticVelocity(ph, 1.0) < FLIGHT_STALL_VELOCITY ? 1 : NEVER);
+	int64_t ground = groundTick(ph);
+	int64_t n = cutoff < stall ? cutoff : stall;
+	if (ground < n)
+		n = ground;
+	if (n == NEVER)
+		return NEVER;
+	// n 번째 틱 : 속도, 멈춤, 엔진, 이동, 착지 순서
+	next.velocity = ballisticVelocity(ph, (double)n);
+	if (n == stall)
+		next.start = 0;
+	if (n == cutoff)
+		next.main = 0.0f;
+	PhasePoint position = phasePosition(ph, tick + (next.start ? n : n - 1));
+	next.x = position.x;
+	next.y = position.y;
+	if (next.y < 0.0) {
+		next.start = 0;
+		next.sky = 0;
+	}
+	return n;
+}
+
+static double phaseApogee(const TrajectoryPhase & ph, int64_t * apogeeTick){
+	*apogeeTick = ph.startTick;
+	if (ph.kind != PHASE_POWERED && ph.kind != PHASE_COAST)
+		return ph.y;
+	// 속도가 양수인 동안 올라간다. 후보는 양 끝과 속도가 0 을 지나기 직전
+	int64_t length = ph.endTick == NEVER ? NEVER : ph.endTick - ph.startTick;
+	int64_t candidates[3] = { 0, length, -1 };
+	const double dv = ph.accel * FLIGHT_TICK;
+	if (dv < 0.0 && ph.velocity > 0.0) {
+		int64_t top = (int64_t)ceil(-ph.velocity / dv) - 1;
+		candidates[2] = top < length ? top : length;
+	}
+	double best = ph.y;
+	for (int i = 1; i < 3; i++) {
+		if (candidates[i] < 0 || candidates[i] == NEVER)
+			continue;
+		double h = ballisticHeight(ph, (double)candidates[i]);
+		if (h > best) {
+			best = h;
+			*apogeeTick = ph.startTick + candidates[i];
+		}
+	}
+	return best;
+}
+
+static void summarize(TrajectoryPrediction & p){
+	p.apogee = p.launchPosition.y;
+	p.apogeeTick = p.launchTick;
+	p.lands = false;
+	p.touchdownTick = NEVER;
+	for (int i = 0; i < p.phaseCount; i++) {
+		const TrajectoryPhase & ph = p.phases[i];
+		if (!p.launched || ph.startTick < p.launchTick)
+			continue;
+		if (ph.kind == PHASE_REST) {
+			if (ph.startTick > p.launchTick) {
+				p.lands = true;
+				p.touchdownTick = ph.startTick;
+				p.touchdown = glm::vec3(ph.x, ph.y, ph.z);
+			}
+			break;
+		}
+		int64_t tick;
+		double h = phaseApogee(ph, &tick);
+		if (h > p.apogee) {
+			p.apogee = (float)h;
+			p.apogeeTick = tick;
+		}
+		p.touchdown = glm::vec3(ph.x, ph.y, ph.z);
+	}
+	p.downrange = p.launched ? p.touchdown.x - p.launchPosition.x : 0.0f;
+}
+
+// 지금 틱에서 구간을 끊고 실제 상태로부터 뒤를 다시 만든다
+static void rebuild(TrajectoryPrediction & p, const FlightState & f){
+	PredictState s = stateOf(f);
+	int keep = p.current;
+	// 이번 틱은 이미 새 상태로 진행했으므로 지금 구간의 식은 한 틱 전까지만 맞다
+	if (p.phaseCount > 0 && p.phases[p.current].startTick < p.tick) {
+		p.phases[p.current].endTick = p.tick - 1;
+		keep = p.current + 1;
+	}
+	// 발사대에서 떠나면 새 비행이다. 앞의 기록은 버린다.
+	TrajectoryPhaseKind kind = phaseKind(s);
+	if (kind != PHASE_REST && (keep == 0 || p.phases[keep - 1].kind == PHASE_REST)) {
+		keep = 0;
+		p.launched = true;
+		p.launchTick = p.tick;
+		p.launchPosition = f.gro1;
+	}
+	// 충돌로 여러 번 끊겨 자리가 모자라면 오래된 구간부터 버린다
+	const int reserve = 6;
+	if (keep > TRAJECTORY_MAX_PHASES - reserve) {
+		int drop = keep - (TRAJECTORY_MAX_PHASES - reserve);
+		memmove(p.phases, p.phases + drop, (keep - drop) * sizeof(TrajectoryPhase));
+		keep -= drop;
+	}
+	p.phaseCount = keep;
+	p.current = keep;
+	int64_t tick = p.tick;
+	while (p.phaseCount < TRAJECTORY_MAX_PHASES) {
+		TrajectoryPhase & ph = p.phases[p.phaseCount++];
+		PredictState next;
+		int64_t n = evaluatePhase(ph, s, tick, next);
+		p.stats.phasesEvaluated++;
+		if (n == NEVER) {
+			ph.endTick = NEVER;
+			break;
+		}
+		tick += n;
+		ph.endTick = tick;
+		s = next;
+	}
+	p.phases[p.phaseCount - 1].endTick = NEVER;
+	p.version++;
+	p.stats.rebuilds++;
+	summarize(p);
+}
+
+void initPrediction(TrajectoryPrediction & p, const FlightState & f){
+	p.phaseCount = 0;
+	p.current = 0;
+	p.tick = 0;
+	p.version = 0;
+	p.launched = false;
+	p.launchTick = 0;
+	p.launchPosition = f.gro1;
+	memset(&p.stats, 0, sizeof(p.stats));
+	rebuild(p, f);
+}
+
+bool updatePrediction(TrajectoryPrediction & p, const FlightState & f){
+	p.tick++;
+	p.stats.queries++;
+	while (p.current + 1 < p.phaseCount && p.phases[p.current].endTick <= p.tick)
+		p.current++;
+	const TrajectoryPhase & ph = p.phases[p.current];
+	PhasePoint predicted = phasePosition(ph, p.tick);
+	float error = (float)fmax(fmax(fabs(predicted.x - f.gro1.x), fabs(predicted.y - f.gro1.y)), fabs(predicted.z - f.gro1.z));
+	if (ph.flags != stateFlags(f.start, f.sky, f.suit, f.main) || error > TRAJECTORY_TOLERANCE) {
+		rebuild(p, f);
+		p.stats.lastError = 0.0f;
+		return true;
+	}
+	p.stats.lastError = error;
+	if (error > p.stats.maxError)
+		p.stats.maxError = error;
+	return false;
+}
+
+glm::vec3 predictPosition(const TrajectoryPrediction & p, int64_t tick){
+	int i = p.phaseCount - 1;
+	while (i > 0 && p.phases[i].startTick > tick)
+		i--;
+	PhasePoint point = phasePosition(p.phases[i], tick);
+	return glm::vec3((float)point.x, (float)point.y, (float)point.z);
+}
+
+int samplePrediction(const TrajectoryPrediction & p, glm::vec3 * out, int maxPoints, int64_t horizonTicks){
+	if (!p.launched || maxPoints < 2)
+		return 0;
+	int64_t from = p.launchTick;
+	int64_t to = p.lands ? p.touchdownTick : (p.tick > from ? p.tick : from) + horizonTicks;
+	int64_t step = (to - from + maxPoints - 2) / (maxPoints - 1);
+	if (step < 1)
+		step = 1;
+	int count = 0;
+	for (int64_t t = from; t < to && count < maxPoints - 1; t += step)
+		out[count++] = predictPosition(p, t);
+	out[count++] = predictPosition(p, to);
+	return count;
+}
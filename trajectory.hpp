@@ -0,0 +1,82 @@
+#ifndef TRAJECTORY_HPP
+#define TRAJECTORY_HPP
+
+#include <stdint.h>
+
+#include <glm/glm.hpp>
+
+#include "flight.hpp"
+
+// 비행 궤적 예측. 비행 모델 (flight.cpp) 은 구간마다 가속도가 일정하므로
+// (엔진 추력 -> 엔진이 꺼진 뒤 관성 비행 -> 낙하산 하강), 구간마다 n 틱 뒤의 상태를 닫힌 식으로 구한다.
+// 식은 updateFlight 의 적분 (속도 먼저, 그 속도로 위치) 을 틱 단위로 그대로 합한 것이라
+// 한 틱씩 돌린 결과와 float 반올림 만큼만 다르다.
+// 구간 목록은 캐시해 두고, 입력 (발사, 낙하산 X) 이나 충돌로 상태가 예측에서 벗어났을 때만
+// 지금 구간부터 뒤를 다시 계산한다. 지나간 구간은 그대로 둔다.
+#define TRAJECTORY_MAX_PHASES 16
+#define TRAJECTORY_FOREVER INT64_MAX
+#define TRAJECTORY_TOLERANCE 0.01f   // 예측과 실제 위치가 이만큼 벌어지면 다시 계산한다
+
+enum TrajectoryPhaseKind {
+	PHASE_REST,          // 발사대 위 또는 착지 (움직이지 않음)
+	PHASE_POWERED,       // 엔진 추력
+	PHASE_COAST,         // 엔진이 꺼진 뒤 관성 비행
+	PHASE_STALLED,       // 속도가 FLIGHT_STALL_VELOCITY 아래로 떨어져 공중에 멈춤
+	PHASE_PARACHUTE      // 낙하산 하강
+};
+
+// 한 구간. startTick <= tick < endTick 동안 상태 플래그가 같다.
+// 위치 식은 startTick ~ endTick 에서 맞고, endTick 의 상태가 다음 구간의 시작 상태다.
+struct TrajectoryPhase {
+	TrajectoryPhaseKind kind;
+	int64_t startTick;
+	int64_t endTick;               // 끝이 없으면 TRAJECTORY_FOREVER
+	double x, y, z, velocity;      // startTick 의 상태
+	double accel;                  // 초당 속도 변화
+	float main;                    // 엔진 추력 (다시 계산할 때 넘겨준다)
+	int flags;                     // 이 구간 동안의 start / sky / suit / 엔진
+};
+
+struct TrajectoryStats {
+	int queries;                   // updatePrediction 호출 수
+	int rebuilds;                  // 다시 계산한 수
+	int phasesEvaluated;           // 다시 계산한 구간 수 (누적)
+	float lastError;               // 지난 틱 예측과 실제 위치의 차이
+	float maxError;                // 다시 계산하지 않고 지나간 틱 중 가장 큰 차이
+};
+
+struct TrajectoryPrediction {
+	TrajectoryPhase phases[TRAJECTORY_MAX_PHASES];
+	int phaseCount;
+	int current;                   // 지금 틱이 들어있는 구간
+	int64_t tick;                  // updatePrediction 이 불린 횟수
+	int version;                   // 다시 계산할 때마다 1 씩 는다 (궤적 선을 다시 올릴지 판단)
+
+	// 요약. 다시 계산할 때 같이 구한다.
+	bool launched;
+	int64_t launchTick;
+	glm::vec3 launchPosition;
+	float apogee;                  // 가장 높은 곳의 높이
+	int64_t apogeeTick;
+	bool lands;                    // false 면 공중에 멈춰서 내려오지 않는다
+	int64_t touchdownTick;
+	glm::vec3 touchdown;           // 착지 지점
+	float downrange;               // 발사 지점에서 착지 지점까지 x 거리
+	TrajectoryStats stats;
+};
+
+// 지금 비행 상태에서 예측을 시작한다 (tick 0).
+void initPrediction(TrajectoryPrediction & p, const FlightState & f);
+
+// updateFlight 로 한 틱 진행한 뒤마다 부른다. 상태 플래그가 예측한 구간과 다르거나
+// 위치가 TRAJECTORY_TOLERANCE 넘게 벗어났으면 지금 구간부터 다시 계산하고 true 를 돌려준다.
+bool updatePrediction(TrajectoryPrediction & p, const FlightState & f);
+
+// tick 때의 예측 위치 (gro1). 구간 안에서 닫힌 식 하나.
+glm::vec3 predictPosition(const TrajectoryPrediction & p, int64_t tick);
+
+// 발사부터 착지까지 (착지하지 않으면 horizonTicks 까지) 를 같은 틱 간격으로 maxPoints 개 이하로 뽑는다.
+// 발사 전이면 0 을 돌려준다.
+int samplePrediction(const TrajectoryPrediction & p, glm::vec3 * out, int maxPoints, int64_t horizonTicks);
+
+#endif
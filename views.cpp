@@ -0,0 +1,144 @@
+#include <math.h>
+
+#include <GL/glew.h>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "views.hpp"
+
+static const char * const VIEW_NAMES[VIEW_KINDS] = { "free", "chase", "tracking", "top" };
+
+const char * viewKindName(ViewKind kind){
+	return kind >= 0 && kind < VIEW_KINDS ? VIEW_NAMES[kind] : "?";
+}
+
+int viewMaskCount(unsigned mask){
+	int n = 0;
+	for (; mask != 0; mask &= mask - 1)
+		n++;
+	return n;
+}
+
+bool viewportArraySupported(){
+	return GLEW_ARB_viewport_array && (GLEW_ARB_shader_viewport_layer_array || GLEW_AMD_vertex_shader_viewport_index);
+}
+
+void layoutViews(ViewSet & s, int count, ViewKind primary){
+	if (count < 1)
+		count = 1;
+	if (count > MAX_VIEWS)
+		count = MAX_VIEWS;
+	s.count = count;
+	// 첫 번째는 primary, 나머지는 순서대로
+	s.kind[0] = primary;
+	for (int k = 0, i = 1; i < count; k++)
+		if (k != primary)
+			s.kind[i++] = (ViewKind)k;
+	if (count == 1) {
+		s.rect[0] = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	}
+	else if (count == 2) {
+		s.rect[0] = glm::vec4(-0.5f, 0.0f, 0.5f, 1.0f);
+		s.rect[1] = glm::vec4(0.5f, 0.0f, 0.5f, 1.0f);
+	}
+	else {
+		for (int i = 0; i < count; i++)
+			s.rect[i] = glm::vec4(i % 2 == 0 ? -0.5f : 0.5f, i < 2 ? 0.5f : -0.5f, 0.5f, 0.5f);
+	}
+}
+
+void computeViews(ViewSet & s, const glm::mat4 & freeView, const glm::mat4 & freeProjection, float aspect,
+	const FlightState & flight, const TrajectoryPrediction & prediction){
+	const glm::vec3 center = flight.gro1 + glm::vec3(0.5f, 1.0f, 0.5f);
+	const glm::vec3 pad = prediction.launched ? prediction.launchPosition : flight.gro1;
+	for (int i = 0; i < s.count; i++) {
+		const glm::vec4 & r = s.rect[i];
+		// 창 비율로 만든 투영을 뷰 비율에 맞춘다 (x 를 반높이/반폭 만큼)
+		glm::mat4 fit = glm::scale(glm::mat4(1.0f), glm::vec3(r.w / r.z, 1.0f, 1.0f));
+		glm::mat4 view, projection;
+		switch (s.kind[i]) {
+		case VIEW_FREE:
+			view = freeView;
+			projection = fit * freeProjection;
+			break;
+		case VIEW_CHASE:
+			view = glm::lookAt(glm::vec3(flight.gro1.x + 3, flight.gro1.y + 3, 10.0f),
+				glm::vec3(flight.gro1.x, flight.gro1.y, 0.0f), glm::vec3(0, 1, 0));
+			projection = fit * freeProjection;
+			break;
+		case VIEW_TRACKING: {
+			// 발사대 옆 땅 위. 멀어질수록 화각을 좁혀서 로켓 크기가 비슷하게 보인다.
+			glm::vec3 eye = pad + glm::vec3(-12.0f, 0.5f, 22.0f);
+			eye.y = 1.5f;
+			float distance = glm::length(center - eye);
+			float zoom = distance > 15.0f ? distance / 15.0f : 1.0f;
+			view = glm::lookAt(eye, center, glm::vec3(0, 1, 0));
+			projection = glm::scale(glm::mat4(1.0f), glm::vec3(zoom, zoom, 1.0f)) * fit * freeProjection;
+			break;
+		}
+		default: {
+			// 발사대, 로켓, 예상 착지점이 모두 들어오게
+			float lo = pad.x < flight.gro1.x ? pad.x : flight.gro1.x;
+			float hi = pad.x > flight.gro1.x ? pad.x : flight.gro1.x;
+			if (prediction.launched && prediction.lands) {
+				lo = prediction.touchdown.x < lo ? prediction.touchdown.x : lo;
+				hi = prediction.touchdown.x > hi ? prediction.touchdown.x : hi;
+			}
+			float half = (hi - lo) * 0.5f + 6.0f;
+			if (half < 12.0f)
+				half = 12.0f;
+			float cx = (lo + hi) * 0.5f + 0.5f;
+			float cz = flight.gro1.z + 0.5f;
+			float viewAspect = aspect * r.z / r.w;
+			view = glm::lookAt(glm::vec3(cx, 150.0f, cz), glm::vec3(cx, 0.0f, cz), glm::vec3(0, 0, -1));
+			projection = glm::ortho(-half * viewAspect, half * viewAspect, -half, half, 1.0f, 300.0f);
+			break;
+		}
+		}
+		s.view[i] = view;
+		s.projection[i] = projection;
+		s.VP[i] = projection * view;
+		s.right[i] = glm::vec3(view[0][0], view[1][0], view[2][0]);
+		s.up[i] = glm::vec3(view[0][1], view[1][1], view[2][1]);
+		extractFrustum(s.VP[i], s.frustum[i]);
+	}
+}
+
+void getViewUniforms(GLuint program, ViewUniforms & u){
+	u.VP = glGetUniformLocation(program, "viewVP");
+	u.rect = glGetUniformLocation(program, "viewRect");
+	u.count = glGetUniformLocation(program, "viewCount");
+	u.viewportArray = glGetUniformLocation(program, "viewportArray");
+}
+
+void setViewUniforms(const ViewUniforms & u, const ViewSet & s){
+	glUniformMatrix4fv(u.VP, s.count, GL_FALSE, &s.VP[0][0][0]);
+	glUniform4fv(u.rect, s.count, &s.rect[0][0]);
+	glUniform1i(u.count, s.count);
+	glUniform1i(u.viewportArray, s.viewportArray ? 1 : 0);
+}
+
+void beginViews(const ViewSet & s, int width, int height){
+	if (s.count == 1)
+		return;
+	for (int c = 0; c < 4; c++)
+		glEnable(GL_CLIP_DISTANCE0 + c);
+	if (s.viewportArray) {
+		for (int i = 0; i < s.count; i++) {
+			const glm::vec4 & r = s.rect[i];
+			glViewportIndexedf(i, (r.x - r.z + 1.0f) * 0.5f * width, (r.y - r.w + 1.0f) * 0.5f * height,
+				r.z * width, r.w * height);
+		}
+	}
+}
+
+void endViews(const ViewSet & s, int width, int height){
+	if (s.count == 1)
+		return;
+	for (int c = 0; c < 4; c++)
+		glDisable(GL_CLIP_DISTANCE0 + c);
+	// glViewport 는 모든 뷰포트를 한번에 되돌린다
+	if (s.viewportArray)
+		glViewport(0, 0, width, height);
+}
@@ -0,0 +1,71 @@
+#ifndef VIEWS_HPP
+#define VIEWS_HPP
+
+#include <glm/glm.hpp>
+
+#include <GL/glew.h>
+
+#include "flight.hpp"
+#include "trajectory.hpp"
+#include "scene.hpp"
+
+// 여러 화면 (자유 카메라, 추적 카메라, 지상 추적 카메라, 위에서 본 지도) 을 한 번에 그린다.
+// 그리기 호출을 뷰마다 반복하지 않고 인스턴스 수를 뷰 수만큼 늘려서, 정점 셰이더가 gl_InstanceID 로
+// 자기 뷰의 VP 를 고른다. 뷰를 늘려도 CPU 쪽은 절두체 컬링 한 번씩만 는다.
+// 정점 셰이더에서 gl_ViewportIndex 를 쓸 수 있으면 (ARB_shader_viewport_layer_array 또는
+// AMD_vertex_shader_viewport_index, 그리고 ARB_viewport_array) 하드웨어 뷰포트를 쓰고,
+// 아니면 (GL 3.3) 클립 좌표를 뷰의 사각형으로 옮기고 gl_ClipDistance 네 개로 그 밖을 잘라낸다.
+// 컬링은 뷰마다 해서 노드/잔해마다 보이는 뷰의 비트를 남긴다. 안 보이는 뷰에서는 셰이더가 잘라낸다.
+#define MAX_VIEWS 4
+
+enum ViewKind {
+	VIEW_FREE,                   // 마우스/키보드 카메라 (controls)
+	VIEW_CHASE,                  // 로켓을 따라가는 카메라 (C)
+	VIEW_TRACKING,               // 땅에 고정된 추적 카메라. 멀어지면 당겨 찍는다
+	VIEW_TOP,                    // 위에서 내려다본 지도 (정사영)
+	VIEW_KINDS
+};
+
+struct ViewSet {
+	int count;
+	bool viewportArray;          // 하드웨어 뷰포트 (gl_ViewportIndex) 를 쓰는지
+	ViewKind kind[MAX_VIEWS];
+	glm::vec4 rect[MAX_VIEWS];   // NDC 에서 (가운데 x, 가운데 y, 반폭, 반높이)
+	glm::mat4 view[MAX_VIEWS];
+	glm::mat4 projection[MAX_VIEWS];
+	glm::mat4 VP[MAX_VIEWS];
+	glm::vec3 right[MAX_VIEWS];  // 빌보드용 카메라 축 (월드)
+	glm::vec3 up[MAX_VIEWS];
+	Frustum frustum[MAX_VIEWS];
+};
+
+// 프로그램마다의 uniform 위치
+struct ViewUniforms {
+	GLint VP;
+	GLint rect;
+	GLint count;
+	GLint viewportArray;
+};
+
+// 뷰 수를 정하고 화면을 나눈다 (1 : 전체, 2 : 좌우, 3~4 : 2x2). primary 가 첫 번째 (왼쪽 위) 뷰다.
+void layoutViews(ViewSet & s, int count, ViewKind primary);
+// 이 GL 에서 gl_ViewportIndex 를 정점 셰이더에서 쓸 수 있는지
+bool viewportArraySupported();
+
+// 뷰마다 카메라 행렬과 절두체를 구한다. freeView/freeProjection 은 controls 의 것이고 창 비율 기준이다.
+// 뷰의 가로세로 비율이 창과 다르면 찌그러지지 않게 고친다.
+void computeViews(ViewSet & s, const glm::mat4 & freeView, const glm::mat4 & freeProjection, float aspect,
+	const FlightState & flight, const TrajectoryPrediction & prediction);
+
+void getViewUniforms(GLuint program, ViewUniforms & u);
+// 지금 쓰는 프로그램에 뷰 행렬과 사각형을 올린다
+void setViewUniforms(const ViewUniforms & u, const ViewSet & s);
+// 여러 뷰를 그리기 전/후에 부른다 (클립 평면, 하드웨어 뷰포트). width/height 는 프레임버퍼 크기.
+void beginViews(const ViewSet & s, int width, int height);
+void endViews(const ViewSet & s, int width, int height);
+
+const char * viewKindName(ViewKind kind);
+// mask 에서 켜진 뷰 수
+int viewMaskCount(unsigned mask);
+
+#endif